@@ -15,6 +15,7 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 // #define BOOST_SPIRIT_DEBUG
+#include <limits>
 #include <boost/bind.hpp>
 #include <boost/spirit/include/qi.hpp>
 #include <boost/spirit/include/qi_numeric.hpp>
@@ -271,10 +272,123 @@ flexible_type_parser::vector_parse(const char** str, size_t len) {
   return ret;
 }
 
+/*
+ * Fast paths for the common number formats, which the int and double parsers
+ * try before the spirit grammars. They accept exactly what the grammars
+ * accept, consume the same characters (including the whitespace around the
+ * number) and return false for anything else (overflows, "inf", "nan", 
+ * numbers which cannot be converted exactly...), which then goes to the 
+ * grammar. Doubles are correctly rounded, where the grammar may be off by
+ * one ulp.
+ */
+static inline bool is_parser_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static inline bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static bool fast_int_parse(const char** str, size_t len, flex_int& ret) {
+  const char* p = *str;
+  const char* end = p + len;
+  while (p != end && is_parser_space(*p)) ++p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  if (p == end || !is_digit(*p)) return false;
+  // accumulate as a negative number so that the minimum value fits
+  int64_t value = 0;
+  const int64_t min_value = std::numeric_limits<int64_t>::min();
+  for (; p != end && is_digit(*p); ++p) {
+    int digit = *p - '0';
+    if (value < (min_value + digit) / 10) return false;
+    value = value * 10 - digit;
+  }
+  if (!negative) {
+    if (value == min_value) return false;
+    value = -value;
+  }
+  while (p != end && is_parser_space(*p)) ++p;
+  ret = value;
+  *str = p;
+  return true;
+}
+
+static bool fast_double_parse(const char** str, size_t len, double& ret) {
+  // powers of 10 which are exactly representable as a double
+  static const double exact_powers_of_10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  const char* p = *str;
+  const char* end = p + len;
+  while (p != end && is_parser_space(*p)) ++p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  size_t num_digits = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  for (; p != end && is_digit(*p); ++p) {
+    has_digits = true;
+    if (mantissa == 0 && *p == '0') continue;
+    mantissa = mantissa * 10 + (*p - '0');
+    if (++num_digits > 15) return false;
+  }
+  if (p != end && *p == '.') {
+    ++p;
+    for (; p != end && is_digit(*p); ++p) {
+      has_digits = true;
+      --exponent;
+      if (mantissa == 0 && *p == '0') continue;
+      mantissa = mantissa * 10 + (*p - '0');
+      if (++num_digits > 15) return false;
+    }
+  }
+  if (!has_digits) return false;
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool negative_exponent = false;
+    if (q != end && (*q == '-' || *q == '+')) {
+      negative_exponent = (*q == '-');
+      ++q;
+    }
+    // an exponent without digits is not part of the number
+    if (q == end || !is_digit(*q)) return false;
+    int exp_value = 0;
+    for (; q != end && is_digit(*q); ++q) {
+      if (exp_value > 1000) return false;
+      exp_value = exp_value * 10 + (*q - '0');
+    }
+    exponent += negative_exponent ? -exp_value : exp_value;
+    p = q;
+  }
+  // with at most 15 digits the mantissa is exact, and a single
+  // multiplication or division by an exact power of 10 is correctly rounded
+  if (exponent < -22 || exponent > 22) return false;
+  double value = (double)mantissa;
+  if (exponent < 0) value /= exact_powers_of_10[-exponent];
+  else value *= exact_powers_of_10[exponent];
+  while (p != end && is_parser_space(*p)) ++p;
+  ret = negative ? -value : value;
+  *str = p;
+  return true;
+}
+
 std::pair<flexible_type, bool>
 flexible_type_parser::double_parse(const char** str, size_t len) {
   std::pair<flexible_type, bool> ret;
   double dblval;
+  if (fast_double_parse(str, len, dblval)) {
+    ret.first = dblval;
+    ret.second = true;
+    return ret;
+  }
   ret.second = qi::phrase_parse((*str), (*str) + len, 
                                 boost::spirit::qi::double_,
                                 qi::standard::space,
@@ -287,6 +401,11 @@ std::pair<flexible_type, bool>
 flexible_type_parser::int_parse(const char** str, size_t len) {
   std::pair<flexible_type, bool> ret;
   flex_int intval;
+  if (fast_int_parse(str, len, intval)) {
+    ret.first = intval;
+    ret.second = true;
+    return ret;
+  }
   ret.second = qi::phrase_parse((*str), (*str) + len, 
                                 boost::spirit::qi::long_,
                                 qi::standard::space,
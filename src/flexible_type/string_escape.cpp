@@ -90,8 +90,10 @@ void unescape_string(std::string& cal, char escape_char) {
   // to avoid allocating a new string, we are do this entirely in-place
   // This works because for all the escapes we have here, the output string
   // is shorter than the input.
-  size_t in = 0;
-  size_t out = 0;
+  // Nothing changes before the first escape character; most strings have none.
+  size_t in = cal.find(escape_char);
+  if (in == std::string::npos) return;
+  size_t out = in;
   while(in != cal.length()) {
     if (cal[in]  == escape_char && in + 1 < cal.size()) {
       char echar = cal[in + 1];
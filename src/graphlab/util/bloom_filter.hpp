@@ -39,12 +39,35 @@
 
 #ifndef BLOOM_FILTER_HPP
 #define BLOOM_FILTER_HPP
+#include <cstdint>
+#include <algorithm>
 #include <util/dense_bitset.hpp>
 
+namespace graphlab {
+
+namespace bloom_filter_impl {
+/**
+ * Returns the position of the probe-th bit of a key in a filter of
+ * num_bits bits, using double hashing: the two halves of the key
+ * (mixed once) give the start and the stride of the probe sequence.
+ */
+inline size_t probe_position(uint64_t key, size_t probe, size_t num_bits) {
+  uint64_t h = key * 0x9e3779b97f4a7c13ULL;
+  h ^= h >> 29;
+  uint64_t h1 = h;
+  // an odd stride visits at least 64 distinct positions when num_bits is
+  // a multiple of 64
+  uint64_t h2 = (h >> 32) | 1;
+  return (h1 + probe * h2) % num_bits;
+}
+} // namespace bloom_filter_impl
+
+} // namespace graphlab
+
 template <size_t len, size_t probes>
 class fixed_bloom_filter {
  private:
-  fixed_dense_bitset<len> bits;
+  graphlab::fixed_dense_bitset<len> bits;
  public:
   inline fixed_bloom_filter() { }
   
@@ -52,21 +75,79 @@ class fixed_bloom_filter {
     bits.clear();
   }
   
-  inline void insert(uint64_t i) {
+  inline void insert(uint64_t key) {
     for (size_t i = 0;i < probes; ++i) {
-      bits.set_bit_unsync(i % len);
-      i = i * 0x9e3779b97f4a7c13LL;
+      bits.set_bit_unsync(graphlab::bloom_filter_impl::probe_position(key, i, len));
     }
   }
   
-  inline bool may_contain(size_t i) {
+  inline bool may_contain(uint64_t key) const {
     for (size_t i = 0;i < probes; ++i) {
-      if (bits.get_bit_unsync(i % len) == false) return false;
-      i = i * 0x9e3779b97f4a7c13LL;
+      if (bits.get(graphlab::bloom_filter_impl::probe_position(key, i, len)) == false) return false;
+    }
+    return true;
+  }
+
+};
+
+namespace graphlab {
+
+/**
+ * A bloom filter over 64 bit keys (typically hashes) whose size is
+ * chosen at runtime.
+ *
+ * insert() sets its bits atomically, so a filter may be filled by
+ * several threads concurrently. may_contain() never returns false for
+ * an inserted key, and returns true for other keys with a probability
+ * which depends on the number of bits per inserted key. About 10 bits
+ * per key and 5 probes give a false positive rate near 1%.
+ */
+class bloom_filter {
+ public:
+  bloom_filter() { }
+
+  /**
+   * Creates an empty filter of (at least) num_bits bits. The size is
+   * rounded up to a multiple of 64.
+   */
+  bloom_filter(size_t num_bits, size_t num_probes) {
+    init(num_bits, num_probes);
+  }
+
+  /// Resets the filter to an empty one of (at least) num_bits bits.
+  inline void init(size_t num_bits, size_t num_probes) {
+    m_bits.resize(std::max<size_t>(64, (num_bits + 63) / 64 * 64));
+    m_bits.clear();
+    m_num_probes = num_probes;
+  }
+
+  /// Returns the number of bits in the filter
+  inline size_t size() const {
+    return m_bits.size();
+  }
+
+  /// Inserts a key. Safe to call concurrently.
+  inline void insert(uint64_t key) {
+    for (size_t i = 0;i < m_num_probes; ++i) {
+      m_bits.set_bit(bloom_filter_impl::probe_position(key, i, m_bits.size()));
+    }
+  }
+
+  /// Returns false if the key was definitely never inserted.
+  inline bool may_contain(uint64_t key) const {
+    for (size_t i = 0;i < m_num_probes; ++i) {
+      if (!m_bits.get(bloom_filter_impl::probe_position(key, i, m_bits.size()))) {
+        return false;
+      }
     }
     return true;
   }
 
+ private:
+  dense_bitset m_bits;
+  size_t m_num_probes = 0;
 };
 
+} // namespace graphlab
+
 #endif
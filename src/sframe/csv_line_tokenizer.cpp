@@ -21,6 +21,7 @@
 #include <vector>
 #include <string>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
 #include <boost/config/warning_disable.hpp>
 #include <sframe/csv_line_tokenizer.hpp>
@@ -274,6 +275,27 @@ bool csv_line_tokenizer::tokenize_line_impl(const char* str,
   // this is adaptive. It can be either " or ' as we encounter it
 
   while(keep_parsing && buf != bufend) {
+    // Inside a field, copy the run of characters up to the next one the
+    // state machine needs to look at in one go.
+    if (state != tokenizer_state::START_FIELD) {
+      const csv_scan::char_set& special_chars = 
+          state == tokenizer_state::IN_FIELD ? field_special_chars : 
+                                               quoted_field_special_chars;
+      const char* run_end = csv_scan::find_first_of(buf, bufend, special_chars);
+      if (run_end != buf) {
+        size_t run_length = run_end - buf;
+        if (field_buffer_len + run_length > field_buffer.size()) {
+          field_buffer.resize(std::max(field_buffer.size() * 2, 
+                                       field_buffer_len + run_length));
+        }
+        memcpy(&(field_buffer[field_buffer_len]), buf, run_length);
+        field_buffer_len += run_length;
+        // none of the characters copied is an escape character
+        escape_sequence = false;
+        buf = run_end;
+        continue;
+      }
+    }
     // Next character in file
     bool is_delimiter = DELIMITER_TEST();
     // since escape_sequence can only be true for one character after it is
@@ -432,6 +454,11 @@ void csv_line_tokenizer::init() {
                                    });
   delimiter_first_character = delimiter[0];
   delimiter_is_singlechar = delimiter.length() == 1;
+
+  field_special_chars = csv_scan::char_set(
+      {delimiter_first_character, comment_char, escape_char});
+  quoted_field_special_chars = csv_scan::char_set(
+      {delimiter_first_character, quote_char, escape_char});
   
 }
 
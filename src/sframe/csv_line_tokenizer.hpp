@@ -24,6 +24,7 @@
 #include <mutex>
 #include <flexible_type/flexible_type.hpp>
 #include <parallel/mutex.hpp>
+#include <sframe/csv_structural_scan.hpp>
 
 namespace graphlab {
 
@@ -293,6 +294,10 @@ struct csv_line_tokenizer {
   bool delimiter_is_space = false;
   char delimiter_first_character;
   bool delimiter_is_singlechar = false;
+  // characters which end a run of ordinary characters in an unquoted field
+  csv_scan::char_set field_special_chars;
+  // characters which end a run of ordinary characters in a quoted field
+  csv_scan::char_set quoted_field_special_chars;
 };
 } // namespace graphlab
 
@@ -0,0 +1,157 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <algorithm>
+#include <logger/assertions.hpp>
+#include <sframe/csv_structural_scan.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CSV_SCAN_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace graphlab {
+namespace csv_scan {
+
+char_set::char_set(const std::string& set_chars) {
+  ASSERT_TRUE(set_chars.length() >= 1 && set_chars.length() <= 4);
+  for (size_t i = 0; i < 4; ++i) {
+    chars[i] = i < set_chars.length() ? set_chars[i] : set_chars[0];
+    member[(unsigned char)chars[i]] = true;
+  }
+}
+
+namespace {
+
+typedef const char* (*find_first_of_fn)(const char*, const char*, const char_set&);
+
+const char* find_first_of_scalar(const char* begin, const char* end,
+                                 const char_set& set) {
+  while (begin != end && !set.contains(*begin)) ++begin;
+  return begin;
+}
+
+#ifdef CSV_SCAN_X86_KERNELS
+/*
+ * SSE2
+ */
+__attribute__((target("sse2")))
+inline int match_mask_16(const char* p, __m128i c0, __m128i c1, __m128i c2, __m128i c3) {
+  __m128i v = _mm_loadu_si128((const __m128i*)p);
+  __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, c0), _mm_cmpeq_epi8(v, c1)),
+                           _mm_or_si128(_mm_cmpeq_epi8(v, c2), _mm_cmpeq_epi8(v, c3)));
+  return _mm_movemask_epi8(m);
+}
+
+__attribute__((target("sse2")))
+const char* find_first_of_sse2(const char* begin, const char* end,
+                               const char_set& set) {
+  const __m128i c0 = _mm_set1_epi8(set.chars[0]);
+  const __m128i c1 = _mm_set1_epi8(set.chars[1]);
+  const __m128i c2 = _mm_set1_epi8(set.chars[2]);
+  const __m128i c3 = _mm_set1_epi8(set.chars[3]);
+  for (; end - begin >= 16; begin += 16) {
+    int mask = match_mask_16(begin, c0, c1, c2, c3);
+    if (mask) return begin + __builtin_ctz(mask);
+  }
+  return find_first_of_scalar(begin, end, set);
+}
+
+/*
+ * AVX2
+ */
+__attribute__((target("avx2")))
+const char* find_first_of_avx2(const char* begin, const char* end,
+                               const char_set& set) {
+  const __m256i c0 = _mm256_set1_epi8(set.chars[0]);
+  const __m256i c1 = _mm256_set1_epi8(set.chars[1]);
+  const __m256i c2 = _mm256_set1_epi8(set.chars[2]);
+  const __m256i c3 = _mm256_set1_epi8(set.chars[3]);
+  for (; end - begin >= 32; begin += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)begin);
+    __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, c0), _mm256_cmpeq_epi8(v, c1)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, c2), _mm256_cmpeq_epi8(v, c3)));
+    unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+    if (mask) return begin + __builtin_ctz(mask);
+  }
+  if (end - begin >= 16) {
+    int mask = match_mask_16(begin,
+                             _mm256_castsi256_si128(c0), _mm256_castsi256_si128(c1),
+                             _mm256_castsi256_si128(c2), _mm256_castsi256_si128(c3));
+    if (mask) return begin + __builtin_ctz(mask);
+    begin += 16;
+  }
+  return find_first_of_scalar(begin, end, set);
+}
+#endif
+
+find_first_of_fn kernel_for_level(scan_level level) {
+#ifdef CSV_SCAN_X86_KERNELS
+  if (level == scan_level::AVX2) return find_first_of_avx2;
+  if (level == scan_level::SSE2) return find_first_of_sse2;
+#endif
+  return find_first_of_scalar;
+}
+
+scan_level& active_scan_level() {
+  static scan_level level = get_max_scan_level();
+  return level;
+}
+
+find_first_of_fn& active_kernel() {
+  static find_first_of_fn kernel = kernel_for_level(active_scan_level());
+  return kernel;
+}
+} // anonymous namespace
+
+scan_level get_max_scan_level() {
+#ifdef CSV_SCAN_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return scan_level::AVX2;
+  if (__builtin_cpu_supports("sse2")) return scan_level::SSE2;
+#endif
+  return scan_level::SCALAR;
+}
+
+scan_level get_scan_level() {
+  return active_scan_level();
+}
+
+scan_level set_scan_level(scan_level level) {
+  level = std::min(level, get_max_scan_level());
+  active_scan_level() = level;
+  active_kernel() = kernel_for_level(level);
+  return level;
+}
+
+const char* scan_level_name(scan_level level) {
+  switch(level) {
+   case scan_level::AVX2:
+    return "avx2";
+   case scan_level::SSE2:
+    return "sse2";
+   default:
+    return "scalar";
+  }
+}
+
+const char* find_first_of(const char* begin, const char* end, const char_set& set) {
+  return active_kernel()(begin, end, set);
+}
+
+} // namespace csv_scan
+} // namespace graphlab
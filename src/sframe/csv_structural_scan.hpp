@@ -0,0 +1,100 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GRAPHLAB_SFRAME_CSV_STRUCTURAL_SCAN_HPP
+#define GRAPHLAB_SFRAME_CSV_STRUCTURAL_SCAN_HPP
+#include <cstddef>
+#include <string>
+
+namespace graphlab {
+
+/**
+ * Vectorized search for the structural characters of CSV text.
+ *
+ * Most of the bytes of a CSV are ordinary characters inside fields. The
+ * tokenizer and the line splitter of the parallel CSV parser use
+ * \ref find_first_of() to jump from one structural character (delimiter,
+ * quote, escape, comment or line ending) to the next, instead of running
+ * their state machines on every byte.
+ *
+ * The search compares 16 (SSE2) or 32 (AVX2) bytes at a time. The kernel is
+ * chosen at runtime from what the CPU supports, with a scalar fallback.
+ */
+namespace csv_scan {
+
+/**
+ * A set of 1 to 4 characters to search for.
+ */
+struct char_set {
+  char_set() { }
+
+  /// Constructs a set from 1 to 4 characters. Duplicates are permitted.
+  explicit char_set(const std::string& set_chars);
+
+  /// Returns true if c is in the set
+  inline bool contains(char c) const {
+    return member[(unsigned char)c];
+  }
+
+  /// The characters in the set, padded by repeating the first one
+  char chars[4] = {0, 0, 0, 0};
+  /// member[c] is true if the character c is in the set
+  bool member[256] = {false};
+};
+
+/**
+ * Returns a pointer to the first character in [begin, end) which is in set,
+ * or end if there is none.
+ */
+const char* find_first_of(const char* begin, const char* end, const char_set& set);
+
+/**
+ * The instruction sets \ref find_first_of() can use.
+ * Levels are ordered; a level implies all levels below it.
+ */
+enum class scan_level {
+  SCALAR = 0,
+  SSE2 = 1,
+  AVX2 = 2
+};
+
+/**
+ * Returns the best level supported by the current CPU. The search kernel is
+ * selected using this on first use.
+ */
+scan_level get_max_scan_level();
+
+/**
+ * Returns the level currently used by \ref find_first_of().
+ */
+scan_level get_scan_level();
+
+/**
+ * Changes the level used by \ref find_first_of(). The level is capped at
+ * \ref get_max_scan_level(), and the level actually used is returned.
+ * Intended for tests and benchmarks; not safe to call concurrently with
+ * parsing.
+ */
+scan_level set_scan_level(scan_level level);
+
+/**
+ * Returns a printable name for a level.
+ */
+const char* scan_level_name(scan_level level);
+
+} // namespace csv_scan
+} // namespace graphlab
+#endif
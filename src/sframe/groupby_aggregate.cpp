@@ -187,6 +187,9 @@ sframe groupby_aggregate(const sframe& source,
 
     container.define_group(column_numbers, group.second);
   }
+  if (container.use_typed_aggregation(num_keys, frame_with_relevant_cols.column_types())) {
+    logstream(LOG_INFO) << "Using typed group aggregation" << std::endl;
+  }
   // done. now we can begin parallel processing
 
   // shuffle the rows based on the value of the key column.
@@ -195,13 +198,16 @@ sframe groupby_aggregate(const sframe& source,
   logstream(LOG_INFO) << "Filling group container: " << std::endl;
   parallel_for (0, input_reader->num_segments(),
                 [&](size_t i) {
+                  groupby_aggregate_impl::group_aggregate_container::local_buffer
+                      buffer(container, num_keys);
                   auto iter = input_reader->begin(i);
                   auto enditer = input_reader->end(i);
                   while(iter != enditer) {
                     auto& row = *iter;
-                    container.add(row, num_keys);
+                    buffer.add(row);
                     ++iter;
                   }
+                  buffer.flush();
                 });
 
   logstream(LOG_INFO) << "Group container filled in " << ti.current_time() << std::endl;
@@ -14,9 +14,12 @@
 * You should have received a copy of the GNU Affero General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <cmath>
+#include <typeinfo>
 #include <unordered_set>
 #include <queue>
 #include <sframe/groupby_aggregate_impl.hpp>
+#include <sframe/groupby_aggregate_operators.hpp>
 #include <sframe/sarray_reader_buffer.hpp>
 #include <parallel/lambda_omp.hpp>
 #include <util/cityhash_gl.hpp>
@@ -149,6 +152,12 @@ void groupby_element::operator+=(const groupby_element& other) {
   }
 }
 
+void groupby_element::partial_finalize() {
+  if (partially_finalized) return;
+  for (auto& value: values) value->partial_finalize();
+  partially_finalized = true;
+}
+
 void groupby_element::add_element(const std::vector<flexible_type>& val,
                                   const std::vector<group_descriptor>& group_desc) const {
   for (size_t i = 0; i < group_desc.size(); ++i) {
@@ -200,6 +209,330 @@ size_t groupby_element::hash() const {
   return hash_val;
 }
 
+/****************************************************************************/
+/*                                                                          */
+/*                             typed_group_table                            */
+/*                                                                          */
+/****************************************************************************/
+/// log2 of the initial number of slots of a typed_group_table
+static const size_t TYPED_GROUP_TABLE_INITIAL_SLOTS_LOG2 = 10;
+
+typed_group_table::typed_group_table(
+    size_t num_keys,
+    const std::vector<typed_aggregate_descriptor>& aggregates)
+    : m_num_keys(num_keys) {
+  for (const auto& desc: aggregates) {
+    aggregate_state state;
+    state.desc = desc;
+    m_aggregates.push_back(std::move(state));
+  }
+  m_slots.resize(size_t(1) << TYPED_GROUP_TABLE_INITIAL_SLOTS_LOG2, 0);
+  m_slot_shift = 64 - TYPED_GROUP_TABLE_INITIAL_SLOTS_LOG2;
+}
+
+bool typed_group_table::key_equals(size_t group,
+                                   const flexible_type* key) const {
+  const flexible_type* group_key = &(m_keys[group * m_num_keys]);
+  for (size_t i = 0; i < m_num_keys; ++i) {
+    if (group_key[i].get_type() != key[i].get_type()) return false;
+    if (group_key[i].get_type() == flex_type_enum::UNDEFINED) continue;
+    else if (group_key[i] != key[i]) return false;
+  }
+  return true;
+}
+
+void typed_group_table::grow() {
+  m_slots.assign(m_slots.size() * 2, 0);
+  --m_slot_shift;
+  size_t mask = m_slots.size() - 1;
+  for (size_t group = 0; group < m_hashes.size(); ++group) {
+    size_t slot = slot_of(m_hashes[group]);
+    while (m_slots[slot] != 0) slot = (slot + 1) & mask;
+    m_slots[slot] = group + 1;
+  }
+}
+
+size_t typed_group_table::find_or_insert(const flexible_type* key,
+                                         size_t hash) {
+  size_t mask = m_slots.size() - 1;
+  size_t slot = slot_of(hash);
+  while (m_slots[slot] != 0) {
+    size_t group = m_slots[slot] - 1;
+    if (m_hashes[group] == hash && key_equals(group, key)) return group;
+    slot = (slot + 1) & mask;
+  }
+  // new group
+  size_t group = m_hashes.size();
+  m_slots[slot] = group + 1;
+  m_hashes.push_back(hash);
+  for (size_t i = 0; i < m_num_keys; ++i) m_keys.push_back(key[i]);
+  for (auto& agg: m_aggregates) {
+    switch(agg.desc.kind) {
+     case typed_aggregate_kind::COUNT:
+       agg.counts.push_back(0);
+       break;
+     case typed_aggregate_kind::SUM:
+       if (agg.desc.integer_input) agg.ints.push_back(0);
+       else agg.values.push_back(0);
+       break;
+     case typed_aggregate_kind::MIN:
+     case typed_aggregate_kind::MAX:
+       if (agg.desc.integer_input) agg.ints.push_back(0);
+       else agg.values.push_back(0);
+       agg.init.push_back(false);
+       break;
+     case typed_aggregate_kind::AVG:
+       agg.values.push_back(0);
+       agg.counts.push_back(0);
+       break;
+     case typed_aggregate_kind::VAR:
+     case typed_aggregate_kind::STDV:
+       agg.values.push_back(0);
+       agg.m2.push_back(0);
+       agg.counts.push_back(0);
+       break;
+    }
+  }
+  if (2 * m_hashes.size() > m_slots.size()) grow();
+  return group;
+}
+
+static inline flex_int typed_int_value(const flexible_type& v) {
+  return v.get_type() == flex_type_enum::INTEGER ? v.get<flex_int>() : v.to<flex_int>();
+}
+
+static inline double typed_float_value(const flexible_type& v) {
+  return v.get_type() == flex_type_enum::FLOAT ? v.get<flex_float>() : v.to<flex_float>();
+}
+
+void typed_group_table::add(const std::vector<flexible_type>& row, size_t hash) {
+  size_t group = find_or_insert(row.data(), hash);
+  for (auto& agg: m_aggregates) {
+    if (agg.desc.kind == typed_aggregate_kind::COUNT) {
+      ++agg.counts[group];
+      continue;
+    }
+    // every other aggregate skips undefined values
+    if (agg.desc.column_number >= row.size()) continue;
+    const flexible_type& v = row[agg.desc.column_number];
+    if (v.get_type() == flex_type_enum::UNDEFINED) continue;
+    switch(agg.desc.kind) {
+     case typed_aggregate_kind::SUM:
+       if (agg.desc.integer_input) agg.ints[group] += typed_int_value(v);
+       else agg.values[group] += typed_float_value(v);
+       break;
+     case typed_aggregate_kind::MIN:
+       if (agg.desc.integer_input) {
+         flex_int x = typed_int_value(v);
+         if (!agg.init[group] || agg.ints[group] > x) agg.ints[group] = x;
+       } else {
+         double x = typed_float_value(v);
+         if (!agg.init[group] || agg.values[group] > x) agg.values[group] = x;
+       }
+       agg.init[group] = true;
+       break;
+     case typed_aggregate_kind::MAX:
+       if (agg.desc.integer_input) {
+         flex_int x = typed_int_value(v);
+         if (!agg.init[group] || agg.ints[group] < x) agg.ints[group] = x;
+       } else {
+         double x = typed_float_value(v);
+         if (!agg.init[group] || agg.values[group] < x) agg.values[group] = x;
+       }
+       agg.init[group] = true;
+       break;
+     case typed_aggregate_kind::AVG: {
+       double x = typed_float_value(v);
+       size_t count = ++agg.counts[group];
+       // same recurrence as groupby_operators::average
+       agg.values[group] += (x - agg.values[group]) / double(count);
+       break;
+     }
+     case typed_aggregate_kind::VAR:
+     case typed_aggregate_kind::STDV: {
+       double x = typed_float_value(v);
+       size_t count = ++agg.counts[group];
+       double delta = x - agg.values[group];
+       agg.values[group] += delta / count;
+       agg.m2[group] += delta * (x - agg.values[group]);
+       break;
+     }
+     default:
+       break;
+    }
+  }
+}
+
+void typed_group_table::combine(const typed_group_table& other,
+                                size_t other_group) {
+  DASSERT_EQ(m_aggregates.size(), other.m_aggregates.size());
+  size_t group = find_or_insert(&(other.m_keys[other_group * m_num_keys]),
+                                other.m_hashes[other_group]);
+  // the same combinations as the combine() of the groupby_operators
+  for (size_t i = 0; i < m_aggregates.size(); ++i) {
+    aggregate_state& agg = m_aggregates[i];
+    const aggregate_state& oagg = other.m_aggregates[i];
+    size_t og = other_group;
+    switch(agg.desc.kind) {
+     case typed_aggregate_kind::COUNT:
+       agg.counts[group] += oagg.counts[og];
+       break;
+     case typed_aggregate_kind::SUM:
+       if (agg.desc.integer_input) agg.ints[group] += oagg.ints[og];
+       else agg.values[group] += oagg.values[og];
+       break;
+     case typed_aggregate_kind::MIN:
+     case typed_aggregate_kind::MAX: {
+       if (!oagg.init[og]) break;
+       bool is_min = agg.desc.kind == typed_aggregate_kind::MIN;
+       if (agg.desc.integer_input) {
+         flex_int x = oagg.ints[og];
+         if (!agg.init[group] ||
+             (is_min ? agg.ints[group] > x : agg.ints[group] < x)) {
+           agg.ints[group] = x;
+         }
+       } else {
+         double x = oagg.values[og];
+         if (!agg.init[group] ||
+             (is_min ? agg.values[group] > x : agg.values[group] < x)) {
+           agg.values[group] = x;
+         }
+       }
+       agg.init[group] = true;
+       break;
+     }
+     case typed_aggregate_kind::AVG: {
+       size_t count = agg.counts[group];
+       size_t ocount = oagg.counts[og];
+       if (ocount == 0) break;
+       agg.values[group] = (agg.values[group] * count + oagg.values[og] * ocount)
+                           / (count + ocount);
+       agg.counts[group] = count + ocount;
+       break;
+     }
+     case typed_aggregate_kind::VAR:
+     case typed_aggregate_kind::STDV: {
+       size_t count = agg.counts[group];
+       size_t ocount = oagg.counts[og];
+       if (ocount == 0) break;
+       double delta = oagg.values[og] - agg.values[group];
+       agg.values[group] = (agg.values[group] * count + oagg.values[og] * ocount)
+                           / (count + ocount);
+       agg.m2[group] += oagg.m2[og] + delta * delta * ocount * count / (count + ocount);
+       agg.counts[group] = count + ocount;
+       break;
+     }
+    }
+  }
+}
+
+void typed_group_table::clear() {
+  m_keys.clear();
+  m_hashes.clear();
+  std::fill(m_slots.begin(), m_slots.end(), 0);
+  for (auto& agg: m_aggregates) {
+    agg.ints.clear();
+    agg.values.clear();
+    agg.m2.clear();
+    agg.counts.clear();
+    agg.init.clear();
+  }
+}
+
+flexible_type typed_group_table::emit_value(const aggregate_state& agg,
+                                            size_t group) const {
+  switch(agg.desc.kind) {
+   case typed_aggregate_kind::COUNT:
+     return flexible_type(agg.counts[group]);
+   case typed_aggregate_kind::SUM:
+   case typed_aggregate_kind::MIN:
+   case typed_aggregate_kind::MAX:
+     if (agg.desc.integer_input) return flexible_type(agg.ints[group]);
+     else return flexible_type(agg.values[group]);
+   case typed_aggregate_kind::AVG:
+     return flexible_type(agg.values[group]);
+   case typed_aggregate_kind::VAR:
+   case typed_aggregate_kind::STDV: {
+     size_t count = agg.counts[group];
+     double var = count <= 1 ? 0.0 : agg.m2[group] / count;
+     if (agg.desc.kind == typed_aggregate_kind::STDV) var = std::sqrt(var);
+     return flexible_type(var);
+   }
+  }
+  return flexible_type();
+}
+
+/*
+ * Writes the state of an aggregate in the format of the save() function of
+ * the matching groupby_operators class, so that it can be loaded back by
+ * groupby_element::load().
+ */
+void typed_group_table::save_value(oarchive& oarc,
+                                   const aggregate_state& agg,
+                                   size_t group) const {
+  switch(agg.desc.kind) {
+   case typed_aggregate_kind::COUNT:
+     oarc << agg.counts[group];
+     break;
+   case typed_aggregate_kind::SUM:
+     oarc << emit_value(agg, group);
+     break;
+   case typed_aggregate_kind::MIN:
+   case typed_aggregate_kind::MAX:
+     oarc << emit_value(agg, group) << bool(agg.init[group]);
+     break;
+   case typed_aggregate_kind::AVG:
+     oarc << agg.values[group] << agg.counts[group];
+     break;
+   case typed_aggregate_kind::VAR:
+   case typed_aggregate_kind::STDV:
+     oarc << agg.counts[group] << agg.values[group] << agg.m2[group];
+     break;
+  }
+}
+
+size_t typed_group_table::write_sorted(sarray<std::string>::iterator& out) const {
+  size_t ngroups = num_groups();
+  std::vector<std::vector<flexible_type> > keys(ngroups);
+  for (size_t group = 0; group < ngroups; ++group) {
+    keys[group].assign(m_keys.begin() + group * m_num_keys,
+                       m_keys.begin() + (group + 1) * m_num_keys);
+  }
+  // the order of groupby_element::operator<
+  std::vector<size_t> order(ngroups);
+  for (size_t i = 0; i < ngroups; ++i) order[i] = i;
+  std::sort(order.begin(), order.end(),
+            [&](size_t a, size_t b) {
+              if (m_hashes[a] != m_hashes[b]) return m_hashes[a] < m_hashes[b];
+              return groupby_element::flexible_type_vector_lt(keys[a], keys[b]);
+            });
+
+  oarchive oarc;
+  for (size_t group: order) {
+    oarc << keys[group];
+    for (const auto& agg: m_aggregates) save_value(oarc, agg, group);
+    *out = std::string(oarc.buf, oarc.off);
+    ++out;
+    oarc.off = 0;
+  }
+  free(oarc.buf);
+  return ngroups;
+}
+
+void typed_group_table::emit(sframe::iterator& out) const {
+  std::vector<flexible_type> emission_vector(m_num_keys + m_aggregates.size());
+  for (size_t group = 0; group < num_groups(); ++group) {
+    for (size_t i = 0; i < m_num_keys; ++i) {
+      emission_vector[i] = m_keys[group * m_num_keys + i];
+    }
+    for (size_t i = 0; i < m_aggregates.size(); ++i) {
+      emission_vector[m_num_keys + i] = emit_value(m_aggregates[i], group);
+    }
+    *out = emission_vector;
+    ++out;
+  }
+}
+
 /****************************************************************************/
 /*                                                                          */
 /*                         group_aggregate_container                        */
@@ -222,10 +555,60 @@ void group_aggregate_container::define_group(std::vector<size_t> column_numbers,
   group_descriptors.push_back(desc);
 }
 
+bool group_aggregate_container::use_typed_aggregation(
+    size_t num_keys,
+    const std::vector<flex_type_enum>& column_types) {
+  std::vector<typed_aggregate_descriptor> descriptors;
+  for (const auto& group: group_descriptors) {
+    const group_aggregate_value& aggregator = *group.aggregator;
+    typed_aggregate_descriptor desc;
+    if (typeid(aggregator) == typeid(groupby_operators::count)) {
+      desc.kind = typed_aggregate_kind::COUNT;
+      descriptors.push_back(desc);
+      continue;
+    } else if (typeid(aggregator) == typeid(groupby_operators::sum)) {
+      desc.kind = typed_aggregate_kind::SUM;
+    } else if (typeid(aggregator) == typeid(groupby_operators::min)) {
+      desc.kind = typed_aggregate_kind::MIN;
+    } else if (typeid(aggregator) == typeid(groupby_operators::max)) {
+      desc.kind = typed_aggregate_kind::MAX;
+    } else if (typeid(aggregator) == typeid(groupby_operators::average)) {
+      desc.kind = typed_aggregate_kind::AVG;
+    } else if (typeid(aggregator) == typeid(groupby_operators::variance)) {
+      desc.kind = typed_aggregate_kind::VAR;
+    } else if (typeid(aggregator) == typeid(groupby_operators::stdv)) {
+      desc.kind = typed_aggregate_kind::STDV;
+    } else {
+      return false;
+    }
+    if (group.column_numbers.size() != 1) return false;
+    desc.column_number = group.column_numbers[0];
+    ASSERT_LT(desc.column_number, column_types.size());
+    flex_type_enum type = column_types[desc.column_number];
+    if (type != flex_type_enum::INTEGER && type != flex_type_enum::FLOAT) return false;
+    desc.integer_input = (type == flex_type_enum::INTEGER);
+    descriptors.push_back(desc);
+  }
+  typed_descriptors = descriptors;
+  typed_num_keys = num_keys;
+  typed_mode = true;
+  for (auto& segment: segments) {
+    segment.typed_elements.reset(new typed_group_table(num_keys, typed_descriptors));
+  }
+  return true;
+}
+
 void group_aggregate_container::add(const std::vector<flexible_type>& val,
                                     size_t num_keys) {
   size_t hash = groupby_element::hash_key(val, num_keys);
   size_t target_segment = hash % segments.size();
+  if (typed_mode) {
+    DASSERT_EQ(num_keys, typed_num_keys);
+    std::unique_lock<graphlab::simple_spinlock> lock(segments[target_segment].in_memory_group_lock);
+    segments[target_segment].typed_elements->add(val, hash);
+    maybe_spill_typed_segment(target_segment, lock);
+    return;
+  }
   // acquire lock on the segment
   std::unique_lock<graphlab::simple_spinlock> lock(segments[target_segment].in_memory_group_lock);
   // look for the id in the group_keys structure
@@ -244,7 +627,17 @@ void group_aggregate_container::add(const std::vector<flexible_type>& val,
                                                        (*groupby_element_vec)[i].key.size(),
                                                        val,
                                                        num_keys)) {
-      (*groupby_element_vec)[i].add_element(val, group_descriptors);
+      auto& element = (*groupby_element_vec)[i];
+      if (element.partially_finalized) {
+        // a local_buffer combined into this element already. It can no
+        // longer take elements, so combine the row in as well.
+        groupby_element single{element.key, group_descriptors};
+        single.add_element(val, group_descriptors);
+        single.partial_finalize();
+        element += single;
+      } else {
+        element.add_element(val, group_descriptors);
+      }
       found = true;
       break;
     }
@@ -263,9 +656,156 @@ void group_aggregate_container::add(const std::vector<flexible_type>& val,
   }
 }
 
+void group_aggregate_container::maybe_spill_typed_segment(
+    size_t segmentid,
+    std::unique_lock<graphlab::simple_spinlock>& lock) {
+  auto& table = segments[segmentid].typed_elements;
+  if (table->num_groups() < max_buffer_size) {
+    lock.unlock();
+    return;
+  }
+  // swap out the table and write it without holding the lock
+  std::unique_ptr<typed_group_table> local(
+      new typed_group_table(typed_num_keys, typed_descriptors));
+  local.swap(table);
+  lock.unlock();
+  write_typed_segment(segmentid, *local);
+}
+
+void group_aggregate_container::add_partial(groupby_element&& element) {
+  DASSERT_TRUE(element.partially_finalized);
+  size_t hash = element.hash();
+  size_t target_segment = hash % segments.size();
+  std::unique_lock<graphlab::simple_spinlock> lock(segments[target_segment].in_memory_group_lock);
+  auto& groupby_element_vec_ptr = segments[target_segment].elements[hash];
+  if (groupby_element_vec_ptr == NULL) groupby_element_vec_ptr = new std::vector<groupby_element>;
+  // see add() for why this is not a reference
+  auto groupby_element_vec = groupby_element_vec_ptr;
+  segments[target_segment].refctr.inc();
+  lock.unlock();
+  segments[target_segment].fine_grain_locks[hash % 128].lock();
+  bool found = false;
+  for (auto& existing: *groupby_element_vec) {
+    if (existing == element) {
+      existing.partial_finalize();
+      existing += element;
+      found = true;
+      break;
+    }
+  }
+  if (!found) groupby_element_vec->push_back(std::move(element));
+  segments[target_segment].fine_grain_locks[hash % 128].unlock();
+  segments[target_segment].refctr.dec();
+  if (segments[target_segment].elements.size() >= max_buffer_size) {
+    flush_segment(target_segment);
+  }
+}
+
+void group_aggregate_container::add_typed_partials(const typed_group_table& table) {
+  // bucket the groups by segment so that each segment is locked once
+  std::vector<std::vector<size_t> > groups_by_segment(segments.size());
+  for (size_t group = 0; group < table.num_groups(); ++group) {
+    groups_by_segment[table.group_hash(group) % segments.size()].push_back(group);
+  }
+  for (size_t segmentid = 0; segmentid < segments.size(); ++segmentid) {
+    if (groups_by_segment[segmentid].empty()) continue;
+    std::unique_lock<graphlab::simple_spinlock> lock(segments[segmentid].in_memory_group_lock);
+    for (size_t group: groups_by_segment[segmentid]) {
+      segments[segmentid].typed_elements->combine(table, group);
+    }
+    maybe_spill_typed_segment(segmentid, lock);
+  }
+}
+
+group_aggregate_container::local_buffer::local_buffer(
+    group_aggregate_container& container, size_t num_keys)
+    : m_container(container), m_num_keys(num_keys),
+      m_capacity(SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS) {
+  if (m_capacity == 0) {
+    m_bypass = true;
+  } else if (m_container.typed_mode) {
+    m_typed_elements.reset(new typed_group_table(m_num_keys,
+                                                 m_container.typed_descriptors));
+  } else {
+    size_t num_slots = 1;
+    while (num_slots < 2 * m_capacity) num_slots *= 2;
+    m_slots.resize(num_slots, 0);
+  }
+}
+
+void group_aggregate_container::local_buffer::add(const std::vector<flexible_type>& val) {
+  if (m_bypass) {
+    m_container.add(val, m_num_keys);
+    return;
+  }
+  ++m_rows_since_flush;
+  size_t hash = groupby_element::hash_key(val, m_num_keys);
+  if (m_typed_elements) {
+    m_typed_elements->add(val, hash);
+    if (m_typed_elements->num_groups() >= m_capacity) flush();
+    return;
+  }
+  size_t mask = m_slots.size() - 1;
+  size_t slot = hash & mask;
+  while (m_slots[slot] != 0) {
+    auto& element = m_elements[m_slots[slot] - 1];
+    if (element.hash() == hash &&
+        groupby_element::flexible_type_vector_equality(element.key, m_num_keys,
+                                                       val, m_num_keys)) {
+      element.add_element(val, m_container.group_descriptors);
+      return;
+    }
+    slot = (slot + 1) & mask;
+  }
+  m_elements.push_back(groupby_element{
+      std::vector<flexible_type>(val.begin(), val.begin() + m_num_keys),
+      m_container.group_descriptors});
+  m_elements.back().add_element(val, m_container.group_descriptors);
+  m_slots[slot] = m_elements.size();
+  if (m_elements.size() >= m_capacity) flush();
+}
+
+void group_aggregate_container::local_buffer::flush() {
+  size_t num_groups = 0;
+  if (m_typed_elements) {
+    num_groups = m_typed_elements->num_groups();
+    m_container.add_typed_partials(*m_typed_elements);
+    m_typed_elements->clear();
+  } else {
+    num_groups = m_elements.size();
+    for (auto& element: m_elements) {
+      element.partial_finalize();
+      m_container.add_partial(std::move(element));
+    }
+    m_elements.clear();
+    std::fill(m_slots.begin(), m_slots.end(), 0);
+  }
+  // stop buffering if a full table barely aggregated anything
+  if (num_groups >= m_capacity && m_rows_since_flush < 2 * num_groups) {
+    m_bypass = true;
+  }
+  m_rows_since_flush = 0;
+}
+
+void group_aggregate_container::write_typed_segment(size_t segmentid,
+                                                    const typed_group_table& table) {
+  if (table.num_groups() == 0) return;
+  std::unique_lock<graphlab::mutex> filelock(segments[segmentid].file_lock);
+  size_t num_written = table.write_sorted(segments[segmentid].outiter);
+  segments[segmentid].chunk_size.push_back(num_written);
+}
+
 void group_aggregate_container::flush_segment(size_t segmentid) {
   // unlock and swap out the segment.
   std::unique_lock<graphlab::simple_spinlock> lock(segments[segmentid].in_memory_group_lock);
+  if (typed_mode) {
+    std::unique_ptr<typed_group_table> local(
+        new typed_group_table(typed_num_keys, typed_descriptors));
+    local.swap(segments[segmentid].typed_elements);
+    lock.unlock();
+    write_typed_segment(segmentid, *local);
+    return;
+  }
   if (segments[segmentid].elements.size() == 0) return;
   while(segments[segmentid].refctr.value > 0) cpu_relax();
   decltype(segments[segmentid].elements) local;
@@ -291,9 +831,7 @@ void group_aggregate_container::flush_segment(size_t segmentid) {
   }
 
   for (auto& item: local_sorted) {
-    for (auto& value: item.values) {
-      value->partial_finalize();
-    }
+    item.partial_finalize();
   }
   // ok. now we can write! lock the file
   std::unique_lock<graphlab::mutex> filelock(segments[segmentid].file_lock);
@@ -310,7 +848,12 @@ void group_aggregate_container::flush_segment(size_t segmentid) {
 }
 
 void group_aggregate_container::group_and_write(sframe& out) {
-  for (size_t i = 0 ;i < segments.size(); ++i) flush_segment(i);
+  for (size_t i = 0 ;i < segments.size(); ++i) {
+    // typed segments which never spilled are written out directly by
+    // group_and_write_segment
+    if (typed_mode && segments[i].chunk_size.empty()) continue;
+    flush_segment(i);
+  }
 
   intermediate_buffer.close();
   std::shared_ptr<sarray<std::string>::reader_type> reader = std::move(intermediate_buffer.get_reader());
@@ -352,6 +895,11 @@ void group_aggregate_container::group_and_write_segment(sframe& out,
   // here is where we are going to write to
   auto outiter = out.get_output_iterator(segmentid);
 
+  if (typed_mode && segments[segmentid].chunk_size.empty()) {
+    segments[segmentid].typed_elements->emit(outiter);
+    return;
+  }
+
   // id of the chunks that still have elements.
   std::unordered_set<size_t> remaining_chunks;
 
@@ -59,6 +59,12 @@ struct groupby_element {
   /// A cache of the hash of the key
   size_t hash_val;
 
+  /**
+   * True once partial_finalize() was called on the values. No element may
+   * be added after that, but other values may still be combined in.
+   */
+  bool partially_finalized = false;
+
   groupby_element() = default;
 
   /**
@@ -148,6 +154,9 @@ struct groupby_element {
   void add_element(const std::vector<flexible_type>& val,
                    const std::vector<group_descriptor>& group_desc) const;
 
+  /// Calls partial_finalize() on all the values, unless already done
+  void partial_finalize();
+
   static size_t hash_key(const std::vector<flexible_type>& key);
 
   static size_t hash_key(const std::vector<flexible_type>& key, size_t keylen);
@@ -183,6 +192,115 @@ struct hash<graphlab::groupby_aggregate_impl::groupby_element> {
 namespace graphlab {
 namespace groupby_aggregate_impl {
 
+/**
+ * The aggregators which have a typed implementation in
+ * \ref typed_group_table.
+ */
+enum class typed_aggregate_kind { COUNT, SUM, MIN, MAX, AVG, VAR, STDV };
+
+/**
+ * A description of a group operation computed by \ref typed_group_table.
+ */
+struct typed_aggregate_descriptor {
+  typed_aggregate_kind kind;
+  /// The column to operate on. Ignored by COUNT.
+  size_t column_number = 0;
+  /// True if the column is an INTEGER column, false if it is a FLOAT column
+  bool integer_input = false;
+};
+
+/**
+ * In memory aggregation of the count, sum, min, max, avg, var and stdv
+ * aggregators over INTEGER and FLOAT columns, which neither allocates per
+ * group nor makes virtual calls per row.
+ *
+ * Groups get dense ids in order of first appearance. Their keys are stored
+ * in one flat array (num_keys values per group), and located through an
+ * open addressing table of group ids. The state of each aggregate lives in
+ * typed arrays indexed by group id.
+ *
+ * The results are identical to those of the corresponding
+ * group_aggregate_value implementations in groupby_aggregate_operators.hpp,
+ * and the groups can be written out as serialized \ref groupby_element
+ * objects, so that tables which outgrow the memory budget can be merged by
+ * the generic path.
+ */
+class typed_group_table {
+ public:
+  typed_group_table(size_t num_keys,
+                    const std::vector<typed_aggregate_descriptor>& aggregates);
+
+  /// Returns the number of groups
+  inline size_t num_groups() const {
+    return m_hashes.size();
+  }
+
+  /**
+   * Aggregates a row whose key is made of its first num_keys values.
+   * hash must be groupby_element::hash_key(row, num_keys).
+   */
+  void add(const std::vector<flexible_type>& row, size_t hash);
+
+  /**
+   * Combines a group of another table, which must have the same key columns
+   * and aggregates, into the matching group of this table.
+   */
+  void combine(const typed_group_table& other, size_t other_group);
+
+  /// Returns the key hash of a group
+  inline size_t group_hash(size_t group) const {
+    return m_hashes[group];
+  }
+
+  /// Removes all the groups
+  void clear();
+
+  /**
+   * Writes all the groups as serialized groupby_element objects, ordered by
+   * groupby_element::operator<. Returns the number of groups written.
+   */
+  size_t write_sorted(sarray<std::string>::iterator& out) const;
+
+  /// Writes all the groups as rows of keys followed by aggregated values
+  void emit(sframe::iterator& out) const;
+
+ private:
+  struct aggregate_state {
+    typed_aggregate_descriptor desc;
+    /// SUM, MIN and MAX over integers
+    std::vector<flex_int> ints;
+    /// SUM, MIN and MAX over floats, the mean for AVG and VAR
+    std::vector<double> values;
+    /// M2 for VAR
+    std::vector<double> m2;
+    /// COUNT, AVG and VAR
+    std::vector<size_t> counts;
+    /// MIN and MAX: whether a value was seen
+    std::vector<char> init;
+  };
+
+  size_t m_num_keys;
+  std::vector<aggregate_state> m_aggregates;
+  /// The keys of all the groups, num_keys values per group
+  std::vector<flexible_type> m_keys;
+  /// The key hash of each group
+  std::vector<size_t> m_hashes;
+  /// group id + 1 of the group in each slot, 0 for empty slots
+  std::vector<size_t> m_slots;
+  /// 64 - log2(m_slots.size())
+  size_t m_slot_shift;
+
+  size_t find_or_insert(const flexible_type* key, size_t hash);
+  void grow();
+  bool key_equals(size_t group, const flexible_type* key) const;
+  flexible_type emit_value(const aggregate_state& agg, size_t group) const;
+  void save_value(oarchive& oarc, const aggregate_state& agg, size_t group) const;
+
+  inline size_t slot_of(size_t hash) const {
+    return (hash * 0x9E3779B97F4A7C15ULL) >> m_slot_shift;
+  }
+};
+
 /**
  * This
  */
@@ -206,10 +324,57 @@ class group_aggregate_container {
    void define_group(std::vector<size_t> column_numbers,
                      std::shared_ptr<group_aggregate_value> aggregator);
 
+   /**
+    * Switches the container to \ref typed_group_table aggregation if all the
+    * groups are count, sum, min, max, avg, var or stdv over INTEGER or FLOAT
+    * columns. Must be called after all the groups are defined, and before
+    * any element is added. column_types are the types of the input columns.
+    * Returns true if typed aggregation is used.
+    */
+   bool use_typed_aggregation(size_t num_keys,
+                              const std::vector<flex_type_enum>& column_types);
+
    /// Add a new element to the container.
    void add(const std::vector<flexible_type>& val,
             size_t num_keys);
 
+   /**
+    * A bounded table private to one thread, which aggregates rows before
+    * they reach the shared segments of the container. Every group of the
+    * table is combined into the container when the table fills up, or when
+    * flush() is called. This keeps threads from contending on the segment
+    * locks when a few keys account for most of the rows.
+    *
+    * If the table finds little to aggregate (most groups see a single row
+    * between two flushes) it stops buffering and passes the rows straight
+    * to the container.
+    *
+    * flush() must be called once all the rows are added.
+    */
+   class local_buffer {
+    public:
+     local_buffer(group_aggregate_container& container, size_t num_keys);
+
+     /// Aggregates a row
+     void add(const std::vector<flexible_type>& val);
+
+     /// Combines all the buffered groups into the container
+     void flush();
+
+    private:
+     group_aggregate_container& m_container;
+     size_t m_num_keys;
+     size_t m_capacity;
+     bool m_bypass = false;
+     size_t m_rows_since_flush = 0;
+     /// Buffered groups of the generic path
+     std::vector<groupby_element> m_elements;
+     /// index + 1 of the element in each slot, 0 for empty slots
+     std::vector<size_t> m_slots;
+     /// Buffered groups of the typed path
+     std::unique_ptr<typed_group_table> m_typed_elements;
+   };
+
    /// Sort all elements in the container and writes to the output.
    void group_and_write(sframe& out);
   private:
@@ -217,6 +382,12 @@ class group_aggregate_container {
    /// collection of all the group operations
    std::vector<group_descriptor> group_descriptors;
 
+   /// The group operations when using typed aggregation
+   std::vector<typed_aggregate_descriptor> typed_descriptors;
+   /// The number of key columns when using typed aggregation
+   size_t typed_num_keys = 0;
+   bool typed_mode = false;
+
    struct segment_information {
      /// Locks on the elements structure
      graphlab::simple_spinlock in_memory_group_lock;
@@ -224,6 +395,8 @@ class group_aggregate_container {
      atomic<size_t> refctr;
      /// Intermediate group values
      hopscotch_map<size_t, std::vector<groupby_element>* > elements;
+     /// Intermediate group values when using typed aggregation
+     std::unique_ptr<typed_group_table> typed_elements;
 
      /// Locks on the below structures
      graphlab::mutex file_lock;
@@ -236,6 +409,25 @@ class group_aggregate_container {
    /// Writes the content into the sarray segment backend.
    void flush_segment(size_t segmentid);
 
+   /// Writes a typed table into the sarray segment backend.
+   void write_typed_segment(size_t segmentid, const typed_group_table& table);
+
+   /**
+    * Combines a partially finalized element into the matching element of
+    * its segment.
+    */
+   void add_partial(groupby_element&& element);
+
+   /// Combines all the groups of a typed table into the segment tables
+   void add_typed_partials(const typed_group_table& table);
+
+   /**
+    * Writes out the typed table of a segment if it reached the buffer size.
+    * Lock must be held on entry, and is released.
+    */
+   void maybe_spill_typed_segment(size_t segmentid,
+                                  std::unique_lock<graphlab::simple_spinlock>& lock);
+
    size_t max_buffer_size;
    std::vector<segment_information> segments;
    sarray<std::string> intermediate_buffer;
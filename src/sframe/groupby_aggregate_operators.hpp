@@ -16,8 +16,12 @@
 */
 #ifndef GRAPHLAB_SFRAME_GROUPBY_AGGREGATE_OPERATORS_HPP
 #define GRAPHLAB_SFRAME_GROUPBY_AGGREGATE_OPERATORS_HPP
+#include <cmath>
+#include <limits>
+#include <unordered_set>
 #include <sframe/group_aggregate_value.hpp>
 #include <sketches/streaming_quantile_sketch.hpp>
+#include <sketches/hyperloglog.hpp>
 namespace graphlab {
 namespace groupby_operators {
 /**
@@ -1116,6 +1120,216 @@ class select_one: public group_aggregate_value {
   flexible_type m_value;
   bool m_has_value = false;
 };
+/**
+ * Returns the value the count distinct operators count for a float: all
+ * NaNs (which hash by their bit pattern) become one canonical NaN, and -0.0
+ * becomes 0.0.
+ */
+inline flex_float canonical_distinct_float(flex_float v) {
+  if (std::isnan(v)) return std::numeric_limits<flex_float>::quiet_NaN();
+  if (v == 0) return 0;
+  return v;
+}
+
+/**
+ * Implements an aggregator that counts the number of distinct values in a
+ * group. Missing values are not counted, and all the NaNs count as one
+ * value.
+ *
+ * The distinct values of each group are kept in a hash set, so the memory
+ * used grows with the number of distinct values rather than the number of
+ * rows. See \ref approx_count_distinct for a fixed memory alternative.
+ */
+class count_distinct : public group_aggregate_value {
+ public:
+  /// Returns a new empty instance of count_distinct
+  group_aggregate_value* new_instance() const {
+    return new count_distinct;
+  }
+
+  /// Adds a value to the set of distinct values
+  void add_element_simple(const flexible_type& flex) {
+    if (flex.get_type() == flex_type_enum::FLOAT) {
+      // NaN never compares equal to itself, so it is not kept in the set
+      flex_float v = flex.get<flex_float>();
+      if (std::isnan(v)) m_has_nan = true;
+      else m_values.insert(flexible_type(canonical_distinct_float(v)));
+    } else if (flex.get_type() != flex_type_enum::UNDEFINED) {
+      m_values.insert(flex);
+    }
+  }
+
+  /// combines two partial sets of distinct values
+  void combine(const group_aggregate_value& other) {
+    const auto& v = dynamic_cast<const count_distinct&>(other);
+    m_values.insert(v.m_values.begin(), v.m_values.end());
+    m_has_nan = m_has_nan || v.m_has_nan;
+  }
+
+  /// Emits the number of distinct values
+  flexible_type emit() const {
+    return flexible_type(m_values.size() + (m_has_nan ? 1 : 0));
+  }
+
+  /// The types supported by the count distinct. Images are not hashable.
+  bool support_type(flex_type_enum type) const {
+    return type != flex_type_enum::IMAGE;
+  }
+
+  /// The input type
+  flex_type_enum set_input_type(flex_type_enum type) {
+    return flex_type_enum::INTEGER;
+  }
+
+  /// Name of the class
+  std::string name() const {
+    return "Count Distinct";
+  }
+
+  /// Serializer
+  void save(oarchive& oarc) const {
+    oarc << m_has_nan << m_values.size();
+    for (const auto& v: m_values) oarc << v;
+  }
+
+  /// Deserializer
+  void load(iarchive& iarc) {
+    size_t num_values = 0;
+    iarc >> m_has_nan >> num_values;
+    m_values.clear();
+    m_values.reserve(num_values);
+    for (size_t i = 0;i < num_values; ++i) {
+      flexible_type v;
+      iarc >> v;
+      m_values.insert(std::move(v));
+    }
+  }
+
+ private:
+  std::unordered_set<flexible_type> m_values;
+  bool m_has_nan = false;
+};
+
+/**
+ * Implements an aggregator that estimates the number of distinct values in a
+ * group with a \ref sketches::hyperloglog. Missing values are not counted,
+ * and all the NaNs count as one value.
+ *
+ * Small groups keep the sorted hashes of their values and are counted
+ * exactly. Once a group has as many hashes as would fill the sketch, they are
+ * moved into a hyperloglog with 2^HLL_BITS buckets, which bounds the memory
+ * used per group to 2^HLL_BITS bytes. The standard error of the estimate is
+ * then about 1.04 / sqrt(2^HLL_BITS), i.e. 1.6%.
+ */
+class approx_count_distinct : public group_aggregate_value {
+ public:
+  static constexpr size_t HLL_BITS = 12;
+  static constexpr size_t MAX_SPARSE_HASHES = (1 << HLL_BITS) / sizeof(size_t);
+
+  /// Returns a new empty instance of approx_count_distinct
+  group_aggregate_value* new_instance() const {
+    return new approx_count_distinct;
+  }
+
+  /// Adds a value to the sketch
+  void add_element_simple(const flexible_type& flex) {
+    if (flex.get_type() == flex_type_enum::UNDEFINED) return;
+    if (flex.get_type() == flex_type_enum::FLOAT) {
+      add_hash(flexible_type(canonical_distinct_float(flex.get<flex_float>())).hash());
+    } else {
+      add_hash(flex.hash());
+    }
+  }
+
+  /// combines two partial sketches
+  void combine(const group_aggregate_value& other) {
+    const auto& v = dynamic_cast<const approx_count_distinct&>(other);
+    if (v.m_sketch) {
+      make_dense();
+      m_sketch->combine(*v.m_sketch);
+    } else if (m_sketch) {
+      for (size_t h: v.m_hashes) m_sketch->add(h);
+    } else {
+      std::vector<size_t> merged;
+      merged.reserve(m_hashes.size() + v.m_hashes.size());
+      std::set_union(m_hashes.begin(), m_hashes.end(),
+                     v.m_hashes.begin(), v.m_hashes.end(),
+                     std::back_inserter(merged));
+      m_hashes.swap(merged);
+      if (m_hashes.size() > MAX_SPARSE_HASHES) make_dense();
+    }
+  }
+
+  /// Emits the estimated number of distinct values
+  flexible_type emit() const {
+    if (m_sketch) {
+      return flex_int(std::llround(m_sketch->estimate()));
+    } else {
+      return flex_int(m_hashes.size());
+    }
+  }
+
+  /// The types supported by the count distinct. Images are not hashable.
+  bool support_type(flex_type_enum type) const {
+    return type != flex_type_enum::IMAGE;
+  }
+
+  /// The input type
+  flex_type_enum set_input_type(flex_type_enum type) {
+    return flex_type_enum::INTEGER;
+  }
+
+  /// Name of the class
+  std::string name() const {
+    return "Approximate Count Distinct";
+  }
+
+  /// Serializer
+  void save(oarchive& oarc) const {
+    bool dense = (m_sketch != nullptr);
+    oarc << dense;
+    if (dense) oarc << *m_sketch;
+    else oarc << m_hashes;
+  }
+
+  /// Deserializer
+  void load(iarchive& iarc) {
+    bool dense = false;
+    iarc >> dense;
+    m_hashes.clear();
+    if (dense) {
+      m_sketch.reset(new sketches::hyperloglog(HLL_BITS));
+      iarc >> *m_sketch;
+    } else {
+      m_sketch.reset();
+      iarc >> m_hashes;
+    }
+  }
+
+ private:
+  /// Sorted distinct hashes, used until the group is large enough for m_sketch
+  std::vector<size_t> m_hashes;
+  std::unique_ptr<sketches::hyperloglog> m_sketch;
+
+  void add_hash(size_t h) {
+    if (m_sketch) {
+      m_sketch->add(h);
+      return;
+    }
+    auto iter = std::lower_bound(m_hashes.begin(), m_hashes.end(), h);
+    if (iter != m_hashes.end() && *iter == h) return;
+    m_hashes.insert(iter, h);
+    if (m_hashes.size() > MAX_SPARSE_HASHES) make_dense();
+  }
+
+  void make_dense() {
+    if (m_sketch) return;
+    m_sketch.reset(new sketches::hyperloglog(HLL_BITS));
+    for (size_t h: m_hashes) m_sketch->add(h);
+    m_hashes.clear();
+    m_hashes.shrink_to_fit();
+  }
+};
 } // namespace groupby_operators
 } // namespace graphlab
 #endif //GRAPHLAB_SFRAME_GROUPBY_AGGREGATE_OPERATORS_HPP
@@ -14,7 +14,15 @@
 * You should have received a copy of the GNU Affero General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <cstring>
 #include <serialization/serialization_includes.hpp>
+#include <sframe/integer_pack.hpp>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define INTEGER_PACK_X86_KERNELS
+#include <immintrin.h>
+#endif
+
 namespace graphlab {
 namespace integer_pack {
 
@@ -116,7 +124,7 @@ size_t pack_32(uint64_t* src, size_t srclen, uint32_t* out) {
 }
 
 
-void unpack_1(uint8_t* src, size_t nout_values, uint64_t* out) {
+static void unpack_1_scalar(uint8_t* src, size_t nout_values, uint64_t* out) {
   size_t n = (nout_values + 7) / 8;
   uint8_t c = (*src++);
   // the first byte, if incomplete, annoying is going to live
@@ -138,7 +146,7 @@ void unpack_1(uint8_t* src, size_t nout_values, uint64_t* out) {
 }
 
 
-void unpack_2(uint8_t* src, size_t nout_values, uint64_t* out) {
+static void unpack_2_scalar(uint8_t* src, size_t nout_values, uint64_t* out) {
   size_t n = (nout_values + 7) / 8;
   uint8_t c = (*src++);
   c >>= ((8 - 2 * (nout_values % 4)) % 8);
@@ -158,7 +166,7 @@ void unpack_2(uint8_t* src, size_t nout_values, uint64_t* out) {
 }
 
 
-void unpack_4(uint8_t* src, size_t nout_values, uint64_t* out) {
+static void unpack_4_scalar(uint8_t* src, size_t nout_values, uint64_t* out) {
   size_t n = (nout_values + 7) / 8;
   uint8_t c = (*src++);
   c >>= ((8 - 4 * (nout_values % 2)) % 8);
@@ -180,7 +188,7 @@ void unpack_4(uint8_t* src, size_t nout_values, uint64_t* out) {
 }
 
 
-void unpack_8(uint8_t* src, size_t nout_values, uint64_t* out) {
+static void unpack_8_scalar(uint8_t* src, size_t nout_values, uint64_t* out) {
   uint8_t* src_end = src + nout_values;
   while(src != src_end) {
     (*out++) = (*src++);
@@ -188,14 +196,14 @@ void unpack_8(uint8_t* src, size_t nout_values, uint64_t* out) {
 }
 
 
-void unpack_16(uint16_t* src, size_t nout_values, uint64_t* out) {
+static void unpack_16_scalar(uint16_t* src, size_t nout_values, uint64_t* out) {
   uint16_t* src_end = src + nout_values;
   while(src != src_end) {
     (*out++) = (*src++);
   }
 }
 
-void unpack_32(uint32_t* src, size_t nout_values, uint64_t* out) {
+static void unpack_32_scalar(uint32_t* src, size_t nout_values, uint64_t* out) {
   uint32_t* src_end = src + nout_values;
   while(src != src_end) {
     (*out++) = (*src++);
@@ -203,5 +211,429 @@ void unpack_32(uint32_t* src, size_t nout_values, uint64_t* out) {
 }
 
 
+static void delta_decode_scalar(uint64_t* output, size_t len) {
+  for (int i = 0;i < (int)len; ++i) {
+    // yes this will will go below 0. yes this is intentional
+    output[i] += output[i-1]; 
+  }
+}
+
+static void delta_negative_decode_scalar(uint64_t* output, size_t len) {
+  for (int i = 0;i < (int)len; ++i) {
+    output[i] = shifted_integer_decode(output[i]);
+    // yes this will will go below 0. yes this is intentional
+    output[i] += output[i-1]; 
+  }
+}
+
+
+/**************************************************************************/
+/*                                                                        */
+/*                           SIMD Kernels (x86)                           */
+/*                                                                        */
+/**************************************************************************/
+#ifdef INTEGER_PACK_X86_KERNELS
+
+/**
+ * Decodes the values in the partially filled first byte of a 1, 2 or 4
+ * bit packing (see unpack_1), advancing src and out. Returns the number of
+ * values remaining, which fill complete bytes.
+ */
+template <int BITS>
+static inline size_t unpack_head(uint8_t*& src, size_t nout_values, uint64_t*& out) {
+  constexpr size_t values_per_byte = 8 / BITS;
+  size_t head = nout_values % values_per_byte;
+  if (head) {
+    uint8_t c = (*src++) >> (8 - BITS * head);
+    for (size_t i = 0; i < head; ++i) {
+      (*out++) = c & ((1 << BITS) - 1); 
+      c >>= BITS;
+    }
+  }
+  return nout_values - head;
+}
+
+/**
+ * Spreads the 8 values packed in the next BITS bytes of src into the
+ * 8 bytes of a word, first value in the least significant byte.
+ */
+template <int BITS>
+static inline uint64_t spread_8_values(const uint8_t* src);
+
+template <>
+inline uint64_t spread_8_values<1>(const uint8_t* src) {
+  // replicate the byte, keep bit i in byte i, then normalize each byte to 0/1
+  uint64_t x = src[0] * 0x0101010101010101ULL;
+  x &= 0x8040201008040201ULL;
+  return ((x + 0x7F7F7F7F7F7F7F7FULL) >> 7) & 0x0101010101010101ULL;
+}
+
+template <>
+inline uint64_t spread_8_values<2>(const uint8_t* src) {
+  uint16_t w;
+  memcpy(&w, src, sizeof(w));
+  uint64_t x = w;
+  x = (x | (x << 24)) & 0x000000FF000000FFULL;
+  x = (x | (x << 12)) & 0x000F000F000F000FULL;
+  return (x | (x << 6)) & 0x0303030303030303ULL;
+}
+
+template <>
+inline uint64_t spread_8_values<4>(const uint8_t* src) {
+  uint32_t w;
+  memcpy(&w, src, sizeof(w));
+  uint64_t x = w;
+  x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+  x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+  return (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+/**
+ * Unpacks 1, 2 or 4 bit values. Every BITS bytes of input are 8 values,
+ * which are spread to 8 bytes and then widened to 64 bits using 
+ * Store8(word, out).
+ */
+template <int BITS, typename Store8>
+static inline void unpack_small(uint8_t* src, size_t nout_values, uint64_t* out,
+                                Store8 store8) {
+  constexpr size_t values_per_byte = 8 / BITS;
+  nout_values = unpack_head<BITS>(src, nout_values, out);
+  size_t nbytes = nout_values / values_per_byte;
+  size_t i = 0;
+  for (; i + BITS <= nbytes; i += BITS) {
+    store8(spread_8_values<BITS>(src + i), out);
+    out += 8;
+  }
+  for (; i < nbytes; ++i) {
+    uint8_t c = src[i];
+    for (size_t j = 0; j < values_per_byte; ++j) {
+      (*out++) = c & ((1 << BITS) - 1);
+      c >>= BITS;
+    }
+  }
+}
+
+/*
+ * SSE4.2
+ */
+__attribute__((target("sse4.2")))
+static inline void store8_sse(uint64_t word, uint64_t* out) {
+  __m128i v = _mm_cvtsi64_si128(word);
+  _mm_storeu_si128((__m128i*)(out), _mm_cvtepu8_epi64(v));
+  _mm_storeu_si128((__m128i*)(out + 2), _mm_cvtepu8_epi64(_mm_srli_si128(v, 2)));
+  _mm_storeu_si128((__m128i*)(out + 4), _mm_cvtepu8_epi64(_mm_srli_si128(v, 4)));
+  _mm_storeu_si128((__m128i*)(out + 6), _mm_cvtepu8_epi64(_mm_srli_si128(v, 6)));
+}
+
+__attribute__((target("sse4.2")))
+static void unpack_1_sse(uint8_t* src, size_t nout_values, uint64_t* out) {
+  unpack_small<1>(src, nout_values, out, store8_sse);
+}
+
+__attribute__((target("sse4.2")))
+static void unpack_2_sse(uint8_t* src, size_t nout_values, uint64_t* out) {
+  unpack_small<2>(src, nout_values, out, store8_sse);
+}
+
+__attribute__((target("sse4.2")))
+static void unpack_4_sse(uint8_t* src, size_t nout_values, uint64_t* out) {
+  unpack_small<4>(src, nout_values, out, store8_sse);
+}
+
+__attribute__((target("sse4.2")))
+static void unpack_8_sse(uint8_t* src, size_t nout_values, uint64_t* out) {
+  size_t i = 0;
+  for (; i + 8 <= nout_values; i += 8) {
+    uint64_t word;
+    memcpy(&word, src + i, sizeof(word));
+    store8_sse(word, out + i);
+  }
+  for (; i < nout_values; ++i) out[i] = src[i];
+}
+
+__attribute__((target("sse4.2")))
+static void unpack_16_sse(uint16_t* src, size_t nout_values, uint64_t* out) {
+  size_t i = 0;
+  for (; i + 4 <= nout_values; i += 4) {
+    __m128i v = _mm_loadl_epi64((const __m128i*)(src + i));
+    _mm_storeu_si128((__m128i*)(out + i), _mm_cvtepu16_epi64(v));
+    _mm_storeu_si128((__m128i*)(out + i + 2), 
+                     _mm_cvtepu16_epi64(_mm_srli_si128(v, 4)));
+  }
+  for (; i < nout_values; ++i) out[i] = src[i];
+}
+
+__attribute__((target("sse4.2")))
+static void unpack_32_sse(uint32_t* src, size_t nout_values, uint64_t* out) {
+  size_t i = 0;
+  for (; i + 2 <= nout_values; i += 2) {
+    __m128i v = _mm_loadl_epi64((const __m128i*)(src + i));
+    _mm_storeu_si128((__m128i*)(out + i), _mm_cvtepu32_epi64(v));
+  }
+  for (; i < nout_values; ++i) out[i] = src[i];
+}
+
+/**
+ * Prefix sum over 2 lanes at a time, optionally undoing the
+ * shifted_integer_encode() first. Like the scalar version, output[-1] 
+ * is the starting value.
+ */
+template <bool NEGATIVE>
+__attribute__((target("sse4.2")))
+static inline void delta_decode_sse_impl(uint64_t* output, size_t len) {
+  const __m128i one = _mm_set1_epi64x(1);
+  const __m128i zero = _mm_setzero_si128();
+  __m128i carry = _mm_set1_epi64x(output[-1]);
+  size_t i = 0;
+  for (; i + 2 <= len; i += 2) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(output + i));
+    if (NEGATIVE) {
+      x = _mm_xor_si128(_mm_srli_epi64(x, 1), 
+                        _mm_sub_epi64(zero, _mm_and_si128(x, one)));
+    }
+    x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+    x = _mm_add_epi64(x, carry);
+    _mm_storeu_si128((__m128i*)(output + i), x);
+    carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2));
+  }
+  if (NEGATIVE) delta_negative_decode_scalar(output + i, len - i);
+  else delta_decode_scalar(output + i, len - i);
+}
+
+__attribute__((target("sse4.2")))
+static void delta_decode_sse(uint64_t* output, size_t len) {
+  delta_decode_sse_impl<false>(output, len);
+}
+
+__attribute__((target("sse4.2")))
+static void delta_negative_decode_sse(uint64_t* output, size_t len) {
+  delta_decode_sse_impl<true>(output, len);
+}
+
+/*
+ * AVX2
+ */
+__attribute__((target("avx2")))
+static inline void store8_avx2(uint64_t word, uint64_t* out) {
+  __m128i v = _mm_cvtsi64_si128(word);
+  _mm256_storeu_si256((__m256i*)(out), _mm256_cvtepu8_epi64(v));
+  _mm256_storeu_si256((__m256i*)(out + 4), 
+                      _mm256_cvtepu8_epi64(_mm_srli_si128(v, 4)));
+}
+
+__attribute__((target("avx2")))
+static void unpack_1_avx2(uint8_t* src, size_t nout_values, uint64_t* out) {
+  unpack_small<1>(src, nout_values, out, store8_avx2);
+  _mm256_zeroupper();
+}
+
+__attribute__((target("avx2")))
+static void unpack_2_avx2(uint8_t* src, size_t nout_values, uint64_t* out) {
+  unpack_small<2>(src, nout_values, out, store8_avx2);
+  _mm256_zeroupper();
+}
+
+__attribute__((target("avx2")))
+static void unpack_4_avx2(uint8_t* src, size_t nout_values, uint64_t* out) {
+  unpack_small<4>(src, nout_values, out, store8_avx2);
+  _mm256_zeroupper();
+}
+
+__attribute__((target("avx2")))
+static void unpack_8_avx2(uint8_t* src, size_t nout_values, uint64_t* out) {
+  size_t i = 0;
+  for (; i + 8 <= nout_values; i += 8) {
+    uint64_t word;
+    memcpy(&word, src + i, sizeof(word));
+    store8_avx2(word, out + i);
+  }
+  _mm256_zeroupper();
+  for (; i < nout_values; ++i) out[i] = src[i];
+}
+
+__attribute__((target("avx2")))
+static void unpack_16_avx2(uint16_t* src, size_t nout_values, uint64_t* out) {
+  size_t i = 0;
+  for (; i + 4 <= nout_values; i += 4) {
+    __m128i v = _mm_loadl_epi64((const __m128i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu16_epi64(v));
+  }
+  _mm256_zeroupper();
+  for (; i < nout_values; ++i) out[i] = src[i];
+}
+
+__attribute__((target("avx2")))
+static void unpack_32_avx2(uint32_t* src, size_t nout_values, uint64_t* out) {
+  size_t i = 0;
+  for (; i + 4 <= nout_values; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    _mm256_storeu_si256((__m256i*)(out + i), _mm256_cvtepu32_epi64(v));
+  }
+  _mm256_zeroupper();
+  for (; i < nout_values; ++i) out[i] = src[i];
+}
+
+/**
+ * Prefix sum over 4 lanes at a time. See delta_decode_sse_impl.
+ */
+template <bool NEGATIVE>
+__attribute__((target("avx2")))
+static inline void delta_decode_avx2_impl(uint64_t* output, size_t len) {
+  const __m256i one = _mm256_set1_epi64x(1);
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i carry = _mm256_set1_epi64x(output[-1]);
+  size_t i = 0;
+  for (; i + 4 <= len; i += 4) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(output + i));
+    if (NEGATIVE) {
+      x = _mm256_xor_si256(_mm256_srli_epi64(x, 1), 
+                           _mm256_sub_epi64(zero, _mm256_and_si256(x, one)));
+    }
+    // [x0, x1, x2, x3] + [0, x0, x1, x2]
+    __m256i t = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0));
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(zero, t, 0xFC));
+    // [y0, y1, y2, y3] + [0, 0, y0, y1]
+    t = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0));
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(zero, t, 0xF0));
+    x = _mm256_add_epi64(x, carry);
+    _mm256_storeu_si256((__m256i*)(output + i), x);
+    carry = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+  }
+  // avoid the AVX to SSE transition penalty in the scalar code that follows
+  _mm256_zeroupper();
+  if (NEGATIVE) delta_negative_decode_scalar(output + i, len - i);
+  else delta_decode_scalar(output + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static void delta_decode_avx2(uint64_t* output, size_t len) {
+  delta_decode_avx2_impl<false>(output, len);
+}
+
+__attribute__((target("avx2")))
+static void delta_negative_decode_avx2(uint64_t* output, size_t len) {
+  delta_decode_avx2_impl<true>(output, len);
+}
+
+#endif // INTEGER_PACK_X86_KERNELS
+
+
+/**************************************************************************/
+/*                                                                        */
+/*                            Runtime Dispatch                            */
+/*                                                                        */
+/**************************************************************************/
+
+namespace {
+struct decode_kernels {
+  void (*unpack_1)(uint8_t*, size_t, uint64_t*);
+  void (*unpack_2)(uint8_t*, size_t, uint64_t*);
+  void (*unpack_4)(uint8_t*, size_t, uint64_t*);
+  void (*unpack_8)(uint8_t*, size_t, uint64_t*);
+  void (*unpack_16)(uint16_t*, size_t, uint64_t*);
+  void (*unpack_32)(uint32_t*, size_t, uint64_t*);
+  void (*delta_decode)(uint64_t*, size_t);
+  void (*delta_negative_decode)(uint64_t*, size_t);
+};
+
+const decode_kernels scalar_kernels = {
+  unpack_1_scalar, unpack_2_scalar, unpack_4_scalar, unpack_8_scalar,
+  unpack_16_scalar, unpack_32_scalar, 
+  delta_decode_scalar, delta_negative_decode_scalar};
+
+#ifdef INTEGER_PACK_X86_KERNELS
+const decode_kernels sse_kernels = {
+  unpack_1_sse, unpack_2_sse, unpack_4_sse, unpack_8_sse,
+  unpack_16_sse, unpack_32_sse, 
+  delta_decode_sse, delta_negative_decode_sse};
+
+const decode_kernels avx2_kernels = {
+  unpack_1_avx2, unpack_2_avx2, unpack_4_avx2, unpack_8_avx2,
+  unpack_16_avx2, unpack_32_avx2, 
+  delta_decode_avx2, delta_negative_decode_avx2};
+#endif
+
+const decode_kernels* kernels_for_level(simd_level level) {
+#ifdef INTEGER_PACK_X86_KERNELS
+  if (level == simd_level::AVX2) return &avx2_kernels;
+  if (level == simd_level::SSE42) return &sse_kernels;
+#endif
+  return &scalar_kernels;
+}
+
+simd_level& active_simd_level() {
+  static simd_level level = get_max_simd_level();
+  return level;
+}
+
+const decode_kernels*& active_kernels() {
+  static const decode_kernels* kernels = kernels_for_level(active_simd_level());
+  return kernels;
+}
+} // anonymous namespace
+
+simd_level get_max_simd_level() {
+#ifdef INTEGER_PACK_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return simd_level::AVX2;
+  if (__builtin_cpu_supports("sse4.2")) return simd_level::SSE42;
+#endif
+  return simd_level::SCALAR;
+}
+
+simd_level get_simd_level() {
+  return active_simd_level();
+}
+
+simd_level set_simd_level(simd_level level) {
+  level = std::min(level, get_max_simd_level());
+  active_simd_level() = level;
+  active_kernels() = kernels_for_level(level);
+  return level;
+}
+
+const char* simd_level_name(simd_level level) {
+  switch(level) {
+   case simd_level::AVX2:
+    return "avx2";
+   case simd_level::SSE42:
+    return "sse4.2";
+   default:
+    return "scalar";
+  }
+}
+
+void unpack_1(uint8_t* src, size_t nout_values, uint64_t* out) {
+  active_kernels()->unpack_1(src, nout_values, out);
+}
+
+void unpack_2(uint8_t* src, size_t nout_values, uint64_t* out) {
+  active_kernels()->unpack_2(src, nout_values, out);
+}
+
+void unpack_4(uint8_t* src, size_t nout_values, uint64_t* out) {
+  active_kernels()->unpack_4(src, nout_values, out);
+}
+
+void unpack_8(uint8_t* src, size_t nout_values, uint64_t* out) {
+  active_kernels()->unpack_8(src, nout_values, out);
+}
+
+void unpack_16(uint16_t* src, size_t nout_values, uint64_t* out) {
+  active_kernels()->unpack_16(src, nout_values, out);
+}
+
+void unpack_32(uint32_t* src, size_t nout_values, uint64_t* out) {
+  active_kernels()->unpack_32(src, nout_values, out);
+}
+
+void delta_decode(uint64_t* output, size_t len) {
+  active_kernels()->delta_decode(output, len);
+}
+
+void delta_negative_decode(uint64_t* output, size_t len) {
+  active_kernels()->delta_negative_decode(output, len);
+}
+
 } // namespace integer_pack
 } // namespace graphlab
@@ -186,6 +186,55 @@ void unpack_16(uint16_t* src, size_t nout_values, uint64_t* out);
 /// Unpacks a sequence of 32 bit numbers from src into output returning #bytes used.
 void unpack_32(uint32_t* src, size_t nout_values, uint64_t* out);
 
+/**
+ * In place prefix sum of a delta coded sequence. 
+ * i.e. output[i] += output[i-1] for i in [0, len). output[-1] must be valid
+ * and contain the first value of the sequence.
+ */
+void delta_decode(uint64_t* output, size_t len);
+
+/**
+ * Like \ref delta_decode() but each delta is first decoded with 
+ * \ref shifted_integer_decode(). 
+ * i.e. output[i] = shifted_integer_decode(output[i]) + output[i-1] 
+ * for i in [0, len). output[-1] must be valid.
+ */
+void delta_negative_decode(uint64_t* output, size_t len);
+
+/**
+ * The instruction sets the unpack and delta decode kernels can use.
+ * Levels are ordered; a level implies all levels below it.
+ */
+enum class simd_level {
+  SCALAR = 0,
+  SSE42 = 1,
+  AVX2 = 2
+};
+
+/**
+ * Returns the best kernel level supported by the current CPU. 
+ * The decode kernels are selected using this on first use.
+ */
+simd_level get_max_simd_level();
+
+/**
+ * Returns the kernel level currently used by the decoders.
+ */
+simd_level get_simd_level();
+
+/**
+ * Changes the kernel level used by the decoders. The level is capped at 
+ * \ref get_max_simd_level(), and the level actually used is returned.
+ * Intended for tests and benchmarks; not safe to call concurrently with
+ * decoding.
+ */
+simd_level set_simd_level(simd_level level);
+
+/**
+ * Returns a printable name for a kernel level.
+ */
+const char* simd_level_name(simd_level level);
+
 
 /**
  * Maps values [0,-1,1,-2,2,-3,3,-4,4...] to [0,1,2,3,4,5,6,...]
@@ -507,16 +556,10 @@ void frame_of_reference_decode_128(InArcType& iarc,
       output[i] += minvalue;
     }
   } else if (coding_technique == FRAME_OF_REFERENCE_DELTA) {
-    for (int i = 0;i < (int)len; ++i) {
-      // yes this will will go below 0. yes this is intentional
-      output[i] += output[i-1]; 
-    }
+    // output[-1] is the first value decoded above
+    delta_decode(output, len);
   } else if (coding_technique == FRAME_OF_REFERENCE_DELTA_NEGATIVE) {
-    for (int i = 0;i < (int)len; ++i) {
-      output[i] = shifted_integer_decode(output[i]);
-      // yes this will will go below 0. yes this is intentional
-      output[i] += output[i-1]; 
-    }
+    delta_negative_decode(output, len);
   }
 }
 
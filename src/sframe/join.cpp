@@ -18,11 +18,30 @@
 
 namespace graphlab {
 
+/**
+ * Returns true if the merge join can order the join columns. Floats are left
+ * out as NaN has no place in the order.
+ */
+static bool merge_join_supported(const sframe& sf,
+                                 const std::vector<size_t>& join_positions) {
+  if (join_positions.empty()) return false;
+  for (size_t pos: join_positions) {
+    auto type = sf.column_type(pos);
+    if (type != flex_type_enum::INTEGER &&
+        type != flex_type_enum::STRING &&
+        type != flex_type_enum::DATETIME) {
+      return false;
+    }
+  }
+  return true;
+}
+
 sframe join(sframe& sf_left, 
             sframe& sf_right,
             std::string join_type,
             const std::map<std::string,std::string> join_columns,
-            size_t max_buffer_size) {
+            size_t max_buffer_size,
+            join_sort_function sorter) {
   // ***SANITY CHECKS 
 
   // check that each sframe is valid
@@ -30,10 +49,6 @@ sframe join(sframe& sf_left,
     log_and_throw("Current SFrame has nothing to join!");
   }
 
-  if(!sf_right.num_rows() || !sf_right.num_columns()) {
-    log_and_throw("Given SFrame has nothing to join!");
-  }
-
   std::vector<size_t> left_join_positions;
   std::vector<size_t> right_join_positions;
   for(const auto &col_pair : join_columns) {
@@ -62,11 +77,86 @@ sframe join(sframe& sf_left,
     in_join_type = RIGHT_JOIN;
   } else if(join_type == "inner") {
     in_join_type = INNER_JOIN;
+  } else if(join_type == "semi") {
+    in_join_type = SEMI_JOIN;
+  } else if(join_type == "anti") {
+    in_join_type = ANTI_JOIN;
   } else {
     log_and_throw("Invalid join type given!");
   }
 
-  // execute join (perhaps multiplex algorithm based on something?)
+  // Filtering against an empty key set is fine
+  bool membership_join = (in_join_type == SEMI_JOIN || in_join_type == ANTI_JOIN);
+  if((!sf_right.num_rows() && !membership_join) || !sf_right.num_columns()) {
+    log_and_throw("Given SFrame has nothing to join!");
+  }
+
+  // Choose the algorithm by the number of cells each one reads and writes.
+  //  - The hash join reads both frames, and also builds a hash table on the
+  //    smaller one. If that does not fit in memory, GRACE partitioning first
+  //    writes out and reads back both frames: 3 passes over each.
+  //  - The merge join reads both frames once. Each frame which is not sorted
+  //    on the join keys must first be sorted, which reads, writes, reads back
+  //    and writes the sorted frame: 5 passes over it in total.
+  // So the merge join wins when both frames are sorted, or when GRACE
+  // partitioning is needed and the only unsorted frame is the smaller one.
+  // Membership joins only read the join columns of the right frame, and
+  // always build on them. They are not worth sorting for.
+  size_t left_cells = sf_left.num_rows() * sf_left.num_columns();
+  size_t right_cells = sf_right.num_rows() *
+      (membership_join ? right_join_positions.size() : sf_right.num_columns());
+  size_t build_cells = membership_join ? right_cells : std::min(left_cells, right_cells);
+  size_t hash_cost = left_cells + right_cells + build_cells;
+  if (build_cells > max_buffer_size) hash_cost = 3 * (left_cells + right_cells);
+  if (membership_join) sorter = join_sort_function();
+
+  // The merge join needs at least one frame already sorted to win, so the
+  // sort order is checked first on the frame with fewer rows, and on the
+  // other one only when the merge join can still win: when the first is
+  // sorted, or when sorting just the first can win. Checks stop at the
+  // first out of order row, and are cached by is_sorted_on.
+  if (merge_join_supported(sf_left, left_join_positions)) {
+    bool left_first = sf_left.num_rows() <= sf_right.num_rows();
+    bool left_only_can_win = sorter && left_cells + 5 * right_cells < hash_cost;
+    bool right_only_can_win = sorter && 5 * left_cells + right_cells < hash_cost;
+    bool left_sorted = false, right_sorted = false;
+    if (left_first) {
+      left_sorted = join_impl::is_sorted_on(sf_left, left_join_positions);
+      if (left_sorted || right_only_can_win) {
+        right_sorted = join_impl::is_sorted_on(sf_right, right_join_positions);
+      }
+    } else {
+      right_sorted = join_impl::is_sorted_on(sf_right, right_join_positions);
+      if (right_sorted || left_only_can_win) {
+        left_sorted = join_impl::is_sorted_on(sf_left, left_join_positions);
+      }
+    }
+    size_t merge_cost = (left_sorted ? 1 : 5) * left_cells +
+                        (right_sorted ? 1 : 5) * right_cells;
+    if ((left_sorted && right_sorted) || sorter) {
+      if (merge_cost < hash_cost) {
+        logstream(LOG_INFO) << "Using sort-merge join" << std::endl;
+        sframe sorted_left = sf_left, sorted_right = sf_right;
+        if (!left_sorted) {
+          std::vector<std::string> names;
+          for (const auto& col_pair: join_columns) names.push_back(col_pair.first);
+          sorted_left = sorter(sf_left, names);
+        }
+        if (!right_sorted) {
+          std::vector<std::string> names;
+          for (const auto& col_pair: join_columns) names.push_back(col_pair.second);
+          sorted_right = sorter(sf_right, names);
+        }
+        join_impl::merge_join_executor join_executor(sorted_left,
+                                                     sorted_right,
+                                                     left_join_positions,
+                                                     right_join_positions,
+                                                     in_join_type);
+        return join_executor.merge_join();
+      }
+    }
+  }
+
   join_impl::hash_join_executor join_executor(sf_left,
                                               sf_right,
                                               left_join_positions,
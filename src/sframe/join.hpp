@@ -17,6 +17,7 @@
 #include <string>
 #include <vector>
 #include <cstdio>
+#include <functional>
 #include <boost/algorithm/string.hpp>
 #include <sframe/sframe_constants.hpp>
 #include <sframe/sframe.hpp>
@@ -24,10 +25,31 @@
 
 namespace graphlab {
 
+/**
+ * Returns a copy of an SFrame sorted in ascending order of the given
+ * columns, with missing values first. See \ref join.
+ */
+typedef std::function<sframe(const sframe&, const std::vector<std::string>&)>
+    join_sort_function;
+
+/**
+ * Joins two SFrames on the columns given by join_columns (left column name
+ * to right column name). join_type is one of "inner", "left", "right" or
+ * "outer".
+ *
+ * Chooses between a hash join (\ref join_impl::hash_join_executor) and a
+ * sort-merge join (\ref join_impl::merge_join_executor) by estimating the
+ * number of cells each one reads and writes. The merge join is picked when
+ * both frames are already sorted on the join keys, or when sorter is
+ * provided and sorting the unsorted frames is cheaper than GRACE
+ * partitioning both frames. The sframe library has no sort of its own, so
+ * frames are never sorted without a sorter.
+ */
 sframe join(sframe& sf_left,
             sframe& sf_right,
             std::string join_type,
             const std::map<std::string,std::string> join_columns,
-            size_t max_buffer_size = SFRAME_JOIN_BUFFER_NUM_CELLS);
+            size_t max_buffer_size = SFRAME_JOIN_BUFFER_NUM_CELLS,
+            join_sort_function sorter = join_sort_function());
 
 } // end of graphlab
@@ -14,101 +14,150 @@
 * You should have received a copy of the GNU Affero General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include <sframe/join_impl.hpp>
 #include <cppipc/server/cancel_ops.hpp>
 #include <util/cityhash_gl.hpp>
 #include <sframe/sframe_constants.hpp>
+#include <parallel/lambda_omp.hpp>
+#include <parallel/pthread_tools.hpp>
 
 namespace graphlab {
 namespace join_impl {
 
 /****************** join_hash_table **********************/
-bool join_hash_table::add_row(const std::vector<flexible_type> &row) {
-
-  size_t the_hash_key = compute_hash_from_row(row, _hash_positions);
-  bool first_entry;
-
-  auto find_ret = _hash_table.find(the_hash_key);
-  if(find_ret == _hash_table.end()) {
-    // Not found, add
-    hash_join_row_t tmp;
-    tmp.rows = {row};
-    tmp.matched = false;
-    std::list<value_type> tmp_list;
-    tmp_list.push_back(std::move(tmp));
-    _hash_table.insert(std::make_pair(the_hash_key, tmp_list));
-    first_entry = true;
-  } else {
-    // Get an iterator to the list, loop to find join-key match
-    ASSERT_GT(find_ret->second.size(), 0);
-    bool matched = false;
-    auto it = find_ret->second.begin();
-    while(it != find_ret->second.end()) {
-      ASSERT_GT(it->rows.size(), 0);
-      if(join_values_equal(it->rows[0], row, _hash_positions)) {
-        it->rows.push_back(row);
-        matched = true;
-        first_entry = false;
-        break;
-      }
-      ++it;
-    }
+join_hash_table::join_hash_table(const std::vector<size_t>& hp,
+                                 size_t num_columns,
+                                 size_t num_threads)
+    : _hash_positions(hp), _num_columns(num_columns) {
+  // a few partitions per thread so that skewed partitions balance out
+  size_t target = std::max<size_t>(num_threads, 1) * 4;
+  while ((size_t(1) << _partition_bits) < target) ++_partition_bits;
+  _partitions.resize(size_t(1) << _partition_bits);
+  _pending.resize(std::max<size_t>(num_threads, 1),
+                  std::vector<pending_rows>(_partitions.size()));
+}
 
-    // If we get here, this means the join key hashed to the same value as a
-    // different join key
-    if(!matched) {
-      hash_join_row_t tmp;
-      tmp.rows = {row};
-      tmp.matched = false;
-      find_ret->second.push_back(std::move(tmp));
-      first_entry = true;
-    }
+void join_hash_table::add_rows(size_t thread_id,
+                               std::vector<std::vector<flexible_type>> &rows) {
+  DASSERT_LT(thread_id, _pending.size());
+  auto& pending = _pending[thread_id];
+  for (auto& row: rows) {
+    DASSERT_EQ(row.size(), _num_columns);
+    // remix so that the partition and slot bits do not depend on the
+    // GRACE partition the row comes from
+    size_t h = hash64(compute_hash_from_row(row, _hash_positions));
+    auto& target = pending[partition_of(h)];
+    target.hashes.push_back(h);
+    std::move(row.begin(), row.end(), std::back_inserter(target.values));
   }
-
-  return first_entry;
 }
 
-const join_hash_table::value_type& join_hash_table::get_matching_rows(
-    const std::vector<flexible_type> &row,
-    const std::vector<size_t> &hash_positions,
-    bool mark_match) {
+void join_hash_table::finalize() {
+  parallel_for(0, _partitions.size(), [&](size_t partition_id) {
+    build_partition(partition_id);
+  });
+  _pending.clear();
+}
 
-  size_t the_hash_key = compute_hash_from_row(row, hash_positions);
-  auto ret = _hash_table.find(the_hash_key);
-
-  if(ret == _hash_table.end()) {
-    // Return empty hash_join_key_t if nothing is found
-    return empty_vt;
-  } else {
-    // There's a hit on the hash! See if it is an actual match.
-    auto it = ret->second.begin();
-    while(it != ret->second.end()) {
-      if(join_values_equal(it->rows[0], row, hash_positions)) {
-        if(mark_match) {
-          it->matched = true;
+void join_hash_table::build_partition(size_t partition_id) {
+  partition& part = _partitions[partition_id];
+  size_t num_rows = 0;
+  for (auto& thread_pending: _pending) {
+    num_rows += thread_pending[partition_id].hashes.size();
+  }
+  size_t num_slots = 16;
+  while (num_slots < 2 * num_rows) num_slots *= 2;
+  part.slots.assign(num_slots, 0);
+  size_t mask = num_slots - 1;
+
+  // Pass 1: find the distinct join keys and count their rows
+  std::vector<size_t> row_entry(num_rows);
+  // the first row of each entry, used to compare join keys
+  std::vector<const flexible_type*> representative;
+  size_t row_id = 0;
+  for (auto& thread_pending: _pending) {
+    const pending_rows& rows = thread_pending[partition_id];
+    for (size_t i = 0; i < rows.hashes.size(); ++i, ++row_id) {
+      size_t h = rows.hashes[i];
+      const flexible_type* row = rows.values.data() + i * _num_columns;
+      size_t slot = h & mask;
+      while (true) {
+        size_t e = part.slots[slot];
+        if (e == 0) {
+          part.slots[slot] = part.entries.size() + 1;
+          row_entry[row_id] = part.entries.size();
+          part.entries.push_back(key_entry{h, 0, 1, false});
+          representative.push_back(row);
+          break;
         }
-        return *it;
+        key_entry& entry = part.entries[e - 1];
+        if (entry.hash == h &&
+            join_values_equal(representative[e - 1], row, _hash_positions)) {
+          row_entry[row_id] = e - 1;
+          ++entry.row_end;
+          break;
+        }
+        slot = (slot + 1) & mask;
       }
-      ++it;
     }
+  }
 
-    // If we're here, we didn't find an actual match
-    return empty_vt;
+  // Assign each key a contiguous range of the arena. row_end currently
+  // holds the row count, and becomes the insertion cursor.
+  size_t offset = 0;
+  for (auto& entry: part.entries) {
+    entry.row_begin = offset;
+    offset += entry.row_end;
+    entry.row_end = entry.row_begin;
+  }
+
+  // Pass 2: move the rows in the arena
+  part.arena.resize(num_rows * _num_columns);
+  row_id = 0;
+  for (auto& thread_pending: _pending) {
+    pending_rows& rows = thread_pending[partition_id];
+    for (size_t i = 0; i < rows.hashes.size(); ++i, ++row_id) {
+      key_entry& entry = part.entries[row_entry[row_id]];
+      std::move(rows.values.begin() + i * _num_columns,
+                rows.values.begin() + (i + 1) * _num_columns,
+                part.arena.begin() + entry.row_end * _num_columns);
+      ++entry.row_end;
+    }
+    rows = pending_rows();
   }
 }
 
-bool join_hash_table::join_values_equal(const std::vector<flexible_type> &row,
-                                        const std::vector<flexible_type> &other,
-                                        const std::vector<size_t> &hash_positions) {
-  if(hash_positions.size() == 0) {
-    if(row.size() == 0 && other.size() == 0) {
-      return true;
-    } else {
-      return false;
+row_range join_hash_table::get_matching_rows(
+    const std::vector<flexible_type> &row,
+    const std::vector<size_t> &hash_positions,
+    bool mark_match) {
+
+  size_t h = hash64(compute_hash_from_row(row, hash_positions));
+  partition& part = _partitions[partition_of(h)];
+  size_t mask = part.slots.size() - 1;
+  size_t slot = h & mask;
+  while (part.slots[slot] != 0) {
+    key_entry& entry = part.entries[part.slots[slot] - 1];
+    if (entry.hash == h &&
+        join_values_equal(part.arena.data() + entry.row_begin * _num_columns,
+                          row.data(), hash_positions)) {
+      if (mark_match && !entry.matched) entry.matched = true;
+      return get_range(part, entry);
     }
+    slot = (slot + 1) & mask;
   }
+  // Return an empty range if nothing is found
+  return row_range();
+}
 
-  ASSERT_EQ(_hash_positions.size(), hash_positions.size());
+bool join_hash_table::join_values_equal(const flexible_type* row,
+                                        const flexible_type* other,
+                                        const std::vector<size_t> &hash_positions) const {
+  DASSERT_EQ(_hash_positions.size(), hash_positions.size());
 
   for(size_t i = 0; i < hash_positions.size(); ++i) {
     if(row[_hash_positions[i]] != other[hash_positions[i]]) {
@@ -122,12 +171,9 @@ bool join_hash_table::join_values_equal(const std::vector<flexible_type> &row,
 size_t join_hash_table::num_stored_rows() {
   size_t num_rows = 0;
   size_t num_unique_join_values = 0;
-  logstream(LOG_INFO) << "Number of hash values: " << _hash_table.size() << std::endl;
-  for(auto it = _hash_table.begin(); it != _hash_table.end(); ++it) {
-    for(auto it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
-      num_unique_join_values++;
-      num_rows += it2->rows.size();
-    }
+  for(const auto& part: _partitions) {
+    num_unique_join_values += part.entries.size();
+    num_rows += part.arena.size() / std::max<size_t>(_num_columns, 1);
   }
   logstream(LOG_INFO) << "Number of unique join values: " << num_unique_join_values << std::endl;
   logstream(LOG_INFO) << "Number of stored rows: " << num_rows << std::endl;
@@ -135,29 +181,21 @@ size_t join_hash_table::num_stored_rows() {
   return num_rows;
 }
 
-std::unordered_map<size_t, std::list<join_hash_table::value_type>>::const_iterator join_hash_table::cbegin() {
-  return _hash_table.cbegin();
-}
-
-std::unordered_map<size_t, std::list<join_hash_table::value_type>>::const_iterator join_hash_table::cend() {
-  return _hash_table.cend();
-}
-
-hash_join_executor::hash_join_executor(const sframe &left,
-                                       const sframe &right,
-                                       const std::vector<size_t> &left_join_positions,
-                                       const std::vector<size_t> &right_join_positions,
-                                       join_type_t join_type,
-                                       size_t max_buffer_size) :
+join_executor::join_executor(const sframe &left,
+                             const sframe &right,
+                             const std::vector<size_t> &left_join_positions,
+                             const std::vector<size_t> &right_join_positions,
+                             join_type_t join_type,
+                             bool smaller_frame_first) :
     _left_frame(left),
     _right_frame(right),
     _left_join_positions(left_join_positions),
     _right_join_positions(right_join_positions),
-    _max_buffer_size(max_buffer_size),
     _left_join(false),
     _right_join(false),
     _reverse_output_column_order(false),
-    _frames_partitioned(false) {
+    _membership_join(join_type == SEMI_JOIN || join_type == ANTI_JOIN),
+    _anti_join(join_type == ANTI_JOIN) {
 
 
   if(join_type == LEFT_JOIN || join_type == FULL_JOIN) {
@@ -167,8 +205,21 @@ hash_join_executor::hash_join_executor(const sframe &left,
     _right_join = true;
   }
 
-  // Left should always be smaller than right
-  if(get_num_cells(right) < get_num_cells(left)) {
+  if(_membership_join) {
+    // Only the keys of the right frame are needed to test membership. The
+    // left frame streams through the probe side.
+    std::vector<std::string> key_names;
+    for(size_t pos : right_join_positions) {
+      key_names.push_back(right.column_name(pos));
+    }
+    _left_frame = right.select_columns(key_names);
+    _right_frame = left;
+    _right_join_positions = left_join_positions;
+    for(size_t i = 0; i < _left_join_positions.size(); ++i) {
+      _left_join_positions[i] = i;
+    }
+  } else if(smaller_frame_first && get_num_cells(right) < get_num_cells(left)) {
+    // Left should always be smaller than right
     _reverse_output_column_order = true;
     std::swap(_left_frame, _right_frame);
     std::swap(_left_join_positions, _right_join_positions);
@@ -189,14 +240,30 @@ hash_join_executor::hash_join_executor(const sframe &left,
   }
 }
 
-void hash_join_executor::init_result_frame(sframe &result_frame) {
+hash_join_executor::hash_join_executor(const sframe &left,
+                                       const sframe &right,
+                                       const std::vector<size_t> &left_join_positions,
+                                       const std::vector<size_t> &right_join_positions,
+                                       join_type_t join_type,
+                                       size_t max_buffer_size) :
+    join_executor(left, right, left_join_positions, right_join_positions,
+                  join_type, true),
+    _max_buffer_size(max_buffer_size),
+    _frames_partitioned(false),
+    _num_filtered_rows(0) { }
+
+void join_executor::init_result_frame(sframe &result_frame) {
   std::vector<std::string> res_column_names;
   std::vector<flex_type_enum> res_column_types;
 
   res_column_names = _left_frame.column_names();
   res_column_types = _left_frame.column_types();
+  if(_membership_join) {
+    res_column_names = _right_frame.column_names();
+    res_column_types = _right_frame.column_types();
+  }
 
-  for(size_t i = 0; i < _right_frame.num_columns(); ++i) {
+  for(size_t i = 0; i < _right_frame.num_columns() && !_membership_join; ++i) {
     // If this isn't one of the columns that's part of the join key, it
     // belongs in the result set.
     if(_right_to_left_join_positions.find(i) ==
@@ -253,7 +320,8 @@ sframe hash_join_executor::grace_hash_join() {
   logstream(LOG_INFO) << "Partitioned frames in: " << ti.current_time() << std::endl;
   this->init_result_frame(result_frame);
   ASSERT_EQ(grace_left->size(), _left_frame.size());
-  ASSERT_EQ(grace_right->size(), _right_frame.size());
+  // right rows which cannot match may have been dropped while partitioning
+  ASSERT_LE(grace_right->size(), _right_frame.size());
 
   size_t num_segments;
   std::vector<size_t> right_segment_lengths;
@@ -310,31 +378,24 @@ sframe hash_join_executor::grace_hash_join() {
             num_segments*result_frame.num_segments());
 
   // Readers for the left and right SArray used in the join
-  std::unique_ptr<sframe::reader_type> l_rdr;
-  if(_frames_partitioned) {
-    l_rdr = grace_left->get_reader();
-  } else {
-    l_rdr = grace_left->get_reader(num_segments);
-  }
+  auto l_rdr = grace_left->get_reader();
   auto r_rdr = grace_right->get_reader(logical_right_segment_sizes);
 
-  // Iterate over each segment of the left frame and add to a hash table.
-  // These segments can not be read in parallel because they are
-  // meant to represent the upper bound of the memory we can read in.
+  // Load each partition of the left frame into a hash table, and probe it
+  // with the matching partition of the right frame. The partitions can not
+  // be processed in parallel because they are meant to represent the upper
+  // bound of the memory we can read in. The rows of one partition are read
+  // and hashed in parallel instead.
   ti.start();
+  size_t left_row_begin = 0;
   for(size_t i = 0; i < num_segments; ++i) {
-    // Load the entire left partition into a hash table
-    join_hash_table cur_ht(_left_join_positions);
-    for(auto iter = l_rdr->begin(i); iter != l_rdr->end(i); ++iter) {
-      // Must unpack the row data from the serialized string it is stored as
-      std::vector<flexible_type> row;
-      if(_frames_partitioned) {
-        row = unpack_row(std::string(iter->at(0)), _left_frame.num_columns());
-      } else {
-        row = *iter;
-      }
-      cur_ht.add_row(row);
-    }
+    size_t left_row_end = _frames_partitioned ?
+        left_row_begin + grace_left->segment_length(i) : grace_left->num_rows();
+    join_hash_table cur_ht(_left_join_positions,
+                           _left_frame.num_columns(),
+                           thread::cpu_count());
+    build_hash_table(*l_rdr, left_row_begin, left_row_end, cur_ht);
+    left_row_begin = left_row_end;
 
     parallel_for(0, result_frame.num_segments(),
         [&](size_t seg_num) {
@@ -354,41 +415,81 @@ sframe hash_join_executor::grace_hash_join() {
               row = *iter;
             }
 
+            if(_membership_join) {
+              // Emit the row unchanged depending on its key being in the key set
+              bool found = cur_ht.get_matching_rows(row, _right_join_positions,
+                                                    false).num_rows > 0;
+              if(found != _anti_join) {
+                *writer = row;
+              }
+              continue;
+            }
+
             // Merge any matching rows to the corresponding left row and write
             auto query_result = cur_ht.get_matching_rows(row, _right_join_positions);
 
             // If our matching rows query returned something, then this result
             // should be in the inner join.  If it didn't, this row should only
             // be in a right join
-            if((query_result.rows.size() > 0) ||
-              ((query_result.rows.size() == 0) && _right_join)) {
+            if(query_result.num_rows > 0 || _right_join) {
               // Match found! Add to the result set
-              merge_rows_for_output(result_frame, writer, query_result.rows, {row});
+              merge_rows_for_output(result_frame, writer, query_result, &row);
             }
           }
         });
 
-    // Get an output iterator for a segment...try not to overload one segment
-    size_t seg_cntr = 0;
+    // Emit the unmatched left rows. Each output segment takes a share of
+    // the hash table partitions.
     if(_left_join) {
-      for(auto iter = cur_ht.cbegin(); iter != cur_ht.cend(); ++iter) {
-        for(auto iter2 = iter->second.begin(); iter2 != iter->second.end(); ++iter2) {
-          if(!iter2->matched) {
-            auto result_writer =
-              result_output_iterators[seg_cntr % result_frame.num_segments()];
-            merge_rows_for_output(result_frame,
-                result_writer,
-                {iter2->rows},
-                std::vector<std::vector<flexible_type>>());
-          }
-        }
-      }
+      parallel_for(0, result_frame.num_segments(),
+          [&](size_t seg_num) {
+            auto result_writer = result_output_iterators[seg_num];
+            for(size_t p = seg_num; p < cur_ht.num_partitions();
+                p += result_frame.num_segments()) {
+              cur_ht.for_each_unmatched(p,
+                  [&](const row_range& rows) {
+                    merge_rows_for_output(result_frame, result_writer, rows, nullptr);
+                  });
+            }
+          });
     }
   }
   logstream(LOG_INFO) << "Hash join time: " << ti.current_time() << std::endl;
 
-  result_frame.close();
+  sframe ret = finalize_result_frame(result_frame);
   logstream(LOG_INFO) << "Full join time: " << full_ti.current_time() << std::endl;
+  return ret;
+}
+
+void hash_join_executor::build_hash_table(sframe::reader_type& rdr,
+                                          size_t row_begin,
+                                          size_t row_end,
+                                          join_hash_table& ht) {
+  const size_t READ_BATCH_SIZE = 4096;
+  size_t num_threads = thread::cpu_count();
+  size_t num_rows = row_end - row_begin;
+  parallel_for(0, num_threads, [&](size_t thread_id) {
+    size_t begin = row_begin + num_rows * thread_id / num_threads;
+    size_t end = row_begin + num_rows * (thread_id + 1) / num_threads;
+    std::vector<std::vector<flexible_type>> rows;
+    while (begin < end) {
+      size_t batch_end = std::min(begin + READ_BATCH_SIZE, end);
+      rdr.read_rows(begin, batch_end, rows);
+      // Must unpack the row data from the serialized string it is stored as
+      if(_frames_partitioned) {
+        for (auto& row: rows) {
+          row = unpack_row(std::string(row[0]), _left_frame.num_columns());
+        }
+      }
+      ht.add_rows(thread_id, rows);
+      begin = batch_end;
+    }
+  });
+  ht.finalize();
+}
+
+sframe join_executor::finalize_result_frame(sframe &result_frame) {
+  result_frame.close();
 
   // If we swapped the join order for performance reasons, we need to make the
   // columns appear in the order the user was expecting.  This code does this.
@@ -445,90 +546,47 @@ sframe hash_join_executor::grace_hash_join() {
   return result_frame;
 }
 
-void hash_join_executor::merge_rows_for_output(sframe &result_frame,
+void join_executor::merge_rows_for_output(sframe &result_frame,
                                                sframe::iterator result_iter,
-                                               const std::vector<std::vector<flexible_type>> &left_rows,
-                                               const std::vector<std::vector<flexible_type>> &right_rows) {
-  // Size of cross product of left and right rows
-  size_t num_emitted_rows = left_rows.size() * right_rows.size();
-  if(num_emitted_rows == 0) {
-    if(left_rows.size() == 0 && right_rows.size() == 0) {
-      return;
-    } else {
-      // For special case of one empty vector
-      num_emitted_rows = std::max(left_rows.size(), right_rows.size());
-    }
-  }
+                                               const row_range &left_rows,
+                                               const std::vector<flexible_type> *right_row) {
+  if(left_rows.num_rows == 0 && right_row == nullptr) return;
 
   // Initialize the values as missing (or NULL)
-  std::vector<std::vector<flexible_type>> rows_to_emit
-    (num_emitted_rows, std::vector<flexible_type>(result_frame.num_columns(),
-                                                  flex_undefined()));
-
-  // The result from these two separate loops are basically what a nested for
-  // loop would've output if both vectors are non-empty.  The advantage of
-  // coding it this way is that if the rows_to_emit structure is initialized
-  // with NULLs, a left-join or right-join can be performed if one of the
-  // passed in vectors is empty.
-  if(left_rows.size()) {
-    // To acheive a cross product of left and right, we must repeat the left
-    // rows this many times
-    size_t left_repeats = num_emitted_rows / left_rows.size();
-    size_t i = 0;
-    for(auto l_iter = left_rows.begin();
-        l_iter != left_rows.end();
-        ++l_iter, ++i) {
-      for(size_t j = 0; j < left_repeats; ++j) {
-        std::copy(l_iter->begin(), l_iter->end(), rows_to_emit[i].begin());
-      }
-    }
-    ASSERT_EQ(i, rows_to_emit.size());
-  }
-
-  if(right_rows.size()) {
-    size_t right_repeats = num_emitted_rows / right_rows.size();
-    ASSERT_GE(right_rows[0].size(), _right_join_positions.size());
-
-    // This is the number of values in the output frame that appear from
-    // columns in the right frame.
-    size_t num_values = right_rows[0].size() - _right_join_positions.size();
-
-    size_t row_cntr = 0;
-    for(size_t i = 0; i < right_repeats; ++i) {
-      for(auto r_iter = right_rows.begin();
-          r_iter != right_rows.end();
-          ++r_iter, ++row_cntr) {
-
-        // Where we are in the current row to emit
-        auto row_iter = rows_to_emit[row_cntr].end()-num_values;
-
-        // Iterate through each value of this row
-        for(size_t j = 0; j < r_iter->size(); ++j) {
-          // This isn't a join position, copy into result
-          auto find_ret = _right_to_left_join_positions.find(j);
-          if(find_ret == _right_to_left_join_positions.end()) {
-            *row_iter = (*r_iter)[j];
-            ++row_iter;
-          } else {
-            // Special case for right join...we want this data from the right
-            if(!left_rows.size()) {
-              rows_to_emit[row_cntr][find_ret->second] = (*r_iter)[j];
-            }
-          }
-        }
+  std::vector<flexible_type> row_to_emit(result_frame.num_columns(),
+                                         flex_undefined());
+
+  // The values in the output frame which come from the right frame go after
+  // the columns of the left frame. When there are no left rows, the join
+  // columns come from the right row.
+  if(right_row != nullptr) {
+    ASSERT_GE(right_row->size(), _right_join_positions.size());
+    size_t num_values = right_row->size() - _right_join_positions.size();
+    auto row_iter = row_to_emit.end() - num_values;
+    for(size_t j = 0; j < right_row->size(); ++j) {
+      auto find_ret = _right_to_left_join_positions.find(j);
+      if(find_ret == _right_to_left_join_positions.end()) {
+        *row_iter = (*right_row)[j];
+        ++row_iter;
+      } else if(left_rows.num_rows == 0) {
+        row_to_emit[find_ret->second] = (*right_row)[j];
       }
     }
-
-    ASSERT_EQ(row_cntr, rows_to_emit.size());
   }
 
   // Emit our rows to the iterator!
-  for(auto iter = rows_to_emit.begin(); iter != rows_to_emit.end(); ++iter) {
-    *result_iter = *iter;
+  if(left_rows.num_rows == 0) {
+    *result_iter = row_to_emit;
+    return;
+  }
+  for(size_t i = 0; i < left_rows.num_rows; ++i) {
+    const flexible_type* left_row = left_rows.row(i);
+    std::copy(left_row, left_row + left_rows.num_columns, row_to_emit.begin());
+    *result_iter = row_to_emit;
   }
 }
 
-size_t hash_join_executor::get_num_cells(const sframe &sf) {
+size_t join_executor::get_num_cells(const sframe &sf) {
   return (sf.num_rows() * sf.num_columns());
 }
 
@@ -549,10 +607,42 @@ std::pair<std::shared_ptr<sframe>,std::shared_ptr<sframe>> hash_join_executor::g
   logstream(LOG_INFO) << "Chose " << num_partitions <<
     " partitions for GRACE hash join\n";
 
+  // Right rows without a match are only needed when they are emitted
+  // unmatched. Otherwise a bloom filter of the left join keys built while
+  // partitioning the left frame drops most of them before they are written
+  // out.
+  // ~10 bits per key and 5 probes give a ~1% false positive rate. The
+  // filter may use up to 1/8 of the memory budget of the join
+  // (_max_buffer_size cells), so with many keys it gets fewer bits per key,
+  // and fewer probes to match. Below 2 bits per key it drops too few rows
+  // to be worth it.
+  const size_t BLOOM_FILTER_BITS_PER_KEY = 10;
+  const size_t BLOOM_FILTER_MAX_PROBES = 5;
+  size_t num_keys = _left_frame.num_rows();
+  size_t filter_bits = std::min(BLOOM_FILTER_BITS_PER_KEY * num_keys,
+                                _max_buffer_size * sizeof(flexible_type));
+  size_t bits_per_key = num_keys > 0 ? filter_bits / num_keys : 0;
+  bloom_filter key_filter;
+  bool use_filter = num_partitions > 1 && !_right_join && !_anti_join &&
+                    bits_per_key >= 2;
+  if (use_filter) {
+    // k = ln(2) * bits per key minimizes the false positive rate
+    size_t num_probes = std::max<size_t>(1, std::min(BLOOM_FILTER_MAX_PROBES,
+                                                     bits_per_key * 69 / 100));
+    key_filter.init(filter_bits, num_probes);
+  }
+
   // Hash join columns into separate partitions
   // (each partition is a segment of an SFrame)
-  auto parted_left_frame = grace_partition_frame(_left_frame, _left_join_positions, num_partitions);
-  auto parted_right_frame = grace_partition_frame(_right_frame, _right_join_positions, num_partitions);
+  auto parted_left_frame = grace_partition_frame(_left_frame, _left_join_positions, num_partitions,
+                                                 use_filter ? &key_filter : NULL, NULL);
+  auto parted_right_frame = grace_partition_frame(_right_frame, _right_join_positions, num_partitions,
+                                                  NULL, use_filter ? &key_filter : NULL);
+  _num_filtered_rows = _right_frame.num_rows() - parted_right_frame->num_rows();
+  if (use_filter) {
+    logstream(LOG_INFO) << "Bloom filter dropped " << _num_filtered_rows
+                        << " of " << _right_frame.num_rows() << " right rows\n";
+  }
 
   return std::make_pair(parted_left_frame, parted_right_frame);
 }
@@ -560,7 +650,9 @@ std::pair<std::shared_ptr<sframe>,std::shared_ptr<sframe>> hash_join_executor::g
 std::shared_ptr<sframe> hash_join_executor::grace_partition_frame(
     const sframe &sf,
     const std::vector<size_t> &join_col_nums,
-    size_t num_partitions) {
+    size_t num_partitions,
+    bloom_filter* build_filter,
+    const bloom_filter* probe_filter) {
   //TODO: for now
   log_func_entry();
   // We don't need to partition if only 1 is needed
@@ -590,6 +682,8 @@ std::shared_ptr<sframe> hash_join_executor::grace_partition_frame(
     for(auto j = rdr->begin(seg_num); j != rdr->end(seg_num); ++j) {
       // Hash the given columns
       size_t hash_val = compute_hash_from_row(*j, join_col_nums);
+      if (build_filter) build_filter->insert(hash_val);
+      if (probe_filter && !probe_filter->may_contain(hash_val)) continue;
       size_t which_partition = hash_val % num_partitions;
 
       // Serialize the row
@@ -615,6 +709,272 @@ std::shared_ptr<sframe> hash_join_executor::grace_partition_frame(
   return parted_array;
 }
 
+/****************** merge_join_executor **********************/
+merge_join_executor::merge_join_executor(const sframe &left,
+                                         const sframe &right,
+                                         const std::vector<size_t> &left_join_positions,
+                                         const std::vector<size_t> &right_join_positions,
+                                         join_type_t join_type) :
+    join_executor(left, right, left_join_positions, right_join_positions,
+                  join_type, false) { }
+
+size_t merge_join_executor::lower_bound(sframe::reader_type &key_rdr,
+                                        size_t num_rows,
+                                        const flexible_type* key_row,
+                                        const std::vector<size_t> &key_positions) {
+  std::vector<size_t> positions(key_positions.size());
+  for (size_t i = 0; i < positions.size(); ++i) positions[i] = i;
+  std::vector<std::vector<flexible_type>> rows;
+  size_t begin = 0, end = num_rows;
+  while (begin < end) {
+    size_t mid = begin + (end - begin) / 2;
+    key_rdr.read_rows(mid, mid + 1, rows);
+    ASSERT_EQ(rows.size(), 1);
+    if (compare_join_keys(rows[0].data(), positions,
+                          key_row, key_positions) < 0) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+sframe merge_join_executor::merge_join() {
+  timer ti;
+  sframe result_frame;
+  this->init_result_frame(result_frame);
+  size_t num_ranges = result_frame.num_segments();
+
+  // Split the frames into key ranges, one per output segment. The split
+  // points are the first rows of the keys found at evenly spaced rows of the
+  // left frame, so that no key straddles two ranges.
+  std::vector<std::string> left_key_names, right_key_names;
+  for (size_t i = 0; i < _left_join_positions.size(); ++i) {
+    left_key_names.push_back(_left_frame.column_name(_left_join_positions[i]));
+    right_key_names.push_back(_right_frame.column_name(_right_join_positions[i]));
+  }
+  auto left_key_rdr = _left_frame.select_columns(left_key_names).get_reader();
+  auto right_key_rdr = _right_frame.select_columns(right_key_names).get_reader();
+  size_t left_rows = _left_frame.num_rows();
+  size_t right_rows = _right_frame.num_rows();
+  std::vector<size_t> left_splits{0}, right_splits{0};
+  std::vector<size_t> key_positions(_left_join_positions.size());
+  for (size_t i = 0; i < key_positions.size(); ++i) key_positions[i] = i;
+  std::vector<std::vector<flexible_type>> key;
+  for (size_t t = 1; t < num_ranges; ++t) {
+    size_t row = left_rows * t / num_ranges;
+    if (row <= left_splits.back()) {
+      left_splits.push_back(left_splits.back());
+      right_splits.push_back(right_splits.back());
+      continue;
+    }
+    left_key_rdr->read_rows(row, row + 1, key);
+    ASSERT_EQ(key.size(), 1);
+    left_splits.push_back(lower_bound(*left_key_rdr, left_rows,
+                                      key[0].data(), key_positions));
+    right_splits.push_back(lower_bound(*right_key_rdr, right_rows,
+                                       key[0].data(), key_positions));
+  }
+  left_splits.push_back(left_rows);
+  right_splits.push_back(right_rows);
+
+  std::vector<size_t> left_lengths, right_lengths;
+  for (size_t t = 0; t < num_ranges; ++t) {
+    left_lengths.push_back(left_splits[t + 1] - left_splits[t]);
+    right_lengths.push_back(right_splits[t + 1] - right_splits[t]);
+  }
+  auto l_rdr = _left_frame.get_reader(left_lengths);
+  auto r_rdr = _right_frame.get_reader(right_lengths);
+  logstream(LOG_INFO) << "Merge join range split time: " << ti.current_time() << std::endl;
+
+  parallel_for(0, num_ranges, [&](size_t t) {
+    merge_range(result_frame, result_frame.get_output_iterator(t),
+                *l_rdr, *r_rdr, t);
+  });
+  logstream(LOG_INFO) << "Merge join time: " << ti.current_time() << std::endl;
+
+  return finalize_result_frame(result_frame);
+}
+
+void merge_join_executor::merge_range(sframe &result_frame,
+                                      sframe::iterator result_iter,
+                                      sframe::reader_type &left_rdr,
+                                      sframe::reader_type &right_rdr,
+                                      size_t segment) {
+  auto l_iter = left_rdr.begin(segment);
+  auto l_end = left_rdr.end(segment);
+  auto r_iter = right_rdr.begin(segment);
+  auto r_end = right_rdr.end(segment);
+  size_t num_left_columns = _left_frame.num_columns();
+  // The left rows sharing the current join key
+  std::vector<flexible_type> run;
+  row_range run_rows;
+  run_rows.num_columns = num_left_columns;
+
+  while (l_iter != l_end || r_iter != r_end) {
+    int cmp;
+    if (l_iter == l_end) {
+      cmp = 1;
+    } else if (r_iter == r_end) {
+      cmp = -1;
+    } else {
+      cmp = compare_join_keys((*l_iter).data(), _left_join_positions,
+                              (*r_iter).data(), _right_join_positions);
+    }
+
+    if (_membership_join) {
+      // the left frame is the sorted key set. Emit the rows of the right
+      // frame depending on their key being in it.
+      if (cmp < 0) {
+        ++l_iter;
+      } else {
+        if ((cmp == 0) != _anti_join) *result_iter = *r_iter;
+        ++r_iter;
+      }
+      continue;
+    }
+
+    if (cmp < 0) {
+      // a left row without match
+      if (_left_join) {
+        run.assign((*l_iter).begin(), (*l_iter).end());
+        run_rows.data = run.data();
+        run_rows.num_rows = 1;
+        merge_rows_for_output(result_frame, result_iter, run_rows, nullptr);
+      }
+      ++l_iter;
+    } else if (cmp > 0) {
+      // a right row without match
+      if (_right_join) {
+        merge_rows_for_output(result_frame, result_iter, row_range(), &(*r_iter));
+      }
+      ++r_iter;
+    } else {
+      // Gather the left rows of this join key, and join them with each right
+      // row of the same key.
+      run.clear();
+      run_rows.num_rows = 0;
+      do {
+        run.insert(run.end(), (*l_iter).begin(), (*l_iter).end());
+        ++run_rows.num_rows;
+        ++l_iter;
+      } while (l_iter != l_end &&
+               compare_join_keys((*l_iter).data(), _left_join_positions,
+                                 run.data(), _left_join_positions) == 0);
+      run_rows.data = run.data();
+      do {
+        merge_rows_for_output(result_frame, result_iter, run_rows, &(*r_iter));
+        ++r_iter;
+      } while (r_iter != r_end &&
+               compare_join_keys(run.data(), _left_join_positions,
+                                 (*r_iter).data(), _right_join_positions) == 0);
+    }
+  }
+}
+
+int compare_join_keys(const flexible_type* row,
+                      const std::vector<size_t> &positions,
+                      const flexible_type* other,
+                      const std::vector<size_t> &other_positions) {
+  DASSERT_EQ(positions.size(), other_positions.size());
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const flexible_type& a = row[positions[i]];
+    const flexible_type& b = other[other_positions[i]];
+    bool a_missing = (a.get_type() == flex_type_enum::UNDEFINED);
+    bool b_missing = (b.get_type() == flex_type_enum::UNDEFINED);
+    if (a_missing || b_missing) {
+      if (a_missing != b_missing) return a_missing ? -1 : 1;
+    } else if (a < b) {
+      return -1;
+    } else if (b < a) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+namespace {
+/**
+ * Results of is_sorted_on, keyed by the segment files of the key columns.
+ * Segment files are never rewritten, so a result stays valid as long as
+ * the files exist.
+ */
+graphlab::mutex sorted_cache_lock;
+std::map<std::string, bool> sorted_cache;
+const size_t MAX_SORTED_CACHE_SIZE = 1024;
+
+std::string sorted_cache_key(const sframe &sf, const std::vector<size_t> &positions) {
+  std::stringstream strm;
+  for (size_t pos: positions) {
+    auto info = sf.select_column(pos)->get_index_info();
+    for (size_t i = 0; i < info.segment_files.size(); ++i) {
+      strm << info.segment_files[i] << "#" << info.segment_sizes[i] << ";";
+    }
+    strm << "|";
+  }
+  return strm.str();
+}
+} // anonymous namespace
+
+bool is_sorted_on(const sframe &sf, const std::vector<size_t> &positions) {
+  if (sf.num_rows() < 2) return true;
+  std::string cache_key = sorted_cache_key(sf, positions);
+  {
+    std::lock_guard<graphlab::mutex> guard(sorted_cache_lock);
+    auto iter = sorted_cache.find(cache_key);
+    if (iter != sorted_cache.end()) return iter->second;
+  }
+  bool ret = check_sorted_on(sf, positions);
+  std::lock_guard<graphlab::mutex> guard(sorted_cache_lock);
+  if (sorted_cache.size() >= MAX_SORTED_CACHE_SIZE) sorted_cache.clear();
+  sorted_cache[cache_key] = ret;
+  return ret;
+}
+
+bool check_sorted_on(const sframe &sf, const std::vector<size_t> &positions) {
+  std::vector<std::string> key_names;
+  std::vector<size_t> key_positions;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    key_names.push_back(sf.column_name(positions[i]));
+    key_positions.push_back(i);
+  }
+  auto rdr = sf.select_columns(key_names).get_reader(thread::cpu_count());
+  size_t num_segments = rdr->num_segments();
+  std::vector<std::vector<flexible_type>> first_rows(num_segments);
+  std::vector<std::vector<flexible_type>> last_rows(num_segments);
+  std::atomic<bool> sorted(true);
+
+  parallel_for(0, num_segments, [&](size_t seg) {
+    std::vector<flexible_type>& prev = last_rows[seg];
+    for (auto iter = rdr->begin(seg); iter != rdr->end(seg); ++iter) {
+      if (!sorted.load(std::memory_order_relaxed)) return;
+      if (prev.empty()) {
+        first_rows[seg] = *iter;
+      } else if (compare_join_keys(prev.data(), key_positions,
+                                   (*iter).data(), key_positions) > 0) {
+        sorted = false;
+        return;
+      }
+      prev = *iter;
+    }
+  });
+  if (!sorted) return false;
+
+  // check across the segment boundaries
+  const std::vector<flexible_type>* prev = nullptr;
+  for (size_t seg = 0; seg < num_segments; ++seg) {
+    if (last_rows[seg].empty()) continue;
+    if (prev != nullptr &&
+        compare_join_keys(prev->data(), key_positions,
+                          first_rows[seg].data(), key_positions) > 0) {
+      return false;
+    }
+    prev = &last_rows[seg];
+  }
+  return true;
+}
+
 size_t compute_hash_from_row(const std::vector<flexible_type> &row,
                              const std::vector<size_t> &positions) {
   size_t ret = 0;
@@ -19,9 +19,16 @@
 #include <unordered_map>
 
 #include <sframe/sframe.hpp>
+#include <graphlab/util/bloom_filter.hpp>
 
 //TODO: What happens if a join key (or part of one) is NULL?
-enum join_type_t {INNER_JOIN = 0, LEFT_JOIN, RIGHT_JOIN, FULL_JOIN};
+/**
+ * SEMI_JOIN keeps the rows of the left frame whose join keys appear in the
+ * right frame, and ANTI_JOIN the ones whose keys do not. Both emit each left
+ * row at most once and unchanged, without any column of the right frame.
+ */
+enum join_type_t {INNER_JOIN = 0, LEFT_JOIN, RIGHT_JOIN, FULL_JOIN,
+                  SEMI_JOIN, ANTI_JOIN};
 
 namespace graphlab {
 namespace join_impl {
@@ -30,108 +37,279 @@ size_t hash_key(const std::vector<flexible_type>& key);
 size_t compute_hash_from_row(const std::vector<flexible_type> &row,
                              const std::vector<size_t> &positions);
 
-typedef struct {
-  std::vector<std::vector<flexible_type>> rows;
-  bool matched;
-} hash_join_row_t;
+/**
+ * A run of rows stored contiguously, such as the rows of a join key in a
+ * \ref join_hash_table. Row i is the num_columns values starting at row(i).
+ */
+struct row_range {
+  const flexible_type* data = nullptr;
+  size_t num_rows = 0;
+  size_t num_columns = 0;
+
+  inline const flexible_type* row(size_t i) const {
+    return data + i * num_columns;
+  }
+};
+
+/**
+ * Compares the join keys of two rows. Missing values sort before all other
+ * values, the same as in an ascending sort. Returns a negative number, 0 or a
+ * positive number if row's keys are respectively less than, equal to, or
+ * greater than other's keys.
+ */
+int compare_join_keys(const flexible_type* row,
+                      const std::vector<size_t> &positions,
+                      const flexible_type* other,
+                      const std::vector<size_t> &other_positions);
+
+/**
+ * Returns true if the rows of the SFrame are sorted in ascending order of
+ * the columns at the given positions (in order), as compared by
+ * compare_join_keys. Only reads the key columns, and stops at the first
+ * out of order row. The result is cached by the segment files of the key
+ * columns, so joining the same columns again does not read them again.
+ */
+bool is_sorted_on(const sframe &sf, const std::vector<size_t> &positions);
+
+/**
+ * Uncached implementation of is_sorted_on, for an SFrame of 2 rows or more.
+ */
+bool check_sorted_on(const sframe &sf, const std::vector<size_t> &positions);
 
 /**
  * This class is the keeper of an in-memory hash table for use in a join
  * algorithm. Its methods facilatate hashing by given join keys by taking
  * a vector of positions these keys are in a row.
  *
- * NOTE:Could be templated for hash_type, row_type, but I don't see a need now.
+ * The table is split into a power of two number of partitions by the high
+ * bits of the hash of the join keys, so that the partitions can be built in
+ * parallel. Each partition is an open addressing table of distinct join keys,
+ * and stores the rows (keys included) in one contiguous arena of
+ * flexible_type, with the rows sharing a join key next to each other.
+ *
+ * The table is built in two steps. Rows are first added with \ref add_rows
+ * from up to num_threads threads, each with its own thread id, which only
+ * scatters them to the partitions. \ref finalize then builds the partitions
+ * in parallel. The table can only be probed after finalize.
  */
 class join_hash_table {
  public:
-  typedef hash_join_row_t value_type;
-
   /** 
    * Constructor.  Takes a vector of hash positions, which are the column
    * numbers in each row that represent the values the join is on (or the join
    * keys).  These hash positions are for the frame that each row is added from.
+   * num_columns is the number of columns of that frame, and num_threads the
+   * number of threads which will call add_rows.
+   */
+  join_hash_table(const std::vector<size_t>& hp,
+                  size_t num_columns,
+                  size_t num_threads);
+
+  /**
+   * Adds rows to the hash table. Each row must be from the same frame, or
+   * else join results will not make sense. The rows are moved from.
+   *
+   * Concurrent calls must use distinct thread ids. Within a thread id the
+   * order of the rows is preserved among rows sharing a join key.
    */
-  join_hash_table(std::vector<size_t> hp) : _hash_positions(hp) {}
+  void add_rows(size_t thread_id, std::vector<std::vector<flexible_type>>& rows);
 
   /**
-   * Add a row to the hash table.  Each row must be from the same frame, or
-   * else join results will not make sense.
+   * Builds the partitions from the added rows. Must be called once, after
+   * all the add_rows calls and before any lookup.
    */
-  bool add_row(const std::vector<flexible_type> &row);
+  void finalize();
 
   /**
-   * Returns all rows whose join keys match the given row's join keys.
+   * Returns all rows whose join keys match the given row's join keys, or
+   * an empty range if there is none.
    *
-   * The return object is a hash_join_row_t, a structure containing a list of
-   * rows and whether this join key was "matched" or not.  An optional argument
-   * marks all of the matching rows as "matched", which is usually used for
-   * completing a left join, in deciding which rows need to be joined with NULL
-   * values and emitted into the result set.
+   * An optional argument marks the join key as "matched", which is usually
+   * used for completing a left join, in deciding which rows need to be joined
+   * with NULL values and emitted into the result set.
+   *
+   * Safe to call concurrently.
+   */
+  row_range get_matching_rows(const std::vector<flexible_type> &row,
+                              const std::vector<size_t> &hash_positions,
+                              bool mark_match=true);
+
+  /// Returns the number of partitions.
+  inline size_t num_partitions() const {
+    return _partitions.size();
+  }
+
+  /**
+   * Calls fn(row_range) for the rows of every join key of a partition
+   * which was never marked as matched.
    */
-  const value_type &get_matching_rows(const std::vector<flexible_type> &row,
-                                      const std::vector<size_t> &hash_positions,
-                                      bool mark_match=true);
+  template <typename Fn>
+  void for_each_unmatched(size_t partition, Fn fn) const {
+    const auto& part = _partitions[partition];
+    for (const auto& entry: part.entries) {
+      if (!entry.matched) fn(get_range(part, entry));
+    }
+  }
 
   /**
    * Prints stats about the hash table to the log.
    */
   size_t num_stored_rows();
-  std::unordered_map<size_t, std::list<value_type>>::const_iterator cbegin();
-  std::unordered_map<size_t, std::list<value_type>>::const_iterator cend();
-
 
  private:
+  /// A distinct join key, and the range of its rows in the arena
+  struct key_entry {
+    size_t hash;
+    size_t row_begin;
+    size_t row_end;
+    // Set concurrently by the probing threads, which only ever set it to true
+    bool matched;
+  };
+
+  /// Rows added by one thread to one partition, waiting for finalize
+  struct pending_rows {
+    std::vector<flexible_type> values;
+    std::vector<size_t> hashes;
+  };
+
+  struct partition {
+    std::vector<key_entry> entries;
+    /// Open addressing table of (index in entries + 1). 0 is an empty slot.
+    std::vector<size_t> slots;
+    /// The rows, num_columns values each, grouped by join key
+    std::vector<flexible_type> arena;
+  };
+
+  void build_partition(size_t partition_id);
+
+  inline size_t partition_of(size_t hash) const {
+    return _partition_bits == 0 ? 0 : hash >> (64 - _partition_bits);
+  }
+
+  inline row_range get_range(const partition& part,
+                             const key_entry& entry) const {
+    row_range ret;
+    ret.data = part.arena.data() + entry.row_begin * _num_columns;
+    ret.num_rows = entry.row_end - entry.row_begin;
+    ret.num_columns = _num_columns;
+    return ret;
+  }
+
   /**
    * Does an itemwise check to see if two rows have matching join keys.
+   * row is a stored row.
    */
-  bool join_values_equal(const std::vector<flexible_type> &row,
-      const std::vector<flexible_type> &other,
-      const std::vector<size_t> &hash_positions);
+  bool join_values_equal(const flexible_type* row,
+      const flexible_type* other,
+      const std::vector<size_t> &hash_positions) const;
 
-  // Holds a list of each row with an identical hash key.  If we are joining on
-  // a key that holds a unique primary key within it, all entries will have a vector
-  // with 1 element.  We can't guarantee this though, so the value type is a vector
-  // of vectors.
-  std::unordered_map<size_t, std::list<value_type>> _hash_table;
   // The positions in the rows that we store taht make up the hash key
   std::vector<size_t> _hash_positions;
-  value_type empty_vt;
+  size_t _num_columns;
+  size_t _partition_bits = 0;
+  std::vector<partition> _partitions;
+  // indexed by [thread_id][partition]
+  std::vector<std::vector<pending_rows>> _pending;
 };
 
 /**
- * The hash_join_executor class executes a hash join.  It is only meant
- * to perform one join.  Could eventually inherit from a generic join class
- * and have further OOP design patterns to choose the algorithm (or just
- * different function calls).  Only one algorithm implemented thus far, 
- * so no need for that yet.
+ * The state and output logic shared by the join algorithms. Each executor is
+ * only meant to perform one join.
  */
-class hash_join_executor {
+class join_executor {
  public:
   //TODO: Perhaps combine the sframe and the join positions into a struct?
-  hash_join_executor(const sframe &left,
-                     const sframe &right,
-                     const std::vector<size_t> &left_join_positions,
-                     const std::vector<size_t> &right_join_positions,
-                     join_type_t join_type,
-                     size_t max_buffer_size);
-
-  ~hash_join_executor() {}
+  /**
+   * If smaller_frame_first is set and the right frame is smaller than the
+   * left frame, the executor swaps them internally. The output columns are
+   * put back in the expected order by \ref finalize_result_frame.
+   *
+   * For SEMI_JOIN and ANTI_JOIN, the executor's left frame is made of the
+   * join columns of the given right frame (the key set), and its right frame
+   * is the given left frame (the rows to filter).
+   */
+  join_executor(const sframe &left,
+                const sframe &right,
+                const std::vector<size_t> &left_join_positions,
+                const std::vector<size_t> &right_join_positions,
+                join_type_t join_type,
+                bool smaller_frame_first);
 
-  sframe grace_hash_join();
+  virtual ~join_executor() {}
 
- private:
+ protected:
   // The original frames we were passed
   sframe _left_frame;
   sframe _right_frame;
   std::vector<size_t> _left_join_positions;
   std::vector<size_t> _right_join_positions;
-  size_t _max_buffer_size;
   bool _left_join;
   bool _right_join;
   std::unordered_map<size_t,size_t> _right_to_left_join_positions;
   bool _reverse_output_column_order;
   std::unordered_map<size_t, std::string> _changed_dup_names;
+  // SEMI_JOIN or ANTI_JOIN: the rows of _right_frame are emitted unchanged
+  // if their keys are (or for ANTI_JOIN, are not) in _left_frame.
+  bool _membership_join;
+  bool _anti_join;
+
+  /**
+   * Return the number of cells (rows * cols) of an sframe.
+   */
+  size_t get_num_cells(const sframe &sf);
+
+  /**
+   * Create an empty SFrame that includes the columns of both left and right
+   * frames without duplicating the join columns.
+   */
+  void init_result_frame(sframe &result_frame);
+
+  /**
+   * Closes the result frame and, if the frames were swapped, makes the
+   * columns appear in the order the user was expecting.
+   */
+  sframe finalize_result_frame(sframe &result_frame);
+
+  /**
+   * Join the rows of the left frame matching a row of the right frame with
+   * that row and write to the given output iterator.
+   *
+   * If there are left rows and right_row is not NULL, each left row is joined
+   * with the right row. If only one side is present, its rows are joined with
+   * 'NULL' values, making sure that each join column is not 'NULL'.
+   */
+  void merge_rows_for_output(sframe &result_frame,
+                             sframe::iterator result_iter,
+                             const row_range &left_rows,
+                             const std::vector<flexible_type> *right_row);
+};
+
+/**
+ * The hash_join_executor class executes a hash join, building a hash table
+ * on the smaller frame (on the key set for SEMI_JOIN and ANTI_JOIN). Falls
+ * back to GRACE partitioning when it does not fit in memory.
+ */
+class hash_join_executor : public join_executor {
+ public:
+  hash_join_executor(const sframe &left,
+                     const sframe &right,
+                     const std::vector<size_t> &left_join_positions,
+                     const std::vector<size_t> &right_join_positions,
+                     join_type_t join_type,
+                     size_t max_buffer_size);
+
+  sframe grace_hash_join();
+
+  /**
+   * Returns the number of rows of the (internal) right frame which the
+   * bloom filter of the left join keys dropped while GRACE partitioning.
+   */
+  size_t num_filtered_rows() const { return _num_filtered_rows; }
+
+ private:
+  size_t _max_buffer_size;
   bool _frames_partitioned;
+  size_t _num_filtered_rows;
 
   /**
    * Partition the left and right frames for the GRACE hash join algorithm and
@@ -142,14 +320,17 @@ class hash_join_executor {
   /**
    * Partition one SFrame for the GRACE hash join algorithm.
    *
+   * If build_filter is not NULL, the hashes of the join keys of all rows are
+   * inserted into it. If probe_filter is not NULL, rows whose join key hash
+   * is not in it cannot have a match and are dropped instead of written out.
+   *
    * Used by grace_partition_frames().
    */
-  std::shared_ptr<sframe> grace_partition_frame(const sframe &sf, const std::vector<size_t> &join_col_nums, size_t num_partitions);
-
-  /**
-   * Return the number of cells (rows * cols) of an sframe.
-   */
-  size_t get_num_cells(const sframe &sf);
+  std::shared_ptr<sframe> grace_partition_frame(const sframe &sf,
+                                                const std::vector<size_t> &join_col_nums,
+                                                size_t num_partitions,
+                                                bloom_filter* build_filter = NULL,
+                                                const bloom_filter* probe_filter = NULL);
 
   /**
    * Estimates how many partitions this SFrame should be divided into for the
@@ -159,26 +340,55 @@ class hash_join_executor {
   size_t choose_number_of_grace_partitions(const sframe &sf);
 
   /**
-   * Create an empty SFrame that includes the columns of both left and right
-   * frames without duplicating the join columns.
+   * Loads a range of rows of the left frame into a hash table, reading in
+   * parallel. rdr reads from the (possibly partitioned) left frame.
    */
-  void init_result_frame(sframe &result_frame);
+  void build_hash_table(sframe::reader_type& rdr,
+                        size_t row_begin,
+                        size_t row_end,
+                        join_hash_table& ht);
 
+  std::vector<flexible_type> unpack_row(std::string val, size_t num_cols);
+};
+
+/**
+ * The merge_join_executor class executes a sort-merge join over two frames
+ * which are both sorted in ascending order of their join keys (see
+ * \ref is_sorted_on). No hash table is built. Both frames are streamed
+ * once, and only the left rows sharing the current join key are held in
+ * memory.
+ *
+ * The frames are split into key ranges merged in parallel, one per output
+ * segment.
+ */
+class merge_join_executor : public join_executor {
+ public:
+  merge_join_executor(const sframe &left,
+                      const sframe &right,
+                      const std::vector<size_t> &left_join_positions,
+                      const std::vector<size_t> &right_join_positions,
+                      join_type_t join_type);
+
+  sframe merge_join();
+
+ private:
   /**
-   * Join a vector of rows from the left frame with a vector of rows from the
-   * right frame and write to the given output iterator.
-   *
-   * If both vectors have size > 0, this will perform a cross product and write
-   * the result. If one vector is empty and the other is not, each row from the
-   * non-empty vector is join with 'NULL' values, making sure that each join
-   * column is not 'NULL'.
+   * Returns the index of the first row of a sorted frame whose join keys are
+   * not less than the given keys. key_rdr reads a frame of num_rows rows with
+   * only the join columns. key_positions are the positions of the keys in
+   * key_row.
    */
-  void merge_rows_for_output(sframe &result_frame,
-                             sframe::iterator result_iter,
-                             const std::vector<std::vector<flexible_type>> &left_rows,
-                             const std::vector<std::vector<flexible_type>> &right_rows);
+  size_t lower_bound(sframe::reader_type &key_rdr,
+                     size_t num_rows,
+                     const flexible_type* key_row,
+                     const std::vector<size_t> &key_positions);
 
-  std::vector<flexible_type> unpack_row(std::string val, size_t num_cols);
+  /// Merges one range of the left frame with one range of the right frame
+  void merge_range(sframe &result_frame,
+                   sframe::iterator result_iter,
+                   sframe::reader_type &left_rdr,
+                   sframe::reader_type &right_rdr,
+                   size_t segment);
 };
 
 } // end of join_impl
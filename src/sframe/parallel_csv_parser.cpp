@@ -16,6 +16,7 @@
 */
 #include <string>
 #include <regex>
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <set>
@@ -25,10 +26,12 @@
 #include <timer/timer.hpp>
 #include <parallel/thread_pool.hpp>
 #include <parallel/atomic.hpp>
+#include <parallel/lambda_omp.hpp>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sframe.hpp>
 #include <sframe/parallel_csv_parser.hpp>
 #include <sframe/csv_line_tokenizer.hpp>
+#include <sframe/csv_structural_scan.hpp>
 #include <fileio/general_fstream.hpp>
 #include <fileio/sanitize_url.hpp>
 #include <fileio/fs_utils.hpp>
@@ -82,6 +85,8 @@ struct csv_info {
   size_t ncols = 0;
   std::vector<std::string> column_names;
   std::vector<flex_type_enum> column_types;
+  /// whether the type of each column was given by a type hint
+  std::vector<bool> column_type_hinted;
 };
 
 inline bool is_end_line_char(char c) {
@@ -123,6 +128,28 @@ class parallel_csv_parser {
   void set_total_input_size(size_t input_size) {
     total_input_file_sizes = input_size;
   }
+
+  /**
+   * Sets the output segment to write to when no total input size is set.
+   */
+  void set_output_segment(size_t output_segment) {
+    current_output_segment = output_segment;
+  }
+
+  /**
+   * Sets the number of bytes read from the file for each parallel parse.
+   * Defaults to SFRAME_CSV_PARSER_READ_SIZE.
+   */
+  void set_read_size(size_t size) {
+    read_size = size;
+  }
+
+  /**
+   * Sets whether the number of lines read is periodically reported.
+   */
+  void set_report_progress(bool report) {
+    report_progress = report;
+  }
   /**
    * Parses an input file into an output frame
    */
@@ -195,7 +222,7 @@ class parallel_csv_parser {
         }
 
         start_background_write(output_frame, errors, current_output_segment);
-        if (lines_read.value > 0) {
+        if (report_progress && lines_read.value > 0) {
           logprogress_stream_ontick(5) << "Read " << lines_read.value
                                        << " lines. Lines per second: "
                                        << lines_read.value / get_time_elapsed()
@@ -281,6 +308,8 @@ class parallel_csv_parser {
   std::vector<flex_type_enum> column_types;
 
   size_t current_output_segment = 0;
+  size_t read_size = SFRAME_CSV_PARSER_READ_SIZE;
+  bool report_progress = true;
 
   atomic<size_t> lines_read = 0;
   timer ti;
@@ -362,10 +391,12 @@ class parallel_csv_parser {
       /**************************************************************************/
       // this is the current character I am scanning
       const char comment_char = thread_local_tokenizer[threadid].comment_char;
+      const csv_scan::char_set end_line_chars("\n\r");
       const char* pnext = pstart;
       while(pnext < pend) {
         // search for a new line
-        if (is_end_line_char(*pnext)) {
+        pnext = csv_scan::find_first_of(pnext, pend, end_line_chars);
+        if (pnext != pend) {
           // parse pstart until pnext
           // clear local tokens
           size_t nextelem = parsed_buffer_last_elem[threadid];
@@ -427,7 +458,7 @@ class parallel_csv_parser {
   bool fill_buffer(general_ifstream& fin) {
     if (fin.good()) {
       size_t oldsize = buffer.size();
-      size_t amount_to_read = SFRAME_CSV_PARSER_READ_SIZE;
+      size_t amount_to_read = read_size;
       buffer.resize(buffer.size() + amount_to_read);
       fin.read(&(buffer[0]) + oldsize, buffer.size() - oldsize);
       if ((size_t)fin.gcount() < amount_to_read) {
@@ -635,9 +666,11 @@ void read_csv_header(csv_info& info,
 void get_column_types(csv_info& info, 
                       std::map<std::string, flex_type_enum> column_type_hints) {
   info.column_types.resize(info.ncols, flex_type_enum::STRING);
+  info.column_type_hinted.resize(info.ncols, false);
 
   if (column_type_hints.count("__all_columns__")) {
     info.column_types = std::vector<flex_type_enum>(info.ncols, column_type_hints["__all_columns__"]);
+    info.column_type_hinted.assign(info.ncols, true);
   } else if (column_type_hints.count("__X0__")) {
     if (column_type_hints.size() != info.column_types.size()) {
       std::stringstream warning_msg;
@@ -654,6 +687,7 @@ void get_column_types(csv_info& info,
         log_and_throw("Bad column type hints");
       }
       info.column_types[i] = column_type_hints[key.str()];
+      info.column_type_hinted[i] = true;
     }
   } else {
     for (size_t i = 0; i < info.column_names.size(); ++i) {
@@ -665,6 +699,7 @@ void get_column_types(csv_info& info,
          * }
          */
         info.column_types[i] = coltype;
+        info.column_type_hinted[i] = true;
         column_type_hints.erase(info.column_names[i]);
       }
     }
@@ -679,21 +714,164 @@ void get_column_types(csv_info& info,
   }
 }
 
+/**************************************************************************/
+/*                                                                        */
+/* Type Inference                                                         */
+/* --------------                                                         */
+/* If requested, the types of the columns without a type hint are         */
+/* inferred from the first rows of the input. The rows are tokenized in   */
+/* parallel as if every column had the UNDEFINED type, which parses each  */
+/* value as whatever it looks like. The type of a column then combines    */
+/* the types of its values:                                               */
+/*  - missing values do not change the type                               */
+/*  - integers and floats give a float                                    */
+/*  - vectors and lists give a list                                       */
+/*  - any other disagreement gives a string                               */
+/* Columns with only missing values are strings.                          */
+/*                                                                        */
+/**************************************************************************/
+flex_type_enum combine_inferred_types(flex_type_enum a, flex_type_enum b) {
+  if (a == b || b == flex_type_enum::UNDEFINED) return a;
+  if (a == flex_type_enum::UNDEFINED) return b;
+  auto is_pair = [&](flex_type_enum x, flex_type_enum y) {
+    return (a == x && b == y) || (a == y && b == x);
+  };
+  if (is_pair(flex_type_enum::INTEGER, flex_type_enum::FLOAT)) {
+    return flex_type_enum::FLOAT;
+  }
+  if (is_pair(flex_type_enum::VECTOR, flex_type_enum::LIST)) {
+    return flex_type_enum::LIST;
+  }
+  return flex_type_enum::STRING;
+}
+
+/**
+ * Returns the name of the Python type of a column type, as passed in the
+ * column_type_hints of read_csv.
+ */
+const char* python_type_name(flex_type_enum type) {
+  switch(type) {
+   case flex_type_enum::INTEGER: return "int";
+   case flex_type_enum::FLOAT: return "float";
+   case flex_type_enum::VECTOR: return "array";
+   case flex_type_enum::LIST: return "list";
+   case flex_type_enum::DICT: return "dict";
+   default: return "str";
+  }
+}
+
+/**
+ * Reads up to num_rows non empty lines following the headers of the files.
+ */
+std::vector<std::string> read_sample_lines(const std::vector<std::string>& files,
+                                           csv_line_tokenizer& tokenizer,
+                                           bool use_header,
+                                           size_t num_rows) {
+  std::vector<std::string> lines;
+  for (const auto& file : files) {
+    if (lines.size() >= num_rows) break;
+    general_ifstream fin(file);
+    if (!fin.good()) log_and_throw("Cannot open " + sanitize_url(file));
+    if (use_header) {
+      std::vector<std::string> header_tokens;
+      while (header_tokens.size() == 0 && fin.good()) {
+        std::string line;
+        eol_safe_getline(fin, line);
+        tokenizer.tokenize_line(line.c_str(), line.length(), header_tokens);
+      }
+    }
+    std::string line;
+    while (lines.size() < num_rows && fin.good()) {
+      eol_safe_getline(fin, line);
+      boost::algorithm::trim(line);
+      if (!line.empty()) lines.push_back(line);
+    }
+  }
+  return lines;
+}
+
+void infer_column_types(csv_info& info,
+                        const std::vector<std::string>& files,
+                        csv_line_tokenizer& tokenizer,
+                        bool use_header,
+                        size_t num_rows) {
+  if (std::all_of(info.column_type_hinted.begin(),
+                  info.column_type_hinted.end(),
+                  [](bool hinted) { return hinted; })) {
+    return;
+  }
+  std::vector<std::string> lines = read_sample_lines(files, tokenizer,
+                                                     use_header, num_rows);
+
+  size_t max_threads = thread_pool::get_instance().size();
+  std::vector<std::vector<flex_type_enum>> thread_types(
+      max_threads, std::vector<flex_type_enum>(info.ncols, flex_type_enum::UNDEFINED));
+  in_parallel([&](size_t thread_id, size_t num_threads) {
+    size_t begin = lines.size() * thread_id / num_threads;
+    size_t end = lines.size() * (thread_id + 1) / num_threads;
+    csv_line_tokenizer local_tokenizer = tokenizer;
+    std::vector<flexible_type> values(info.ncols);
+    std::vector<flex_type_enum>& types = thread_types[thread_id];
+    for (size_t i = begin; i < end; ++i) {
+      for (auto& value : values) value.reset(flex_type_enum::UNDEFINED);
+      size_t num_values = local_tokenizer.tokenize_line(lines[i].c_str(),
+                                                        lines[i].length(),
+                                                        values, true);
+      // lines which would fail to parse are ignored
+      if (num_values != info.ncols) continue;
+      for (size_t c = 0; c < info.ncols; ++c) {
+        types[c] = combine_inferred_types(types[c], values[c].get_type());
+      }
+    }
+  });
+
+  for (size_t c = 0; c < info.ncols; ++c) {
+    if (info.column_type_hinted[c]) continue;
+    flex_type_enum type = flex_type_enum::UNDEFINED;
+    for (auto& types : thread_types) {
+      type = combine_inferred_types(type, types[c]);
+    }
+    if (type == flex_type_enum::UNDEFINED) type = flex_type_enum::STRING;
+    info.column_types[c] = type;
+  }
+
+  // Printed before the file is parsed, so that the types can be corrected
+  // when parsing fails because of them. This is progress output, so it is
+  // not shown when progress printing is off (read_csv with verbose=False).
+  std::stringstream typelist;
+  for (size_t c = 0; c < info.ncols; ++c) {
+    if (c > 0) typelist << ",";
+    typelist << python_type_name(info.column_types[c]);
+  }
+  logprogress_stream
+      << "------------------------------------------------------\n"
+      << "Inferred types from first " << lines.size() << " line(s) of file as \n"
+      << "column_type_hints=[" << typelist.str() << "]\n"
+      << "If parsing fails due to incorrect types, you can correct\n"
+      << "the inferred type list above and pass it to read_csv in\n"
+      << "the column_type_hints argument\n"
+      << "------------------------------------------------------" << std::endl;
+}
+
 /**
  * Get info about a CSV.
  */
 void get_csv_info(csv_info& info, 
-                  std::string path, 
+                  const std::vector<std::string>& files, 
                   csv_line_tokenizer& tokenizer, 
                   bool use_header,
-                  std::map<std::string, flex_type_enum> column_type_hints) {
+                  std::map<std::string, flex_type_enum> column_type_hints,
+                  size_t type_inference_rows) {
   timer ti;
   
   ti.start();
-  read_csv_header(info, path, tokenizer, use_header);
+  read_csv_header(info, files[0], tokenizer, use_header);
   
   ti.start();
   get_column_types(info, column_type_hints);
+  if (type_inference_rows > 0) {
+    infer_column_types(info, files, tokenizer, use_header, type_inference_rows);
+  }
   
   logstream(LOG_INFO) << "Type Determination in " 
                       << ti.current_time() 
@@ -774,7 +952,6 @@ void parse_csv_to_sframe(
     try {
       parser.parse(fin, frame, *file_errors);
     } catch(const std::string& s) {
-      frame.close();
       if (store_errors) file_errors->close();
       log_and_throw(s);
     }
@@ -796,6 +973,113 @@ void parse_csv_to_sframe(
   }
 }
 
+/**
+ * The pool on which parse_csv_files_in_parallel() runs its files. Each file
+ * is parsed by a parallel_csv_parser which runs its own tasks on
+ * thread_pool::get_instance(), so the files cannot run on that pool too
+ * without risking every pool thread waiting on a task which never runs.
+ */
+static thread_pool& get_file_parse_pool() {
+  static thread_pool pool(std::max<size_t>(thread::cpu_count(), 2));
+  return pool;
+}
+
+/**
+ * Assigns the files, in order, to the segments of the output frame by their
+ * cumulative size, the same way the serial parse advances through the
+ * segments, except that a file is never split across segments.
+ *
+ * Returns the files of each segment.
+ */
+static std::vector<std::vector<std::string>> assign_csv_files_to_segments(
+    const std::vector<std::string>& files,
+    const std::vector<size_t>& file_sizes,
+    size_t num_segments) {
+  size_t total_input_file_sizes = 0;
+  for (size_t size : file_sizes) total_input_file_sizes += size;
+
+  std::vector<std::vector<std::string>> segment_files(num_segments);
+  size_t cumulative_file_sizes = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    size_t segment = 0;
+    if (total_input_file_sizes > 0) {
+      segment = std::min(cumulative_file_sizes * num_segments / total_input_file_sizes,
+                         num_segments - 1);
+    }
+    segment_files[segment].push_back(files[i]);
+    cumulative_file_sizes += file_sizes[i];
+  }
+  return segment_files;
+}
+
+/**
+ * Parses several CSV files concurrently, one parser per output segment with
+ * files (see assign_csv_files_to_segments()).
+ *
+ * The files of a segment are parsed one after the other, so the rows of the
+ * frame are in the same order as with the serial parse. Decompression of the
+ * files, which is single threaded per file, thus runs on several threads at
+ * once.
+ *
+ * Returns the total number of lines read.
+ */
+static size_t parse_csv_files_in_parallel(
+    const std::vector<std::vector<std::string>>& segment_files,
+    const csv_info& info,
+    const csv_line_tokenizer& tokenizer,
+    bool use_header,
+    bool continue_on_failure,
+    bool store_errors,
+    const std::map<std::string, flex_type_enum>& column_type_hints,
+    sframe& frame,
+    const std::string& frame_sidx_file,
+    std::map<std::string, std::shared_ptr<sarray<flexible_type>>>& errors) {
+  size_t num_segments = segment_files.size();
+  size_t num_parsers = 0;
+  for (auto& seg_files : segment_files) num_parsers += !seg_files.empty();
+  // the parsers share the read buffer budget and the parse threads of the
+  // serial parser
+  size_t read_size = std::max<size_t>(SFRAME_CSV_PARSER_READ_SIZE / num_parsers, 1024);
+  size_t parser_threads = std::max<size_t>(
+      thread_pool::get_instance().size() / num_parsers, 2);
+
+  atomic<size_t> lines_read = 0;
+  volatile bool failed = false;
+  mutex errors_lock;
+  parallel_task_queue file_group(get_file_parse_pool());
+  for (size_t segment = 0; segment < num_segments; ++segment) {
+    if (segment_files[segment].empty()) continue;
+    file_group.launch([&, segment]() {
+      csv_line_tokenizer local_tokenizer = tokenizer;
+      parallel_csv_parser parser(info.column_types, local_tokenizer,
+                                 continue_on_failure, store_errors,
+                                 0 /* row_limit */, parser_threads);
+      parser.set_output_segment(segment);
+      parser.set_read_size(read_size);
+      parser.set_report_progress(false);
+      std::map<std::string, std::shared_ptr<sarray<flexible_type>>> segment_errors;
+      try {
+        for (auto& file : segment_files[segment]) {
+          if (failed) break;
+          parse_csv_to_sframe(file, local_tokenizer, use_header,
+                              continue_on_failure, store_errors,
+                              column_type_hints, 0, frame, frame_sidx_file,
+                              parser, segment_errors);
+        }
+      } catch (...) {
+        // stop the other parsers early
+        failed = true;
+        throw;
+      }
+      lines_read.inc(parser.num_lines_read());
+      std::lock_guard<mutex> guard(errors_lock);
+      errors.insert(segment_errors.begin(), segment_errors.end());
+    });
+  }
+  file_group.join();
+  return lines_read.value;
+}
+
 std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sframe(
     const std::string& url,
     csv_line_tokenizer& tokenizer,
@@ -805,7 +1089,8 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
     std::map<std::string, flex_type_enum> column_type_hints,
     size_t row_limit,                          
     sframe& frame,
-    std::string frame_sidx_file) {
+    std::string frame_sidx_file,
+    size_t type_inference_rows) {
   
   if (store_errors) continue_on_failure = true;
   // otherwise, check that url is valid directory, and get its listing if no 
@@ -833,7 +1118,8 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
 
   // get CSV info from first file
   csv_info info;
-  get_csv_info(info, files[0], tokenizer, use_header, column_type_hints);
+  get_csv_info(info, files, tokenizer, use_header, column_type_hints,
+               type_inference_rows);
   logstream(LOG_INFO) << "CSV num. columns: " << info.ncols << std::endl;
 
   if (info.ncols <= 0)
@@ -842,19 +1128,51 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
   parallel_csv_parser parser(info.column_types, tokenizer,
                              continue_on_failure, store_errors, row_limit);
   // get the total input file size so I can stripe it across segments
+  std::vector<size_t> file_sizes;
   size_t total_input_file_sizes = 0;
   for (auto file : files) {
     general_ifstream fin(file);
-    total_input_file_sizes += fin.file_size();
+    file_sizes.push_back(fin.file_size());
+    total_input_file_sizes += file_sizes.back();
   }
   parser.set_total_input_size(total_input_file_sizes);
 
+  // Files are parsed concurrently, each output segment by its own parser,
+  // when there are enough of them to keep every core busy, or when they are
+  // compressed, since decompression runs on a single thread per file. A few
+  // large uncompressed files parse faster one after the other, each with all
+  // the parse threads. A row limit requires reading the files in order.
+  bool has_compressed_files = false;
+  for (auto& file : files) {
+    has_compressed_files |= boost::ends_with(file, ".gz");
+  }
+  bool parse_files_in_parallel = SFRAME_CSV_PARSE_FILES_IN_PARALLEL &&
+      files.size() > 1 && row_limit == 0 &&
+      (has_compressed_files || files.size() >= thread::cpu_count());
+
   if (!frame.is_opened_for_write()) {
     // open as many segments as there are temp directories.
-    // But at least one segment
+    // But at least one segment. When parsing files concurrently, open
+    // enough segments to give each thread its own.
+    size_t num_segments = std::max<size_t>(1, num_temp_directories());
+    if (parse_files_in_parallel) {
+      num_segments = std::max(num_segments,
+                              std::min(files.size(), thread::cpu_count()));
+    }
     frame.open_for_write(info.column_names, info.column_types, 
-                         frame_sidx_file, 
-                         std::max<size_t>(1, num_temp_directories()));
+                         frame_sidx_file, num_segments);
+  }
+
+  // A frame which was already opened may have too few segments to hold the
+  // files of as many parsers.
+  std::vector<std::vector<std::string>> segment_files;
+  if (parse_files_in_parallel) {
+    segment_files = assign_csv_files_to_segments(files, file_sizes,
+                                                 frame.num_segments());
+    size_t num_parsers = 0;
+    for (auto& seg_files : segment_files) num_parsers += !seg_files.empty();
+    parse_files_in_parallel = num_parsers > 1 &&
+        (has_compressed_files || num_parsers >= thread::cpu_count());
   }
 
   // create the errors map
@@ -863,16 +1181,32 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
   // start parser timer for cumulative time consumed (in seconds)
   parser.start_timer();
 
-  for (auto file : files) {
-    // check that we've read < row_limit  
-    if (parser.num_lines_read() < row_limit || row_limit == 0) {      
-      parse_csv_to_sframe(file, tokenizer, use_header, continue_on_failure, 
-                          store_errors, column_type_hints, row_limit, frame, 
-                          frame_sidx_file, parser, errors);
-    } else break;
+  size_t num_lines_read = 0;
+  try {
+    if (parse_files_in_parallel) {
+      num_lines_read = parse_csv_files_in_parallel(segment_files, info,
+                                                   tokenizer, use_header,
+                                                   continue_on_failure,
+                                                   store_errors,
+                                                   column_type_hints, frame,
+                                                   frame_sidx_file, errors);
+    } else {
+      for (auto file : files) {
+        // check that we've read < row_limit  
+        if (parser.num_lines_read() < row_limit || row_limit == 0) {      
+          parse_csv_to_sframe(file, tokenizer, use_header, continue_on_failure, 
+                              store_errors, column_type_hints, row_limit, frame, 
+                              frame_sidx_file, parser, errors);
+        } else break;
+      }
+      num_lines_read = parser.num_lines_read();
+    }
+  } catch (...) {
+    if (frame.is_opened_for_write()) frame.close();
+    throw;
   }
   
-  logprogress_stream << "Parsing completed. Parsed " << parser.num_lines_read()
+  logprogress_stream << "Parsing completed. Parsed " << num_lines_read
                      << " lines in " << parser.get_time_elapsed() << " secs."  << std::endl;
 
   
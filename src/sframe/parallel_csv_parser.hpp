@@ -27,6 +27,16 @@ namespace graphlab {
 
 std::istream& eol_safe_getline(std::istream& is, std::string& t);
 
+/**
+ * Parses a CSV file, or a directory or glob of CSV files, into an SFrame.
+ *
+ * Columns without a type hint are parsed as strings, unless 
+ * type_inference_rows is non-zero. Their types are then inferred from that
+ * many rows at the start of the input.
+ *
+ * Returns a map from file name to an SArray of the lines of the file which
+ * failed to parse, if store_errors is set.
+ */
 std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sframe(
     const std::string& url,
     csv_line_tokenizer& tokenizer,
@@ -36,7 +46,8 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> parse_csvs_to_sfra
     std::map<std::string, flex_type_enum> column_type_hints,
     size_t row_limit,
     sframe& frame,
-    std::string frame_sidx_file = "");
+    std::string frame_sidx_file = "",
+    size_t type_inference_rows = 0);
 
 }
 
@@ -23,12 +23,14 @@
 #include <string>
 #include <sstream>
 #include <map>
+#include <vector>
 #include <fileio/general_fstream.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/ini_parser.hpp>
 #include <sframe/sarray_index_file.hpp>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sframe_rows.hpp>
+#include <sframe/sarray_v2_block_types.hpp>
 namespace graphlab {
 
 /**
@@ -112,6 +114,21 @@ class sarray_format_reader_common_base {
    * Gets the contents of the index file information read from the index file
    */
   virtual const index_file_information& get_index_info() const = 0;
+
+  /**
+   * Sets the number of blocks to read ahead of sequential reads in the
+   * background. 0 disables readahead. Formats which do not support
+   * readahead ignore this.
+   */
+  virtual void set_readahead(size_t num_blocks) { }
+
+  /**
+   * Sets the (sorted) ends of the row ranges the array is read in, for
+   * instance the segments of an sarray_reader. Readahead stops at the end
+   * of the range being read. Formats which do not support readahead ignore
+   * this.
+   */
+  virtual void set_readahead_range_ends(const std::vector<size_t>& range_ends) { }
 };
 
 template <typename T>
@@ -158,6 +175,20 @@ class sarray_format_reader<flexible_type>
     }
     return ret;
   }
+
+  /**
+   * Returns the statistics (min / max / undefined count) of the on disk 
+   * block containing a given row, and stores the range of rows covered by
+   * the block in [block_row_start, block_row_end).
+   * Returns NULL if the file format does not store block statistics, or 
+   * the block has none.
+   */
+  virtual const v2_block_impl::block_statistics* 
+      get_block_statistics(size_t row, 
+                           size_t& block_row_start, 
+                           size_t& block_row_end) {
+    return NULL;
+  }
 };
 
 
@@ -241,6 +272,15 @@ class sarray_group_format_writer {
    * Throws an exception if the array is not open.
    */
   virtual size_t num_columns() const = 0;
+
+  /**
+   * Sets how the data written after this call is compressed, overriding
+   * sframe_config::SFRAME_COMPRESSION_TYPE and SFRAME_COMPRESSION_LEVEL.
+   * level is only used by LZ4HC. Formats which do not support it ignore
+   * this.
+   */
+  virtual void set_compression(v2_block_impl::block_compression_type type,
+                               int level = 0) { }
 };
 
 } // namespace graphlab
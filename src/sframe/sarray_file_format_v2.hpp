@@ -21,6 +21,7 @@
 #include <mutex>
 #include <typeinfo>
 #include <map>
+#include <algorithm>
 #include <boost/algorithm/string/predicate.hpp>
 #include <logger/logger.hpp>
 #include <random/random.hpp>
@@ -31,8 +32,10 @@
 #include <fileio/temp_files.hpp>
 #include <serialization/serialization_includes.hpp>
 #include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
 #include <sframe/sarray_v2_block_writer.hpp>
+#include <sframe/sarray_v2_block_readahead.hpp>
 #include <cppipc/server/cancel_ops.hpp>
 namespace graphlab {
 
@@ -45,7 +48,8 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
  public:
   /// Default Constructor
   inline sarray_format_reader_v2(): 
-      m_manager(v2_block_impl::block_manager::get_instance()) {
+      m_manager(v2_block_impl::block_manager::get_instance()),
+      m_readahead_depth(sframe_config::SFRAME_READAHEAD_BLOCKS) {
   }
 
   /**
@@ -93,6 +97,7 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     m_cache.resize(m_block_list.size());
     m_used_cache_entries.resize(m_block_list.size());
     m_used_cache_entries.clear();
+    m_readahead.reset(new v2_block_impl::block_readahead(m_block_list));
     // it is convenient for m_start_row to have one more entry which is 
     // the total # elements in the file
     m_start_row.push_back(m_num_rows);
@@ -109,6 +114,8 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
    * Closes an sarray file set. No-op if the array is already closed.
    */
   void close() {
+    // background reads must complete before the columns are closed
+    m_readahead.reset();
     // close all columns
     for (auto column: m_segment_list) {
       m_manager.close_column(column);
@@ -146,10 +153,43 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
     return m_index_info.index_file;
   }
 
+  /**
+   * Sets the number of blocks to read ahead of sequential reads in the
+   * background. 0 disables readahead. Only flexible_type arrays support
+   * readahead.
+   */
+  void set_readahead(size_t num_blocks) {
+    m_readahead_depth = num_blocks;
+  }
+
+  /**
+   * Sets the (sorted) ends of the row ranges the array is read in.
+   * Readahead does not go past the end of the range being read. By default
+   * the whole array is one range.
+   */
+  void set_readahead_range_ends(const std::vector<size_t>& range_ends) {
+    m_range_ends = range_ends;
+  }
+
+  /**
+   * Returns the end of the row range containing row. See
+   * set_readahead_range_ends().
+   */
+  size_t readahead_range_end(size_t row) const {
+    auto iter = std::upper_bound(m_range_ends.begin(), m_range_ends.end(), row);
+    if (iter == m_range_ends.end()) return m_num_rows;
+    return std::min(*iter, m_num_rows);
+  }
+
   size_t read_rows(size_t row_start, 
                    size_t row_end, 
                    sframe_rows& out_obj);
 
+  const v2_block_impl::block_statistics* 
+      get_block_statistics(size_t row, 
+                           size_t& block_row_start, 
+                           size_t& block_row_end);
+
   /**
    * Reads a collection of rows, storing the result in out_obj.
    * This function is independent of the open_segment/read_segment/close_segment
@@ -199,6 +239,13 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
   std::vector<size_t> m_start_row;
   std::vector<column_address> m_segment_list;
 
+  /// The number of blocks to read ahead. See set_readahead()
+  size_t m_readahead_depth = 0;
+  /// The ends of the row ranges read. See set_readahead_range_ends()
+  std::vector<size_t> m_range_ends;
+  /// Background reads of the blocks following sequential scans
+  std::unique_ptr<v2_block_impl::block_readahead> m_readahead;
+
   /**
    * this describes one cache block.
    *
@@ -326,6 +373,50 @@ class sarray_format_reader_v2: public sarray_format_reader<T> {
 
   void fetch_cache_from_file(size_t block_number, cache_entry& ret);
 
+  /**
+   * Called when a sequential read of row starts or finishes a block.
+   * Schedules background reads of the next m_readahead_depth blocks which
+   * start before the end of the row range containing row.
+   */
+  void schedule_readahead(size_t block_number, size_t row) {
+    if (m_readahead_depth == 0 || !m_readahead) return;
+    // bound the number of blocks in flight across all threads reading
+    // this array
+    size_t max_outstanding = m_readahead_depth * 
+        std::max<size_t>(thread::cpu_count(), 1);
+    size_t range_end = readahead_range_end(row);
+    for (size_t i = block_number + 1; 
+         i <= block_number + m_readahead_depth && i < m_block_list.size() &&
+         m_start_row[i] < range_end;
+         ++i) {
+      if (m_used_cache_entries.get(i)) continue;
+      if (!m_readahead->schedule(i, max_outstanding)) {
+        // full. Drop blocks read for earlier parts of the array which were 
+        // never claimed, and try again
+        m_readahead->drop_before(block_number);
+        if (!m_readahead->schedule(i, max_outstanding)) break;
+      }
+    }
+  }
+
+  /**
+   * Marks a cache entry as holding data, evicting other entries if the
+   * cache is too large.
+   */
+  void register_cache_entry(size_t block_number) {
+    if (m_used_cache_entries.get(block_number) == false) m_cache_size.inc();
+    m_used_cache_entries.set_bit(block_number);
+    // evict something random
+    // we will only loop at most this number of times
+    int num_to_evict = (int)(m_cache_size.value) - 
+        SFRAME_MAX_BLOCKS_IN_CACHE;
+    while(num_to_evict > 0 && 
+          m_cache_size.value > SFRAME_MAX_BLOCKS_IN_CACHE) {
+      try_evict_something_from_cache();
+      --num_to_evict;
+    }
+  }
+
   size_t block_offset_containing_row(size_t row) {
     auto pos = std::lower_bound(m_start_row.begin(), m_start_row.end(), row);
     size_t blocknum = std::distance(m_start_row.begin(), pos);
@@ -359,28 +450,29 @@ fetch_cache_from_file(size_t block_number, cache_entry& ret) {
     m_buffer_pool.release_buffer(std::move(ret.buffer));
     ret.buffer.reset();
   }
+  // was it read in the background?
+  if (m_readahead && m_readahead->take(block_number, ret.buffer)) {
+    ret.encoded_buffer.release();
+    ret.encoded_buffer_reader.release();
+    ret.buffer_start_row = m_start_row[block_number];
+    ret.is_encoded = false;
+    ret.has_data = true;
+    register_cache_entry(block_number);
+    return;
+  }
   block_address block_addr = m_block_list[block_number];
   v2_block_impl::block_info* info; 
-  auto buffer = m_manager.read_block(block_addr, &info);
+  size_t length = 0;
+  auto buffer = m_manager.read_block_view(block_addr, length, &info);
   if (buffer == nullptr) {
     log_and_throw("Unexpected block read failure. Bad file?");
   }
   ret.buffer_start_row = m_start_row[block_number];
-  ret.encoded_buffer.init(*info, buffer);
+  ret.encoded_buffer.init(*info, buffer, length);
   ret.encoded_buffer_reader = ret.encoded_buffer.get_range();
   ret.is_encoded = true;
   ret.has_data = true;
-  if (m_used_cache_entries.get(block_number) == false) m_cache_size.inc();
-  m_used_cache_entries.set_bit(block_number);
-  // evict something random
-  // we will only loop at most this number of times
-  int num_to_evict = (int)(m_cache_size.value) - 
-      SFRAME_MAX_BLOCKS_IN_CACHE;
-  while(num_to_evict > 0 && 
-        m_cache_size.value > SFRAME_MAX_BLOCKS_IN_CACHE) {
-    try_evict_something_from_cache();
-    --num_to_evict;
-  }
+  register_cache_entry(block_number);
 }
 
 template <typename T>
@@ -393,17 +485,7 @@ fetch_cache_from_file(size_t block_number, cache_entry& ret) {
     log_and_throw("Unexpected block read failure. Bad file?");
   }
   ret.buffer_start_row = m_start_row[block_number];
-  if (m_used_cache_entries.get(block_number) == false) m_cache_size.inc();
-  m_used_cache_entries.set_bit(block_number);
-  // evict something random
-  // we will only loop at most this number of times
-  int num_to_evict = (int)(m_cache_size.value) - 
-      SFRAME_MAX_BLOCKS_IN_CACHE;
-  while(num_to_evict > 0 && 
-        m_cache_size.value > SFRAME_MAX_BLOCKS_IN_CACHE) {
-    try_evict_something_from_cache();
-    --num_to_evict;
-  }
+  register_cache_entry(block_number);
 }
 
 
@@ -414,8 +496,8 @@ ensure_cache_decoded(cache_entry& cache, size_t block_number) {
     cache.buffer = m_buffer_pool.get_new_buffer();
     auto data = cache.encoded_buffer.get_block_data();
     v2_block_impl::typed_decode(cache.encoded_buffer.get_block_info(),
-                                data->data(),
-                                data->size(),
+                                data.get(),
+                                cache.encoded_buffer.get_block_data_length(),
                                 *cache.buffer);
     // clear the encoded buffer information
     cache.encoded_buffer.release();
@@ -452,6 +534,10 @@ fetch_rows_from_cache(size_t fetch_start,
     cache.lock.lock();
     if (!cache.has_data) {
       fetch_cache_from_file(i, cache);
+      // starting a block from the top looks like a sequential scan
+      if (first_row_to_fetch_in_this_block == m_start_row[i]) {
+        schedule_readahead(i, m_start_row[i]);
+      }
     } 
     if (cache.buffer_start_row < first_row_to_fetch_in_this_block && cache.is_encoded) {
       // fast forward
@@ -475,10 +561,14 @@ fetch_rows_from_cache(size_t fetch_start,
              ++j) {
           out_obj[output_idx++] = (*cache.buffer)[j - input_offset];
         }
+        // the decoded buffer still holds all the rows, so random reads
+        // of earlier rows remain possible
+        cache.buffer_start_row = last_row_to_fetch_in_this_block;
       }
       if (last_row_to_fetch_in_this_block == m_start_row[i + 1]) {
         // we have exhausted this cache
         release_cache(i); 
+        schedule_readahead(i, m_start_row[i + 1] - 1);
       }
     } else {
       // non sequential read
@@ -560,6 +650,29 @@ read_rows(size_t row_start,
   return 0;
 }
 
+template <>
+inline const v2_block_impl::block_statistics* 
+sarray_format_reader_v2<flexible_type>::
+get_block_statistics(size_t row, 
+                     size_t& block_row_start, 
+                     size_t& block_row_end) {
+  if (row >= m_num_rows) return NULL;
+  size_t block_number = block_offset_containing_row(row);
+  // skip over empty blocks
+  while (m_start_row[block_number + 1] <= row) ++block_number;
+  block_row_start = m_start_row[block_number];
+  block_row_end = m_start_row[block_number + 1];
+  return m_manager.get_block_statistics(m_block_list[block_number]);
+}
+
+template <typename T>
+inline const v2_block_impl::block_statistics* 
+sarray_format_reader_v2<T>::
+get_block_statistics(size_t row, 
+                     size_t& block_row_start, 
+                     size_t& block_row_end) {
+  return NULL;
+}
 
 /**
  * The array group writer which emits array v2 file formats.
@@ -597,6 +710,15 @@ class sarray_group_format_writer_v2: public sarray_group_format_writer<T> {
     return m_writer.get_index_info();
   }
 
+  /**
+   * Sets how the blocks written after this call are compressed.
+   * See v2_block_impl::block_writer::set_compression()
+   */
+  void set_compression(v2_block_impl::block_compression_type type,
+                       int level = 0) {
+    m_writer.set_compression(type, level);
+  }
+
   /**
    * Writes a row to the array group
    */
@@ -478,6 +478,30 @@ class sarray_reader: public siterable<sarray_iterator<T> > {
                    size_t row_end, 
                    sframe_rows& out_obj);
 
+  /**
+   * Returns the statistics (min / max / undefined count) of the on disk 
+   * block containing a given row, and stores the range of rows covered by
+   * the block in [block_row_start, block_row_end).
+   * Returns NULL if the statistics are not available.
+   *
+   * This function should only be used for sarray<flexible_type> and
+   * will fail fatally otherwise.
+   */
+  const v2_block_impl::block_statistics* 
+      get_block_statistics(size_t row, 
+                           size_t& block_row_start, 
+                           size_t& block_row_end);
+
+
+  /**
+   * Sets the number of blocks to read ahead of sequential reads in the
+   * background. 0 disables readahead. Defaults to 
+   * sframe_config::SFRAME_READAHEAD_BLOCKS.
+   */
+  void set_readahead(size_t num_blocks) {
+    DASSERT_NE(reader, NULL);
+    reader->set_readahead(num_blocks);
+  }
 
   /**
    * Resets all the file handles. All existing iterators are invalidated.
@@ -596,6 +620,12 @@ class sarray_reader: public siterable<sarray_iterator<T> > {
                              segment_row_start_end[i].first, 
                              segment_row_start_end[i].second);
     }
+    // segments are scanned independently; readahead stops at their ends
+    std::vector<size_t> segment_ends;
+    for (const auto& start_end: segment_row_start_end) {
+      segment_ends.push_back(start_end.second);
+    }
+    reader->set_readahead_range_ends(segment_ends);
   }
 };
 
@@ -617,6 +647,24 @@ inline size_t sarray_reader<flexible_type>::read_rows(size_t row_start,
   return reader->read_rows(row_start, row_end, out_obj);
 }
 
+template <typename T>
+inline const v2_block_impl::block_statistics* 
+sarray_reader<T>::get_block_statistics(size_t row, 
+                                       size_t& block_row_start, 
+                                       size_t& block_row_end) {
+  ASSERT_MSG(false, "get_block_statistics() not implemented for "
+                    "non-flexible_type templatizations of sarray");
+  return NULL;
+}
+
+template <>
+inline const v2_block_impl::block_statistics* 
+sarray_reader<flexible_type>::get_block_statistics(size_t row, 
+                                                   size_t& block_row_start, 
+                                                   size_t& block_row_end) {
+  DASSERT_NE(reader, NULL);
+  return reader->get_block_statistics(row, block_row_start, block_row_end);
+}
 
 } // namespace graphlab
 
@@ -0,0 +1,122 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <mutex>
+#include <util/cityhash_gl.hpp>
+#include <sframe/sarray_v2_block_cache.hpp>
+#include <sframe/sframe_config.hpp>
+
+namespace graphlab {
+namespace v2_block_impl {
+
+block_cache& block_cache::get_instance() {
+  static block_cache cache;
+  return cache;
+}
+
+size_t block_cache::key_hash::operator()(const key& k) const {
+  return hash64_combine(hash64(k.segment_file),
+                        hash64(k.file_size, k.column_id, k.block_id));
+}
+
+bool block_cache::enabled() const {
+  return sframe_config::SFRAME_BLOCK_CACHE_SIZE > 0;
+}
+
+std::shared_ptr<const char> block_cache::get(const key& k, size_t& ret_length) {
+  std::lock_guard<graphlab::mutex> guard(m_lock);
+  auto iter = m_index.find(k);
+  if (iter == m_index.end()) {
+    m_misses.inc();
+    return std::shared_ptr<const char>();
+  }
+  m_hits.inc();
+  // move to the front of the lru list
+  m_lru.splice(m_lru.begin(), m_lru, iter->second);
+  ret_length = iter->second->length;
+  return iter->second->data;
+}
+
+void block_cache::insert(const key& k,
+                         std::shared_ptr<const char> data,
+                         size_t length,
+                         size_t charge) {
+  std::lock_guard<graphlab::mutex> guard(m_lock);
+  // read under the lock so that a concurrent set_capacity() cannot be undone
+  size_t budget = sframe_config::SFRAME_BLOCK_CACHE_SIZE;
+  if (charge > budget) return;
+  auto iter = m_index.find(k);
+  if (iter != m_index.end()) {
+    // already inserted by a concurrent reader
+    m_lru.splice(m_lru.begin(), m_lru, iter->second);
+    return;
+  }
+  m_lru.push_front(entry{k, data, length, charge});
+  m_index[k] = m_lru.begin();
+  m_memory_usage += charge;
+  evict_to_budget(budget);
+}
+
+void block_cache::invalidate_file(const std::string& segment_file) {
+  std::lock_guard<graphlab::mutex> guard(m_lock);
+  auto iter = m_lru.begin();
+  while (iter != m_lru.end()) {
+    if (iter->k.segment_file == segment_file) {
+      m_memory_usage -= iter->charge;
+      m_index.erase(iter->k);
+      iter = m_lru.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+void block_cache::clear() {
+  std::lock_guard<graphlab::mutex> guard(m_lock);
+  m_lru.clear();
+  m_index.clear();
+  m_memory_usage = 0;
+}
+
+void block_cache::set_capacity(size_t capacity) {
+  std::lock_guard<graphlab::mutex> guard(m_lock);
+  sframe_config::SFRAME_BLOCK_CACHE_SIZE = capacity;
+  evict_to_budget(capacity);
+}
+
+block_cache::statistics block_cache::get_statistics() const {
+  statistics ret;
+  ret.hits = m_hits.value;
+  ret.misses = m_misses.value;
+  ret.evictions = m_evictions.value;
+  std::lock_guard<graphlab::mutex> guard(m_lock);
+  ret.num_entries = m_lru.size();
+  ret.memory_usage = m_memory_usage;
+  return ret;
+}
+
+void block_cache::evict_to_budget(size_t budget) {
+  while (m_memory_usage > budget && !m_lru.empty()) {
+    entry& e = m_lru.back();
+    m_memory_usage -= e.charge;
+    m_index.erase(e.k);
+    m_lru.pop_back();
+    m_evictions.inc();
+  }
+}
+
+} // namespace v2_block_impl
+} // namespace graphlab
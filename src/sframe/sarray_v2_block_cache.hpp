@@ -0,0 +1,142 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GRAPHLAB_SFRAME_SARRAY_V2_BLOCK_CACHE_HPP
+#define GRAPHLAB_SFRAME_SARRAY_V2_BLOCK_CACHE_HPP
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <parallel/pthread_tools.hpp>
+#include <parallel/atomic.hpp>
+namespace graphlab {
+namespace v2_block_impl {
+
+/**
+ * A process wide LRU cache of decompressed (but still type encoded) v2
+ * blocks, shared by all readers through the \ref block_manager.
+ *
+ * Blocks are identified by the segment file they live in (its name and size)
+ * and their column and block numbers within the segment. This allows a
+ * block to be found again after the segment is closed and reopened, which
+ * happens on every query over an SFrame.
+ *
+ * The total size of the cached blocks is bounded by
+ * sframe_config::SFRAME_BLOCK_CACHE_SIZE bytes. Setting it to 0 disables the
+ * cache. Cached blocks are held by shared pointers, so evicting a block
+ * never invalidates data a reader is still using.
+ *
+ * All functions are safe for concurrent use.
+ */
+class block_cache {
+ public:
+  /// Identifies a block in a segment file
+  struct key {
+    std::string segment_file;
+    size_t file_size;
+    size_t column_id;
+    size_t block_id;
+    bool operator==(const key& other) const {
+      return segment_file == other.segment_file &&
+          file_size == other.file_size &&
+          column_id == other.column_id &&
+          block_id == other.block_id;
+    }
+  };
+
+  /// Cache usage counters
+  struct statistics {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t num_entries = 0;
+    size_t memory_usage = 0;
+  };
+
+  /// Get singleton instance
+  static block_cache& get_instance();
+
+  /// Returns true if the cache budget is non-zero.
+  bool enabled() const;
+
+  /**
+   * Looks up a block. Returns the block contents and stores its length in
+   * ret_length on a hit. Returns an empty pointer on a miss.
+   */
+  std::shared_ptr<const char> get(const key& k, size_t& ret_length);
+
+  /**
+   * Inserts a block, evicting the least recently used blocks to stay
+   * within budget. charge is the number of bytes the block holds on to
+   * (which may exceed length if the data lives in a larger buffer).
+   * Blocks larger than the whole budget are not cached.
+   */
+  void insert(const key& k,
+              std::shared_ptr<const char> data,
+              size_t length,
+              size_t charge);
+
+  /**
+   * Drops all blocks belonging to a segment file. Called when the file is
+   * (re)written.
+   */
+  void invalidate_file(const std::string& segment_file);
+
+  /// Drops all blocks. The counters are not reset.
+  void clear();
+
+  /**
+   * Changes the budget to capacity bytes, evicting the least recently used
+   * blocks right away to fit. Called when the SFRAME_BLOCK_CACHE_SIZE global
+   * is set, so that lowering it (or setting it to 0, which disables the
+   * cache) also frees the blocks already cached.
+   */
+  void set_capacity(size_t capacity);
+
+  /// Returns the usage counters
+  statistics get_statistics() const;
+
+ private:
+  struct key_hash {
+    size_t operator()(const key& k) const;
+  };
+
+  struct entry {
+    key k;
+    std::shared_ptr<const char> data;
+    size_t length;
+    size_t charge;
+  };
+
+  typedef std::list<entry> lru_list_type;
+
+  mutable graphlab::mutex m_lock;
+  /// most recently used at the front
+  lru_list_type m_lru;
+  std::unordered_map<key, lru_list_type::iterator, key_hash> m_index;
+  size_t m_memory_usage = 0;
+
+  graphlab::atomic<size_t> m_hits;
+  graphlab::atomic<size_t> m_misses;
+  graphlab::atomic<size_t> m_evictions;
+
+  /// Evicts from the back of the list until within budget. Lock must be held.
+  void evict_to_budget(size_t budget);
+};
+
+} // namespace v2_block_impl
+} // namespace graphlab
+#endif
@@ -17,10 +17,16 @@
 extern "C" {
 #include <lz4/lz4.h>
 }
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <algorithm>
 #include <mutex>
 #include <boost/algorithm/string.hpp>
+#include <fileio/fs_utils.hpp>
 #include <sframe/sarray_v2_block_manager.hpp>
+#include <sframe/sarray_v2_block_cache.hpp>
 #include <sframe/sarray_index_file.hpp>
 #include <sframe/sframe_constants.hpp>
 #include <sframe/unfair_lock.hpp>
@@ -43,6 +49,10 @@ block_manager::block_manager() {
   m_buffer_pool.init(SFRAME_BLOCK_MANAGER_BLOCK_BUFFER_COUNT);
 }
 
+block_manager::mapped_file::~mapped_file() {
+  if (data) munmap(const_cast<char*>(data), length);
+}
+
 column_address block_manager::open_column(std::string column_file) {
   std::lock_guard<graphlab::mutex> guard(m_global_lock);
   std::pair<std::string, size_t> parsed_fname = parse_v2_segment_filename(column_file); 
@@ -107,6 +117,10 @@ void block_manager::close_column(column_address addr) {
   }
 }
 
+bool block_manager::is_column_mapped(column_address addr) {
+  return get_segment(std::get<0>(addr))->mapping != nullptr;
+}
+
 size_t block_manager::num_blocks_in_column(column_address addr) {
   // get the segment 
   size_t segment_id = std::get<0>(addr);
@@ -125,6 +139,18 @@ const block_info& block_manager::get_block_info(block_address addr) {
   return seg->blocks[column_id][block_id];
 }
 
+const block_statistics* block_manager::get_block_statistics(block_address addr) {
+  size_t segment_id, column_id, block_id;
+  std::tie(segment_id, column_id, block_id) = addr;
+  // get the segment 
+  std::shared_ptr<segment> seg = get_segment(segment_id);
+  if (seg->block_stats.size() <= column_id ||
+      seg->block_stats[column_id].size() <= block_id) {
+    return NULL;
+  }
+  return &(seg->block_stats[column_id][block_id]);
+}
+
 std::shared_ptr<std::vector<char> > 
 block_manager::read_block(block_address addr, block_info** ret_info) {
 
@@ -140,6 +166,27 @@ block_manager::read_block(block_address addr, block_info** ret_info) {
   // get the return buffer
   // resize ret to the block length on disk
   std::shared_ptr<std::vector<char> > ret = m_buffer_pool.get_new_buffer();
+
+  if (seg->mapping) {
+    // read straight out of the mapping. No file handles or locks needed.
+    if (info.offset + info.length > seg->mapping->length) {
+      m_buffer_pool.release_buffer(std::move(ret));
+      ret.reset();
+      return ret;
+    }
+    const char* src = seg->mapping->data + info.offset;
+    if (info.flags & LZ4_COMPRESSION) {
+      ret->resize(info.block_size);
+      LZ4_decompress_safe(src,                // src
+                          ret->data(),        // target
+                          info.length,        // src length
+                          info.block_size);   // target length
+    } else {
+      ret->assign(src, src + info.length);
+    }
+    return ret;
+  }
+
   ret->resize(info.length);
 
   // acquire lock on get the file handle and perform the read
@@ -179,16 +226,70 @@ block_manager::read_block(block_address addr, block_info** ret_info) {
 
 
 
+std::shared_ptr<const char> 
+block_manager::read_block_view(block_address addr, 
+                               size_t& ret_length,
+                               block_info** ret_info) {
+  size_t segment_id, column_id, block_id;
+  std::tie(segment_id, column_id, block_id) = addr;
+  // get the segment 
+  std::shared_ptr<segment> seg = get_segment(segment_id);
+  // get the block info
+  block_info& info = seg->blocks[column_id][block_id];
+
+  if (seg->mapping && !(info.flags & LZ4_COMPRESSION)) {
+    if(ret_info) (*ret_info) = &info;
+    if (info.offset + info.length > seg->mapping->length) {
+      return std::shared_ptr<const char>();
+    }
+    ret_length = info.length;
+    // aliasing pointer: keeps the mapping alive while pointing at the block
+    return std::shared_ptr<const char>(seg->mapping, 
+                                       seg->mapping->data + info.offset);
+  }
+
+  // compressed or not mapped. Try the shared cache, then go through the 
+  // regular read path.
+  block_cache& cache = block_cache::get_instance();
+  bool use_cache = cache.enabled();
+  block_cache::key cache_key{seg->segment_file, seg->file_size, 
+                             column_id, block_id};
+  if (use_cache) {
+    std::shared_ptr<const char> cached = cache.get(cache_key, ret_length);
+    if (cached) {
+      if(ret_info) (*ret_info) = &info;
+      return cached;
+    }
+  }
+  std::shared_ptr<std::vector<char> > buffer = read_block(addr, ret_info);
+  if (!buffer) return std::shared_ptr<const char>();
+  ret_length = buffer->size();
+  if (use_cache) {
+    // The cache owns the buffer from now on. It is freed on eviction.
+    std::shared_ptr<const char> ret(buffer, buffer->data());
+    cache.insert(cache_key, ret, ret_length, buffer->capacity());
+    return ret;
+  }
+  // The buffer returns to the pool once the view is released.
+  const char* data = buffer->data();
+  return std::shared_ptr<const char>(
+      data,
+      [this, buffer](const char*) mutable {
+        m_buffer_pool.release_buffer(std::move(buffer));
+      });
+}
+
+
 bool block_manager::read_typed_block(block_address addr, 
                                      std::vector<flexible_type>& ret,
                                      block_info** ret_info) {
   block_info* info;
-  std::shared_ptr<std::vector<char> > read_buffer = read_block(addr, &info);
+  size_t length = 0;
+  std::shared_ptr<const char> read_buffer = read_block_view(addr, length, &info);
   if (ret_info) (*ret_info) = info;
   if (!read_buffer) return false;
   // check that the block flags match
-  bool success = typed_decode(*info, read_buffer->data(), read_buffer->size(), ret);
-  m_buffer_pool.release_buffer(std::move(read_buffer));
+  bool success = typed_decode(*info, read_buffer.get(), length, ret);
   // check its the correct number of elements read
   return success;
 }
@@ -218,6 +319,31 @@ std::shared_ptr<block_manager::segment> block_manager::get_segment(size_t segid)
   return m_segments[segid];
 }
 
+std::shared_ptr<block_manager::mapped_file> 
+block_manager::map_segment_file(const std::string& file) {
+  std::shared_ptr<mapped_file> ret;
+  // only plain local paths can be mapped
+  if (!SFRAME_MMAP_READ || !fileio::get_protocol(file).empty()) return ret;
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) return ret;
+  struct stat statout;
+  if (fstat(fd, &statout) == 0 && statout.st_size > 0) {
+    void* addr = mmap(NULL, statout.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr != MAP_FAILED) {
+      ret = std::make_shared<mapped_file>();
+      ret->data = reinterpret_cast<const char*>(addr);
+      ret->length = statout.st_size;
+    }
+  }
+  // the mapping remains valid after the descriptor is closed
+  close(fd);
+  if (!ret) {
+    logstream(LOG_DEBUG) << "Unable to memory map " << file 
+                         << ". Falling back to stream reads." << std::endl;
+  }
+  return ret;
+}
+
 std::shared_ptr<general_ifstream> 
 block_manager::get_segment_file_handle(std::shared_ptr<segment>& group) {
   std::shared_ptr<general_ifstream> fin = group->segment_file_handle.lock();
@@ -248,8 +374,26 @@ void block_manager::init_segment(std::shared_ptr<block_manager::segment>& seg) {
   // deserialize the block information
   fin->clear();
   fin->seekg(filesize - footer_size - sizeof(footer_size), std::ios_base::beg);
-  iarchive iarc(*fin);
+  std::vector<char> footer(footer_size);
+  fin->read(footer.data(), footer_size);
+  if (fin->fail()) {
+    log_and_throw("Unable to read segment footer of " + seg->segment_file);
+  }
+  iarchive iarc(footer.data(), footer.size());
   iarc >> seg->blocks;
+  // the block statistics may follow the block information
+  seg->block_stats.clear();
+  if (iarc.off + sizeof(uint64_t) <= footer_size) {
+    uint64_t magic = 0;
+    iarc >> magic;
+    if (magic == BLOCK_STATISTICS_FOOTER_MAGIC) {
+      iarc >> seg->block_stats;
+      if (seg->block_stats.size() != seg->blocks.size()) seg->block_stats.clear();
+    }
+  }
+
+  seg->mapping = map_segment_file(seg->segment_file);
+  if (seg->mapping && seg->mapping->length != filesize) seg->mapping.reset();
 
   seg->inited = true;
   seg->file_size = filesize;
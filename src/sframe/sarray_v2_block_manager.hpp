@@ -63,7 +63,10 @@ namespace v2_block_impl {
  * Each segment file internally then has the following layout
  *  (1) Consecutive Block contents, each block 4K aligned.
  *  (2) A direct serialization of a vector<vector<block_info> > (blocks[column_id][block_id])
- *  (3) 8 bytes containing the file offset. at which (2) begins
+ *      optionally followed by BLOCK_STATISTICS_FOOTER_MAGIC and a direct
+ *      serialization of a vector<vector<block_statistics> > with the same
+ *      shape.
+ *  (3) 8 bytes containing the size of (2)
  *
  * For instance, if there are 2 segments with 3 columns each of 20 rows, 
  * we may get the following layout: 
@@ -184,11 +187,25 @@ class block_manager {
    */
   size_t num_blocks_in_column(column_address addr);
 
+  /**
+   * Returns true if the segment file of the column is memory mapped.
+   * See SFRAME_MMAP_READ.
+   */
+  bool is_column_mapped(column_address addr);
+
   /** Returns the number of rows in a block
    * Returns (size_t)(-1) on failure.
    */
   const block_info& get_block_info(block_address addr); 
 
+  /**
+   * Returns the statistics (min / max / undefined count) of a block.
+   * Returns NULL if the segment file was written without block statistics.
+   * The pointer is into internal datastructures of the block manager and
+   * remains valid as long as the column is open.
+   */
+  const block_statistics* get_block_statistics(block_address addr);
+
   /** 
    * Reads a block as bytes a block address ((array_group ID, segment ID, block
    * ID) tuple),  
@@ -204,6 +221,31 @@ class block_manager {
   std::shared_ptr<std::vector<char> >
     read_block(block_address addr, block_info** ret_info = NULL);
 
+  /** 
+   * Reads a block as bytes a block address ((array_group ID, segment ID, block
+   * ID) tuple), avoiding copies where possible.
+   *
+   * If the segment file is memory mapped (see SFRAME_MMAP_READ) and the
+   * block is not compressed, the returned pointer is a view directly into
+   * the mapping; no buffer is allocated and no file handle lock is taken.
+   * Otherwise the block is looked up in the shared \ref block_cache, and 
+   * read with \ref read_block() (and cached) on a miss. In either case the
+   * returned pointer keeps the data alive, and the length of the data is
+   * stored in ret_length.
+   *
+   *  If info is not NULL, A pointer to the block information will be stored 
+   *  info *info. This is a pointer into internal datastructures of the
+   *  block manager and should not be modified or freed.
+   *
+   *  Return an empty pointer on failure.
+   *
+   *  Safe for concurrent operation.
+   */
+  std::shared_ptr<const char>
+    read_block_view(block_address addr, 
+                    size_t& ret_length,
+                    block_info** ret_info = NULL);
+
 
   /** 
    * Reads a block given a block address ((array_group ID, segment ID, block
@@ -258,6 +300,16 @@ class block_manager {
 
   mutable graphlab::mutex m_global_lock;
   mutable graphlab::mutex m_file_handles_lock;
+
+  /**
+   * A read only memory mapping of an entire segment file.
+   * The mapping is released when the last reference is dropped.
+   */
+  struct mapped_file {
+    const char* data = NULL;
+    size_t length = 0;
+    ~mapped_file();
+  };
   /**
    * Describes an array group and all the file handles pointing into 
    * the array group
@@ -284,6 +336,21 @@ class block_manager {
      */
     std::vector<std::vector<block_info> > blocks;
 
+    /**
+     * The statistics for each block. Same shape as blocks, or empty if the 
+     * segment file was written without block statistics.
+     * block_stats[column_id][block_id]
+     */
+    std::vector<std::vector<block_statistics> > block_stats;
+
+    /**
+     * The memory mapping of the segment file if it lives on local disk and
+     * SFRAME_MMAP_READ is set. NULL otherwise. Once inited, this is never 
+     * modified. Views returned by read_block_view() hold a reference to it, 
+     * so it may outlive the segment.
+     */
+    std::shared_ptr<mapped_file> mapping;
+
     graphlab::atomic<size_t> reference_count;
   };
   
@@ -329,6 +396,12 @@ class block_manager {
 
   std::shared_ptr<segment> get_segment(size_t segmentid);
 
+  /**
+   * Memory maps a local segment file. Returns an empty pointer if the file 
+   * is not on the local filesystem or cannot be mapped.
+   */
+  std::shared_ptr<mapped_file> map_segment_file(const std::string& file);
+
   void init_segment(std::shared_ptr<segment>& seg);
 };
 
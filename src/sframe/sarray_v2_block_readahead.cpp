@@ -0,0 +1,131 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <mutex>
+#include <parallel/thread_pool.hpp>
+#include <sframe/sarray_v2_block_readahead.hpp>
+#include <sframe/sarray_v2_block_manager.hpp>
+#include <sframe/sarray_v2_type_encoding.hpp>
+
+namespace graphlab {
+namespace v2_block_impl {
+
+/**
+ * The readahead tasks run on their own pool so that they are never queued
+ * behind (or starve) the compute tasks on thread_pool::get_instance().
+ * The tasks mostly wait on IO so the pool is not limited to the cpu count.
+ */
+static thread_pool& get_readahead_pool() {
+  static thread_pool pool(std::max<size_t>(thread::cpu_count(), 4));
+  return pool;
+}
+
+block_readahead::block_readahead(const std::vector<block_address>& blocks) {
+  m_state = std::make_shared<shared_state>();
+  m_state->blocks = blocks;
+}
+
+block_readahead::~block_readahead() {
+  cancel();
+}
+
+bool block_readahead::schedule(size_t block_number, size_t max_outstanding) {
+  {
+    std::lock_guard<mutex> guard(m_state->lock);
+    if (block_number >= m_state->blocks.size()) return false;
+    if (m_state->slots.count(block_number)) return true;
+    if (m_state->slots.size() >= max_outstanding) return false;
+    m_state->slots[block_number] = slot();
+  }
+  auto state = m_state;
+  get_readahead_pool().launch([state, block_number]() {
+                                read_block_task(state, block_number);
+                              });
+  return true;
+}
+
+void block_readahead::read_block_task(std::shared_ptr<shared_state> state,
+                                      size_t block_number) {
+  block_address addr;
+  {
+    std::lock_guard<mutex> guard(state->lock);
+    auto iter = state->slots.find(block_number);
+    // cancelled, or claimed by the consumer before we got here
+    if (iter == state->slots.end() ||
+        iter->second.state != slot_state::QUEUED) return;
+    iter->second.state = slot_state::RUNNING;
+    ++state->num_running;
+    addr = state->blocks[block_number];
+  }
+  auto data = std::make_shared<std::vector<flexible_type> >();
+  try {
+    if (!block_manager::get_instance().read_typed_block(addr, *data)) {
+      data.reset();
+    }
+  } catch (...) {
+    // the consumer will retry the read itself and see the error
+    data.reset();
+  }
+  std::lock_guard<mutex> guard(state->lock);
+  auto iter = state->slots.find(block_number);
+  if (iter != state->slots.end()) {
+    iter->second.state = slot_state::DONE;
+    iter->second.data = data;
+  }
+  --state->num_running;
+  state->cond.broadcast();
+}
+
+bool block_readahead::take(size_t block_number,
+                           std::shared_ptr<std::vector<flexible_type> >& ret) {
+  std::unique_lock<mutex> guard(m_state->lock);
+  auto iter = m_state->slots.find(block_number);
+  if (iter == m_state->slots.end()) return false;
+  while (iter->second.state == slot_state::RUNNING) {
+    m_state->cond.wait(m_state->lock);
+    // another consumer may have claimed it in the mean time
+    iter = m_state->slots.find(block_number);
+    if (iter == m_state->slots.end()) return false;
+  }
+  // if still queued, erasing it cancels the read
+  ret = std::move(iter->second.data);
+  m_state->slots.erase(iter);
+  return ret != nullptr;
+}
+
+void block_readahead::drop_before(size_t block_number) {
+  std::lock_guard<mutex> guard(m_state->lock);
+  auto iter = m_state->slots.begin();
+  while (iter != m_state->slots.end() && iter->first < block_number) {
+    if (iter->second.state == slot_state::RUNNING) ++iter;
+    else iter = m_state->slots.erase(iter);
+  }
+}
+
+void block_readahead::cancel() {
+  std::unique_lock<mutex> guard(m_state->lock);
+  // erasing the queued slots cancels them
+  auto iter = m_state->slots.begin();
+  while (iter != m_state->slots.end()) {
+    if (iter->second.state == slot_state::RUNNING) ++iter;
+    else iter = m_state->slots.erase(iter);
+  }
+  while (m_state->num_running > 0) m_state->cond.wait(m_state->lock);
+  m_state->slots.clear();
+}
+
+} // namespace v2_block_impl
+} // namespace graphlab
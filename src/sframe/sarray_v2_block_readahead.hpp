@@ -0,0 +1,110 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GRAPHLAB_SFRAME_SARRAY_V2_BLOCK_READAHEAD_HPP
+#define GRAPHLAB_SFRAME_SARRAY_V2_BLOCK_READAHEAD_HPP
+#include <map>
+#include <memory>
+#include <vector>
+#include <parallel/pthread_tools.hpp>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sarray_v2_block_types.hpp>
+namespace graphlab {
+namespace v2_block_impl {
+
+/**
+ * Background reading and decoding of the blocks of a typed v2 column.
+ *
+ * The sarray_format_reader_v2 uses this to read ahead of a sequential scan:
+ * when it finishes a block, it schedules the next few blocks, which are read
+ * (fetched, decompressed and decoded) on a dedicated thread pool while the
+ * consumer works on the current one. The consumer then claims a block with
+ * \ref take().
+ *
+ * If the consumer gets to a block whose read has not yet started, the read
+ * is cancelled and take() returns false so the consumer reads the block
+ * itself. take() thus never waits on a task stuck in a queue, which
+ * keeps it deadlock free when readers run inside thread pool tasks.
+ *
+ * All functions are safe for concurrent use. Destruction cancels queued
+ * reads and waits for the ones running, so the columns the blocks belong
+ * to must stay open until the object is destroyed.
+ */
+class block_readahead {
+ public:
+  /**
+   * Constructs a readahead over a list of blocks. block numbers in the
+   * other functions index into this list.
+   */
+  explicit block_readahead(const std::vector<block_address>& blocks);
+
+  /// Cancels all outstanding reads. See \ref cancel()
+  ~block_readahead();
+
+  block_readahead(const block_readahead&) = delete;
+  block_readahead& operator=(const block_readahead&) = delete;
+
+  /**
+   * Schedules a background read of a block, unless it is already
+   * scheduled or max_outstanding blocks are already scheduled but not yet
+   * taken. Returns true if the block is scheduled after the call.
+   */
+  bool schedule(size_t block_number, size_t max_outstanding);
+
+  /**
+   * Claims a block read in the background. If the block's read is in
+   * progress, waits for it. Returns true and stores the decoded block in ret
+   * on success. Returns false if the block was not scheduled, the read had
+   * not started yet (it is then cancelled), or the read failed.
+   */
+  bool take(size_t block_number,
+            std::shared_ptr<std::vector<flexible_type> >& ret);
+
+  /**
+   * Drops blocks which were read but not taken, and whose block number is
+   * less than block_number.
+   */
+  void drop_before(size_t block_number);
+
+  /**
+   * Cancels all queued reads, waits for the running ones and drops
+   * everything which was not taken.
+   */
+  void cancel();
+
+ private:
+  enum class slot_state { QUEUED, RUNNING, DONE };
+  struct slot {
+    slot_state state = slot_state::QUEUED;
+    std::shared_ptr<std::vector<flexible_type> > data;
+  };
+  /// State shared with the background tasks, which may outlive this object
+  struct shared_state {
+    mutex lock;
+    conditional cond;
+    std::vector<block_address> blocks;
+    std::map<size_t, slot> slots;
+    size_t num_running = 0;
+  };
+  std::shared_ptr<shared_state> m_state;
+
+  static void read_block_task(std::shared_ptr<shared_state> state,
+                              size_t block_number);
+};
+
+} // namespace v2_block_impl
+} // namespace graphlab
+#endif
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <tuple>
 #include <serialization/serializable_pod.hpp>
+#include <flexible_type/flexible_type.hpp>
 namespace graphlab {
 namespace v2_block_impl {
 
@@ -26,9 +27,52 @@ namespace v2_block_impl {
 enum BLOCK_FLAGS {
   LZ4_COMPRESSION = 1,
   IS_FLEXIBLE_TYPE = 2,
-  MULTIPLE_TYPE_BLOCK = 4
+  MULTIPLE_TYPE_BLOCK = 4,
+  RLE_ENCODING = 8,
+  DELTA_OF_DELTA_ENCODING = 16,
+  XOR_DOUBLE_ENCODING = 32
 };
 
+/**
+ * How the block writer compresses blocks. Blocks compressed with either
+ * LZ4 or LZ4HC are flagged LZ4_COMPRESSION and decompressed the same way.
+ */
+enum class block_compression_type: int {
+  NONE = 0,   ///< Blocks are stored uncompressed
+  LZ4 = 1,    ///< Fast LZ4 compression
+  LZ4HC = 2   ///< LZ4HC compression. Slower to write, smaller blocks.
+};
+
+/**
+ * The largest LZ4HC compression level. Levels are 1 to 16 where higher is
+ * slower and smaller. 0 picks the LZ4HC default.
+ */
+static constexpr int MAX_LZ4HC_COMPRESSION_LEVEL = 16;
+
+/**
+ * The flags of the extended typed block encodings (see typed_encode()).
+ * A typed block using one of these has exactly one of them set and does
+ * *not* set IS_FLEXIBLE_TYPE, so that readers which predate them refuse
+ * the block instead of misreading it.
+ */
+static constexpr uint64_t EXTENDED_ENCODING_FLAGS = 
+    RLE_ENCODING | DELTA_OF_DELTA_ENCODING | XOR_DOUBLE_ENCODING;
+
+/**
+ * All the flags this version understands. Blocks with any other flag set
+ * were written by a newer version and cannot be read.
+ */
+static constexpr uint64_t KNOWN_BLOCK_FLAGS = 
+    LZ4_COMPRESSION | IS_FLEXIBLE_TYPE | MULTIPLE_TYPE_BLOCK | 
+    EXTENDED_ENCODING_FLAGS;
+
+/**
+ * Returns true if the block flags describe a block of flexible_type values.
+ */
+inline bool is_typed_block(uint64_t flags) {
+  return (flags & (IS_FLEXIBLE_TYPE | EXTENDED_ENCODING_FLAGS)) != 0;
+}
+
 
 /**
  * A column address is a tuple of segment_id, 
@@ -56,12 +100,63 @@ struct block_info: public graphlab::IS_POD_TYPE {
   uint64_t num_elem = 0; /// The number of elements in the block
   uint64_t flags = 0;  /// block flags
   /**
-   * If flags & IS_FLEXIBLE_TYPE, the type of the contents.
+   * If is_typed_block(flags), the type of the contents.
    * This is really of type flex_type_enum
    */
   uint16_t content_type = 0;
 };
 
+/**
+ * Marks the start of the block statistics section in the segment footer.
+ * The statistics follow the block_info array, so readers which do not know
+ * about them simply stop reading after the block_info array.
+ */
+static constexpr uint64_t BLOCK_STATISTICS_FOOTER_MAGIC = 0x5354415453763231ULL;
+
+/**
+ * The longest string min_value or max_value stored in the block statistics.
+ * Longer bounds are cut down to a prefix so that a column of large strings
+ * does not bloat the segment footer.
+ */
+static constexpr size_t MAX_BLOCK_STATISTICS_STRING_LENGTH = 64;
+
+/**
+ * Per block statistics ("zone map") stored in the segment footer alongside
+ * the block_info.
+ *
+ * min_value and max_value bound every non-undefined value in the block, and
+ * are only meaningful if has_bounds is set. has_bounds is only set if all
+ * the defined values in the block are of the same type, and that type is one
+ * of INTEGER, FLOAT, DATETIME or STRING (and for FLOAT, none of the values
+ * are NaN).
+ *
+ * STRING bounds are at most MAX_BLOCK_STATISTICS_STRING_LENGTH long, so they
+ * need not be values of the block: a longer min_value is cut to its prefix,
+ * and a longer max_value is cut to its prefix with the last byte incremented
+ * (the block has no bounds if the prefix is all 0xFF bytes).
+ */
+struct block_statistics {
+  /// Whether min_value and max_value bound the contents of the block
+  bool has_bounds = false;
+  /// The smallest defined value in the block
+  flexible_type min_value;
+  /// The largest defined value in the block
+  flexible_type max_value;
+  /// The number of undefined values in the block
+  uint64_t num_undefined = 0;
+  /// The number of elements in the block
+  uint64_t num_elem = 0;
+
+  void save(oarchive& oarc) const {
+    oarc << has_bounds << min_value << max_value << num_undefined << num_elem;
+  }
+
+  void load(iarchive& iarc) {
+    iarc >> has_bounds >> min_value >> max_value >> num_undefined >> num_elem;
+  }
+};
+
+
 } // v2_block_impl
 } // graphlab
 
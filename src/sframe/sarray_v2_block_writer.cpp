@@ -16,10 +16,14 @@
 */
 extern "C" {
 #include <lz4/lz4.h>
+#include <lz4/lz4hc.h>
 }
+#include <cmath>
 #include <sframe/sarray_v2_block_writer.hpp>
+#include <sframe/sarray_v2_block_cache.hpp>
 #include <sframe/sarray_index_file.hpp>
 #include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
 #include <sframe/sarray_v2_type_encoding.hpp>
 
 namespace graphlab {
@@ -34,10 +38,17 @@ void block_writer::init(std::string group_index_file,
 
   // 1x for the compression buffer, 
   // 1x for the flexible_type serialization buffer
-  m_buffer_pool.init(2 * num_segments); 
+  // 1x for the LZ4HC compression state
+  m_buffer_pool.init(3 * num_segments); 
+
+  set_compression(
+      (block_compression_type)sframe_config::SFRAME_COMPRESSION_TYPE,
+      sframe_config::SFRAME_COMPRESSION_LEVEL);
 
   m_blocks.resize(num_segments);
   for (auto& m_blockseg: m_blocks) m_blockseg.resize(num_columns);
+  m_block_stats.resize(num_segments);
+  for (auto& m_statseg: m_block_stats) m_statseg.resize(num_columns);
   m_index_info.group_index_file = group_index_file;
   m_index_info.version = 2;
   m_index_info.nsegments = num_segments;
@@ -62,6 +73,8 @@ void block_writer::init(std::string group_index_file,
 void block_writer::open_segment(size_t segmentid, std::string filename) {
   ASSERT_LT(segmentid, m_index_info.nsegments);
   ASSERT_TRUE(m_output_files[segmentid] == NULL);
+  // any cached blocks of a previous file with this name are stale
+  block_cache::get_instance().invalidate_file(filename);
   m_output_files[segmentid].reset(new general_ofstream(filename, 
                                                     /* must not compress! 
                                                      * We need the blocks!*/
@@ -82,10 +95,116 @@ void block_writer::open_segment(size_t segmentid, std::string filename) {
 
 static char padding_bytes[4096] = {0};
 
+/**
+ * Cuts a string upper bound down to MAX_BLOCK_STATISTICS_STRING_LENGTH,
+ * rounding it up so that it still bounds the original string. Returns false
+ * if there is no such bound, i.e. the prefix is all 0xFF bytes.
+ */
+static bool truncate_string_upper_bound(flex_string& bound) {
+  if (bound.length() <= MAX_BLOCK_STATISTICS_STRING_LENGTH) return true;
+  bound.resize(MAX_BLOCK_STATISTICS_STRING_LENGTH);
+  while (!bound.empty() && (unsigned char)bound.back() == 0xFF) bound.pop_back();
+  if (bound.empty()) return false;
+  bound.back() = (char)((unsigned char)bound.back() + 1);
+  return true;
+}
+
+/**
+ * Computes the min / max / undefined count of a block of values.
+ * Bounds are only computed if all defined values have the same type, and
+ * that type has a total order we can prune on. String bounds are cut down
+ * to MAX_BLOCK_STATISTICS_STRING_LENGTH.
+ */
+static block_statistics compute_block_statistics(const std::vector<flexible_type>& data) {
+  block_statistics stats;
+  stats.num_elem = data.size();
+  flex_type_enum bounds_type = flex_type_enum::UNDEFINED;
+  bool bounds_ok = true;
+  for (const flexible_type& val: data) {
+    flex_type_enum val_type = val.get_type();
+    if (val_type == flex_type_enum::UNDEFINED) {
+      ++stats.num_undefined;
+      continue;
+    }
+    if (!bounds_ok) continue;
+    if (bounds_type == flex_type_enum::UNDEFINED) {
+      if (val_type != flex_type_enum::INTEGER &&
+          val_type != flex_type_enum::FLOAT &&
+          val_type != flex_type_enum::DATETIME &&
+          val_type != flex_type_enum::STRING) {
+        bounds_ok = false;
+        continue;
+      }
+      bounds_type = val_type;
+      stats.min_value = val;
+      stats.max_value = val;
+    } else if (val_type != bounds_type) {
+      bounds_ok = false;
+      continue;
+    }
+    if (val_type == flex_type_enum::FLOAT && std::isnan(val.get<flex_float>())) {
+      bounds_ok = false;
+      continue;
+    }
+    if (val < stats.min_value) stats.min_value = val;
+    if (stats.max_value < val) stats.max_value = val;
+  }
+  stats.has_bounds = bounds_ok && bounds_type != flex_type_enum::UNDEFINED;
+  if (stats.has_bounds && bounds_type == flex_type_enum::STRING) {
+    // a prefix of the min is still a lower bound
+    flex_string& min_value = stats.min_value.mutable_get<flex_string>();
+    if (min_value.length() > MAX_BLOCK_STATISTICS_STRING_LENGTH) {
+      min_value.resize(MAX_BLOCK_STATISTICS_STRING_LENGTH);
+    }
+    stats.has_bounds = 
+        truncate_string_upper_bound(stats.max_value.mutable_get<flex_string>());
+  }
+  if (!stats.has_bounds) {
+    stats.min_value = FLEX_UNDEFINED;
+    stats.max_value = FLEX_UNDEFINED;
+  }
+  return stats;
+}
+
+void block_writer::set_compression(block_compression_type type, int level) {
+  if (type != block_compression_type::NONE && 
+      type != block_compression_type::LZ4 &&
+      type != block_compression_type::LZ4HC) {
+    log_and_throw("Invalid block compression type " + 
+                  std::to_string((int)type));
+  }
+  if (level < 0 || level > MAX_LZ4HC_COMPRESSION_LEVEL) {
+    log_and_throw("Invalid LZ4HC compression level " + std::to_string(level));
+  }
+  m_compression_type = type;
+  m_compression_level = level;
+}
+
+size_t block_writer::compress_block(const char* data, size_t len, char* cbuffer) {
+  switch(m_compression_type) {
+   case block_compression_type::LZ4:
+     return LZ4_compress(data, cbuffer, len);
+   case block_compression_type::LZ4HC:
+     {
+       // reuse the (fairly large) compression state across blocks
+       auto state_buffer = m_buffer_pool.get_new_buffer();
+       state_buffer->resize(LZ4_sizeofStateHC());
+       size_t clen = LZ4_compressHC2_withStateHC(state_buffer->data(), 
+                                                 data, cbuffer, len,
+                                                 m_compression_level);
+       m_buffer_pool.release_buffer(std::move(state_buffer));
+       return clen;
+     }
+   default:
+     return 0;
+  }
+}
+
 size_t block_writer::write_block(size_t segment_id,
                                  size_t column_id, 
                                  char* data,
-                                 block_info block) {
+                                 block_info block,
+                                 const block_statistics* stats) {
   DASSERT_LT(segment_id, m_index_info.nsegments);
   DASSERT_LT(column_id, m_index_info.columns.size());
   DASSERT_TRUE(m_output_files[segment_id] != NULL);
@@ -94,12 +213,11 @@ size_t block_writer::write_block(size_t segment_id,
   auto compression_buffer = m_buffer_pool.get_new_buffer();
   compression_buffer->resize(compress_bound);
   char* cbuffer = compression_buffer->data();
-  size_t clen = compress_bound;
-  clen = LZ4_compress(data, cbuffer, block.block_size);
+  size_t clen = compress_block(data, block.block_size, cbuffer);
 
   char* buffer_to_write = NULL;
   size_t buffer_to_write_len = 0;
-  if (clen < COMPRESSION_DISABLE_THRESHOLD * block.block_size) {
+  if (clen > 0 && clen < COMPRESSION_DISABLE_THRESHOLD * block.block_size) {
     // compression has a benefit!
     block.flags |= LZ4_COMPRESSION;
     block.length = clen;
@@ -124,6 +242,13 @@ size_t block_writer::write_block(size_t segment_id,
   m_output_files[segment_id]->write(buffer_to_write, buffer_to_write_len);
   m_output_files[segment_id]->write(padding_bytes, padding);
   m_blocks[segment_id][column_id].push_back(block);
+  if (stats) {
+    m_block_stats[segment_id][column_id].push_back(*stats);
+  } else {
+    block_statistics no_stats;
+    no_stats.num_elem = block.num_elem;
+    m_block_stats[segment_id][column_id].push_back(std::move(no_stats));
+  }
   m_output_file_locks[segment_id].unlock();
 
   m_buffer_pool.release_buffer(std::move(compression_buffer));
@@ -141,7 +266,9 @@ size_t block_writer::write_typed_block(size_t segment_id,
   auto serialization_buffer = m_buffer_pool.get_new_buffer();
   oarchive oarc(*serialization_buffer);
   typed_encode(data, block, oarc);
-  size_t ret = write_block(segment_id, column_id, serialization_buffer->data(), block);
+  block_statistics stats = compute_block_statistics(data);
+  size_t ret = write_block(segment_id, column_id, serialization_buffer->data(), 
+                           block, &stats);
   m_buffer_pool.release_buffer(std::move(serialization_buffer));
   return ret;
 }
@@ -166,6 +293,9 @@ void block_writer::emit_footer(size_t segment_id) {
   // write out all the block headers
   oarchive oarc;
   oarc << m_blocks[segment_id];
+  // followed by the block statistics. Older readers stop after the block 
+  // headers and never see this.
+  oarc << BLOCK_STATISTICS_FOOTER_MAGIC << m_block_stats[segment_id];
   m_output_files[segment_id]->write(oarc.buf, oarc.off);
   uint64_t footer_size = oarc.off;
 
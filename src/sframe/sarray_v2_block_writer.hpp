@@ -72,6 +72,14 @@ class block_writer {
   void open_segment(size_t segment_id,
                     std::string filename);
 
+  /**
+   * Sets how the blocks written after this call are compressed. 
+   * level is the LZ4HC compression level (1 - 16, 0 for the default) and
+   * is ignored for the other compression types. init() resets this to 
+   * sframe_config::SFRAME_COMPRESSION_TYPE and SFRAME_COMPRESSION_LEVEL.
+   */
+  void set_compression(block_compression_type type, int level = 0);
+
   /**
    * Writes a block of data into a segment.
    *
@@ -81,12 +89,15 @@ class block_writer {
    *
    * The only fields in block_info which *must* be filled is block_size and
    * num_elem. 
+   * If stats is not NULL, it is stored in the segment footer as the
+   * statistics of this block.
    * Returns the actual number of bytes written.
    */
   size_t write_block(size_t segment_id,
                    size_t column_id,
                    char* data,
-                   block_info block);
+                   block_info block,
+                   const block_statistics* stats = NULL);
 
   /**
    * Writes a block of data into a segment.
@@ -96,6 +107,8 @@ class block_writer {
    * \param block_info Metadata about the block. 
    *
    * No fields of block_info are required at the moment.
+   * The min / max / undefined count of the block are computed and stored
+   * in the segment footer.
    * Returns the actual number of bytes written.
    */
   size_t write_typed_block(size_t segment_id,
@@ -158,9 +171,27 @@ class block_writer {
    */
   std::vector<std::vector<std::vector<block_info> > > m_blocks;
 
+  /**
+   * The statistics of each block, stored in the footer after m_blocks.
+   * Has exactly the same shape as m_blocks.
+   * block_stats[segment_id][column_id][block_id]
+   */
+  std::vector<std::vector<std::vector<block_statistics> > > m_block_stats;
+
   /// For each segment, for each column the number of rows written so far
   std::vector<std::vector<size_t> > m_column_row_counter;
 
+  /// How blocks are compressed
+  block_compression_type m_compression_type = block_compression_type::LZ4;
+  /// The LZ4HC compression level
+  int m_compression_level = 0;
+
+  /**
+   * Compresses a block into cbuffer according to the compression type.
+   * Returns the compressed length, or 0 if the block was not compressed.
+   */
+  size_t compress_block(const char* data, size_t len, char* cbuffer);
+
   /// Writes the file footer
   void emit_footer(size_t segment_id);
 };
@@ -23,14 +23,19 @@ encoded_block::encoded_block() {
 }
 
 void encoded_block::init(block_info info, std::vector<char>&& data) {
-  m_block = block{info, 
-    std::make_shared<std::vector<char>>(std::move(data))};
-  m_size = info.num_elem;
+  init(info, std::make_shared<std::vector<char>>(std::move(data)));
 }
 
 
 void encoded_block::init(block_info info, std::shared_ptr<std::vector<char> > data) {
-  m_block = block{info, data};
+  // aliasing pointer: keeps the vector alive while pointing at its contents
+  init(info, std::shared_ptr<const char>(data, data->data()), data->size());
+}
+
+void encoded_block::init(block_info info, 
+                         std::shared_ptr<const char> data, 
+                         size_t length) {
+  m_block = block{info, data, length};
   m_size = info.num_elem;
 }
 
@@ -40,6 +45,7 @@ encoded_block_range encoded_block::get_range() {
 
 void encoded_block::release() {
   m_block.m_data.reset();
+  m_block.m_data_length = 0;
   m_block.m_block_info = block_info();
 }
 
@@ -63,8 +69,8 @@ void encoded_block_range::coroutine_launch() {
             // which sticks stuff into the buffer. 
             // and triggers the sink when the buffer full.
             typed_decode_stream_callback(coro_m_block.m_block_info,
-                                         coro_m_block.m_data->data(),
-                                         coro_m_block.m_data->size(),
+                                         coro_m_block.m_data.get(),
+                                         coro_m_block.m_data_length,
                                          [&coro_m_shared, &sink](const flexible_type& val) {
                                            auto& shared = *coro_m_shared;
                                            if (shared.m_write_target_numel) {
@@ -60,6 +60,11 @@ class encoded_block {
     init(info, data);
   }
 
+  /// block constructor from a view of data contents; simply calls init().
+  encoded_block(block_info info, std::shared_ptr<const char> data, size_t length) {
+    init(info, data, length);
+  }
+
   /** 
    * Initializes this block to point to new data.
    *
@@ -81,6 +86,20 @@ class encoded_block {
    */
   void init(block_info info, std::shared_ptr<std::vector<char> > data);
 
+  /** 
+   * Initializes this block to point to a view of new data. The shared 
+   * pointer need not own the buffer directly (it can for instance be an
+   * aliasing pointer into a memory mapped file), but must keep the 
+   * length bytes starting at data alive.
+   *
+   * Existing ranges are NOT invalidated.
+   * They will continue to point to what they used to point to.
+   * \param info The block information structure
+   * \param data Pointer to the binary data
+   * \param length The length of the binary data
+   */
+  void init(block_info info, std::shared_ptr<const char> data, size_t length);
+
   /**
    * Returns an accessor to the contents of the block.
    *
@@ -102,10 +121,14 @@ class encoded_block {
     return m_block.m_block_info;
   }
 
-  std::shared_ptr<std::vector<char> > get_block_data() const {
+  std::shared_ptr<const char> get_block_data() const {
     return m_block.m_data;
   }
 
+  size_t get_block_data_length() const {
+    return m_block.m_data_length;
+  }
+
   friend class encoded_block_range;
 
  private:
@@ -115,10 +138,12 @@ class encoded_block {
     /// The block information. Needed for the decode.
     block_info m_block_info;
     /// The actual block data.
-    std::shared_ptr<std::vector<char> > m_data;
+    std::shared_ptr<const char> m_data;
+    /// The length of the block data.
+    size_t m_data_length;
   };
 
-  block m_block;
+  block m_block = block();
   size_t m_size = 0;
 }; // class encoded_block
 
@@ -187,7 +212,7 @@ class encoded_block_range {
   /*                       The data I am reading from                       */
   /*                                                                        */
   /**************************************************************************/
-  encoded_block::block m_block;
+  encoded_block::block m_block = encoded_block::block();
 
   /**************************************************************************/
   /*                                                                        */
@@ -14,12 +14,14 @@
 * You should have received a copy of the GNU Affero General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <algorithm>
 #include <functional>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sarray_v2_block_types.hpp>
 #include <sframe/sarray_v2_type_encoding.hpp>
 #include <util/dense_bitset.hpp>
 #include <sframe/integer_pack.hpp>
+#include <sframe/sframe_constants.hpp>
 
 
 namespace graphlab {
@@ -325,6 +327,414 @@ static void decode_vector(iarchive& iarc,
                          ++last_id;
                        });
 }
+/**************************************************************************/
+/*                                                                        */
+/*                          Extended Encodings                            */
+/*                                                                        */
+/**************************************************************************/
+
+/**
+ * Frame of reference codes an array of numbers, MAX_INTEGERS_PER_BLOCK
+ * at a time.
+ */
+static void encode_uint64_array(oarchive& oarc, std::vector<uint64_t>& values) {
+  for (size_t i = 0;i < values.size(); i += MAX_INTEGERS_PER_BLOCK) {
+    size_t len = std::min<size_t>(values.size() - i, MAX_INTEGERS_PER_BLOCK);
+    frame_of_reference_encode_128(values.data() + i, len, oarc);
+  }
+}
+
+/**
+ * Reverse of encode_uint64_array(). Decodes num_elements numbers.
+ */
+static void decode_uint64_array(iarchive& iarc, 
+                                size_t num_elements,
+                                std::vector<uint64_t>& values) {
+  values.resize(num_elements);
+  for (size_t i = 0;i < num_elements; i += MAX_INTEGERS_PER_BLOCK) {
+    size_t len = std::min<size_t>(num_elements - i, MAX_INTEGERS_PER_BLOCK);
+    frame_of_reference_decode_128(iarc, len, values.data() + i);
+  }
+}
+
+/**
+ * Returns the bit patterns of all the defined values in an INTEGER or FLOAT
+ * array.
+ */
+static void get_defined_bits(const std::vector<flexible_type>& data,
+                             std::vector<uint64_t>& ret) {
+  ret.clear();
+  for (size_t i = 0;i < data.size(); ++i) {
+    if (data[i].get_type() != flex_type_enum::UNDEFINED) {
+      ret.push_back(data[i].get<flex_int>());
+    }
+  }
+}
+
+/**
+ * Returns the number of runs of equal values in the array.
+ */
+static size_t count_runs(const std::vector<uint64_t>& values) {
+  size_t num_runs = values.empty() ? 0 : 1;
+  for (size_t i = 1;i < values.size(); ++i) {
+    num_runs += (values[i] != values[i - 1]);
+  }
+  return num_runs;
+}
+
+/**
+ * Run length encoding (RLE_ENCODING) of a collection of integers or doubles.
+ *  - variable_encode(number of runs)
+ *  - encode the value of each run using frame_of_reference_encode_128()
+ *    (doubles are left rotated as in encode_double())
+ *  - encode the length of each run using frame_of_reference_encode_128()
+ */
+static void encode_rle(oarchive& oarc, 
+                       const std::vector<uint64_t>& values,
+                       bool is_double) {
+  std::vector<uint64_t> run_values;
+  std::vector<uint64_t> run_lengths;
+  for (size_t i = 0;i < values.size(); ++i) {
+    if (i > 0 && values[i] == values[i - 1]) {
+      ++run_lengths.back();
+    } else {
+      run_values.push_back(values[i]);
+      run_lengths.push_back(1);
+    }
+  }
+  if (is_double) {
+    for (auto& v: run_values) v = (v << 1) | (v >> 63);
+  }
+  variable_encode(oarc, run_values.size());
+  encode_uint64_array(oarc, run_values);
+  encode_uint64_array(oarc, run_lengths);
+}
+
+/**
+ * Reverse of encode_rle(). Returns false if the runs do not add up to 
+ * num_elements.
+ */
+static bool decode_rle(iarchive& iarc, 
+                       size_t num_elements,
+                       std::vector<uint64_t>& values,
+                       bool is_double) {
+  uint64_t num_runs = 0;
+  variable_decode(iarc, num_runs);
+  if (num_runs > num_elements) return false;
+  std::vector<uint64_t> run_values;
+  std::vector<uint64_t> run_lengths;
+  decode_uint64_array(iarc, num_runs, run_values);
+  decode_uint64_array(iarc, num_runs, run_lengths);
+  values.resize(num_elements);
+  size_t pos = 0;
+  for (size_t i = 0;i < num_runs; ++i) {
+    uint64_t v = run_values[i];
+    if (is_double) v = (v >> 1) | (v << 63);
+    if (run_lengths[i] > num_elements - pos) return false;
+    std::fill_n(values.begin() + pos, run_lengths[i], v);
+    pos += run_lengths[i];
+  }
+  return pos == num_elements;
+}
+
+/**
+ * Writes a stream of bits, most significant bit first.
+ */
+class bit_writer {
+ public:
+  /// Writes the lowest nbits of value. nbits must be between 1 and 64.
+  void write(uint64_t value, size_t nbits) {
+    while (nbits > 0) {
+      size_t space = 8 - m_bits_used;
+      size_t take = std::min(space, nbits);
+      unsigned char chunk = (value >> (nbits - take)) & ((1u << take) - 1);
+      m_current |= chunk << (space - take);
+      m_bits_used += take;
+      nbits -= take;
+      if (m_bits_used == 8) {
+        m_bytes.push_back(m_current);
+        m_current = 0;
+        m_bits_used = 0;
+      }
+    }
+  }
+  /// Pads the last byte with zeros and returns all the bytes written.
+  std::vector<unsigned char>& finish() {
+    if (m_bits_used > 0) {
+      m_bytes.push_back(m_current);
+      m_current = 0;
+      m_bits_used = 0;
+    }
+    return m_bytes;
+  }
+ private:
+  std::vector<unsigned char> m_bytes;
+  unsigned char m_current = 0;
+  size_t m_bits_used = 0;
+};
+
+/**
+ * Reads a stream of bits written by bit_writer. Reading past the end
+ * returns zeros.
+ */
+class bit_reader {
+ public:
+  bit_reader(const unsigned char* data, size_t len): m_data(data), m_len(len) { }
+  /// Reads nbits bits. nbits must be between 1 and 64.
+  uint64_t read(size_t nbits) {
+    uint64_t ret = 0;
+    while (nbits > 0) {
+      size_t avail = 8 - (m_pos & 7);
+      size_t take = std::min(avail, nbits);
+      unsigned char byte = (m_pos >> 3) < m_len ? m_data[m_pos >> 3] : 0;
+      ret = (ret << take) | ((byte >> (avail - take)) & ((1u << take) - 1));
+      m_pos += take;
+      nbits -= take;
+    }
+    return ret;
+  }
+ private:
+  const unsigned char* m_data;
+  size_t m_len;
+  size_t m_pos = 0;
+};
+
+/**
+ * XOR coding (XOR_DOUBLE_ENCODING) of a collection of doubles, as
+ * described in "Gorilla: A Fast, Scalable, In-Memory Time Series Database"
+ * (Pelkonen et al. VLDB 2015).
+ *
+ * The first value is written in full. Each subsequent value is XORed with
+ * the previous value:
+ *  - if the XOR is 0, a single '0' bit is written.
+ *  - otherwise, a '1' bit is written followed by
+ *     - '0' and the meaningful bits of the XOR, if they fall within the
+ *       window of meaningful bits of the last XOR written with a header.
+ *     - '1', the number of leading zeros (5 bits), the number of meaningful
+ *       bits minus 1 (6 bits), and the meaningful bits of the XOR.
+ *
+ * The bits are stored as variable_encode(number of bytes) followed by the
+ * bytes.
+ */
+static void encode_xor_double(oarchive& oarc, 
+                              const std::vector<uint64_t>& values) {
+  bit_writer writer;
+  uint64_t prev = 0;
+  size_t prev_leading = 64, prev_trailing = 64;
+  for (size_t i = 0;i < values.size(); ++i) {
+    if (i == 0) {
+      writer.write(values[0], 64);
+      prev = values[0];
+      continue;
+    }
+    uint64_t x = values[i] ^ prev;
+    prev = values[i];
+    if (x == 0) {
+      writer.write(0, 1);
+      continue;
+    }
+    writer.write(1, 1);
+    size_t leading = std::min<size_t>(__builtin_clzll(x), 31);
+    size_t trailing = __builtin_ctzll(x);
+    if (prev_leading + prev_trailing < 64 &&
+        leading >= prev_leading && trailing >= prev_trailing) {
+      writer.write(0, 1);
+      writer.write(x >> prev_trailing, 64 - prev_leading - prev_trailing);
+    } else {
+      size_t meaningful = 64 - leading - trailing;
+      writer.write(1, 1);
+      writer.write(leading, 5);
+      writer.write(meaningful - 1, 6);
+      writer.write(x >> trailing, meaningful);
+      prev_leading = leading;
+      prev_trailing = trailing;
+    }
+  }
+  auto& bytes = writer.finish();
+  variable_encode(oarc, bytes.size());
+  oarc.write((char*)bytes.data(), bytes.size());
+}
+
+/**
+ * Reverse of encode_xor_double(). Returns false if the data is truncated.
+ */
+static bool decode_xor_double(iarchive& iarc, 
+                              size_t num_elements,
+                              std::vector<uint64_t>& values) {
+  uint64_t num_bytes = 0;
+  variable_decode(iarc, num_bytes);
+  if (iarc.buf == NULL || iarc.off + num_bytes > iarc.len) return false;
+  bit_reader reader((const unsigned char*)(iarc.buf + iarc.off), num_bytes);
+  iarc.off += num_bytes;
+
+  values.resize(num_elements);
+  if (num_elements == 0) return true;
+  uint64_t prev = reader.read(64);
+  values[0] = prev;
+  size_t prev_leading = 0, prev_trailing = 0;
+  for (size_t i = 1;i < num_elements; ++i) {
+    if (reader.read(1)) {
+      if (reader.read(1)) {
+        prev_leading = reader.read(5);
+        size_t meaningful = reader.read(6) + 1;
+        if (prev_leading + meaningful > 64) return false;
+        prev_trailing = 64 - prev_leading - meaningful;
+      }
+      prev ^= reader.read(64 - prev_leading - prev_trailing) << prev_trailing;
+    }
+    values[i] = prev;
+  }
+  return true;
+}
+
+/**
+ * Delta-of-delta coding (DELTA_OF_DELTA_ENCODING) of a collection of 
+ * datetimes. Regularly spaced timestamps have second differences of 0,
+ * which frame_of_reference_encode_128() codes in no bits at all.
+ *  - encode the sequence [t0, t1 - t0, (t2 - t1) - (t1 - t0), ...] of 
+ *    timestamps, mapped through shifted_integer_encode(), using
+ *    frame_of_reference_encode_128()
+ *  - encode the time zone offsets using frame_of_reference_encode_128()
+ */
+static void encode_delta_of_delta_datetime(oarchive& oarc, 
+                                           const std::vector<flexible_type>& data) {
+  std::vector<uint64_t> timestamps;
+  std::vector<uint64_t> time_zones;
+  int64_t prev = 0, prev_delta = 0;
+  for (size_t i = 0;i < data.size(); ++i) {
+    if (data[i].get_type() != flex_type_enum::UNDEFINED) {
+      const flex_date_time& dt = data[i].get<flex_date_time>();
+      int64_t delta = dt.posix_timestamp() - prev;
+      timestamps.push_back(shifted_integer_encode(delta - prev_delta));
+      time_zones.push_back((uint8_t)dt.time_zone_offset());
+      // the first entry is coded against 0, and the second entry is a 
+      // first difference.
+      prev_delta = timestamps.size() == 1 ? 0 : delta;
+      prev = dt.posix_timestamp();
+    }
+  }
+  encode_uint64_array(oarc, timestamps);
+  encode_uint64_array(oarc, time_zones);
+}
+
+/**
+ * Encodes the defined values of an INTEGER, FLOAT or DATETIME block 
+ * using whichever of the available encodings gives the smallest output.
+ * The candidates are:
+ *  - INTEGER: encode_number() or RLE_ENCODING
+ *  - FLOAT: encode_double(), RLE_ENCODING or XOR_DOUBLE_ENCODING
+ *  - DATETIME: direct serialization or DELTA_OF_DELTA_ENCODING
+ * RLE_ENCODING is only tried if there are at most half as many runs as 
+ * values. Returns the BLOCK_FLAGS bit of the encoding used, or 0 if the 
+ * original encoding was used.
+ */
+static uint64_t encode_best_of(flex_type_enum column_type,
+                               block_info& info, 
+                               oarchive& oarc, 
+                               const std::vector<flexible_type>& data) {
+  std::vector<char> best_buf;
+  size_t best_len = 0;
+  uint64_t best_flag = 0;
+  auto try_encoding = [&](uint64_t flag, 
+                          std::function<void(oarchive&)> encode_fn) {
+    std::vector<char> buf;
+    oarchive trial(buf);
+    encode_fn(trial);
+    if (flag == 0 || trial.off < best_len) {
+      best_buf.swap(buf);
+      best_len = trial.off;
+      best_flag = flag;
+    }
+  };
+
+  if (column_type == flex_type_enum::DATETIME) {
+    try_encoding(0, [&](oarchive& o) {
+                   flexible_type_impl::serializer s{o};
+                   for (size_t i = 0;i < data.size(); ++i) {
+                     if (data[i].get_type() != flex_type_enum::UNDEFINED) {
+                       data[i].apply_visitor(s);
+                     }
+                   }
+                 });
+    try_encoding(DELTA_OF_DELTA_ENCODING, [&](oarchive& o) {
+                   encode_delta_of_delta_datetime(o, data);
+                 });
+  } else {
+    bool is_double = column_type == flex_type_enum::FLOAT;
+    std::vector<uint64_t> values;
+    get_defined_bits(data, values);
+    try_encoding(0, [&](oarchive& o) {
+                   if (is_double) encode_double(info, o, data);
+                   else encode_number(info, o, data);
+                 });
+    if (2 * count_runs(values) <= values.size()) {
+      try_encoding(RLE_ENCODING, [&](oarchive& o) {
+                     encode_rle(o, values, is_double);
+                   });
+    }
+    if (is_double) {
+      try_encoding(XOR_DOUBLE_ENCODING, [&](oarchive& o) {
+                     encode_xor_double(o, values);
+                   });
+    }
+  }
+  oarc.write(best_buf.data(), best_len);
+  return best_flag;
+}
+
+bool decode_extended(uint64_t flags,
+                     flex_type_enum column_type,
+                     iarchive& iarc,
+                     std::vector<flexible_type>& ret,
+                     size_t num_undefined) {
+  size_t num_elements = ret.size() - num_undefined;
+  std::vector<uint64_t> values;
+  bool success = false;
+  if (flags == RLE_ENCODING && 
+      (column_type == flex_type_enum::INTEGER || 
+       column_type == flex_type_enum::FLOAT)) {
+    success = decode_rle(iarc, num_elements, values, 
+                         column_type == flex_type_enum::FLOAT);
+  } else if (flags == XOR_DOUBLE_ENCODING && 
+             column_type == flex_type_enum::FLOAT) {
+    success = decode_xor_double(iarc, num_elements, values);
+  } else if (flags == DELTA_OF_DELTA_ENCODING && 
+             column_type == flex_type_enum::DATETIME) {
+    std::vector<uint64_t> time_zones;
+    decode_uint64_array(iarc, num_elements, values);
+    decode_uint64_array(iarc, num_elements, time_zones);
+    int64_t timestamp = 0, delta = 0;
+    size_t j = 0;
+    for (size_t i = 0;i < ret.size(); ++i) {
+      if (ret[i].get_type() != flex_type_enum::UNDEFINED) {
+        int64_t v = shifted_integer_decode(values[j]);
+        if (j == 0) delta = v;
+        else delta += v;
+        timestamp += delta;
+        if (j == 0) delta = 0;
+        ret[i].mutable_get<flex_date_time>() = 
+            flex_date_time(timestamp, (int8_t)(uint8_t)time_zones[j]);
+        ++j;
+      }
+    }
+    return true;
+  }
+  if (!success) {
+    logstream(LOG_ERROR) << "Unable to decode block with encoding flags " 
+                         << flags << " and type " 
+                         << flex_type_enum_to_name(column_type) << std::endl;
+    return false;
+  }
+  size_t j = 0;
+  for (size_t i = 0;i < ret.size(); ++i) {
+    if (ret[i].get_type() != flex_type_enum::UNDEFINED) {
+      ret[i].mutable_get<flex_int>() = values[j];
+      ++j;
+    }
+  }
+  return true;
+}
+
 /**
  * Encodes a collection of flexible_type values. The array must be of 
  * contiguous type, but permitting undefined values.
@@ -344,6 +754,12 @@ static void decode_vector(iarchive& iarc,
  *     - otherwise, direct serialization is currently used.
  *     - If UNDEFINED (i.e. array is of all UNDEFINED values, nothing is written)
  *
+ * If SFRAME_WRITE_EXTENDED_ENCODINGS is set, integer, float and datetime 
+ * values are also trial encoded with the extended encodings (run length,
+ * XOR and delta-of-delta coding), and the smallest encoding is kept (see 
+ * encode_best_of()). If an extended encoding is used, its flag is set in
+ * block.flags *instead of* IS_FLEXIBLE_TYPE.
+ *
  * \note The coding does not store the number of values stored. This is
  * stored in the block_info (block.num_elem)
  */
@@ -398,7 +814,22 @@ void typed_encode(const std::vector<flexible_type>& data,
     block.flags |= MULTIPLE_TYPE_BLOCK;
   }
   if (perform_type_encoding) {
-    if (types_appeared.get((char)flex_type_enum::INTEGER)) {
+    uint64_t extended_flag = 0;
+    if (SFRAME_WRITE_EXTENDED_ENCODINGS &&
+        (types_appeared.get((char)flex_type_enum::INTEGER) ||
+         types_appeared.get((char)flex_type_enum::FLOAT) ||
+         types_appeared.get((char)flex_type_enum::DATETIME))) {
+      for(auto t: types_appeared) {
+        if ((flex_type_enum)t != flex_type_enum::UNDEFINED) {
+          extended_flag = encode_best_of((flex_type_enum)t, block, oarc, data);
+          break;
+        }
+      }
+      if (extended_flag) {
+        block.flags &= ~(uint64_t)IS_FLEXIBLE_TYPE;
+        block.flags |= extended_flag;
+      }
+    } else if (types_appeared.get((char)flex_type_enum::INTEGER)) {
       encode_number(block, oarc, data);
     } else if(types_appeared.get((char)flex_type_enum::FLOAT)) {
       encode_double(block, oarc, data);
@@ -428,13 +859,20 @@ void typed_encode(const std::vector<flexible_type>& data,
  * stored in the block_info (block.num_elem)
  */
 bool typed_decode(const block_info& info,
-                  char* start, size_t len,
+                  const char* start, size_t len,
                   std::vector<flexible_type>& ret) {
-  if (!(info.flags & IS_FLEXIBLE_TYPE)) {
+  if (!is_typed_block(info.flags)) {
     logstream(LOG_ERROR) << "Attempting to decode a non-typed block"
                          << std::endl;
     return false;
   }
+  if (info.flags & ~KNOWN_BLOCK_FLAGS) {
+    logstream(LOG_ERROR) << "Attempting to decode a block with unknown flags "
+                         << info.flags 
+                         << ". It may have been written by a newer version."
+                         << std::endl;
+    return false;
+  }
   graphlab::iarchive iarc(start, len);
 
   size_t dsize = info.num_elem;
@@ -480,7 +918,12 @@ bool typed_decode(const block_info& info,
   }
   if (perform_type_decoding) {
     // type decode
-    if (column_type == flex_type_enum::INTEGER) {
+    if (info.flags & EXTENDED_ENCODING_FLAGS) {
+      if (!decode_extended(info.flags & EXTENDED_ENCODING_FLAGS, 
+                           column_type, iarc, ret, num_undefined)) {
+        return false;
+      }
+    } else if (column_type == flex_type_enum::INTEGER) {
       decode_number(iarc, ret, num_undefined);
     } else if (column_type == flex_type_enum::FLOAT) {
       decode_double(iarc, ret, num_undefined);
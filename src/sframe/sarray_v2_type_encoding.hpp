@@ -40,12 +40,27 @@ void encode_double(block_info& info,
 void decode_double(iarchive& iarc,
                    std::vector<flexible_type>& ret,
                    size_t num_undefined);
+
+/**
+ * Decodes a collection of values coded with one of the extended encodings
+ * into 'ret'. flags is the one EXTENDED_ENCODING_FLAGS bit the block was
+ * coded with. Entries in ret which are of type flex_type_enum::UNDEFINED
+ * will be skipped, and there must be exactly num_undefined number of them.
+ * All other entries must be of type column_type.
+ * Returns false on failure.
+ */
+bool decode_extended(uint64_t flags,
+                     flex_type_enum column_type,
+                     iarchive& iarc,
+                     std::vector<flexible_type>& ret,
+                     size_t num_undefined);
+
 /**
  * Decodes a type block. Reads from block_info and a buffer.
  * Returns false on failure. 
  */
 bool typed_decode(const block_info& info,
-                  char* start, size_t len,
+                  const char* start, size_t len,
                   std::vector<flexible_type>& ret);
 
 /**
@@ -53,7 +68,7 @@ bool typed_decode(const block_info& info,
  * Returns false on failure. 
  */
 bool typed_decode_stream_callback(const block_info& info,
-                                  char* start, size_t len,
+                                  const char* start, size_t len,
                                   std::function<void(flexible_type)> retcallback);
 
 /**
@@ -201,13 +216,20 @@ static void decode_vector_stream(size_t num_elements,
  */
 template <typename Fn> // Fn is a function like void(flexible_type)
 static bool typed_decode_stream_callback(const block_info& info,
-                                  char* start, size_t len,
+                                  const char* start, size_t len,
                                   Fn callback) {
-  if (!(info.flags & IS_FLEXIBLE_TYPE)) {
+  if (!is_typed_block(info.flags)) {
     logstream(LOG_ERROR) << "Attempting to decode a non-typed block"
                          << std::endl;
     return false;
   }
+  if (info.flags & ~KNOWN_BLOCK_FLAGS) {
+    logstream(LOG_ERROR) << "Attempting to decode a block with unknown flags "
+                         << info.flags 
+                         << ". It may have been written by a newer version."
+                         << std::endl;
+    return false;
+  }
   graphlab::iarchive iarc(start, len);
 
   // some basic block properties which will be filled in
@@ -274,7 +296,15 @@ static bool typed_decode_stream_callback(const block_info& info,
           ++last_id;
         };
     size_t elements_to_decode = dsize - num_undefined;
-    if (column_type == flex_type_enum::INTEGER) {
+    if (info.flags & EXTENDED_ENCODING_FLAGS) {
+      std::vector<flexible_type> values(elements_to_decode, 
+                                        flexible_type(column_type));
+      if (!decode_extended(info.flags & EXTENDED_ENCODING_FLAGS, 
+                           column_type, iarc, values, 0)) {
+        return false;
+      }
+      for (const auto& val: values) stream_callback(val);
+    } else if (column_type == flex_type_enum::INTEGER) {
       decode_number_stream(elements_to_decode, iarc, stream_callback); 
     } else if (column_type == flex_type_enum::FLOAT) {
       decode_double_stream(elements_to_decode, iarc, stream_callback); 
@@ -293,6 +323,8 @@ static bool typed_decode_stream_callback(const block_info& info,
           callback(ret);
         }
       }
+      // all the undefined values have been generated
+      last_id = dsize;
     }
     // generate the final undefined values
     if (num_undefined) {
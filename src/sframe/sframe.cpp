@@ -109,9 +109,11 @@ std::map<std::string, std::shared_ptr<sarray<flexible_type>>> sframe::init_from_
     bool continue_on_failure,
     bool store_errors,
     std::map<std::string, flex_type_enum> column_type_hints,
-    size_t row_limit) {
+    size_t row_limit,
+    size_t type_inference_rows) {
   return parse_csvs_to_sframe(url, tokenizer, use_header, continue_on_failure,
-                              store_errors, column_type_hints, row_limit, *this);
+                              store_errors, column_type_hints, row_limit, *this,
+                              "", type_inference_rows);
 }
 
 sframe::~sframe() {
@@ -516,6 +518,13 @@ bool sframe::set_num_segments(size_t numseg) {
   return true;
 }
 
+void sframe::set_compression(v2_block_impl::block_compression_type type, 
+                             int level) {
+  ASSERT_MSG(inited, "Invalid SFrame");
+  ASSERT_MSG(writing, "SFrame not opened for writing");
+  group_writer->set_compression(type, level);
+}
+
 sframe::iterator sframe::get_output_iterator(size_t segmentid) {
   ASSERT_MSG(inited, "Invalid SFrame");
   ASSERT_MSG(writing, "SFrame not opened for writing");
@@ -169,7 +169,7 @@ class sframe : public swriter_base<sframe_output_iterator> {
    * Constructs an SFrame from a csv file.
    *
    * All columns will be parsed into flex_string unless the column type is
-   * specified in the column_type_hints.
+   * specified in the column_type_hints, or type_inference_rows is non-zero.
    *
    * \param path The url to the csv file. The url can points to local
    * filesystem, hdfs, or s3.  \param tokenizer The tokenization rules to use
@@ -178,6 +178,9 @@ class sframe : public swriter_base<sframe_output_iterator> {
    * \param continue_on_failure If true, lines with parsing errors will be skipped.
    * \param column_type_hints A map from column name to the column type.
    * \param row_limit If non-zero, the maximum number of rows to read
+   * \param type_inference_rows If non-zero, the types of the columns not in
+   * column_type_hints are inferred from this many rows at the start of the
+   * input.
    *
    * Throws an exception if IO error or csv parse failed.
    */
@@ -188,7 +191,8 @@ class sframe : public swriter_base<sframe_output_iterator> {
       bool continue_on_failure,
       bool store_errors,
       std::map<std::string, flex_type_enum> column_type_hints,
-      size_t row_limit = 0);
+      size_t row_limit = 0,
+      size_t type_inference_rows = 0);
 
   /**
    * Constructs an SFrame from dataframe_t.
@@ -619,6 +623,22 @@ class sframe : public swriter_base<sframe_output_iterator> {
    */
   iterator get_output_iterator(size_t segmentid);
 
+  /**
+   * Sets how the data written to the frame is compressed, overriding
+   * sframe_config::SFRAME_COMPRESSION_TYPE and SFRAME_COMPRESSION_LEVEL.
+   * level is the LZ4HC compression level (1 - 16, 0 for the default).
+   * Must be called after the number of segments is set, and before any 
+   * data is written.
+   *
+   * Example:
+   * \code
+   * // a frame which is written once and read many times
+   * sfw.set_compression(v2_block_impl::block_compression_type::LZ4HC, 9);
+   * \endcode
+   */
+  void set_compression(v2_block_impl::block_compression_type type, 
+                       int level = 0);
+
   /**
    * Closes the sframe. close() also implicitly closes all segments.  After
    * the writer is closed, no segments can be written.  
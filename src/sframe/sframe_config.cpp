@@ -17,6 +17,7 @@
 #include <cmath>
 #include <cstddef>
 #include <globals/globals.hpp>
+#include <sframe/sarray_v2_block_cache.hpp>
 namespace graphlab {
 
 /**
@@ -26,6 +27,10 @@ namespace graphlab {
 namespace sframe_config {
   size_t SFRAME_SORT_BUFFER_SIZE = size_t(2*1024*1024)*size_t(1024);
   size_t SFRAME_READ_BATCH_SIZE = 128;
+  size_t SFRAME_BLOCK_CACHE_SIZE = size_t(128*1024*1024);
+  size_t SFRAME_READAHEAD_BLOCKS = 2;
+  size_t SFRAME_COMPRESSION_TYPE = 1;
+  size_t SFRAME_COMPRESSION_LEVEL = 9;
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_SORT_BUFFER_SIZE,
@@ -40,5 +45,35 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             true, 
                             +[](int64_t val){ return val >= 1; });
 
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_BLOCK_CACHE_SIZE, 
+                            true, 
+                            +[](int64_t val){ 
+                              if (val < 0) return false;
+                              // the cache only evicts on insertion, so shrink
+                              // it now. Nothing is inserted once it is 0.
+                              v2_block_impl::block_cache::get_instance().set_capacity(val);
+                              return true;
+                            });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_READAHEAD_BLOCKS, 
+                            true, 
+                            +[](int64_t val){ return val >= 0 && val <= 64; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_COMPRESSION_TYPE, 
+                            true, 
+                            +[](int64_t val){ return val >= 0 && val <= 2; });
+
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_COMPRESSION_LEVEL, 
+                            true, 
+                            +[](int64_t val){ return val >= 0 && val <= 16; });
+
 }
 }
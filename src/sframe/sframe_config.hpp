@@ -33,6 +33,31 @@ namespace sframe_config {
   **  The number of rows to read each time for paralleliterator
   **/
   extern size_t SFRAME_READ_BATCH_SIZE;
+
+  /**
+  **  The max number of bytes of decompressed blocks kept in the shared
+  **  block cache (see v2_block_impl::block_cache). 0 disables the cache.
+  **/
+  extern size_t SFRAME_BLOCK_CACHE_SIZE;
+
+  /**
+  **  The default number of blocks sarray readers read and decode in the
+  **  background ahead of a sequential scan. 0 disables readahead.
+  **/
+  extern size_t SFRAME_READAHEAD_BLOCKS;
+
+  /**
+  **  How newly written SFrame blocks are compressed. 0 for no compression,
+  **  1 for LZ4 and 2 for LZ4HC (see v2_block_impl::block_compression_type).
+  **  Readers are the same for all modes. Can be overridden per writer.
+  **/
+  extern size_t SFRAME_COMPRESSION_TYPE;
+
+  /**
+  **  The LZ4HC compression level (1 - 16, 0 for the LZ4HC default) used
+  **  when SFRAME_COMPRESSION_TYPE is 2.
+  **/
+  extern size_t SFRAME_COMPRESSION_LEVEL;
 }
 
 }
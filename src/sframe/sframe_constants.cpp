@@ -37,9 +37,13 @@ size_t SFRAME_WRITER_MAX_BUFFERED_CELLS_PER_BLOCK = 256*1024; // 1M elements.
 // will be modified at startup to be 4x nCPUS
 size_t SFRAME_MAX_BLOCKS_IN_CACHE = 32;
 size_t SFRAME_CSV_PARSER_READ_SIZE = 50 * 1024 * 1024; // 50MB
+size_t SFRAME_CSV_PARSE_FILES_IN_PARALLEL = true;
 size_t SFRAME_GROUPBY_BUFFER_NUM_ROWS = 1024 * 1024;
+size_t SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS = 1024;
 size_t SFRAME_JOIN_BUFFER_NUM_CELLS = 50*1024*1024;
 size_t SFRAME_IO_READ_LOCK = false;
+size_t SFRAME_MMAP_READ = true;
+size_t SFRAME_WRITE_EXTENDED_ENCODINGS = true;
 size_t SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE = 2000000;
 size_t SFRAME_SORT_MAX_SEGMENTS = 128;
 const size_t SFRAME_IO_LOCK_FILE_SIZE_THRESHOLD = 4 * 1024 * 1024;
@@ -82,12 +86,24 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             +[](int64_t val){ return val >= 1024; });
 
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_CSV_PARSE_FILES_IN_PARALLEL, 
+                            true, 
+                            +[](int64_t val){ return val == 0 || val == 1; });
+
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_GROUPBY_BUFFER_NUM_ROWS,
                             true, 
                             +[](int64_t val){ return val >= 64; });
 
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS,
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_JOIN_BUFFER_NUM_CELLS,
                             true, 
@@ -111,6 +127,16 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             true, 
                             +[](int64_t val){ return val == 0 || val == 1 ; });
 
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_MMAP_READ,
+                            true, 
+                            +[](int64_t val){ return val == 0 || val == 1 ; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SFRAME_WRITE_EXTENDED_ENCODINGS,
+                            true, 
+                            +[](int64_t val){ return val == 0 || val == 1 ; });
+
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SFRAME_SORT_PIVOT_ESTIMATION_SAMPLE_SIZE,
                             true, 
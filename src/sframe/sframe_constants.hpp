@@ -131,6 +131,12 @@ extern size_t SFRAME_MAX_BLOCKS_IN_CACHE;
  */
 extern size_t SFRAME_CSV_PARSER_READ_SIZE;
 
+/**
+ * Whether the CSV parser parses several files at once (each into its own
+ * output segments) when reading a directory or glob of files.
+ */
+extern size_t SFRAME_CSV_PARSE_FILES_IN_PARALLEL;
+
 
 
 /**
@@ -138,6 +144,13 @@ extern size_t SFRAME_CSV_PARSER_READ_SIZE;
  */
 extern size_t SFRAME_GROUPBY_BUFFER_NUM_ROWS;
 
+/**
+ * The number of groups each groupby thread pre-aggregates locally before
+ * combining them into the shared groupby buffers. 0 disables the local
+ * pre-aggregation.
+ */
+extern size_t SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS;
+
 
 /**
  * The number of bytes that a join algorithm is allowed to use during execution.
@@ -150,6 +163,21 @@ extern size_t SFRAME_JOIN_BUFFER_NUM_CELLS;
  */
 extern size_t SFRAME_IO_READ_LOCK;
 
+/**
+ * Whether segment files on local storage are memory mapped when read by
+ * the v2 block manager. Uncompressed blocks are then decoded directly out
+ * of the mapping.
+ */
+extern size_t SFRAME_MMAP_READ;
+
+/**
+ * Whether the v2 block writer may use the run length, XOR and 
+ * delta-of-delta block encodings. Blocks using them cannot be read by
+ * versions which predate them, so this can be turned off to write
+ * SFrames for older readers.
+ */
+extern size_t SFRAME_WRITE_EXTENDED_ENCODINGS;
+
 
 /**
  * If SFRAME_IO_READ_LOCK is set, then the IO LOCK is only used when the
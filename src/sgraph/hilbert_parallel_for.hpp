@@ -16,6 +16,7 @@
 */
 #ifndef GRAPHLAB_SGRAPH_HILBERT_PARALLE_FOR_HPP
 #define GRAPHLAB_SGRAPH_HILBERT_PARALLE_FOR_HPP
+#include <vector>
 #include <utility>
 #include <functional>
 #include <parallel/thread_pool.hpp>
@@ -24,6 +25,19 @@
 namespace graphlab {
 namespace sgraph_compute {
 
+/**
+ * Returns the coordinates of an n*n grid in the Hilbert curve order.
+ *
+ * n must be at least 2 and a power of 2.
+ */
+inline std::vector<std::pair<size_t, size_t> > hilbert_ordered_coordinates(size_t n) {
+  std::vector<std::pair<size_t, size_t> > ret(n * n);
+  for (size_t i = 0;i < n*n; ++i) {
+    ret[i] = hilbert_index_to_coordinate(i, n);
+  }
+  return ret;
+}
+
 /**
  * This performs a parallel sweep over an n*n grid following the Hilbert
  * curve ordering. The parallel sweep is broken into two parts. A "preamble"
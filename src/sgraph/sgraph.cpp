@@ -21,7 +21,9 @@
 #include <sframe/sarray_sorted_buffer.hpp>
 #include <sframe/sarray_reader_buffer.hpp>
 #include <fileio/buffered_writer.hpp>
+#include <serialization/dir_archive.hpp>
 #include <atomic>
+#include <algorithm>
 #include <timer/timer.hpp>
 
 /**
@@ -50,6 +52,8 @@ const char* sgraph::VID_COLUMN_NAME = "__id";
 const char* sgraph::SRC_COLUMN_NAME = "__src_id";
 const char* sgraph::DST_COLUMN_NAME = "__dst_id";
 const flex_type_enum sgraph::INTERNAL_ID_TYPE = flex_type_enum::INTEGER;
+// 1: each graph is followed by a flag, and by its edge indices if set
+const size_t sgraph::SERIALIZATION_VERSION = 1;
 
 /**************************************************************************/
 /*                                                                        */
@@ -338,6 +342,19 @@ sframe sgraph::get_edges(const std::vector<flexible_type>& source_vids,
     }
   }
 
+  // Case 0: few id constraints on an indexed edge group; only read the
+  // edges of those vertices.
+  bool indexed = false;
+  {
+    std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+    indexed = m_index_cache->indexed_edge_groups.count({groupa, groupb}) > 0;
+  }
+  if (indexed && !match_all_vertices &&
+      source_vids.size() <= SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES) {
+    return get_edges_with_index(source_vids, target_vids,
+                                satisfy_value_constraint, groupa, groupb);
+  }
+
   std::vector<sframe> out_edge_blocks(m_num_partitions * m_num_partitions);
   // Case 1: there is no source or target id constraints.
   if (match_all_vertices) {
@@ -439,6 +456,231 @@ sframe sgraph::get_edges(const std::vector<flexible_type>& source_vids,
   return ret;
 }
 
+sframe sgraph::get_edges_with_index(
+    const std::vector<flexible_type>& source_vids,
+    const std::vector<flexible_type>& target_vids,
+    const std::function<bool(const std::vector<flexible_type>&)>& satisfy_value_constraint,
+    size_t groupa, size_t groupb) const {
+  const std::vector<sframe>& egroup = edge_group(groupa, groupb);
+  size_t src_column_idx = egroup[0].column_index(SRC_COLUMN_NAME);
+  size_t dst_column_idx = egroup[0].column_index(DST_COLUMN_NAME);
+  std::vector<std::string> out_column_names = egroup[0].column_names();
+  std::vector<flex_type_enum> out_column_types = egroup[0].column_types();
+  out_column_types[src_column_idx] = m_vid_type;
+  out_column_types[dst_column_idx] = m_vid_type;
+
+  // The id constraints of one edge partition, in local ids.
+  struct partition_query {
+    std::unordered_set<size_t> wild_sources;
+    std::unordered_set<size_t> wild_targets;
+    std::unordered_set<std::pair<size_t, size_t>> pairs;
+  };
+  // (src_partition, dst_partition) -> constraints. Ordered as the
+  // partitions are in the output of a full scan.
+  std::map<std::pair<size_t, size_t>, partition_query> queries;
+
+  std::vector<std::shared_ptr<const sgraph_vertex_index>> source_index(m_num_partitions);
+  std::vector<std::shared_ptr<const sgraph_vertex_index>> target_index(m_num_partitions);
+  auto get_index = [&](size_t partition, size_t group,
+                       std::vector<std::shared_ptr<const sgraph_vertex_index>>& index)
+      -> const sgraph_vertex_index& {
+    if (!index[partition]) index[partition] = get_vertex_index(partition, group);
+    return *index[partition];
+  };
+  auto get_local_id = [&](const flexible_type& vid, size_t partition, size_t group,
+                          std::vector<std::shared_ptr<const sgraph_vertex_index>>& index) {
+    return get_index(partition, group, index).local_id(vid);
+  };
+  const size_t NOT_FOUND = (size_t)(-1);
+
+  for (size_t i = 0; i < source_vids.size(); ++i) {
+    const flexible_type& source = source_vids[i];
+    const flexible_type& target = target_vids[i];
+    bool wild_source = source.get_type() == flex_type_enum::UNDEFINED;
+    bool wild_target = target.get_type() == flex_type_enum::UNDEFINED;
+    // matches nothing, as in the full scan
+    if (wild_source && wild_target) continue;
+    size_t source_pid = source.hash() % m_num_partitions;
+    size_t target_pid = target.hash() % m_num_partitions;
+    if (wild_source) {
+      size_t lt = get_local_id(target, target_pid, groupb, target_index);
+      if (lt == NOT_FOUND) continue;
+      for (size_t p = 0; p < m_num_partitions; ++p) {
+        queries[{p, target_pid}].wild_targets.insert(lt);
+      }
+    } else if (wild_target) {
+      size_t ls = get_local_id(source, source_pid, groupa, source_index);
+      if (ls == NOT_FOUND) continue;
+      for (size_t p = 0; p < m_num_partitions; ++p) {
+        queries[{source_pid, p}].wild_sources.insert(ls);
+      }
+    } else {
+      size_t ls = get_local_id(source, source_pid, groupa, source_index);
+      size_t lt = get_local_id(target, target_pid, groupb, target_index);
+      if (ls == NOT_FOUND || lt == NOT_FOUND) continue;
+      queries[{source_pid, target_pid}].pairs.insert({ls, lt});
+    }
+  }
+
+  // the ids of both ends are needed to write the edges out
+  std::vector<std::pair<size_t, size_t>> coordinates;
+  for (auto& kv: queries) {
+    coordinates.push_back(kv.first);
+    get_index(kv.first.first, groupa, source_index);
+    get_index(kv.first.second, groupb, target_index);
+  }
+
+  std::vector<sframe> out_edge_blocks(coordinates.size());
+  parallel_for(0, coordinates.size(), [&](size_t k) {
+    size_t i = coordinates[k].first;
+    size_t j = coordinates[k].second;
+    const partition_query& query = queries.at(coordinates[k]);
+    const std::vector<flexible_type>& src_partition_vids = source_index[i]->vertex_ids();
+    const std::vector<flexible_type>& dst_partition_vids = target_index[j]->vertex_ids();
+    auto edge_index = get_edge_index(i, j, groupa, groupb);
+
+    // rows of the edges which may match
+    std::vector<size_t> rows;
+    for (size_t ls: query.wild_sources) edge_index->get_rows_by_source(ls, rows);
+    for (size_t lt: query.wild_targets) edge_index->get_rows_by_target(lt, rows);
+    for (auto& pair: query.pairs) edge_index->get_rows_by_source(pair.first, rows);
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    sframe out_sframe;
+    out_sframe.open_for_write(out_column_names, out_column_types, "", 1);
+    auto out = out_sframe.get_output_iterator(0);
+    auto reader = edge_partition(i, j, groupa, groupb).get_reader();
+    std::vector<std::vector<flexible_type>> buffer;
+    // read the rows in ranges, merging the ranges with small gaps
+    const size_t MAX_ROW_GAP = 256;
+    size_t begin = 0;
+    while (begin < rows.size()) {
+      size_t end = begin + 1;
+      while (end < rows.size() && rows[end] - rows[end - 1] <= MAX_ROW_GAP) ++end;
+      reader->read_rows(rows[begin], rows[end - 1] + 1, buffer);
+      for (auto& row: buffer) {
+        size_t ls = row[src_column_idx];
+        size_t lt = row[dst_column_idx];
+        if ((query.wild_sources.count(ls) || query.wild_targets.count(lt) ||
+             query.pairs.count({ls, lt})) && satisfy_value_constraint(row)) {
+          row[src_column_idx] = src_partition_vids[ls];
+          row[dst_column_idx] = dst_partition_vids[lt];
+          *out = std::move(row);
+          ++out;
+        }
+      }
+      begin = end;
+    }
+    out_sframe.close();
+    out_edge_blocks[k] = std::move(out_sframe);
+  });
+
+  sframe ret;
+  if (out_edge_blocks.empty()) {
+    ret.open_for_write(out_column_names, out_column_types);
+    ret.close();
+  }
+  for (auto& sf : out_edge_blocks)
+    ret = ret.append(sf);
+  return ret;
+}
+
+void sgraph::build_edge_index(size_t groupa, size_t groupb) const {
+  parallel_for(0, m_num_partitions, [&](size_t i) {
+    get_vertex_index(i, groupa);
+    if (groupb != groupa) get_vertex_index(i, groupb);
+  });
+  parallel_for(0, m_num_partitions * m_num_partitions, [&](size_t k) {
+    get_edge_index(k / m_num_partitions, k % m_num_partitions, groupa, groupb);
+  });
+  std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+  m_index_cache->indexed_edge_groups.insert({groupa, groupb});
+}
+
+void sgraph::drop_edge_index(size_t groupa, size_t groupb) const {
+  std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+  auto& groups = m_index_cache->indexed_edge_groups;
+  groups.erase({groupa, groupb});
+  auto& edge_indices = m_index_cache->edge_indices;
+  for (auto iter = edge_indices.begin(); iter != edge_indices.end(); ) {
+    if (std::get<2>(iter->first) == groupa && std::get<3>(iter->first) == groupb) {
+      iter = edge_indices.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+  // the vertex indices of groups which no other indexed edge group uses
+  auto& vertex_indices = m_index_cache->vertex_indices;
+  for (auto iter = vertex_indices.begin(); iter != vertex_indices.end(); ) {
+    size_t group = iter->first.second;
+    bool used = std::any_of(groups.begin(), groups.end(),
+                            [&](const std::pair<size_t, size_t>& g) {
+                              return g.first == group || g.second == group;
+                            });
+    if (used) ++iter;
+    else iter = vertex_indices.erase(iter);
+  }
+}
+
+std::shared_ptr<const sgraph_edge_index>
+sgraph::find_edge_index(size_t src_partition, size_t dst_partition,
+                        size_t groupa, size_t groupb) const {
+  const sframe& edges = edge_partition(src_partition, dst_partition, groupa, groupb);
+  auto src_ids = edges.select_column(SRC_COLUMN_NAME);
+  auto dst_ids = edges.select_column(DST_COLUMN_NAME);
+  sgraph_index_cache::edge_index_key key{src_partition, dst_partition, groupa, groupb};
+  std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+  auto iter = m_index_cache->edge_indices.find(key);
+  if (iter != m_index_cache->edge_indices.end() &&
+      iter->second->is_valid_for(*src_ids, *dst_ids)) {
+    return iter->second;
+  }
+  return nullptr;
+}
+
+std::shared_ptr<const sgraph_vertex_index>
+sgraph::get_vertex_index(size_t partition, size_t group) const {
+  auto ids = vertex_partition(partition, group).select_column(VID_COLUMN_NAME);
+  sgraph_index_cache::vertex_index_key key{partition, group};
+  {
+    std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+    auto iter = m_index_cache->vertex_indices.find(key);
+    if (iter != m_index_cache->vertex_indices.end() &&
+        iter->second->is_valid_for(*ids)) {
+      return iter->second;
+    }
+  }
+  // built outside of the lock; concurrent builds of the same index are
+  // harmless
+  auto index = std::make_shared<sgraph_vertex_index>();
+  index->build(*ids);
+  std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+  m_index_cache->vertex_indices[key] = index;
+  return index;
+}
+
+std::shared_ptr<const sgraph_edge_index>
+sgraph::get_edge_index(size_t src_partition, size_t dst_partition,
+                       size_t groupa, size_t groupb) const {
+  auto existing = find_edge_index(src_partition, dst_partition, groupa, groupb);
+  if (existing) return existing;
+  const sframe& edges = edge_partition(src_partition, dst_partition, groupa, groupb);
+  auto src_ids = edges.select_column(SRC_COLUMN_NAME);
+  auto dst_ids = edges.select_column(DST_COLUMN_NAME);
+  sgraph_index_cache::edge_index_key key{src_partition, dst_partition, groupa, groupb};
+  timer ti;
+  auto index = std::make_shared<sgraph_edge_index>();
+  index->build(*src_ids, vertex_partition(src_partition, groupa).num_rows(),
+               *dst_ids, vertex_partition(dst_partition, groupb).num_rows());
+  logstream(LOG_INFO) << "Built index of edge partition (" << src_partition
+                      << ", " << dst_partition << ") in "
+                      << ti.current_time() << " secs" << std::endl;
+  std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+  m_index_cache->edge_indices[key] = index;
+  return index;
+}
+
 /**************************************************************************/
 /*                                                                        */
 /*                               Modifiers                                */
@@ -1031,6 +1273,7 @@ bool sgraph::select_edge_fields(const std::vector<std::string>& fields, size_t g
 }
 
 bool sgraph::clear() {
+  m_index_cache = std::make_shared<sgraph_index_cache>();
   // clear EVERYTHING!!
   m_vertex_group_names.clear();
   m_vertex_groups.clear();
@@ -1286,6 +1529,51 @@ void sgraph::save(oarchive& oarc) const {
   for (const auto& kv : m_edge_groups) {
     oarc << kv.first << kv.second;
   }
+
+  // The edge indices of the groups indexed with build_edge_index() are
+  // only saved to directory archives. An archive (of a model, say) can
+  // hold several graphs, so each graph records whether its indices follow.
+  // The archive metadata records the version of this layout, so that
+  // archives written before it still load, without indices. Out of date
+  // indices are not saved, and get rebuilt when used.
+  if (!oarc.dir) return;
+  oarc.dir->set_metadata("sgraph_version", std::to_string(SERIALIZATION_VERSION));
+  std::vector<std::pair<size_t, size_t>> indexed_groups;
+  {
+    std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+    for (const auto& group : m_index_cache->indexed_edge_groups) {
+      if (m_edge_groups.count(group)) indexed_groups.push_back(group);
+    }
+  }
+  bool has_edge_index = !indexed_groups.empty();
+  oarc << has_edge_index;
+  if (has_edge_index) {
+    oarc << indexed_groups;
+    std::vector<std::pair<sgraph_index_cache::edge_index_key,
+                          std::shared_ptr<sgraph_edge_index>>> valid_indices;
+    {
+      std::lock_guard<graphlab::mutex> guard(m_index_cache->lock);
+      for (const auto& kv : m_index_cache->edge_indices) {
+        size_t groupa = std::get<2>(kv.first);
+        size_t groupb = std::get<3>(kv.first);
+        if (!m_index_cache->indexed_edge_groups.count({groupa, groupb}) ||
+            !m_edge_groups.count({groupa, groupb})) continue;
+        const sframe& edges = edge_partition(std::get<0>(kv.first),
+                                             std::get<1>(kv.first),
+                                             groupa, groupb);
+        if (kv.second->is_valid_for(*edges.select_column(SRC_COLUMN_NAME),
+                                    *edges.select_column(DST_COLUMN_NAME))) {
+          valid_indices.push_back(kv);
+        }
+      }
+    }
+    oarc << valid_indices.size();
+    for (const auto& kv : valid_indices) {
+      oarc << std::get<0>(kv.first) << std::get<1>(kv.first)
+           << std::get<2>(kv.first) << std::get<3>(kv.first);
+      kv.second->save(oarc);
+    }
+  }
 }
 
 /**
@@ -1311,6 +1599,33 @@ void sgraph::load(iarchive& iarc) {
       m_edge_groups[group_address] = std::move(egroup);
     }
   }
+
+  // see save() for the layout of the edge indices
+  std::string version;
+  if (!iarc.dir || !iarc.dir->get_metadata("sgraph_version", version) ||
+      std::stoul(version) < 1) {
+    return;
+  }
+  bool has_edge_index = false;
+  iarc >> has_edge_index;
+  if (has_edge_index) {
+    std::vector<std::pair<size_t, size_t>> indexed_groups;
+    iarc >> indexed_groups;
+    m_index_cache->indexed_edge_groups.insert(indexed_groups.begin(),
+                                              indexed_groups.end());
+    size_t num_indices = 0;
+    iarc >> num_indices;
+    for (size_t i = 0; i < num_indices; ++i) {
+      size_t src_partition, dst_partition, groupa, groupb;
+      iarc >> src_partition >> dst_partition >> groupa >> groupb;
+      const sframe& edges = edge_partition(src_partition, dst_partition, groupa, groupb);
+      auto index = std::make_shared<sgraph_edge_index>();
+      index->load(iarc, *edges.select_column(SRC_COLUMN_NAME),
+                  *edges.select_column(DST_COLUMN_NAME));
+      m_index_cache->edge_indices[
+          sgraph_index_cache::edge_index_key{src_partition, dst_partition, groupa, groupb}] = index;
+    }
+  }
 }
 
 /**************************************************************************/
@@ -19,6 +19,7 @@
 #include <memory>
 #include <flexible_type/flexible_type.hpp>
 #include <sgraph/sgraph_constants.hpp>
+#include <sgraph/sgraph_edge_index.hpp>
 #include <sframe/sframe.hpp>
 
 namespace graphlab {
@@ -79,6 +80,8 @@ class sgraph {
   static const char* SRC_COLUMN_NAME;
   static const char* DST_COLUMN_NAME;
   static const flex_type_enum INTERNAL_ID_TYPE;
+  /// Version of the layout written by save() to directory archives
+  static const size_t SERIALIZATION_VERSION;
 
   explicit sgraph(size_t num_partitions = SGRAPH_DEFAULT_NUM_PARTITIONS);
 
@@ -148,12 +151,48 @@ class sgraph {
    *
    * If source_vids and target_vids are empty, a universal
    * "UNDEFINED-->UNDEFINED" query is assumed
+   *
+   * If \ref build_edge_index was called for the edge group, queries on at
+   * most SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES vertex pairs are answered
+   * with the edge index. Other queries scan all the edge partitions.
    */
    sframe get_edges(const std::vector<flexible_type>& source_vids = {},
                     const std::vector<flexible_type>& target_vids = {},
                     const options_map_t& field_constraint = options_map_t(),
                     size_t groupa = 0, size_t groupb = 0) const;
 
+  /**
+   * Builds the index of all the edge partitions between groupa and groupb,
+   * and of the vertex ids of the two groups.
+   *
+   * For each edge partition, the index maps the local source and target
+   * ids to the rows of their edges. \ref get_edges uses it to answer
+   * queries about a few vertices by reading only the rows of their edges,
+   * in the partitions which can contain them, instead of scanning the
+   * graph.
+   *
+   * The index takes 8 bytes per edge, plus a hash table of the vertex ids.
+   * It is never built otherwise. Once built, the index of a partition is
+   * rebuilt when the partition changes, and the index is saved with the
+   * graph, until \ref drop_edge_index is called.
+   */
+  void build_edge_index(size_t groupa = 0, size_t groupb = 0) const;
+
+  /**
+   * Frees the index built by \ref build_edge_index for the edge partitions
+   * between groupa and groupb. Does nothing if there is no index.
+   */
+  void drop_edge_index(size_t groupa = 0, size_t groupb = 0) const;
+
+  /**
+   * Returns the index of an edge partition built by \ref build_edge_index,
+   * or NULL if there is none or it is out of date. Never builds it.
+   */
+  std::shared_ptr<const sgraph_edge_index> find_edge_index(size_t src_partition,
+                                                           size_t dst_partition,
+                                                           size_t groupa = 0,
+                                                           size_t groupb = 0) const;
+
   /**
    * Returns a list of fields for given vertex group in the graph.
    */
@@ -727,6 +766,13 @@ class sgraph {
    */
   std::map<std::pair<size_t, size_t>, std::vector<sframe> > m_edge_groups;
 
+  /**
+   * The indices built for the vertex and edge partitions. Shared by
+   * copies of the graph, see \ref sgraph_index_cache.
+   */
+  std::shared_ptr<sgraph_index_cache> m_index_cache =
+      std::make_shared<sgraph_index_cache>();
+
   /**************************************************************************/
   /*                                                                        */
   /*                            Helper Functions                            */
@@ -771,6 +817,33 @@ class sgraph {
    */
   std::shared_ptr<vid_hash_map_type> fetch_vid_hash_map(size_t partition, size_t group);
 
+  /**
+   * Returns the index of the vertex ids of a vertex partition, building
+   * it if it does not exist or is out of date.
+   */
+  std::shared_ptr<const sgraph_vertex_index> get_vertex_index(size_t partition,
+                                                              size_t group) const;
+
+  /**
+   * Returns the adjacency index of an edge partition, building it if it
+   * does not exist or is out of date.
+   */
+  std::shared_ptr<const sgraph_edge_index> get_edge_index(size_t src_partition,
+                                                          size_t dst_partition,
+                                                          size_t groupa,
+                                                          size_t groupb) const;
+
+  /**
+   * Implementation of get_edges() with the edge index. The constraints
+   * are the same as get_edges(), except that field_constraint is given
+   * as the satisfy_value_constraint function.
+   */
+  sframe get_edges_with_index(
+      const std::vector<flexible_type>& source_vids,
+      const std::vector<flexible_type>& target_vids,
+      const std::function<bool(const std::vector<flexible_type>&)>& satisfy_value_constraint,
+      size_t groupa, size_t groupb) const;
+
   /**
    * Initialize an empty sframe with column names and types.
    */
@@ -22,6 +22,8 @@
 #include <algorithm>
 #include <sframe/sframe.hpp>
 #include <flexible_type/flexible_type.hpp>
+#include <parallel/atomic.hpp>
+#include <logger/logger.hpp>
 namespace graphlab {
 namespace sgraph_compute {
 
@@ -78,6 +80,9 @@ class vertex_block {
     m_loaded = false;
     m_vertices.clear();
     m_vertices.shrink_to_fit();
+    // the partition may be replaced by the time the block is reloaded
+    m_last_index_file.clear();
+    m_reader.reset();
   }
 
   /**
@@ -138,6 +143,144 @@ class vertex_block {
   std::unique_ptr<typename SIterableType::reader_type> m_reader;
 };
 
+/**
+ * A partition of vertices held in memory as typed columns.
+ *
+ * Only a subset of the vertex fields is loaded, and each must be numeric
+ * (flex_type_enum::INTEGER or FLOAT) and have no missing values. Each
+ * field is stored as a contiguous array of graphlab::atomic<flex_int> or
+ * graphlab::atomic<flex_float>, so that edge computations can update the
+ * vertices with atomic adds instead of locking them, and so that a sweep
+ * over the edges only touches the 8 bytes of the fields it reads.
+ *
+ * Fields are addressed by their position in the list of fields given to
+ * \ref load(), and vertices by their local id (row in the partition).
+ */
+class typed_vertex_block {
+ public:
+  /**
+   * Loads the columns field_ids of a vertex partition. Throws if one of
+   * them is not numeric or has missing values.
+   */
+  void load(const sframe& sf, const std::vector<size_t>& field_ids) {
+    const size_t READ_BATCH_SIZE = 64 * 1024;
+    m_num_vertices = sf.num_rows();
+    m_columns.resize(field_ids.size());
+    for (size_t k = 0; k < field_ids.size(); ++k) {
+      auto column = sf.select_column(field_ids[k]);
+      const std::string& name = sf.column_name(field_ids[k]);
+      typed_column& typed = m_columns[k];
+      typed.type = column->get_type();
+      if (typed.type != flex_type_enum::INTEGER &&
+          typed.type != flex_type_enum::FLOAT) {
+        log_and_throw("Vertex field " + name + " is not numeric");
+      }
+      typed.floats.clear();
+      typed.ints.clear();
+      if (typed.type == flex_type_enum::FLOAT) typed.floats.resize(m_num_vertices);
+      else typed.ints.resize(m_num_vertices);
+
+      auto reader = column->get_reader();
+      std::vector<flexible_type> buffer;
+      for (size_t row = 0; row < m_num_vertices; row += READ_BATCH_SIZE) {
+        reader->read_rows(row, std::min(row + READ_BATCH_SIZE, m_num_vertices), buffer);
+        for (size_t i = 0; i < buffer.size(); ++i) {
+          if (buffer[i].get_type() == flex_type_enum::UNDEFINED) {
+            log_and_throw("Vertex field " + name + " has missing values");
+          }
+          if (typed.type == flex_type_enum::FLOAT) {
+            typed.floats[row + i].value = buffer[i].get<flex_float>();
+          } else {
+            typed.ints[row + i].value = buffer[i].get<flex_int>();
+          }
+        }
+      }
+    }
+    m_loaded = true;
+  }
+
+  /**
+   * Writes field k to outputsf, which must be opened for write with one
+   * segment. The type of outputsf is set to the type of the field.
+   */
+  void flush(size_t k, sarray<flexible_type>& outputsf) const {
+    DASSERT_LT(k, m_columns.size());
+    const typed_column& typed = m_columns[k];
+    outputsf.set_type(typed.type);
+    auto out = outputsf.get_output_iterator(0);
+    for (size_t i = 0; i < m_num_vertices; ++i) {
+      if (typed.type == flex_type_enum::FLOAT) *out = flex_float(typed.floats[i].value);
+      else *out = flex_int(typed.ints[i].value);
+      ++out;
+    }
+    outputsf.close();
+  }
+
+  /**
+   * Unloads the loaded data, releasing all memory used.
+   */
+  void unload() {
+    m_loaded = false;
+    m_num_vertices = 0;
+    m_columns.clear();
+    m_columns.shrink_to_fit();
+  }
+
+  /**
+   * Returns true if the block is loaded. False otherwise.
+   */
+  bool is_loaded() const {
+    return m_loaded;
+  }
+
+  /// Returns the number of vertices
+  inline size_t num_vertices() const {
+    return m_num_vertices;
+  }
+
+  /// Returns field k of a vertex as a float
+  inline flex_float get_float(size_t k, size_t vid) const {
+    const typed_column& typed = m_columns[k];
+    return typed.type == flex_type_enum::FLOAT ?
+        typed.floats[vid].value : flex_float(typed.ints[vid].value);
+  }
+
+  /// Returns field k of a vertex as an integer
+  inline flex_int get_int(size_t k, size_t vid) const {
+    const typed_column& typed = m_columns[k];
+    return typed.type == flex_type_enum::INTEGER ?
+        typed.ints[vid].value : flex_int(typed.floats[vid].value);
+  }
+
+  /**
+   * Sets field k of a vertex. Concurrent sets of the same value race;
+   * use \ref add() for updates which commute.
+   */
+  template <typename T>
+  inline void set(size_t k, size_t vid, T value) {
+    typed_column& typed = m_columns[k];
+    if (typed.type == flex_type_enum::FLOAT) typed.floats[vid].value = flex_float(value);
+    else typed.ints[vid].value = flex_int(value);
+  }
+
+  /// Atomically adds value to field k of a vertex
+  template <typename T>
+  inline void add(size_t k, size_t vid, T value) {
+    typed_column& typed = m_columns[k];
+    if (typed.type == flex_type_enum::FLOAT) typed.floats[vid].inc(flex_float(value));
+    else typed.ints[vid].inc(flex_int(value));
+  }
+
+ private:
+  struct typed_column {
+    flex_type_enum type = flex_type_enum::FLOAT;
+    std::vector<graphlab::atomic<flex_float> > floats;
+    std::vector<graphlab::atomic<flex_int> > ints;
+  };
+  std::vector<typed_column> m_columns;
+  size_t m_num_vertices = 0;
+  bool m_loaded = false;
+};
 
 } // sgraph_compute
 } // graphlab 
@@ -24,6 +24,9 @@ size_t SGRAPH_BATCH_TRIPLE_APPLY_LOCK_ARRAY_SIZE = 1024 * 1024;
 size_t SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE = 1024;
 size_t SGRAPH_DEFAULT_NUM_PARTITIONS = 8;
 size_t SGRAPH_INGRESS_VID_BUFFER_SIZE = 1024 * 1024;
+size_t SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES = 1024;
+size_t SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY = 4LL * 1024 * 1024 * 1024;
+size_t SGRAPH_UNION_FIND_CAPACITY = 8LL * 1024 * 1024 * 1024;
 
 REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
                             SGRAPH_TRIPLE_APPLY_LOCK_ARRAY_SIZE, 
@@ -51,4 +54,19 @@ REGISTER_GLOBAL_WITH_CHECKS(int64_t,
                             SGRAPH_INGRESS_VID_BUFFER_SIZE, 
                             true, 
                             +[](int64_t val){ return val >= 1; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES, 
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY, 
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
+
+REGISTER_GLOBAL_WITH_CHECKS(int64_t, 
+                            SGRAPH_UNION_FIND_CAPACITY, 
+                            true, 
+                            +[](int64_t val){ return val >= 0; });
 }
@@ -36,6 +36,25 @@ extern size_t SGRAPH_DEFAULT_NUM_PARTITIONS;
  * Buffer size for vertex deduplication during graph ingress
  */
 extern size_t SGRAPH_INGRESS_VID_BUFFER_SIZE;
+
+/**
+ * Maximum number of (source, target) pairs in a get_edges query for it
+ * to use the edge index (when built with sgraph::build_edge_index) instead
+ * of scanning all the edges. 0 disables the index.
+ */
+extern size_t SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES;
+
+/**
+ * Memory budget in bytes for the vertex blocks held in memory by
+ * triple_apply and the sgraph_engine. See vertex_block_cache.
+ */
+extern size_t SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY;
+
+/**
+ * Memory limit in bytes for the union find of the connected components
+ * toolkit (12 bytes per vertex). Larger graphs use label propagation.
+ */
+extern size_t SGRAPH_UNION_FIND_CAPACITY;
 }
 
 #endif
@@ -0,0 +1,128 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <sstream>
+#include <limits>
+#include <sgraph/sgraph_edge_index.hpp>
+
+namespace graphlab {
+
+namespace {
+
+/// Number of rows read at once when building an index
+const size_t INDEX_READ_BATCH_SIZE = 64 * 1024;
+
+/**
+ * Counting sort of the rows of an edge partition by one of its local id
+ * columns. See \ref sgraph_edge_index.
+ */
+void build_adjacency(const sarray<flexible_type>& ids, size_t num_vertices,
+                     std::vector<uint32_t>& offsets, std::vector<uint32_t>& rows) {
+  if (ids.size() > std::numeric_limits<uint32_t>::max() ||
+      num_vertices > std::numeric_limits<uint32_t>::max()) {
+    log_and_throw("Graph partition too large to be indexed");
+  }
+  std::vector<uint32_t> local_ids;
+  local_ids.reserve(ids.size());
+  auto reader = ids.get_reader();
+  std::vector<flexible_type> buffer;
+  for (size_t row = 0; row < ids.size(); row += INDEX_READ_BATCH_SIZE) {
+    reader->read_rows(row, std::min(row + INDEX_READ_BATCH_SIZE, ids.size()), buffer);
+    for (const auto& id: buffer) {
+      size_t local_id = id;
+      ASSERT_LT(local_id, num_vertices);
+      local_ids.push_back(local_id);
+    }
+  }
+
+  offsets.assign(num_vertices + 1, 0);
+  for (uint32_t local_id: local_ids) ++offsets[local_id + 1];
+  for (size_t i = 0; i < num_vertices; ++i) offsets[i + 1] += offsets[i];
+
+  rows.resize(local_ids.size());
+  std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+  for (size_t row = 0; row < local_ids.size(); ++row) {
+    rows[next[local_ids[row]]++] = row;
+  }
+}
+
+void append_rows(const std::vector<uint32_t>& offsets,
+                 const std::vector<uint32_t>& rows,
+                 size_t local_id, std::vector<size_t>& ret) {
+  if (local_id + 1 >= offsets.size()) return;
+  ret.insert(ret.end(),
+             rows.begin() + offsets[local_id],
+             rows.begin() + offsets[local_id + 1]);
+}
+
+} // anonymous namespace
+
+std::string sgraph_index_data_key(const sarray<flexible_type>& column) {
+  auto info = column.get_index_info();
+  std::stringstream strm;
+  for (size_t i = 0; i < info.segment_files.size(); ++i) {
+    strm << info.segment_files[i] << "#" << info.segment_sizes[i] << ";";
+  }
+  return strm.str();
+}
+
+void sgraph_vertex_index::build(const sarray<flexible_type>& ids) {
+  m_data_key = sgraph_index_data_key(ids);
+  m_vids.clear();
+  ids.get_reader()->read_rows(0, ids.size(), m_vids);
+  m_local_ids.clear();
+  m_local_ids.reserve(m_vids.size());
+  for (size_t i = 0; i < m_vids.size(); ++i) {
+    m_local_ids[m_vids[i]] = i;
+  }
+}
+
+void sgraph_edge_index::build(const sarray<flexible_type>& src_ids,
+                              size_t num_src_vertices,
+                              const sarray<flexible_type>& dst_ids,
+                              size_t num_dst_vertices) {
+  ASSERT_EQ(src_ids.size(), dst_ids.size());
+  m_src_data_key = sgraph_index_data_key(src_ids);
+  m_dst_data_key = sgraph_index_data_key(dst_ids);
+  build_adjacency(src_ids, num_src_vertices, m_src_offsets, m_src_rows);
+  build_adjacency(dst_ids, num_dst_vertices, m_dst_offsets, m_dst_rows);
+}
+
+void sgraph_edge_index::get_rows_by_source(size_t local_id,
+                                           std::vector<size_t>& ret) const {
+  append_rows(m_src_offsets, m_src_rows, local_id, ret);
+}
+
+void sgraph_edge_index::get_rows_by_target(size_t local_id,
+                                           std::vector<size_t>& ret) const {
+  append_rows(m_dst_offsets, m_dst_rows, local_id, ret);
+}
+
+void sgraph_edge_index::save(oarchive& oarc) const {
+  oarc << m_src_offsets << m_src_rows << m_dst_offsets << m_dst_rows;
+}
+
+void sgraph_edge_index::load(iarchive& iarc,
+                             const sarray<flexible_type>& src_ids,
+                             const sarray<flexible_type>& dst_ids) {
+  iarc >> m_src_offsets >> m_src_rows >> m_dst_offsets >> m_dst_rows;
+  ASSERT_EQ(m_src_rows.size(), src_ids.size());
+  ASSERT_EQ(m_dst_rows.size(), dst_ids.size());
+  m_src_data_key = sgraph_index_data_key(src_ids);
+  m_dst_data_key = sgraph_index_data_key(dst_ids);
+}
+
+} // namespace graphlab
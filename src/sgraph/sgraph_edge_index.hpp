@@ -0,0 +1,152 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GRAPHLAB_SGRAPH_SGRAPH_EDGE_INDEX_HPP
+#define GRAPHLAB_SGRAPH_SGRAPH_EDGE_INDEX_HPP
+#include <map>
+#include <set>
+#include <tuple>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <flexible_type/flexible_type.hpp>
+#include <parallel/pthread_tools.hpp>
+#include <sframe/sarray.hpp>
+#include <serialization/serialization_includes.hpp>
+
+namespace graphlab {
+
+/**
+ * Returns a string identifying the data of an sarray. Two sarrays with the
+ * same key hold the same data, since segment files are never modified
+ * once written. Used to tell whether an index is still valid for a
+ * partition of an \ref sgraph.
+ */
+std::string sgraph_index_data_key(const sarray<flexible_type>& column);
+
+/**
+ * Index of the vertex ids of a vertex partition of an \ref sgraph: maps
+ * vertex ids to local ids (row numbers in the partition) and back.
+ */
+class sgraph_vertex_index {
+ public:
+  /// Builds the index from the id column of a vertex partition.
+  void build(const sarray<flexible_type>& ids);
+
+  /// Returns true if the index was built from the current data of ids.
+  inline bool is_valid_for(const sarray<flexible_type>& ids) const {
+    return m_data_key == sgraph_index_data_key(ids);
+  }
+
+  /// Returns the local id of a vertex, or (size_t)(-1) if it is not found.
+  inline size_t local_id(const flexible_type& vid) const {
+    auto iter = m_local_ids.find(vid);
+    return iter == m_local_ids.end() ? (size_t)(-1) : iter->second;
+  }
+
+  /// Returns the vertex ids, indexed by local id.
+  inline const std::vector<flexible_type>& vertex_ids() const {
+    return m_vids;
+  }
+
+ private:
+  std::string m_data_key;
+  std::vector<flexible_type> m_vids;
+  std::unordered_map<flexible_type, size_t> m_local_ids;
+};
+
+/**
+ * Adjacency index of an edge partition of an \ref sgraph.
+ *
+ * Maps the local source and target ids of the partition to the rows of
+ * their edges: the rows of the edges with local source id i are
+ * m_src_rows[m_src_offsets[i]] to m_src_rows[m_src_offsets[i + 1] - 1],
+ * in increasing order (and similarly for the targets). The index is built
+ * with a counting sort over the two id columns, which only reads those
+ * two columns of the partition.
+ *
+ * Rows are stored as 32 bit integers (8 bytes per edge for both sides), so
+ * a partition with 2^32 edges or more cannot be indexed.
+ */
+class sgraph_edge_index {
+ public:
+  /**
+   * Builds the index from the source and target id columns of an edge
+   * partition whose source and target vertex partitions have
+   * num_src_vertices and num_dst_vertices vertices.
+   */
+  void build(const sarray<flexible_type>& src_ids, size_t num_src_vertices,
+             const sarray<flexible_type>& dst_ids, size_t num_dst_vertices);
+
+  /// Returns true if the index was built from the current data of the columns.
+  inline bool is_valid_for(const sarray<flexible_type>& src_ids,
+                           const sarray<flexible_type>& dst_ids) const {
+    return m_src_data_key == sgraph_index_data_key(src_ids) &&
+        m_dst_data_key == sgraph_index_data_key(dst_ids);
+  }
+
+  /// Appends the rows of the edges with a given local source id to ret.
+  void get_rows_by_source(size_t local_id, std::vector<size_t>& ret) const;
+
+  /// Appends the rows of the edges with a given local target id to ret.
+  void get_rows_by_target(size_t local_id, std::vector<size_t>& ret) const;
+
+  /**
+   * Saves the index, but not the keys of the data it was built from,
+   * which change when the partition is saved.
+   */
+  void save(oarchive& oarc) const;
+
+  /// Loads an index saved for the given id columns.
+  void load(iarchive& iarc,
+            const sarray<flexible_type>& src_ids,
+            const sarray<flexible_type>& dst_ids);
+
+ private:
+  std::string m_src_data_key;
+  std::string m_dst_data_key;
+  std::vector<uint32_t> m_src_offsets;
+  std::vector<uint32_t> m_src_rows;
+  std::vector<uint32_t> m_dst_offsets;
+  std::vector<uint32_t> m_dst_rows;
+};
+
+/**
+ * The indices built for the partitions of an \ref sgraph. Safe for
+ * concurrent use. The indices are checked against the data of the
+ * partitions when they are looked up, so a cache may be shared by copies of
+ * a graph which later diverge.
+ *
+ * Only the edge groups in indexed_edge_groups are indexed, see
+ * \ref sgraph::build_edge_index.
+ */
+struct sgraph_index_cache {
+  /// (partition, group) -> vertex index
+  typedef std::pair<size_t, size_t> vertex_index_key;
+  /// (src partition, dst partition, groupa, groupb) -> edge index
+  typedef std::tuple<size_t, size_t, size_t, size_t> edge_index_key;
+
+  graphlab::mutex lock;
+  /// (groupa, groupb) of the edge groups to index
+  std::set<std::pair<size_t, size_t> > indexed_edge_groups;
+  std::map<vertex_index_key, std::shared_ptr<sgraph_vertex_index> > vertex_indices;
+  std::map<edge_index_key, std::shared_ptr<sgraph_edge_index> > edge_indices;
+};
+
+} // namespace graphlab
+#endif
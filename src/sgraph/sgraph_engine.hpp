@@ -26,6 +26,8 @@
 #include <sgraph/sgraph.hpp>
 #include <sgraph/hilbert_parallel_for.hpp>
 #include <sgraph/sgraph_compute_vertex_block.hpp>
+#include <sgraph/sgraph_vertex_block_cache.hpp>
+#include <sgraph/sgraph_constants.hpp>
 #include <util/cityhash_gl.hpp>
 
 namespace graphlab {
@@ -137,50 +139,60 @@ class sgraph_engine {
                                 std::unordered_set<size_t> sgraph_compute_group = {0},
                                 size_t parallel_limit = thread_pool::get_instance().size()) {
     init_data_structures(graph, central_group, initial_value);
-    hilbert_blocked_parallel_for(
-         graph.get_num_partitions(),
-         // The preamble to each parallel for block.
-         // Thisis the collection of edges that will be executed in the next pass.
-         [&](std::vector<std::pair<size_t, size_t> > edgeparts) {
-           std::set<vertex_partition_address> vertex_partitions;
-           std::set<size_t> combine_partitions;
-           // for each partition requested, figure out exactly 
-           // which partition / group I need to load
-           // That does depend on the edge direction I am 
-           // executing.
-           for(auto edgepart: edgeparts) {
-           logstream(LOG_INFO) << "Planning Execution on Edge Partition: " 
-                               << edgepart.first << " " << edgepart.second << std::endl;
-             for(size_t gather_vgroup: sgraph_compute_group) {
-               if (edgedir == edge_direction::ANY_EDGE || 
-                   edgedir == edge_direction::IN_EDGE) {
-                 // this is the edge partition I will read when I have to run
-                 // this edge set. this is IN-edges. So src group is 
-                 // the gather_vgroup and dst group is the central group.
-                 // partition is as defined by edgepart
-                 edge_partition_address address(gather_vgroup, central_group,
-                                                edgepart.first, edgepart.second);
-                 combine_partitions.insert(address.get_dst_vertex_partition().partition);
-                 vertex_partitions.insert(address.get_src_vertex_partition());
-                 vertex_partitions.insert(address.get_dst_vertex_partition());
-               }
-               if (edgedir == edge_direction::ANY_EDGE || 
-                          edgedir == edge_direction::OUT_EDGE) {
-                 // this is the edge partition I will read when I have to run
-                 // this edge set. this is OUT-edges. So dst group is 
-                 // the gather_vgroup and src group is the central group.
-                 // partition is as defined by edgepart
-                 edge_partition_address address(central_group, gather_vgroup,
-                                                edgepart.first, edgepart.second);
-                 combine_partitions.insert(address.get_src_vertex_partition().partition);
-                 vertex_partitions.insert(address.get_src_vertex_partition());
-                 vertex_partitions.insert(address.get_dst_vertex_partition());
-               }
-             }
-           }
-           // request loading of all the vertex partitions I need
-           load_graph_vertex_blocks(graph, vertex_partitions);
-           load_combine_blocks(combine_partitions);
+    size_t num_vertex_blocks = graph.get_num_groups() * graph.get_num_partitions();
+    // The blocks needed by an edge partition: the vertex partitions at
+    // both ends, and the combine partitions of the central vertices.
+    // That does depend on the edge direction I am executing.
+    auto blocks_of = [&](std::pair<size_t, size_t> edgepart) {
+      std::vector<size_t> blocks;
+      for(size_t gather_vgroup: sgraph_compute_group) {
+        if (edgedir == edge_direction::ANY_EDGE || 
+            edgedir == edge_direction::IN_EDGE) {
+          // this is the edge partition I will read when I have to run
+          // this edge set. this is IN-edges. So src group is 
+          // the gather_vgroup and dst group is the central group.
+          // partition is as defined by edgepart
+          edge_partition_address address(gather_vgroup, central_group,
+                                         edgepart.first, edgepart.second);
+          blocks.push_back(combine_block_id(address.get_dst_vertex_partition().partition));
+          blocks.push_back(vertex_block_id(address.get_src_vertex_partition()));
+          blocks.push_back(vertex_block_id(address.get_dst_vertex_partition()));
+        }
+        if (edgedir == edge_direction::ANY_EDGE || 
+            edgedir == edge_direction::OUT_EDGE) {
+          // this is the edge partition I will read when I have to run
+          // this edge set. this is OUT-edges. So dst group is 
+          // the gather_vgroup and src group is the central group.
+          // partition is as defined by edgepart
+          edge_partition_address address(central_group, gather_vgroup,
+                                         edgepart.first, edgepart.second);
+          blocks.push_back(combine_block_id(address.get_src_vertex_partition().partition));
+          blocks.push_back(vertex_block_id(address.get_src_vertex_partition()));
+          blocks.push_back(vertex_block_id(address.get_dst_vertex_partition()));
+        }
+      }
+      return blocks;
+    };
+    std::vector<size_t> block_bytes(num_vertex_blocks + graph.get_num_partitions());
+    for (size_t i = 0; i < num_vertex_blocks; ++i) {
+      block_bytes[i] = estimate_vertex_block_bytes(
+          graph.vertex_partition(i % graph.get_num_partitions(),
+                                 i / graph.get_num_partitions()));
+    }
+    for (size_t i = 0; i < graph.get_num_partitions(); ++i) {
+      block_bytes[combine_block_id(i)] = combine_sarrays[i]->size() * sizeof(T);
+    }
+    vertex_block_cache cache(block_bytes.size(), blocks_of, block_bytes,
+                             SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY);
+    cache.run(
+         hilbert_ordered_coordinates(graph.get_num_partitions()),
+         // blocks to write back and unload
+         [&](const std::vector<size_t>& blocks) {
+           unload_blocks(blocks);
+         },
+         // blocks to load before the next pass
+         [&](const std::vector<size_t>& blocks) {
+           load_blocks(graph, blocks);
          },
          // This is the actual parallel for, and this is the block I am to 
          // be executing
@@ -199,9 +211,8 @@ class sgraph_engine {
              sframe& edgeframe = graph.edge_partition(address);
              compute_const_gather(edgeframe, address, central_group, edgedir, gather);
            }
-         });
-    // flush the combine blocks
-    load_combine_blocks(std::set<size_t>());
+         },
+         parallel_limit);
     return combine_sarrays;
   }
 
@@ -227,31 +238,29 @@ class sgraph_engine {
 
     size_t return_size = graph.get_num_partitions() * graph.get_num_partitions();
     std::vector<std::shared_ptr<sarray<T>>> return_edge_value(return_size);
-    hilbert_blocked_parallel_for(
-         graph.get_num_partitions(),
-         // The preamble to each parallel for block.
-         // Thisis the collection of edges that will be executed in the next pass.
-         [&](std::vector<std::pair<size_t, size_t> > edgeparts) {
-           std::set<vertex_partition_address> vertex_partitions;
-           std::set<size_t> combine_partitions;
-           // for each partition requested, figure out exactly 
-           // which partition / group I need to load
-           // That does depend on the edge direction I am 
-           // executing.
-           for(auto edgepart: edgeparts) {
-           logstream(LOG_INFO) << "Planning Execution on Edge Partition: " 
-                               << edgepart.first << " " << edgepart.second << std::endl;
-             // this is the edge partition I will read when I have to run
-             // this edge set. this is IN-edges. So src group is 
-             // the gather_vgroup and dst group is the central group.
-             // partition is as defined by edgepart
-             edge_partition_address address(groupa, groupb, edgepart.first, edgepart.second);
-             combine_partitions.insert(address.get_dst_vertex_partition().partition);
-             vertex_partitions.insert(address.get_src_vertex_partition());
-             vertex_partitions.insert(address.get_dst_vertex_partition());
-           }
-           // request loading of all the vertex partitions I need
-           load_graph_vertex_blocks(graph, vertex_partitions);
+    size_t num_vertex_blocks = graph.get_num_groups() * graph.get_num_partitions();
+    std::vector<size_t> block_bytes(num_vertex_blocks);
+    for (size_t i = 0; i < num_vertex_blocks; ++i) {
+      block_bytes[i] = estimate_vertex_block_bytes(
+          graph.vertex_partition(i % graph.get_num_partitions(),
+                                 i / graph.get_num_partitions()));
+    }
+    vertex_block_cache cache(
+         num_vertex_blocks,
+         // the vertex partitions at both ends of an edge partition
+         [&](std::pair<size_t, size_t> edgepart) {
+           edge_partition_address address(groupa, groupb, edgepart.first, edgepart.second);
+           return std::vector<size_t>{vertex_block_id(address.get_src_vertex_partition()),
+                                      vertex_block_id(address.get_dst_vertex_partition())};
+         },
+         block_bytes, SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY);
+    cache.run(
+         hilbert_ordered_coordinates(graph.get_num_partitions()),
+         [&](const std::vector<size_t>& blocks) {
+           unload_blocks(blocks);
+         },
+         [&](const std::vector<size_t>& blocks) {
+           load_blocks(graph, blocks);
          },
          // This is the actual parallel for, and this is the block I am to 
          // be executing
@@ -267,7 +276,8 @@ class sgraph_engine {
            sframe& edgeframe = graph.edge_partition(address);
            size_t partid = edgepart.first * graph.get_num_partitions() + edgepart.second;
            return_edge_value[partid] = compute_edge_map(edgeframe, address, map_fn, ret_type);
-         });
+         },
+         parallel_limit);
     return return_edge_value;
   }
 
@@ -332,70 +342,67 @@ class sgraph_engine {
   }
 
   /**
-   * This function will unload all graph vertex blocks which are not in the set
-   * vertex_address and load all vertex blocks which are in the set.
+   * Returns the id of a vertex block in the vertex_block_cache.
+   * The vertex blocks come first, then the combine blocks.
    */
-  void load_graph_vertex_blocks(sgraph& graph,
-                                const std::set<vertex_partition_address>& vertex_address) {
-    // look for all loaded blocks and if they are not in the vertex_address set, unload it
-    for (size_t group = 0; group < vertex_data.size(); ++group) {
-      for (size_t partition = 0; partition < vertex_data[group].size(); ++partition) {
-        if (vertex_data[group][partition].is_loaded() && 
-            vertex_address.count({group, partition}) == 0) {
-          vertex_data[group][partition].unload();
-        }
-      }
-    }
-    std::vector<vertex_partition_address> vertex_address_vec;
-    std::copy(vertex_address.begin(), vertex_address.end(),
-              std::inserter(vertex_address_vec, vertex_address_vec.end()));
-
-    // now, for each element in vertex_address, if it is not loaded, load it
-    parallel_for(vertex_address_vec.begin(),
-                 vertex_address_vec.end(),
-                 // parallel for callback. called with each vertex address I need
-                 // to load
-                 [&](vertex_partition_address& part) {
-                   // get the frame for the vertex partition
-                   const sframe& frame = graph.vertex_partition(part.partition, part.group);
-                   // load it into the vertex data.
-                   logstream(LOG_INFO) << "Loading Vertex Partition: " 
-                                       << part.group << " " << part.partition << std::endl;
-                   vertex_data[part.group][part.partition].load_if_not_loaded(frame);
-                 });
+  inline size_t vertex_block_id(const vertex_partition_address& address) const {
+    return address.group * vertex_data[0].size() + address.partition;
   }
 
+  /// Returns the id of the combine block of a partition. See vertex_block_id
+  inline size_t combine_block_id(size_t partition) const {
+    return vertex_data.size() * vertex_data[0].size() + partition;
+  }
 
   /**
-   * This function will unload all gather blocks not in the set partitions,
-   * writing them back out to the sarray if modified. It will then load
-   * all the gather blocks that are in the set.
+   * This function will load the given vertex and combine blocks.
    */
-  void load_combine_blocks(const std::set<size_t> partitions) {
-    for (size_t partition = 0; partition < combine_data.size(); ++partition) {
-      if (combine_data[partition].is_loaded() && partitions.count(partition) == 0) {
-        // reset the existing sarray and save the gather data to it.
-        combine_sarrays[partition].reset(new sarray<T>());
-        combine_sarrays[partition]->open_for_write(1);
-        if (typeid(T) == typeid(flexible_type)) {
-          combine_sarrays[partition]->set_type(m_return_type);
-        }
-        combine_data[partition].flush(*combine_sarrays[partition]); 
-        // we need to do a save here.
-        combine_data[partition].unload();
-      }
-    }
-
-    std::vector<size_t> partitions_vec;
-    std::copy(partitions.begin(), partitions.end(),
-              std::inserter(partitions_vec, partitions_vec.end()));
+  void load_blocks(sgraph& graph, const std::vector<size_t>& blocks) {
+    size_t num_partitions = vertex_data[0].size();
+    size_t num_vertex_blocks = vertex_data.size() * num_partitions;
+    parallel_for(blocks.begin(),
+                 blocks.end(),
+                 [&](size_t block) {
+                   if (block < num_vertex_blocks) {
+                     size_t group = block / num_partitions;
+                     size_t partition = block % num_partitions;
+                     // get the frame for the vertex partition
+                     const sframe& frame = graph.vertex_partition(partition, group);
+                     // load it into the vertex data.
+                     logstream(LOG_INFO) << "Loading Vertex Partition: " 
+                                         << group << " " << partition << std::endl;
+                     vertex_data[group][partition].load_if_not_loaded(frame);
+                   } else {
+                     size_t partition = block - num_vertex_blocks;
+                     logstream(LOG_INFO) << "Loading Combine Partition: " << partition << std::endl;
+                     combine_data[partition].load_if_not_loaded(*combine_sarrays[partition]);
+                   }
+                 });
+  }
 
-    // now, for each element in partitions, if it is not loaded, load it
-    parallel_for(partitions_vec.begin(), 
-                 partitions_vec.end(),
-                 [&](size_t part) {
-                   logstream(LOG_INFO) << "Loading Combine Partition: " << part << std::endl;
-                   combine_data[part].load_if_not_loaded(*combine_sarrays[part]);
+  /**
+   * This function will unload the given vertex and combine blocks, writing
+   * the combine blocks back out to their sarray.
+   */
+  void unload_blocks(const std::vector<size_t>& blocks) {
+    size_t num_partitions = vertex_data[0].size();
+    size_t num_vertex_blocks = vertex_data.size() * num_partitions;
+    parallel_for(blocks.begin(),
+                 blocks.end(),
+                 [&](size_t block) {
+                   if (block < num_vertex_blocks) {
+                     vertex_data[block / num_partitions][block % num_partitions].unload();
+                   } else {
+                     size_t partition = block - num_vertex_blocks;
+                     // reset the existing sarray and save the gather data to it.
+                     combine_sarrays[partition].reset(new sarray<T>());
+                     combine_sarrays[partition]->open_for_write(1);
+                     if (typeid(T) == typeid(flexible_type)) {
+                       combine_sarrays[partition]->set_type(m_return_type);
+                     }
+                     combine_data[partition].flush(*combine_sarrays[partition]); 
+                     combine_data[partition].unload();
+                   }
                  });
   }
 
@@ -17,6 +17,7 @@
 #include <sgraph/sgraph_triple_apply.hpp>
 #include <sgraph/hilbert_parallel_for.hpp>
 #include <sgraph/sgraph_constants.hpp>
+#include <sgraph/sgraph_vertex_block_cache.hpp>
 #include <util/cityhash_gl.hpp>
 #include <lambda/graph_lambda_interface.hpp>
 #include <lambda/graph_pylambda_master.hpp>
@@ -25,6 +26,46 @@
 namespace graphlab {
 namespace sgraph_compute {
 
+/**************************************************************************/
+/*                                                                        */
+/*                            Vertex Frontier                             */
+/*                                                                        */
+/**************************************************************************/
+
+  void vertex_frontier::init(const sgraph& g) {
+    m_active.resize(g.get_num_partitions());
+    for (size_t i = 0; i < m_active.size(); ++i) {
+      m_active[i].resize(g.vertex_partition(i).num_rows());
+      m_active[i].clear();
+    }
+  }
+
+  void vertex_frontier::activate_all() {
+    for (auto& bits: m_active) bits.fill();
+  }
+
+  void vertex_frontier::clear() {
+    for (auto& bits: m_active) bits.clear();
+  }
+
+  size_t vertex_frontier::num_active(size_t partition) const {
+    DASSERT_LT(partition, m_active.size());
+    return m_active[partition].popcount();
+  }
+
+  size_t vertex_frontier::num_active() const {
+    size_t ret = 0;
+    for (auto& bits: m_active) ret += bits.popcount();
+    return ret;
+  }
+
+  bool vertex_frontier::empty() const {
+    for (auto& bits: m_active) {
+      if (!bits.empty()) return false;
+    }
+    return true;
+  }
+
   /**
    * Field information about a vertex or edge data field.
    */
@@ -87,6 +128,14 @@ namespace sgraph_compute {
      */
     virtual void visit_edges(std::vector<edge_data>& edgedata) = 0;
 
+    /**
+     * Called instead of \ref visit_edges when the edges are restricted to
+     * a frontier. Only the edges with is_active[i] set are visited; the
+     * others must be kept unchanged.
+     */
+    virtual void visit_active_edges(std::vector<edge_data>& edgedata,
+                                    const std::vector<bool>& is_active) = 0;
+
     /**
      * Called when all edges from the partition have been visited.
      */
@@ -110,6 +159,17 @@ namespace sgraph_compute {
           init_data_structures(mutated_vertex_fields, mutated_edge_fields);
         }
 
+    /**
+     * Restricts the following calls to \ref run to the edges around the
+     * active vertices of frontier. See the frontier overload of
+     * \ref triple_apply. The frontier must outlive the calls.
+     */
+    void set_frontier(const vertex_frontier* frontier,
+                      sgraph::edge_direction direction) {
+      m_frontier = frontier;
+      m_frontier_direction = direction;
+    }
+
     template<typename EdgeVisitor>
     void run(EdgeVisitor edge_visitor);
 
@@ -118,15 +178,15 @@ namespace sgraph_compute {
                               const std::vector<std::string>& mutated_edge_fields);
 
     /**
-     * This function will load all graph vertex blocks with the input_vetex_fields.
+     * This function will load the vertex blocks of the given partitions.
      */
-    void load_graph_vertex_blocks(const std::set<vertex_partition_address>& vertex_address);
+    void load_graph_vertex_blocks(const std::vector<size_t>& partitions);
 
     /**
-     * This function will unload all graph vertex blocks and update the columns in the
-     * mutated_vertex_fields.
+     * This function will update the columns in the mutated_vertex_fields
+     * of the given partitions with their vertex blocks, and unload the blocks.
      */
-    void unload_graph_vertex_blocks(const std::set<vertex_partition_address>& vertex_address);
+    void unload_graph_vertex_blocks(const std::vector<size_t>& partitions);
 
     /**
      * Perform the triple apply function on one partition. If \ref muateted_edge_fields
@@ -137,59 +197,91 @@ namespace sgraph_compute {
                                    edge_partition_address partition_address,
                                    EdgeVisitor visitor);
 
+    /**
+     * Returns true if the edge partition may contain edges to visit
+     * given the frontier.
+     */
+    bool edge_partition_is_active(size_t src_partition, size_t dst_partition) const;
+
+    /**
+     * Returns true if the edge is to be visited given the frontier.
+     */
+    inline bool edge_is_active(size_t src_partition, size_t srcid,
+                               size_t dst_partition, size_t dstid) const {
+      switch(m_frontier_direction) {
+       case sgraph::edge_direction::OUT_EDGE:
+         return m_frontier->is_active(src_partition, srcid);
+       case sgraph::edge_direction::IN_EDGE:
+         return m_frontier->is_active(dst_partition, dstid);
+       default:
+         return m_frontier->is_active(src_partition, srcid) ||
+             m_frontier->is_active(dst_partition, dstid);
+      }
+    }
+
    private:
     sgraph& m_graph;
 
     // storing vertex blocks associated with the working edge partitions.
     std::vector<vertex_block<sframe>> m_vertex_data;
 
-    // storing vertex partition addresses that are currently loaded in memory.
-    std::set<vertex_partition_address> m_loaded_vertex_block_address;
-
     std::vector<field_info> m_mutated_vertex_fields;
     std::vector<field_info> m_mutated_edge_fields;
+
+    // if not NULL, only the edges around the active vertices are visited.
+    const vertex_frontier* m_frontier = NULL;
+    sgraph::edge_direction m_frontier_direction = sgraph::edge_direction::ANY_EDGE;
+    // number of active vertices in each vertex partition.
+    std::vector<size_t> m_num_active_vertices;
   };
 
   template<typename EdgeVisitor>
   void triple_apply_impl::run(EdgeVisitor edge_visitor) {
-    // preamble function that load the vertex blocks associated with the
-    // edge partitions to be visited.
-    std::function<void(std::vector<std::pair<size_t, size_t>>)>
-      preamble_fn = [&](std::vector<std::pair<size_t, size_t>> coordinates) {
-        std::set<vertex_partition_address> vertex_partition_to_load;
-        std::set<vertex_partition_address> vertex_partition_to_unload;
-
-        for (const auto& coordinate: coordinates) {
-          size_t srcid = coordinate.first; 
-          size_t dstid = coordinate.second; 
-          edge_partition_address edge_partition(0, 0, srcid, dstid);
-          vertex_partition_to_load.insert(vertex_partition_address(0, srcid));
-          vertex_partition_to_load.insert(vertex_partition_address(0, dstid));
-        }
-
-        for (const auto& address: m_loaded_vertex_block_address) {
-          if (vertex_partition_to_load.find(address) == vertex_partition_to_load.end()) {
-            vertex_partition_to_unload.insert(address);
-          }
-        }
-
-        unload_graph_vertex_blocks(vertex_partition_to_unload);
-        load_graph_vertex_blocks(vertex_partition_to_load);
-
-        m_loaded_vertex_block_address = vertex_partition_to_load;
-      };
+    size_t num_partitions = m_graph.get_num_partitions();
+    std::vector<std::pair<size_t, size_t>> coordinates =
+        hilbert_ordered_coordinates(num_partitions);
+    if (m_frontier != NULL) {
+      // skip the edge partitions (and the vertex partitions they would load)
+      // without edges around the frontier.
+      ASSERT_EQ(m_frontier->num_partitions(), num_partitions);
+      m_num_active_vertices.resize(num_partitions);
+      for (size_t i = 0; i < m_num_active_vertices.size(); ++i) {
+        m_num_active_vertices[i] = m_frontier->num_active(i);
+      }
+      coordinates.erase(
+          std::remove_if(coordinates.begin(), coordinates.end(),
+                         [&](std::pair<size_t, size_t> coordinate) {
+                           return !edge_partition_is_active(coordinate.first,
+                                                            coordinate.second);
+                         }),
+          coordinates.end());
+    }
 
-    hilbert_blocked_parallel_for(
-        m_graph.get_num_partitions(),
-        preamble_fn,
-        [&](std::pair<size_t, size_t> coordinate) {
-          edge_partition_address partition_address(0, 0, coordinate.first, coordinate.second);
-          sframe& sf = m_graph.edge_partition(partition_address);
-          do_work_on_edge_partition(sf, partition_address, edge_visitor);
-        }
-    );
-    // unload and commit the remaining vertex block in the memory.
-    preamble_fn({});
+    // the vertex blocks are held in memory by a cache, which loads the
+    // source and target vertex partitions of each edge partition.
+    std::vector<size_t> block_bytes(num_partitions);
+    for (size_t i = 0; i < num_partitions; ++i) {
+      block_bytes[i] = estimate_vertex_block_bytes(m_graph.vertex_partition(i));
+    }
+    vertex_block_cache cache(num_partitions,
+                             [](std::pair<size_t, size_t> coordinate) {
+                               return std::vector<size_t>{coordinate.first,
+                                                          coordinate.second};
+                             },
+                             block_bytes, SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY);
+    cache.run(coordinates,
+              [&](const std::vector<size_t>& partitions) {
+                unload_graph_vertex_blocks(partitions);
+              },
+              [&](const std::vector<size_t>& partitions) {
+                load_graph_vertex_blocks(partitions);
+              },
+              [&](std::pair<size_t, size_t> coordinate) {
+                edge_partition_address partition_address(0, 0, coordinate.first,
+                                                         coordinate.second);
+                sframe& sf = m_graph.edge_partition(partition_address);
+                do_work_on_edge_partition(sf, partition_address, edge_visitor);
+              });
   }
 
   void triple_apply_impl::init_data_structures(
@@ -233,51 +325,56 @@ namespace sgraph_compute {
     }
   }
 
+  bool triple_apply_impl::edge_partition_is_active(size_t src_partition,
+                                                   size_t dst_partition) const {
+    bool src_active = m_num_active_vertices[src_partition] > 0;
+    bool dst_active = m_num_active_vertices[dst_partition] > 0;
+    switch(m_frontier_direction) {
+     case sgraph::edge_direction::OUT_EDGE: return src_active;
+     case sgraph::edge_direction::IN_EDGE: return dst_active;
+     default: return src_active || dst_active;
+    }
+  }
+
   /**
-   * This function will load all graph vertex blocks with the input_vetex_fields.
+   * This function will load the vertex blocks of the given partitions.
    */
-  void triple_apply_impl::load_graph_vertex_blocks(const std::set<vertex_partition_address>& vertex_address) {
-    std::vector<vertex_partition_address> address_vec(vertex_address.begin(), vertex_address.end());
-    parallel_for (0, address_vec.size(), [&](size_t i) {
-    // for(size_t i = 0; i < address_vec.size(); ++i) {
-      vertex_partition_address address = address_vec[i];
-      m_vertex_data[address.partition].load_if_not_loaded(m_graph.vertex_partition(address));
-    // }
+  void triple_apply_impl::load_graph_vertex_blocks(const std::vector<size_t>& partitions) {
+    parallel_for (0, partitions.size(), [&](size_t i) {
+      size_t partition = partitions[i];
+      m_vertex_data[partition].load_if_not_loaded(m_graph.vertex_partition(partition));
     });
   }
 
   /**
-   * This function will unload all graph vertex blocks and update the columns in the
-   * mutated_vertex_fields.
+   * This function will update the columns in the mutated_vertex_fields of
+   * the given partitions with their vertex blocks, and unload the blocks.
    */
-  void triple_apply_impl::unload_graph_vertex_blocks(const std::set<vertex_partition_address>& vertex_address) {
-    std::vector<vertex_partition_address> address_vec(vertex_address.begin(), vertex_address.end());
-
-    if (!m_mutated_vertex_fields.empty()) {
-      std::vector<std::string> mutated_field_names;
-      std::vector<flex_type_enum> mutated_field_types;
-      std::vector<size_t> mutated_field_index;
-      for (auto& finfo : m_mutated_vertex_fields) {
-        mutated_field_index.push_back(finfo.id);
-        mutated_field_names.push_back(finfo.name);
-        mutated_field_types.push_back(finfo.type);
-      }
-      parallel_for (0, address_vec.size(), [&](size_t i) {
-      // for (size_t i = 0; i < address_vec.size(); ++i) {
-        vertex_partition_address address = address_vec[i];
-        sframe& old_vertex_data = m_graph.vertex_partition(address);
+  void triple_apply_impl::unload_graph_vertex_blocks(const std::vector<size_t>& partitions) {
+    std::vector<std::string> mutated_field_names;
+    std::vector<flex_type_enum> mutated_field_types;
+    std::vector<size_t> mutated_field_index;
+    for (auto& finfo : m_mutated_vertex_fields) {
+      mutated_field_index.push_back(finfo.id);
+      mutated_field_names.push_back(finfo.name);
+      mutated_field_types.push_back(finfo.type);
+    }
+    parallel_for (0, partitions.size(), [&](size_t i) {
+      size_t partition = partitions[i];
+      if (!m_mutated_vertex_fields.empty()) {
+        sframe& old_vertex_data = m_graph.vertex_partition(partition);
         // save the updated vertex fields
         sframe updated_vertex_data;
         updated_vertex_data.open_for_write(mutated_field_names, mutated_field_types, "", 1);
-        m_vertex_data[address.partition].flush(updated_vertex_data, mutated_field_index);
+        m_vertex_data[partition].flush(updated_vertex_data, mutated_field_index);
         for (size_t i = 0; i < m_mutated_vertex_fields.size(); ++i) {
           std::string column_name = updated_vertex_data.column_name(i);
           old_vertex_data = old_vertex_data.replace_column(updated_vertex_data.select_column(i), column_name);
         }
-        logstream(LOG_INFO) << "Flush partition " << address.partition << std::endl;
-      // }
-      });
-    }
+        logstream(LOG_INFO) << "Flush partition " << partition << std::endl;
+      }
+      m_vertex_data[partition].unload();
+    });
   }
 
   /**
@@ -317,11 +414,48 @@ namespace sgraph_compute {
     size_t row_end = reader->num_rows();
     // feed batch of edges to the edge visitor
     std::vector<std::vector<flexible_type> > all_edgedata;
-    while (row_start < row_end) {
-      size_t nrows = std::min<size_t>(SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE, row_end - row_start);
-      reader->read_rows(row_start, row_start + nrows, all_edgedata);
-      visitor.visit_edges(all_edgedata);
-      row_start += nrows;
+    if (m_frontier == NULL) {
+      while (row_start < row_end) {
+        size_t nrows = std::min<size_t>(SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE, row_end - row_start);
+        reader->read_rows(row_start, row_start + nrows, all_edgedata);
+        visitor.visit_edges(all_edgedata);
+        row_start += nrows;
+      }
+    } else {
+      // Read the source and target ids first, and only read the rest of the
+      // edge data for the batches with active edges. Inactive batches must
+      // still be read when the edge data is mutated, since the whole
+      // columns are rewritten.
+      bool mutating_edges = !m_mutated_edge_fields.empty();
+      auto id_reader = edgeframe.select_columns({sgraph::SRC_COLUMN_NAME,
+                                                 sgraph::DST_COLUMN_NAME}).get_reader();
+      std::vector<std::vector<flexible_type> > all_ids;
+      std::vector<bool> is_active;
+      size_t num_visited = 0;
+      while (row_start < row_end) {
+        size_t nrows = std::min<size_t>(SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE, row_end - row_start);
+        id_reader->read_rows(row_start, row_start + nrows, all_ids);
+        is_active.assign(all_ids.size(), false);
+        size_t num_active = 0;
+        for (size_t i = 0; i < all_ids.size(); ++i) {
+          is_active[i] = edge_is_active(src_partition, all_ids[i][0],
+                                        dst_partition, all_ids[i][1]);
+          num_active += is_active[i];
+        }
+        if (num_active > 0 || mutating_edges) {
+          reader->read_rows(row_start, row_start + nrows, all_edgedata);
+          DASSERT_EQ(all_edgedata.size(), is_active.size());
+          if (num_active == all_edgedata.size()) {
+            visitor.visit_edges(all_edgedata);
+          } else {
+            visitor.visit_active_edges(all_edgedata, is_active);
+          }
+        }
+        num_visited += num_active;
+        row_start += nrows;
+      }
+      logstream(LOG_INFO) << "Visited " << num_visited << " active edges out of "
+                          << row_end << std::endl;
     }
     logstream(LOG_INFO) << "Finish working on partition "
                         << partition_address.partition1
@@ -360,13 +494,16 @@ namespace sgraph_compute {
      * \param lock_array array of locks to protect con-current access to vertex data.
      * \param srcid_column the column id of the source id field in edge data.
      * \param dstid_column  the column id of the target id field in edge data.
+     * \param next_frontier the frontier edge scopes may activate vertices in.
      */
     single_edge_triple_apply_visitor(
         triple_apply_fn_type apply_fn,
         std::vector<mutex_type>& lock_array,
-        size_t srcid_column, size_t dstid_column) :
+        size_t srcid_column, size_t dstid_column,
+        vertex_frontier* next_frontier = NULL) :
       apply_fn(apply_fn), lock_array(lock_array),
-      srcid_column(srcid_column), dstid_column(dstid_column) { }
+      srcid_column(srcid_column), dstid_column(dstid_column),
+      next_frontier(next_frontier) { }
 
     /**
      * Set the source and target vertex partition.
@@ -405,48 +542,20 @@ namespace sgraph_compute {
     }
 
     void visit_edges(std::vector<edge_data>& edgedata) {
-      // preallocate vector to store the mutated edge data.
-      std::vector<flexible_type> edge_data_buffer;
-      size_t num_mutated_fields = m_mutated_edge_field_ids.size();
-
       for (auto& edata: edgedata) {
-        size_t srcid = edata[srcid_column];
-        size_t dstid = edata[dstid_column];
-
-        // preparing the locks to the source and target vertices.
-        // To prevent deadlocking, lock ordering is determined by the hash value
-        // Always lock lock_0 before lock_1 (the user defined triple_apply_fn is repsonsible).
-        size_t src_hash = hash64_combine(hash64(src_partition), hash64(srcid)) % lock_array.size();
-        size_t dst_hash = hash64_combine(hash64(dst_partition), hash64(dstid)) % lock_array.size();
-        mutex_type *lock_0, *lock_1;
-        if (src_hash == dst_hash) {
-          lock_0 = lock_1 = &(lock_array[src_hash]);
-        } else if (src_hash < dst_hash) {
-          lock_0 = &lock_array[src_hash];
-          lock_1 = &lock_array[dst_hash];
-        } else {
-          lock_0 = &lock_array[dst_hash];
-          lock_1 = &lock_array[src_hash];
-        }
-
-        // the edge scope contains reference to source, target vertex data,
-        // edge data, and the locks associcated to the vertex data.
-        edge_scope scope(&(*source_vertex_data)[srcid], &(*target_vertex_data)[dstid],
-            &edata, lock_0, lock_1);
-
-        // apply the user defined triple_apply_fn
-        apply_fn(scope);
+        visit_edge(edata);
+        write_edge(edata);
+      }
+    }
 
-        // write the mutated edge data to the a sframe, whose columns will
-        // replace the sframe in the edge partition on finalize call.
-        if (m_mutating_edge_data) {
-          edge_data_buffer.resize(num_mutated_fields);
-          for (size_t i = 0; i < num_mutated_fields; ++i) {
-            edge_data_buffer[i] = edata[m_mutated_edge_field_ids[i]];
-          }
-          *m_mutated_edge_data_writer = std::move(edge_data_buffer);
-          ++m_mutated_edge_data_writer;
-        }
+    void visit_active_edges(std::vector<edge_data>& edgedata,
+                            const std::vector<bool>& is_active) {
+      DASSERT_EQ(edgedata.size(), is_active.size());
+      for (size_t i = 0; i < edgedata.size(); ++i) {
+        if (is_active[i]) visit_edge(edgedata[i]);
+        // the mutated edge columns are rewritten in full, so the
+        // inactive edges are written unchanged
+        write_edge(edgedata[i]);
       }
     }
 
@@ -467,6 +576,58 @@ namespace sgraph_compute {
     }
 
   private:
+    /**
+     * Applies the user defined function on one edge.
+     */
+    void visit_edge(edge_data& edata) {
+      size_t srcid = edata[srcid_column];
+      size_t dstid = edata[dstid_column];
+
+      // preparing the locks to the source and target vertices.
+      // To prevent deadlocking, lock ordering is determined by the hash value
+      // Always lock lock_0 before lock_1 (the user defined triple_apply_fn is repsonsible).
+      size_t src_hash = hash64_combine(hash64(src_partition), hash64(srcid)) % lock_array.size();
+      size_t dst_hash = hash64_combine(hash64(dst_partition), hash64(dstid)) % lock_array.size();
+      mutex_type *lock_0, *lock_1;
+      if (src_hash == dst_hash) {
+        lock_0 = lock_1 = &(lock_array[src_hash]);
+      } else if (src_hash < dst_hash) {
+        lock_0 = &lock_array[src_hash];
+        lock_1 = &lock_array[dst_hash];
+      } else {
+        lock_0 = &lock_array[dst_hash];
+        lock_1 = &lock_array[src_hash];
+      }
+
+      // the edge scope contains reference to source, target vertex data,
+      // edge data, and the locks associcated to the vertex data.
+      edge_scope scope(&(*source_vertex_data)[srcid], &(*target_vertex_data)[dstid],
+          &edata, lock_0, lock_1);
+      if (next_frontier) {
+        scope.set_next_frontier(next_frontier, src_partition, srcid,
+                                dst_partition, dstid);
+      }
+
+      // apply the user defined triple_apply_fn
+      apply_fn(scope);
+    }
+
+    /**
+     * Writes the mutated edge data to the a sframe, whose columns will
+     * replace the sframe in the edge partition on finalize call.
+     */
+    void write_edge(const edge_data& edata) {
+      if (m_mutating_edge_data) {
+        size_t num_mutated_fields = m_mutated_edge_field_ids.size();
+        std::vector<flexible_type> edge_data_buffer(num_mutated_fields);
+        for (size_t i = 0; i < num_mutated_fields; ++i) {
+          edge_data_buffer[i] = edata[m_mutated_edge_field_ids[i]];
+        }
+        *m_mutated_edge_data_writer = std::move(edge_data_buffer);
+        ++m_mutated_edge_data_writer;
+      }
+    }
+
     vertex_block<sframe>* source_vertex_data;
     vertex_block<sframe>* target_vertex_data;
     sframe* edge_data_ptr;
@@ -491,6 +652,9 @@ namespace sgraph_compute {
     std::vector<mutex_type>& lock_array;
     size_t srcid_column;
     size_t dstid_column;
+
+    // frontier the edge scopes activate vertices in. May be NULL.
+    vertex_frontier* next_frontier;
   };
 
 
@@ -511,6 +675,33 @@ namespace sgraph_compute {
     compute.run(visitor);
   }
 
+  /**
+   * The triple apply API restricted to a frontier.
+   */
+  void triple_apply(sgraph& g, triple_apply_fn_type apply_fn,
+                    const std::vector<std::string>& mutated_vertex_fields,
+                    const std::vector<std::string>& mutated_edge_fields,
+                    const vertex_frontier& frontier,
+                    sgraph::edge_direction frontier_direction,
+                    vertex_frontier* next_frontier) {
+    ASSERT_NE(&frontier, next_frontier);
+    if (next_frontier) {
+      ASSERT_EQ(next_frontier->num_partitions(), g.get_num_partitions());
+    }
+
+    triple_apply_impl compute(g, mutated_vertex_fields, mutated_edge_fields);
+    compute.set_frontier(&frontier, frontier_direction);
+
+    std::vector<graphlab::mutex> lock_array(SGRAPH_TRIPLE_APPLY_LOCK_ARRAY_SIZE);
+    size_t srcid_column = g.get_edge_field_id(sgraph::SRC_COLUMN_NAME);
+    size_t dstid_column = g.get_edge_field_id(sgraph::DST_COLUMN_NAME);
+
+    single_edge_triple_apply_visitor visitor(apply_fn, lock_array,
+                                             srcid_column, dstid_column,
+                                             next_frontier);
+    compute.run(visitor);
+  }
+
 /**************************************************************************/
 /*                                                                        */
 /*                     Implementation of batch triple apply               */
@@ -618,6 +809,24 @@ namespace sgraph_compute {
       unlock_and_release();
     }
 
+    /**
+     * The inactive edges are written to the mutated edge data right away,
+     * since its order does not matter, and the active ones are visited.
+     */
+    void visit_active_edges(std::vector<edge_data>& edgedata,
+                            const std::vector<bool>& is_active) {
+      DASSERT_EQ(edgedata.size(), is_active.size());
+      std::vector<edge_data> active_edgedata;
+      for (size_t i = 0; i < edgedata.size(); ++i) {
+        if (is_active[i]) {
+          active_edgedata.push_back(std::move(edgedata[i]));
+        } else {
+          write_edge(edgedata[i]);
+        }
+      }
+      visit_edges(active_edgedata);
+    }
+
     virtual void finalize() {
       DASSERT_LE(m_all_edge_data.size(), 1);
       // finish processing the rest of the edges in the buffer.
@@ -652,19 +861,26 @@ namespace sgraph_compute {
       if (!m_mutating_edges)
         return;
       DASSERT_TRUE(m_mutated_edges.is_opened_for_write());
-      std::vector<flexible_type> edge_data_buffer;
-      size_t num_mutated_fields = m_mutated_edge_field_ids.size();
       for (auto& scope: locked_scopes) {
-        auto& edata = scope.edge();
-        edge_data_buffer.resize(num_mutated_fields);
-        for (size_t i = 0; i < num_mutated_fields; ++i) {
-          edge_data_buffer[i] = edata[m_mutated_edge_field_ids[i]];
-        }
-        *m_mutated_edge_data_writer = std::move(edge_data_buffer);
-        ++m_mutated_edge_data_writer;
+        write_edge(scope.edge());
       }
     }
 
+    /**
+     * Write the data of one edge to the mutated edge data sframe.
+     */
+    void write_edge(const edge_data& edata) {
+      if (!m_mutating_edges)
+        return;
+      size_t num_mutated_fields = m_mutated_edge_field_ids.size();
+      std::vector<flexible_type> edge_data_buffer(num_mutated_fields);
+      for (size_t i = 0; i < num_mutated_fields; ++i) {
+        edge_data_buffer[i] = edata[m_mutated_edge_field_ids[i]];
+      }
+      *m_mutated_edge_data_writer = std::move(edge_data_buffer);
+      ++m_mutated_edge_data_writer;
+    }
+
   private:
     /**************************************************************************/
     /*                                                                        */
@@ -1002,5 +1218,98 @@ namespace sgraph_compute {
     compute.run(visitor);
   }
 
+  /**************************************************************************/
+  /*                                                                        */
+  /*                  Implementation of typed triple apply                  */
+  /*                                                                        */
+  /**************************************************************************/
+
+  /**
+   * The typed triple apply API.
+   */
+  void typed_triple_apply(sgraph& g, typed_triple_apply_fn_type apply_fn,
+                          const std::vector<std::string>& vertex_fields,
+                          const std::vector<std::string>& mutated_vertex_fields) {
+    const auto& all_vertex_field_types = g.get_vertex_field_types();
+    std::vector<size_t> field_ids;
+    for (auto& field: vertex_fields) {
+      size_t fid = g.get_vertex_field_id(field);
+      if (all_vertex_field_types[fid] != flex_type_enum::INTEGER &&
+          all_vertex_field_types[fid] != flex_type_enum::FLOAT) {
+        log_and_throw("Vertex field " + field + " is not numeric");
+      }
+      field_ids.push_back(fid);
+    }
+    // positions of the mutated fields in vertex_fields
+    std::vector<size_t> mutated_fields;
+    for (auto& field: mutated_vertex_fields) {
+      auto iter = std::find(vertex_fields.begin(), vertex_fields.end(), field);
+      if (iter == vertex_fields.end()) {
+        log_and_throw("Mutated vertex field " + field + " is not one of the vertex fields");
+      }
+      mutated_fields.push_back(iter - vertex_fields.begin());
+    }
+
+    size_t num_partitions = g.get_num_partitions();
+    std::vector<typed_vertex_block> vertex_data(num_partitions);
+
+    // writes back the mutated fields of the vertex partitions and unloads them.
+    auto evict_fn = [&](const std::vector<size_t>& partitions) {
+      parallel_for(0, partitions.size(), [&](size_t i) {
+        size_t partition = partitions[i];
+        sframe& vertex_partition = g.vertex_partition(partition);
+        for (size_t k: mutated_fields) {
+          auto column = std::make_shared<sarray<flexible_type>>();
+          column->open_for_write(1);
+          vertex_data[partition].flush(k, *column);
+          vertex_partition = vertex_partition.replace_column(column, vertex_fields[k]);
+        }
+        vertex_data[partition].unload();
+        logstream(LOG_INFO) << "Flush partition " << partition << std::endl;
+      });
+    };
+    auto load_fn = [&](const std::vector<size_t>& partitions) {
+      parallel_for(0, partitions.size(), [&](size_t i) {
+        size_t partition = partitions[i];
+        vertex_data[partition].load(g.vertex_partition(partition), field_ids);
+      });
+    };
+
+    // only the id columns of the edges are read
+    auto work_fn = [&](std::pair<size_t, size_t> coordinate) {
+      size_t src_partition = coordinate.first;
+      size_t dst_partition = coordinate.second;
+      sframe& edgeframe = g.edge_partition(src_partition, dst_partition);
+      auto src_reader = edgeframe.select_column(sgraph::SRC_COLUMN_NAME)->get_reader();
+      auto dst_reader = edgeframe.select_column(sgraph::DST_COLUMN_NAME)->get_reader();
+      typed_edge_scope scope(&vertex_data[src_partition], &vertex_data[dst_partition]);
+      std::vector<flexible_type> srcids;
+      std::vector<flexible_type> dstids;
+      size_t num_rows = edgeframe.num_rows();
+      for (size_t row_start = 0; row_start < num_rows;
+           row_start += SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE) {
+        size_t row_end = std::min(row_start + SGRAPH_TRIPLE_APPLY_EDGE_BATCH_SIZE, num_rows);
+        src_reader->read_rows(row_start, row_end, srcids);
+        dst_reader->read_rows(row_start, row_end, dstids);
+        for (size_t i = 0; i < srcids.size(); ++i) {
+          scope.set_edge(srcids[i].get<flex_int>(), dstids[i].get<flex_int>());
+          apply_fn(scope);
+        }
+      }
+    };
+
+    std::vector<size_t> block_bytes(num_partitions);
+    for (size_t i = 0; i < num_partitions; ++i) {
+      block_bytes[i] = g.vertex_partition(i).num_rows() * field_ids.size() * sizeof(flex_float);
+    }
+    vertex_block_cache cache(num_partitions,
+                             [](std::pair<size_t, size_t> coordinate) {
+                               return std::vector<size_t>{coordinate.first,
+                                                          coordinate.second};
+                             },
+                             block_bytes, SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY);
+    cache.run(hilbert_ordered_coordinates(num_partitions), evict_fn, load_fn, work_fn);
+  }
+
 } // end of sgraph_compute
 } // end of grahlab
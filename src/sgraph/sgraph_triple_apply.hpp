@@ -18,6 +18,7 @@
 #define GRAPHLAB_SGRAPH_SGRAPH_TRIPLE_APPLY
 
 #include<flexible_type/flexible_type.hpp>
+#include<util/dense_bitset.hpp>
 #include<sgraph/sgraph.hpp>
 #include<sgraph/sgraph_compute_vertex_block.hpp>
 
@@ -29,6 +30,63 @@ typedef std::vector<flexible_type> edge_data;
 typedef sgraph::vertex_partition_address vertex_partition_address;
 typedef sgraph::edge_partition_address edge_partition_address;
 
+/**
+ * A set of active vertices of an \ref sgraph, used to restrict
+ * \ref triple_apply to the edges around the vertices which changed.
+ *
+ * The set is stored as one bitset per vertex partition, indexed by the
+ * local vertex ids (the row numbers in the partition, which are also
+ * the ids stored in the edge partitions).
+ *
+ * \ref activate() is safe for concurrent use.
+ */
+class vertex_frontier {
+ public:
+  vertex_frontier() { }
+
+  /// Constructs an empty frontier over the vertices of g.
+  explicit vertex_frontier(const sgraph& g) { init(g); }
+
+  /// Resizes the frontier to the vertices of g and empties it.
+  void init(const sgraph& g);
+
+  /// Returns the number of vertex partitions
+  inline size_t num_partitions() const { return m_active.size(); }
+
+  /// Activates a vertex. Returns true if it was already active.
+  inline bool activate(size_t partition, size_t local_id) {
+    DASSERT_LT(partition, m_active.size());
+    return m_active[partition].set_bit(local_id);
+  }
+
+  /// Returns true if the vertex is active
+  inline bool is_active(size_t partition, size_t local_id) const {
+    DASSERT_LT(partition, m_active.size());
+    return m_active[partition].get(local_id);
+  }
+
+  /// Activates all the vertices
+  void activate_all();
+
+  /// Deactivates all the vertices
+  void clear();
+
+  /// Returns the number of active vertices in a partition
+  size_t num_active(size_t partition) const;
+
+  /// Returns the number of active vertices
+  size_t num_active() const;
+
+  /// Returns true if no vertex is active
+  bool empty() const;
+
+  /// Exchanges the contents of two frontiers
+  inline void swap(vertex_frontier& other) { m_active.swap(other.m_active); }
+
+ private:
+  std::vector<dense_bitset> m_active;
+};
+
 /**
  * Provide access to an edge scope (Vertex, Edge, Vertex);
  * The scope object permits read, modify both vertex data
@@ -75,6 +133,22 @@ class edge_scope {
     }
   };
 
+  /**
+   * Adds the source vertex to the next frontier given to
+   * \ref triple_apply. Has no effect if there is no next frontier.
+   */
+  void activate_source() {
+    if (m_next_frontier) m_next_frontier->activate(m_src_partition, m_srcid);
+  }
+
+  /**
+   * Adds the target vertex to the next frontier given to
+   * \ref triple_apply. Has no effect if there is no next frontier.
+   */
+  void activate_target() {
+    if (m_next_frontier) m_next_frontier->activate(m_dst_partition, m_dstid);
+  }
+
   /// Do not construct edge_scope directly. Used by triple_apply_impl.
   edge_scope(vertex_data* source, vertex_data* target, edge_data* edge,
              graphlab::mutex* lock_0=NULL,
@@ -82,6 +156,17 @@ class edge_scope {
       m_source(source), m_target(target), m_edge(edge),
       m_lock_0(lock_0), m_lock_1(lock_1) { }
 
+  /// Do not call directly. Used by triple_apply_impl.
+  void set_next_frontier(vertex_frontier* next_frontier,
+                         size_t src_partition, size_t srcid,
+                         size_t dst_partition, size_t dstid) {
+    m_next_frontier = next_frontier;
+    m_src_partition = src_partition;
+    m_srcid = srcid;
+    m_dst_partition = dst_partition;
+    m_dstid = dstid;
+  }
+
  private:
   vertex_data* m_source;
   vertex_data* m_target;
@@ -89,6 +174,12 @@ class edge_scope {
   // On construction, the lock ordering is gauanteed: lock_0 < lock_1.
   graphlab::mutex* m_lock_0;
   graphlab::mutex* m_lock_1;
+  // The frontier activate_source() and activate_target() write to.
+  vertex_frontier* m_next_frontier = NULL;
+  size_t m_src_partition = 0;
+  size_t m_srcid = 0;
+  size_t m_dst_partition = 0;
+  size_t m_dstid = 0;
 };
 
 typedef std::function<void(edge_scope&)> triple_apply_fn_type;
@@ -122,6 +213,42 @@ void triple_apply(sgraph& g,
                   const std::vector<std::string>& mutated_edge_fields = {});
 
 
+/**
+ * Overload. Only visits the edges around the active vertices of a frontier.
+ *
+ * An edge is visited if its source is active (frontier_direction ==
+ * OUT_EDGE), its target is active (IN_EDGE) or either is active
+ * (ANY_EDGE). Edge partitions without any such edge are skipped without
+ * loading their vertex partitions, and within a partition, batches of
+ * edges without active edges are skipped without reading their data. The
+ * cost of a call is thus close to the size of the frontier when it is
+ * small, which makes it suitable for the late iterations of algorithms
+ * where few vertices change (shortest paths, label propagation...).
+ *
+ * If next_frontier is not NULL, apply_fn may add vertices to it with
+ * \ref edge_scope::activate_source() and \ref edge_scope::activate_target().
+ * next_frontier must be initialized on g, and must not be the same object
+ * as frontier. It is not cleared.
+ *
+ * \code
+ * vertex_frontier frontier(g), next_frontier(g);
+ * frontier.activate_all();
+ * while (!frontier.empty()) {
+ *   next_frontier.clear();
+ *   triple_apply(g, fn, {"distance"}, {}, frontier,
+ *                sgraph::edge_direction::OUT_EDGE, &next_frontier);
+ *   frontier.swap(next_frontier);
+ * }
+ * \endcode
+ */
+void triple_apply(sgraph& g,
+                  triple_apply_fn_type apply_fn,
+                  const std::vector<std::string>& mutated_vertex_fields,
+                  const std::vector<std::string>& mutated_edge_fields,
+                  const vertex_frontier& frontier,
+                  sgraph::edge_direction frontier_direction,
+                  vertex_frontier* next_frontier = NULL);
+
 /**
  * Overload. Uses python lambda function.
  */
@@ -129,6 +256,105 @@ void triple_apply(sgraph& g, const std::string& lambda_str,
                   const std::vector<std::string>& mutated_vertex_fields,
                   const std::vector<std::string>& mutated_edge_fields = {});
 
+/**
+ * The scope of an edge in \ref typed_triple_apply: gives access to numeric
+ * fields of the source and target vertices. Fields are addressed by their
+ * position in the vertex_fields given to typed_triple_apply.
+ */
+class typed_edge_scope {
+ public:
+  typed_edge_scope(typed_vertex_block* source, typed_vertex_block* target):
+      m_source(source), m_target(target) { }
+
+  /// Sets the local ids of the source and target vertices of the edge
+  inline void set_edge(size_t srcid, size_t dstid) {
+    m_srcid = srcid;
+    m_dstid = dstid;
+  }
+
+  /// Returns a field of the source vertex as a float
+  inline flex_float source_float(size_t field) const {
+    return m_source->get_float(field, m_srcid);
+  }
+
+  /// Returns a field of the target vertex as a float
+  inline flex_float target_float(size_t field) const {
+    return m_target->get_float(field, m_dstid);
+  }
+
+  /// Returns a field of the source vertex as an integer
+  inline flex_int source_int(size_t field) const {
+    return m_source->get_int(field, m_srcid);
+  }
+
+  /// Returns a field of the target vertex as an integer
+  inline flex_int target_int(size_t field) const {
+    return m_target->get_int(field, m_dstid);
+  }
+
+  /// Atomically adds value to a field of the source vertex
+  template <typename T>
+  inline void add_to_source(size_t field, T value) {
+    m_source->add(field, m_srcid, value);
+  }
+
+  /// Atomically adds value to a field of the target vertex
+  template <typename T>
+  inline void add_to_target(size_t field, T value) {
+    m_target->add(field, m_dstid, value);
+  }
+
+  /// Sets a field of the source vertex. See \ref typed_vertex_block::set
+  template <typename T>
+  inline void set_source(size_t field, T value) {
+    m_source->set(field, m_srcid, value);
+  }
+
+  /// Sets a field of the target vertex. See \ref typed_vertex_block::set
+  template <typename T>
+  inline void set_target(size_t field, T value) {
+    m_target->set(field, m_dstid, value);
+  }
+
+ private:
+  typed_vertex_block* m_source;
+  typed_vertex_block* m_target;
+  size_t m_srcid = 0;
+  size_t m_dstid = 0;
+};
+
+typedef std::function<void(typed_edge_scope&)> typed_triple_apply_fn_type;
+
+/**
+ * Overload of triple_apply over typed numeric vertex fields.
+ *
+ * Only the vertex_fields are loaded, as contiguous typed arrays (see
+ * \ref typed_vertex_block), and only the source and target id columns of
+ * the edges are read. Vertices are not locked: apply_fn updates them with
+ * the atomic \ref typed_edge_scope::add_to_source and
+ * \ref typed_edge_scope::add_to_target. This suits sums over the
+ * neighborhood (degrees, PageRank) whose cost is otherwise dominated by
+ * locking and by boxing the vertex data into flexible_type rows.
+ *
+ * \code
+ * // out degree
+ * g.init_vertex_field("out_degree", flex_int(0));
+ * typed_triple_apply(g, [](typed_edge_scope& scope) {
+ *                         scope.add_to_source(0, 1);
+ *                       },
+ *                    {"out_degree"}, {"out_degree"});
+ * \endcode
+ *
+ * \param g The target graph.
+ * \param apply_fn The function applied on each edge scope.
+ * \param vertex_fields The numeric vertex fields apply_fn reads or modifies.
+ * \param mutated_vertex_fields The subset of vertex_fields apply_fn modifies.
+ */
+void typed_triple_apply(sgraph& g,
+                        typed_triple_apply_fn_type apply_fn,
+                        const std::vector<std::string>& vertex_fields,
+                        const std::vector<std::string>& mutated_vertex_fields);
+
 
 
 
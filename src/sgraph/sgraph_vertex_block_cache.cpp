@@ -0,0 +1,146 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <set>
+#include <algorithm>
+#include <parallel/lambda_omp.hpp>
+#include <logger/logger.hpp>
+#include <logger/assertions.hpp>
+#include <sgraph/sgraph_vertex_block_cache.hpp>
+
+namespace graphlab {
+namespace sgraph_compute {
+
+vertex_block_cache::vertex_block_cache(
+    size_t num_blocks,
+    std::function<std::vector<size_t>(coordinate_type)> blocks_of,
+    const std::vector<size_t>& block_bytes,
+    size_t capacity)
+    : m_num_blocks(num_blocks), m_blocks_of(blocks_of),
+      m_block_bytes(block_bytes), m_capacity(capacity) {
+  ASSERT_EQ(m_block_bytes.size(), m_num_blocks);
+}
+
+void vertex_block_cache::run(const std::vector<coordinate_type>& coordinates,
+                             std::function<void(const std::vector<size_t>&)> evict,
+                             std::function<void(const std::vector<size_t>&)> load,
+                             std::function<void(coordinate_type)> fn,
+                             size_t parallel_limit) {
+  parallel_limit = std::max<size_t>(parallel_limit, 1);
+
+  // Split the coordinates into passes of at most parallel_limit
+  // coordinates whose blocks fit in the capacity.
+  std::vector<std::vector<coordinate_type>> passes;
+  std::vector<std::set<size_t>> pass_blocks;
+  size_t pass_bytes = 0;
+  for (const auto& coordinate: coordinates) {
+    std::vector<size_t> blocks = m_blocks_of(coordinate);
+    std::sort(blocks.begin(), blocks.end());
+    blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+    size_t new_bytes = 0;
+    if (!passes.empty()) {
+      for (size_t block: blocks) {
+        DASSERT_LT(block, m_num_blocks);
+        if (!pass_blocks.back().count(block)) new_bytes += m_block_bytes[block];
+      }
+    }
+    if (passes.empty() || passes.back().size() >= parallel_limit ||
+        pass_bytes + new_bytes > m_capacity) {
+      passes.emplace_back();
+      pass_blocks.emplace_back();
+      pass_bytes = 0;
+      new_bytes = 0;
+      for (size_t block: blocks) new_bytes += m_block_bytes[block];
+    }
+    passes.back().push_back(coordinate);
+    pass_blocks.back().insert(blocks.begin(), blocks.end());
+    pass_bytes += new_bytes;
+  }
+
+  // The passes using each block, in reverse order so that the next use
+  // is at the back.
+  std::vector<std::vector<size_t>> next_uses(m_num_blocks);
+  for (size_t pass = passes.size(); pass > 0; --pass) {
+    for (size_t block: pass_blocks[pass - 1]) next_uses[block].push_back(pass - 1);
+  }
+  const size_t NEVER = (size_t)(-1);
+  auto next_use = [&](size_t block) {
+    return next_uses[block].empty() ? NEVER : next_uses[block].back();
+  };
+
+  m_num_loads = 0;
+  m_num_passes = passes.size();
+  std::set<size_t> loaded;
+  size_t loaded_bytes = 0;
+  for (size_t pass = 0; pass < passes.size(); ++pass) {
+    const std::set<size_t>& needed = pass_blocks[pass];
+    for (size_t block: needed) {
+      DASSERT_EQ(next_use(block), pass);
+      next_uses[block].pop_back();
+    }
+
+    // Memory used by the loaded blocks and the blocks of this pass
+    size_t required_bytes = loaded_bytes;
+    for (size_t block: needed) {
+      if (!loaded.count(block)) required_bytes += m_block_bytes[block];
+    }
+    // Evict the blocks which are not used again, and then the blocks used
+    // the farthest ahead until the required memory fits.
+    std::vector<std::pair<size_t, size_t>> candidates;  // {next use, block}
+    for (size_t block: loaded) {
+      if (!needed.count(block)) candidates.push_back({next_use(block), block});
+    }
+    std::sort(candidates.rbegin(), candidates.rend());
+    std::vector<size_t> to_evict;
+    for (const auto& candidate: candidates) {
+      if (candidate.first != NEVER && required_bytes <= m_capacity) break;
+      to_evict.push_back(candidate.second);
+      required_bytes -= m_block_bytes[candidate.second];
+    }
+    if (!to_evict.empty()) {
+      evict(to_evict);
+      for (size_t block: to_evict) {
+        loaded.erase(block);
+        loaded_bytes -= m_block_bytes[block];
+      }
+    }
+
+    std::vector<size_t> to_load;
+    for (size_t block: needed) {
+      if (!loaded.count(block)) to_load.push_back(block);
+    }
+    if (!to_load.empty()) {
+      load(to_load);
+      for (size_t block: to_load) {
+        loaded.insert(block);
+        loaded_bytes += m_block_bytes[block];
+      }
+      m_num_loads += to_load.size();
+    }
+
+    parallel_for(passes[pass].begin(), passes[pass].end(), fn);
+  }
+
+  if (!loaded.empty()) {
+    evict(std::vector<size_t>(loaded.begin(), loaded.end()));
+  }
+  logstream(LOG_INFO) << "Swept " << coordinates.size() << " edge partitions in "
+                      << passes.size() << " passes with " << m_num_loads
+                      << " block loads" << std::endl;
+}
+
+} // sgraph_compute
+} // graphlab
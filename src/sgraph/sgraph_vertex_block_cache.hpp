@@ -0,0 +1,114 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GRAPHLAB_SGRAPH_SGRAPH_VERTEX_BLOCK_CACHE_HPP
+#define GRAPHLAB_SGRAPH_SGRAPH_VERTEX_BLOCK_CACHE_HPP
+#include <vector>
+#include <utility>
+#include <functional>
+#include <parallel/thread_pool.hpp>
+#include <sframe/sframe.hpp>
+#include <flexible_type/flexible_type.hpp>
+
+namespace graphlab {
+namespace sgraph_compute {
+
+/**
+ * Returns an estimate of the memory used by a partition of vertices
+ * loaded in a vertex_block<sframe>.
+ */
+inline size_t estimate_vertex_block_bytes(const sframe& sf) {
+  return sf.num_rows() * (sizeof(std::vector<flexible_type>) +
+                          sf.num_columns() * sizeof(flexible_type));
+}
+
+/**
+ * Manages the vertex blocks held in memory during a sweep over edge
+ * partitions, within a memory budget.
+ *
+ * The sweep visits a list of edge partition coordinates in order (usually
+ * the Hilbert curve order, see \ref hilbert_ordered_coordinates), in
+ * passes of coordinates run in parallel, as \ref
+ * hilbert_blocked_parallel_for does. Each coordinate needs a few blocks
+ * (vertex partitions, or any other per partition data), identified by
+ * integers in [0, num_blocks). Since the whole sweep is known in advance:
+ *
+ *  - A pass is cut short when the blocks it needs would exceed the
+ *    capacity, so memory stays within the budget unless a single
+ *    coordinate needs more than the budget.
+ *  - Blocks are kept in memory after their pass while they fit, and when
+ *    room is needed, the block whose next use is the farthest ahead is
+ *    evicted first (blocks which are never used again are evicted right
+ *    away). Graphs whose vertex data nearly fits are thus loaded about
+ *    once.
+ *  - Blocks are only written back when they are evicted, by the evict
+ *    callback, rather than after every pass.
+ *
+ * \code
+ * vertex_block_cache cache(num_partitions,
+ *                          [](std::pair<size_t, size_t> c) {
+ *                            return std::vector<size_t>{c.first, c.second};
+ *                          },
+ *                          block_bytes, SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY);
+ * cache.run(hilbert_ordered_coordinates(num_partitions),
+ *           evict_fn, load_fn, work_fn);
+ * \endcode
+ */
+class vertex_block_cache {
+ public:
+  typedef std::pair<size_t, size_t> coordinate_type;
+
+  /**
+   * \param num_blocks The number of blocks.
+   * \param blocks_of Returns the blocks needed by a coordinate.
+   * \param block_bytes The estimated memory used by each block when loaded.
+   * \param capacity The memory budget in bytes.
+   */
+  vertex_block_cache(size_t num_blocks,
+                     std::function<std::vector<size_t>(coordinate_type)> blocks_of,
+                     const std::vector<size_t>& block_bytes,
+                     size_t capacity);
+
+  /**
+   * Runs the sweep over coordinates. Before each pass, calls evict with the
+   * blocks to write back and unload, then load with the blocks to load.
+   * Then calls fn on each coordinate of the pass in parallel. All the
+   * blocks are evicted at the end.
+   */
+  void run(const std::vector<coordinate_type>& coordinates,
+           std::function<void(const std::vector<size_t>&)> evict,
+           std::function<void(const std::vector<size_t>&)> load,
+           std::function<void(coordinate_type)> fn,
+           size_t parallel_limit = thread_pool::get_instance().size());
+
+  /// Returns the number of block loads during the last run
+  inline size_t num_loads() const { return m_num_loads; }
+
+  /// Returns the number of passes of the last run
+  inline size_t num_passes() const { return m_num_passes; }
+
+ private:
+  size_t m_num_blocks;
+  std::function<std::vector<size_t>(coordinate_type)> m_blocks_of;
+  std::vector<size_t> m_block_bytes;
+  size_t m_capacity;
+  size_t m_num_loads = 0;
+  size_t m_num_passes = 0;
+};
+
+} // sgraph_compute
+} // graphlab
+#endif
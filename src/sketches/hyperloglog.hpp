@@ -21,6 +21,7 @@
 #include <functional>
 #include <util/cityhash_gl.hpp>
 #include <logger/assertions.hpp>
+#include <serialization/serialization_includes.hpp>
 namespace graphlab {
 namespace sketches {
 /**
@@ -140,6 +141,16 @@ class hyperloglog {
     // collisions are unlikely
     return E;
   }
+
+  /// Serializer
+  void save(oarchive& oarc) const {
+    oarc << m_b << m_m << m_alpha << m_buckets;
+  }
+
+  /// Deserializer
+  void load(iarchive& iarc) {
+    iarc >> m_b >> m_m >> m_alpha >> m_buckets;
+  }
 }; // hyperloglog
 } // namespace sketch 
 } // namespace graphlab
@@ -74,6 +74,8 @@ GENERATE_INTERFACE_AND_PROXY(unity_sgraph_base, unity_graph_proxy,
       (const std::vector<flexible_type>&)
       (const std::vector<flexible_type>&)
       (const options_map_t&)(size_t)(size_t))
+    (void, build_edge_index, (size_t)(size_t))
+    (void, drop_edge_index, (size_t)(size_t))
     // (bool, save_graph_as_json, (std::string))
     (bool, save_graph, (std::string)(std::string))
     (bool, load_graph, (std::string))
@@ -81,6 +81,12 @@ groupby_descriptor_type MIN(const std::string& col) {
 groupby_descriptor_type COUNT() {
   return {"__builtin__count__", std::vector<std::string>()};
 }
+groupby_descriptor_type COUNT_DISTINCT(const std::string& col) {
+  return {"__builtin__count__distinct__", {col}};
+}
+groupby_descriptor_type APPROX_COUNT_DISTINCT(const std::string& col) {
+  return {"__builtin__approx__count__distinct__", {col}};
+}
 groupby_descriptor_type MEAN(const std::string& col) {
   return {"__builtin__avg__", {col}};
 }
@@ -599,20 +605,10 @@ gl_sframe gl_sframe::filter_by(const gl_sarray& values,
     throw std::string("Type of given values does not match type of column ") + 
         column_name + " in SFrame";
   }
+  // semi and anti joins emit each row at most once, so the values do not
+  // need to be made unique
   gl_sframe value_sf({{column_name, values}});
-  value_sf = value_sf.unique();
-  if (exclude == false) {
-    return join(value_sf, {column_name}, "inner");
-  } else {
-    std::string id_name = "id";
-    while(colnameset.count(id_name)) id_name += "1";
-    value_sf[id_name] = 1;
-    auto retsf = join(value_sf, {column_name}, "left");
-    retsf = retsf[retsf[id_name] == FLEX_UNDEFINED];
-    retsf.remove_column(id_name);
-    return retsf;
-  }
-
+  return join(value_sf, {column_name}, exclude ? "anti" : "semi");
 }
 
 
@@ -152,6 +152,38 @@ groupby_descriptor_type MIN(const std::string& col);
  */
 groupby_descriptor_type COUNT();
 
+/**
+ * Builtin exact distinct count aggregator for groupby. Missing values are not
+ * counted.
+ *
+ * Example: Get the number of distinct items rated by each user
+ * \code
+ * sf.groupby({"user"},
+ *            {{"num_items",aggregate::COUNT_DISTINCT("item")}});
+ * \endcode
+ *
+ * \see gl_sframe::groupby
+ */
+groupby_descriptor_type COUNT_DISTINCT(const std::string& col);
+
+/**
+ * Builtin approximate distinct count aggregator for groupby. Missing values
+ * are not counted.
+ *
+ * Small groups are counted exactly. Larger groups are estimated with a
+ * hyperloglog sketch of fixed size (4KB per group), with a standard error of
+ * about 1.6%.
+ *
+ * Example: Get the approximate number of distinct users per day
+ * \code
+ * sf.groupby({"day"},
+ *            {{"num_users",aggregate::APPROX_COUNT_DISTINCT("user")}});
+ * \endcode
+ *
+ * \see gl_sframe::groupby
+ */
+groupby_descriptor_type APPROX_COUNT_DISTINCT(const std::string& col);
+
 
 /**
  * Builtin average aggregator for groupby. 
@@ -1634,6 +1666,12 @@ class gl_sframe {
     *     - \b "outer" : Equivalent to a SQL full outer join. Result is
     *       the union between the result of a left outer join and a right
     *       outer join.
+    *     - \b "semi" : Result consists of the rows of the left
+    *       \ref gl_sframe whose join key values appear in the right
+    *       \ref gl_sframe, unchanged and each at most once.
+    *     - \b "anti" : Result consists of the rows of the left
+    *       \ref gl_sframe whose join key values do not appear in the right
+    *       \ref gl_sframe, unchanged.
     * 
     * Example: 
     * \code
@@ -1719,6 +1757,12 @@ class gl_sframe {
     *     - \b "outer" : Equivalent to a SQL full outer join. Result is
     *       the union between the result of a left outer join and a right
     *       outer join.
+    *     - \b "semi" : Result consists of the rows of the left
+    *       \ref gl_sframe whose join key values appear in the right
+    *       \ref gl_sframe, unchanged and each at most once.
+    *     - \b "anti" : Result consists of the rows of the left
+    *       \ref gl_sframe whose join key values do not appear in the right
+    *       \ref gl_sframe, unchanged.
     * 
     * Example: 
     * \code
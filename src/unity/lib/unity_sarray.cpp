@@ -1601,16 +1601,43 @@ std::shared_ptr<unity_sarray_base> unity_sarray::scalar_operator(flexible_type o
 
   // create the lazy evalation transform operator from the source
   std::shared_ptr<unity_sarray> ret_unity_sarray(new unity_sarray());
-  if (other.get_type() != flex_type_enum::UNDEFINED) {
+  auto source_sarray = std::dynamic_pointer_cast<le_sarray<flexible_type>>(
+      m_lazy_sarray->get_query_tree());
+  if (other.get_type() != flex_type_enum::UNDEFINED && source_sarray &&
+      le_sarray_compare::is_supported_operator(op)) {
+    // comparisons directly against a physical sarray can use the block
+    // statistics to skip blocks where the result is constant
+    auto compare_operator = std::make_shared<le_sarray_compare>(
+        source_sarray->get_sarray_ptr(), other, op, right_operator, transformfn);
+
+    ret_unity_sarray->construct_from_lazy_operator(compare_operator, false, output_type);
+  } else if (other.get_type() != flex_type_enum::UNDEFINED) {
+    auto elementfn = [=](const flexible_type& f)->flexible_type {
+      if (f.get_type() == flex_type_enum::UNDEFINED) {
+        return f;
+      } else {
+        return right_operator ? transformfn(other, f) :transformfn(f, other);
+      }
+    };
     auto transform_operator = std::make_shared<le_transform<flexible_type>>(
-        m_lazy_sarray->get_query_tree(),
-        [=](const flexible_type& f)->flexible_type {
-          if (f.get_type() == flex_type_enum::UNDEFINED) {
-            return f;
-          } else {
-            return right_operator ? transformfn(other, f) :transformfn(f, other);
-          }
-        }, output_type);
+        m_lazy_sarray->get_query_tree(), elementfn, output_type);
+
+    // use the typed kernel when there is one for the input types
+    auto kernel = unity_sarray_binary_operations::
+        get_binary_kernel(left_type, right_type, op);
+    if (kernel) {
+      transform_operator->set_batch_transform_fn(
+          [=](std::vector<flexible_type>& input, std::vector<flexible_type>& output) {
+            bool done = right_operator ?
+                kernel(&other, 0, input.data(), 1, input.size(), output.data()) :
+                kernel(input.data(), 1, &other, 0, input.size(), output.data());
+            if (!done) {
+              for (size_t i = 0; i < input.size(); ++i) {
+                output[i] = convert_value_to_output_type(elementfn(input[i]), output_type);
+              }
+            }
+          });
+    }
 
     ret_unity_sarray->construct_from_lazy_operator(transform_operator, false, output_type);
   } else {
@@ -1696,6 +1723,32 @@ std::shared_ptr<unity_sarray_base> unity_sarray::vector_operator(
     output_type
     );
 
+  // use the typed kernel when there is one for the input types
+  auto kernel =
+      unity_sarray_binary_operations::get_binary_kernel(dtype(), other->dtype(), op);
+  if (kernel) {
+    vector_op->set_batch_vector_op_fn(
+        [=](const std::vector<flexible_type>& left,
+            const std::vector<flexible_type>& right,
+            std::vector<flexible_type>& output) {
+          size_t n = left.size();
+          if (!kernel(left.data(), 1, right.data(), 1, n, output.data())) {
+            for (size_t i = 0; i < n; ++i) {
+              output[i] = transform_fn_with_undefined_checking(left[i], right[i]);
+            }
+          } else if (!op_is_not_equality_compare) {
+            // == and != compare undefined values by type instead of
+            // returning undefined
+            for (size_t i = 0; i < n; ++i) {
+              if (left[i].get_type() == flex_type_enum::UNDEFINED ||
+                  right[i].get_type() == flex_type_enum::UNDEFINED) {
+                output[i] = transform_fn_with_undefined_checking(left[i], right[i]);
+              }
+            }
+          }
+        });
+  }
+
   auto le_generator_ptr = std::make_shared<lazy_sarray<flexible_type>>(
     vector_op,
     false,
@@ -15,6 +15,7 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <string>
+#include <vector>
 #include <functional>
 #include <flexible_type/flexible_type.hpp>
 #include <unity/lib/unity_sarray_binary_operations.hpp>
@@ -223,6 +224,192 @@ get_binary_operator(flex_type_enum left, flex_type_enum right, std::string op) {
 }
 
 
+/**************************************************************************/
+/*                                                                        */
+/*                           Vectorized Kernels                           */
+/*                                                                        */
+/**************************************************************************/
+
+namespace {
+
+/**
+ * The unboxed values of one side of a binary operation.
+ * values holds n values for a column, or a single value for a scalar.
+ */
+template <typename T>
+struct typed_values {
+  std::vector<T> values;
+  std::vector<unsigned char> is_undefined;
+  bool has_undefined = false;
+};
+
+/**
+ * Unboxes n values of the given type into a typed array. Undefined values
+ * read as 0 and are flagged in is_undefined. Returns false if any other
+ * value is not of type "type".
+ */
+template <typename T>
+bool unbox(const flexible_type* in, size_t n, flex_type_enum type,
+           typed_values<T>& ret) {
+  ret.values.resize(n);
+  ret.is_undefined.assign(n, 0);
+  ret.has_undefined = false;
+  for (size_t i = 0;i < n; ++i) {
+    flex_type_enum t = in[i].get_type();
+    if (t == type) {
+      if (type == flex_type_enum::INTEGER) ret.values[i] = in[i].get<flex_int>();
+      else ret.values[i] = in[i].get<flex_float>();
+    } else if (t == flex_type_enum::UNDEFINED) {
+      ret.values[i] = 0;
+      ret.is_undefined[i] = 1;
+      ret.has_undefined = true;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Runs fn over the typed arrays. Each loop only touches contiguous arrays
+ * so that the compiler can vectorize it.
+ */
+template <typename T, typename O, typename Fn>
+void apply_typed(const T* left, bool left_is_scalar,
+                 const T* right, bool right_is_scalar,
+                 size_t n, O* out, Fn fn) {
+  if (left_is_scalar && right_is_scalar) {
+    O value = fn(left[0], right[0]);
+    for (size_t i = 0;i < n; ++i) out[i] = value;
+  } else if (left_is_scalar) {
+    const T l = left[0];
+    for (size_t i = 0;i < n; ++i) out[i] = fn(l, right[i]);
+  } else if (right_is_scalar) {
+    const T r = right[0];
+    for (size_t i = 0;i < n; ++i) out[i] = fn(left[i], r);
+  } else {
+    for (size_t i = 0;i < n; ++i) out[i] = fn(left[i], right[i]);
+  }
+}
+
+/**
+ * Builds a kernel which unboxes both sides to T, computes an O per row with
+ * fn and boxes the result.
+ */
+template <typename T, typename O, typename Fn>
+binary_kernel_type make_kernel(flex_type_enum left_type,
+                               flex_type_enum right_type,
+                               Fn fn) {
+  return [=](const flexible_type* left, size_t left_step,
+             const flexible_type* right, size_t right_step,
+             size_t n, flexible_type* out)->bool {
+    bool left_is_scalar = (left_step == 0);
+    bool right_is_scalar = (right_step == 0);
+    typed_values<T> l, r;
+    if (!unbox(left, left_is_scalar ? 1 : n, left_type, l) ||
+        !unbox(right, right_is_scalar ? 1 : n, right_type, r)) {
+      return false;
+    }
+    std::vector<O> result(n);
+    apply_typed(l.values.data(), left_is_scalar,
+                r.values.data(), right_is_scalar, n, result.data(), fn);
+    if (!l.has_undefined && !r.has_undefined) {
+      for (size_t i = 0;i < n; ++i) out[i] = result[i];
+    } else {
+      for (size_t i = 0;i < n; ++i) {
+        if (l.is_undefined[i * left_step] || r.is_undefined[i * right_step]) {
+          out[i] = FLEX_UNDEFINED;
+        } else {
+          out[i] = result[i];
+        }
+      }
+    }
+    return true;
+  };
+}
+
+struct plus_fn {
+  template <typename T> T operator()(T a, T b) const { return a + b; }
+};
+struct minus_fn {
+  template <typename T> T operator()(T a, T b) const { return a - b; }
+};
+struct multiply_fn {
+  template <typename T> T operator()(T a, T b) const { return a * b; }
+};
+struct divide_fn {
+  template <typename T> T operator()(T a, T b) const { return a / b; }
+};
+struct lt_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return a < b; }
+};
+struct gt_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return a > b; }
+};
+struct le_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return a <= b; }
+};
+struct ge_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return a >= b; }
+};
+struct eq_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return a == b; }
+};
+struct ne_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return a != b; }
+};
+struct and_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return (a != 0) && (b != 0); }
+};
+struct or_fn {
+  template <typename T> flex_int operator()(T a, T b) const { return (a != 0) || (b != 0); }
+};
+
+/**
+ * Picks the operation for values unboxed as T. Arithmetic returns T, except
+ * for division which always returns floats. Comparison and logical
+ * operations return integers.
+ */
+template <typename T>
+binary_kernel_type make_kernel_for_op(flex_type_enum left,
+                                      flex_type_enum right,
+                                      const std::string& op) {
+  if (op == "+") return make_kernel<T, T>(left, right, plus_fn());
+  else if (op == "-") return make_kernel<T, T>(left, right, minus_fn());
+  else if (op == "*") return make_kernel<T, T>(left, right, multiply_fn());
+  else if (op == "/") return make_kernel<flex_float, flex_float>(left, right, divide_fn());
+  else if (op == "<") return make_kernel<T, flex_int>(left, right, lt_fn());
+  else if (op == ">") return make_kernel<T, flex_int>(left, right, gt_fn());
+  else if (op == "<=") return make_kernel<T, flex_int>(left, right, le_fn());
+  else if (op == ">=") return make_kernel<T, flex_int>(left, right, ge_fn());
+  else if (op == "==") return make_kernel<T, flex_int>(left, right, eq_fn());
+  else if (op == "!=") return make_kernel<T, flex_int>(left, right, ne_fn());
+  else if (op == "&") return make_kernel<T, flex_int>(left, right, and_fn());
+  else if (op == "|") return make_kernel<T, flex_int>(left, right, or_fn());
+  return binary_kernel_type();
+}
+
+} // anonymous namespace
+
+binary_kernel_type get_binary_kernel(flex_type_enum left,
+                                     flex_type_enum right,
+                                     std::string op) {
+  bool left_is_numeric = (left == flex_type_enum::INTEGER ||
+                          left == flex_type_enum::FLOAT);
+  bool right_is_numeric = (right == flex_type_enum::INTEGER ||
+                           right == flex_type_enum::FLOAT);
+  if (!left_is_numeric || !right_is_numeric) return binary_kernel_type();
+
+  // integers against integers stay integers. Everything else is computed
+  // on floats, as flexible_type does.
+  if (left == flex_type_enum::INTEGER && right == flex_type_enum::INTEGER) {
+    return make_kernel_for_op<flex_int>(left, right, op);
+  } else {
+    return make_kernel_for_op<flex_float>(left, right, op);
+  }
+}
+
+
 
 } // namespace unity_sarray_binary_operations
 } // namespace graphlab
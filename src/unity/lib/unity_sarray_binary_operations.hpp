@@ -54,6 +54,34 @@ flex_type_enum get_output_type(flex_type_enum left,
  */
 std::function<flexible_type(const flexible_type&, const flexible_type&)> 
 get_binary_operator(flex_type_enum left, flex_type_enum right, std::string op);
+
+/**
+ * A vectorized binary operation over a batch of values.
+ *
+ * Computes out[i] = left[i * left_step] op right[i * right_step] for i in
+ * [0, n), where a step is either 1 (a column of values) or 0 (a scalar).
+ * The values are first unboxed into contiguous typed arrays, with undefined
+ * values tracked in a separate mask, and the operation then runs over the
+ * typed arrays. Rows where either side is undefined are set to undefined.
+ *
+ * Returns false, with out left in an unspecified state, if a defined input
+ * value is not of the type the kernel was specialized for. The caller must
+ * then fall back to the operator returned by get_binary_operator().
+ */
+typedef std::function<bool(const flexible_type* left, size_t left_step,
+                           const flexible_type* right, size_t right_step,
+                           size_t n, flexible_type* out)> binary_kernel_type;
+
+/**
+ * Returns a vectorized kernel computing the same binary operation as
+ * get_binary_operator(), or an empty function if there is no kernel
+ * specialized for the input types. Kernels exist for every operation
+ * between integers and floats. check_operation_feasibility is assumed to be
+ * true.
+ */
+binary_kernel_type get_binary_kernel(flex_type_enum left,
+                                     flex_type_enum right,
+                                     std::string op);
 } // namespace unity_sarray_binary_operations
 } // namespace graphlab
 #endif
@@ -121,6 +121,7 @@ std::map<std::string, std::shared_ptr<unity_sarray_base>> unity_sframe::construc
   bool continue_on_failure = false;
   bool store_errors = false;
   size_t row_limit = 0;
+  size_t type_inference_rows = 0;
   tokenizer.delimiter = ",";
   tokenizer.comment_char = '\0';
   tokenizer.escape_char = '\\';
@@ -141,6 +142,9 @@ std::map<std::string, std::shared_ptr<unity_sarray_base>> unity_sframe::construc
   if (csv_parsing_config.count("row_limit")) {
     row_limit = (flex_int)(csv_parsing_config["row_limit"]);
   }
+  if (csv_parsing_config.count("type_inference_rows")) {
+    type_inference_rows = (flex_int)(csv_parsing_config["type_inference_rows"]);
+  }
   if (csv_parsing_config["delimiter"].get_type() == flex_type_enum::STRING) {
     std::string tmp = (flex_string)csv_parsing_config["delimiter"];
     if(tmp.length() > 0) tokenizer.delimiter = tmp;
@@ -178,7 +182,8 @@ std::map<std::string, std::shared_ptr<unity_sarray_base>> unity_sframe::construc
   auto sframe_ptr = std::make_shared<sframe>();
 
   auto errors = sframe_ptr->init_from_csvs(url, tokenizer, use_header, continue_on_failure,
-                                           store_errors, column_type_hints, row_limit);
+                                           store_errors, column_type_hints, row_limit,
+                                           type_inference_rows);
 
   m_lazy_sframe = std::make_shared<lazy_sframe>(sframe_ptr);
 
@@ -911,10 +916,17 @@ std::shared_ptr<unity_sframe_base> unity_sframe::join(
   if(m_lazy_sframe) {
     auto sframe_ptr = get_underlying_sframe();
     auto right_sframe_ptr = us_right->get_underlying_sframe();
+    // lets join() sort the inputs for a sort-merge join when it is cheaper
+    auto sorter = [](const sframe& sf, const std::vector<std::string>& keys) {
+      auto lazy_sf = std::make_shared<lazy_sframe>(std::make_shared<sframe>(sf));
+      return *graphlab::sort(lazy_sf, keys, std::vector<bool>(keys.size(), true));
+    };
     sframe joined_sf = graphlab::join(*sframe_ptr,
                                       *right_sframe_ptr,
                                       join_type,
-                                      join_keys);
+                                      join_keys,
+                                      SFRAME_JOIN_BUFFER_NUM_CELLS,
+                                      sorter);
     ret->construct_from_sframe(joined_sf);
   }
 
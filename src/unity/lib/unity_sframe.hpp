@@ -121,6 +121,9 @@ class unity_sframe : public unity_sframe_base {
    *  - double_quote : True if not is zero()
    *  - quote_char : First character if flexible_type is a string
    *  - skip_initial_space : True if not is zero()
+   *  - type_inference_rows : If non-zero, the types of the columns not in 
+   *                          column_type_hints are inferred from this many
+   *                          rows at the start of the input.
    */
   std::map<std::string, std::shared_ptr<unity_sarray_base>> construct_from_csvs(
       std::string url,
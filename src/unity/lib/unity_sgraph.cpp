@@ -96,6 +96,14 @@ std::shared_ptr<unity_sframe_base> unity_sgraph::get_edges(
   }
 }
 
+void unity_sgraph::build_edge_index(size_t groupa, size_t groupb) {
+  (*m_graph)().build_edge_index(groupa, groupb);
+}
+
+void unity_sgraph::drop_edge_index(size_t groupa, size_t groupb) {
+  (*m_graph)().drop_edge_index(groupa, groupb);
+}
+
 struct lazy_id_translation_functor {
   lazy_id_translation_functor() { }
 
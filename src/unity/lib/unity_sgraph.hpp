@@ -143,6 +143,21 @@ class unity_sgraph: public unity_sgraph_base {
                                  const options_map_t& field_constraint=options_map_t(),
                                  size_t groupa = 0, size_t groupb = 0);
 
+    /**
+     * Builds the index of the edges between groupa and groupb. get_edges()
+     * then answers queries on a few vertices by reading only their edges,
+     * instead of scanning the graph. The index is shared by the graphs
+     * derived from this one, and is saved with the graph.
+     * See \ref sgraph::build_edge_index.
+     */
+    void build_edge_index(size_t groupa = 0, size_t groupb = 0);
+
+    /**
+     * Frees the index built by build_edge_index(). Does nothing if there
+     * is no index.
+     */
+    void drop_edge_index(size_t groupa = 0, size_t groupb = 0);
+
     /**
      * Returns a summary of the basic graph information such as the number of
      * vertices / number of edges.
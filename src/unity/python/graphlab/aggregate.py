@@ -85,6 +85,36 @@ def COUNT(*args):
   # arguments if any are ignored
   return ("__builtin__count__", [""])
 
+def COUNT_DISTINCT(src_column):
+  """
+  Builtin exact distinct count aggregator for groupby. Missing values are
+  not counted.
+
+  Example: Get the number of distinct items rated by each user.
+
+  >>> sf.groupby("user",
+                 {'num_items':gl.aggregate.COUNT_DISTINCT('item')})
+
+  """
+  return ("__builtin__count__distinct__", [src_column])
+
+def APPROX_COUNT_DISTINCT(src_column):
+  """
+  Builtin approximate distinct count aggregator for groupby. Missing values
+  are not counted.
+
+  The count is exact for small groups. Larger groups are estimated with a
+  HyperLogLog sketch using a fixed 4KB per group, with a standard error of
+  about 1.6%.
+
+  Example: Get the approximate number of distinct users per day.
+
+  >>> sf.groupby("day",
+                 {'num_users':gl.aggregate.APPROX_COUNT_DISTINCT('user')})
+
+  """
+  return ("__builtin__approx__count__distinct__", [src_column])
+
 
 
 def AVG(src_column):
@@ -29,6 +29,9 @@ cdef extern from "<unity/lib/api/unity_graph_interface.hpp>" namespace 'graphlab
         unity_sframe_base_ptr get_vertices(gl_vec, gl_options_map, size_t) except +
         unity_sframe_base_ptr get_edges(gl_vec, gl_vec, gl_options_map, size_t, size_t) except +
 
+        void build_edge_index(size_t, size_t) except +
+        void drop_edge_index(size_t, size_t) except +
+
         unity_sgraph_base_ptr add_vertices(unity_sframe_base_ptr, string, size_t) except +
         unity_sgraph_base_ptr add_edges(unity_sframe_base_ptr, string, string, size_t, size_t) except +
 
@@ -68,6 +71,10 @@ cdef class UnityGraphProxy:
 
     cpdef get_edges(self, object src_ids, object dst_ids, object field_constraints, size_t groupa=*, size_t groupb=*) 
 
+    cpdef build_edge_index(self, size_t groupa=*, size_t groupb=*)
+
+    cpdef drop_edge_index(self, size_t groupa=*, size_t groupb=*)
+
     cpdef add_vertices(self, UnitySFrameProxy sframe, string id_field, size_t group=*)
 
     cpdef add_edges(self, UnitySFrameProxy sframe, string src_id_field, string dst_id_field, size_t groupa=*, size_t groupb=*)
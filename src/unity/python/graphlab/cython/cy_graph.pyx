@@ -84,6 +84,14 @@ cdef class UnityGraphProxy:
             result = self.thisptr.get_edges(src_vec, dst_vec, field_map, groupa, groupb)
         return sframe_proxy(self._cli, result)
 
+    cpdef build_edge_index(self, size_t groupa=0, size_t groupb=0):
+        with nogil:
+            self.thisptr.build_edge_index(groupa, groupb)
+
+    cpdef drop_edge_index(self, size_t groupa=0, size_t groupb=0):
+        with nogil:
+            self.thisptr.drop_edge_index(groupa, groupb)
+
     cpdef add_vertices(self, UnitySFrameProxy sf, string id_field, size_t group=0):
         cdef unity_sgraph_base_ptr new_graph 
         with nogil:
@@ -856,57 +856,6 @@ class SFrame(object):
         tracker.track('sframe.row.size', value=sframe_size)
         tracker.track('sframe.col.size', value=self.num_cols())
 
-    @staticmethod
-    def _infer_column_types_from_lines(first_rows):
-        if (len(first_rows.column_names()) < 1):
-          print "Insufficient number of columns to perform type inference"
-          raise RuntimeError("Insufficient columns ")
-        if len(first_rows) < 1:
-          print "Insufficient number of rows to perform type inference"
-          raise RuntimeError("Insufficient rows")
-        # gets all the values column-wise
-        all_column_values_transposed = [list(first_rows[col])
-                for col in first_rows.column_names()]
-        # transpose
-        all_column_values = [list(x) for x in zip(*all_column_values_transposed)]
-        all_column_type_hints = [[type(t) for t in vals] for vals in all_column_values]
-        # collect the hints
-        # if every line was inferred to have a different number of elements, die
-        if len(set(len(x) for x in all_column_type_hints)) != 1:
-            print "Unable to infer column types. Defaulting to str"
-            return str
-
-        import types
-
-        column_type_hints = all_column_type_hints[0]
-        # now perform type combining across rows
-        for i in range(1, len(all_column_type_hints)):
-          currow = all_column_type_hints[i]
-          for j in range(len(column_type_hints)):
-            # combine types
-            d = set([currow[j], column_type_hints[j]])
-            if (len(d) == 1):
-              # easy case. both agree on the type
-              continue
-            if ((int in d) and (float in d)):
-              # one is an int, one is a float. its a float
-              column_type_hints[j] = float
-            elif ((array.array in d) and (list in d)):
-              # one is an array , one is a list. its a list
-              column_type_hints[j] = list
-            elif types.NoneType in d:
-              # one is a NoneType. assign to other type
-              if currow[j] != types.NoneType:
-                  column_type_hints[j] = currow[j]
-            else:
-              column_type_hints[j] = str
-        # final pass. everything whih is still NoneType is now a str
-        for i in range(len(column_type_hints)):
-          if column_type_hints[i] == types.NoneType:
-            column_type_hints[i] = str
-
-        return column_type_hints
-
     @classmethod
     def _read_csv_impl(cls,
                        url,
@@ -922,7 +871,8 @@ class SFrame(object):
                        na_values=["NA"],
                        nrows=None,
                        verbose=True,
-                       store_errors=True):
+                       store_errors=True,
+                       nrows_to_infer=100):
         """
         Constructs an SFrame from a CSV file or a path to multiple CSVs, and
         returns a pair containing the SFrame and optionally
@@ -961,38 +911,14 @@ class SFrame(object):
         if (not verbose):
             glconnect.get_client().set_log_progress(False)
 
-        # Attempt to automatically detect the column types. Either produce a
-        # list of types; otherwise default to all str types.
+        # Automatically detect the column types from the first rows of the
+        # file while parsing it. The parser prints the inferred types before
+        # parsing the file.
         column_type_inference_was_used = False
         if column_type_hints is None:
-            try:
-                # Get the first 100 rows (using all the desired arguments).
-                first_rows = graphlab.SFrame.read_csv(url, nrows=100,
-                                 column_type_hints=type(None),
-                                 header=header,
-                                 delimiter=delimiter,
-                                 comment_char=comment_char,
-                                 escape_char=escape_char,
-                                 double_quote=double_quote,
-                                 quote_char=quote_char,
-                                 skip_initial_space=skip_initial_space,
-                                 na_values = na_values)
-                column_type_hints = SFrame._infer_column_types_from_lines(first_rows)
-                typelist = '[' + ','.join(t.__name__ for t in column_type_hints) + ']'
-                print "------------------------------------------------------"
-                print "Inferred types from first line of file as "
-                print "column_type_hints="+ typelist
-                print "If parsing fails due to incorrect types, you can correct"
-                print "the inferred type list above and pass it to read_csv in"
-                print "the column_type_hints argument"
-                print "------------------------------------------------------"
-                column_type_inference_was_used = True
-            except Exception as e:
-                if type(e) == RuntimeError and "CSV parsing cancelled" in e.message:
-                    raise e
-                # If the above fails, default back to str for all columns.
-                column_type_hints = str
-                print 'Could not detect types. Using str for each column.'
+            column_type_hints = {}
+            parsing_config["type_inference_rows"] = nrows_to_infer
+            column_type_inference_was_used = True
 
         if type(column_type_hints) is type:
             type_hints = {'__all_columns__': column_type_hints}
@@ -1024,6 +950,8 @@ class SFrame(object):
                 print "Unable to parse the file with automatic type inference."
                 print "Defaulting to column_type_hints=str"
                 type_hints = {'__all_columns__': str}
+                parsing_config["type_inference_rows"] = 0
+                column_type_inference_was_used = False
                 try:
                     with cython_context():
                         errors = proxy.load_from_csvs(internal_url, parsing_config, type_hints)
@@ -1034,7 +962,8 @@ class SFrame(object):
 
         glconnect.get_client().set_log_progress(True)
 
-        return (cls(_proxy=proxy), { f: SArray(_proxy = es) for (f, es) in errors.iteritems() })
+        sf = cls(_proxy=proxy)
+        return (sf, { f: SArray(_proxy = es) for (f, es) in errors.iteritems() })
 
     @classmethod
     def read_csv_with_errors(cls,
@@ -1049,7 +978,8 @@ class SFrame(object):
                              column_type_hints=None,
                              na_values=["NA"],
                              nrows=None,
-                             verbose=True):
+                             verbose=True,
+                             nrows_to_infer=100):
         """
         Constructs an SFrame from a CSV file or a path to multiple CSVs, and
         returns a pair containing the SFrame and a dict of filenames to SArrays
@@ -1113,7 +1043,12 @@ class SFrame(object):
             If set, only this many rows will be read from the file.
 
         verbose : bool, optional
-            If True, print the progress.
+            If True, print the progress, and the column types inferred when
+            column_type_hints is None.
+
+        nrows_to_infer : int, optional
+            The number of rows used to infer the column types when
+            column_type_hints is None.
 
         Returns
         -------
@@ -1163,6 +1098,7 @@ class SFrame(object):
                                   na_values=na_values,
                                   nrows=nrows,
                                   verbose=verbose,
+                                  nrows_to_infer=nrows_to_infer,
                                   store_errors=True)
     @classmethod
     def read_csv(cls,
@@ -1178,7 +1114,8 @@ class SFrame(object):
                  column_type_hints=None,
                  na_values=["NA"],
                  nrows=None,
-                 verbose=True):
+                 verbose=True,
+                 nrows_to_infer=100):
         """
         Constructs an SFrame from a CSV file or a path to multiple CSVs.
 
@@ -1244,7 +1181,12 @@ class SFrame(object):
             If set, only this many rows will be read from the file.
 
         verbose : bool, optional
-            If True, print the progress.
+            If True, print the progress, and the column types inferred when
+            column_type_hints is None.
+
+        nrows_to_infer : int, optional
+            The number of rows used to infer the column types when
+            column_type_hints is None.
 
         Returns
         -------
@@ -1410,6 +1352,7 @@ class SFrame(object):
                                   na_values=na_values,
                                   nrows=nrows,
                                   verbose=verbose,
+                                  nrows_to_infer=nrows_to_infer,
                                   store_errors=False)[0]
 
 
@@ -3772,7 +3715,7 @@ class SFrame(object):
               right SFrame that will be joined together. e.g.
               {'left_col_name':'right_col_name'}.
 
-        how : {'left', 'right', 'outer', 'inner'}, optional
+        how : {'left', 'right', 'outer', 'inner', 'semi', 'anti'}, optional
             The type of join to perform.  'inner' is default.
 
             * inner: Equivalent to a SQL inner join.  Result consists of the
@@ -3791,6 +3734,13 @@ class SFrame(object):
               the union between the result of a left outer join and a right
               outer join.
 
+            * semi: Result consists of the rows of the left SFrame whose join
+              key values appear in the right SFrame, unchanged and each at
+              most once.
+
+            * anti: Result consists of the rows of the left SFrame whose join
+              key values do not appear in the right SFrame, unchanged.
+
         Returns
         -------
         out : SFrame
@@ -3846,7 +3796,7 @@ class SFrame(object):
         [5 rows x 3 columns]
         """
         _mt._get_metric_tracker().track('sframe.join', properties={'type':how})
-        available_join_types = ['left','right','outer','inner']
+        available_join_types = ['left','right','outer','inner','semi','anti']
 
         if not isinstance(right, SFrame):
             raise TypeError("Can only join two SFrames")
@@ -3940,10 +3890,6 @@ class SFrame(object):
         value_sf = SFrame()
         value_sf.add_column(values, column_name)
 
-        # Make sure the values list has unique values, or else join will not
-        # filter.
-        value_sf = value_sf.groupby(column_name, {})
-
         existing_columns = self.column_names()
         if column_name not in existing_columns:
             raise KeyError("Column '" + column_name + "' not in SFrame.")
@@ -3954,24 +3900,11 @@ class SFrame(object):
             raise TypeError("Type of given values does not match type of column '" +
                 column_name + "' in SFrame.")
 
+        # The semi and anti joins keep each row at most once, so the values
+        # do not need to be unique.
         with cython_context():
-            if exclude:
-                id_name = "id"
-                # Make sure this name is unique so we know what to remove in
-                # the result
-                while id_name in existing_columns:
-                    id_name += "1"
-                value_sf = value_sf.add_row_number(id_name)
-
-                tmp = SFrame(_proxy=self.__proxy__.join(value_sf.__proxy__,
-                                                     'left',
-                                                     {column_name:column_name}))
-                ret_sf = tmp[tmp[id_name] == None]
-                del ret_sf[id_name]
-                return ret_sf
-            else:
-                return SFrame(_proxy=self.__proxy__.join(value_sf.__proxy__,
-                                                     'inner',
+            return SFrame(_proxy=self.__proxy__.join(value_sf.__proxy__,
+                                                     'anti' if exclude else 'semi',
                                                      {column_name:column_name}))
 
     @_check_canvas_enabled
@@ -570,6 +570,48 @@ class SGraph(object):
         else:
             raise ValueError("Invalid format specifier")
 
+    def build_edge_index(self):
+        """
+        Index the edges of the graph by vertex ID. Once the index is built,
+        :py:func:`~graphlab.SGraph.get_edges` with a few source or target
+        vertex IDs reads only the edges of those vertices, instead of scanning
+        all the edges of the graph.
+
+        The index takes 8 bytes per edge. It is shared by the graphs derived
+        from this graph, is kept up to date as edges are added, and is saved
+        with the graph.
+
+        See Also
+        --------
+        drop_edge_index, get_edges, get_neighborhood
+
+        Examples
+        --------
+        >>> g = graphlab.SGraph().add_edges(
+                graphlab.SFrame({'src': range(1000), 'dst': range(1, 1001)}),
+                src_field='src', dst_field='dst')
+        >>> g.build_edge_index()
+        >>> g.get_edges(src_ids=[5])
+        """
+        _mt._get_metric_tracker().track('sgraph.build_edge_index')
+
+        with cython_context():
+            self.__proxy__.build_edge_index()
+
+    def drop_edge_index(self):
+        """
+        Free the index built by :py:func:`~graphlab.SGraph.build_edge_index`.
+        Does nothing if the graph has no index.
+
+        See Also
+        --------
+        build_edge_index
+        """
+        _mt._get_metric_tracker().track('sgraph.drop_edge_index')
+
+        with cython_context():
+            self.__proxy__.drop_edge_index()
+
     def add_vertices(self, vertices, vid_field=None):
         """
         Add vertices to the SGraph. Vertices should be input as a list of
@@ -1213,9 +1255,16 @@ class SGraph(object):
         out : Graph
             The subgraph with the neighborhoods around the target vertices.
 
+        Notes
+        -----
+        - The neighborhood is found with :py:func:`~graphlab.SGraph.get_edges`
+          queries on the vertices found so far. On a graph indexed with
+          :py:func:`~graphlab.SGraph.build_edge_index`, these read only the
+          edges of those vertices instead of scanning the graph.
+
         See Also
         --------
-        get_edges, get_vertices
+        get_edges, get_vertices, build_edge_index
 
         References
         ----------
@@ -467,6 +467,11 @@ def set_runtime_config(name, value):
      The number of groupby keys cached in memory. Increasing this will increase
      performance with increased memory consumption. Defaults to 1048576.
 
+    - *GRAPHLAB_SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS*
+     The number of groupby keys each thread aggregates locally before merging
+     them into the shared groupby buffers. This helps when a few keys account
+     for most rows. 0 disables the local aggregation. Defaults to 1024.
+
     **Advanced Configuration Variables**
 
     - *GRAPHLAB_SFRAME_FILE_HANDLE_POOL_SIZE*
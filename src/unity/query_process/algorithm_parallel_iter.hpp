@@ -188,15 +188,17 @@ inline std::shared_ptr<sarray<T>> save_sarray(
   parallel_for(0, dop,
    [&](size_t idx) {
 
-    std::vector<T> items;
+    column_batch items;
+    T value;
     while(true) {
-      items = input_iterator->get_next(idx, graphlab::sframe_config::SFRAME_READ_BATCH_SIZE);
-      if (items.size() == 0) {
+      input_iterator->get_next_batch(idx, graphlab::sframe_config::SFRAME_READ_BATCH_SIZE, items);
+      if (items.num_rows() == 0) {
         break;
       }
 
-      for(auto i = items.begin(); i != items.end(); ++i) {
-        *(writer_iters[idx]) = *i;
+      for(size_t i = 0; i < items.num_rows(); ++i) {
+        items.get_row(i, value);
+        *(writer_iters[idx]) = value;
         writer_iters[idx]++;
       }
     }
@@ -259,14 +261,18 @@ inline std::shared_ptr<sframe> save_sframe(
 
     auto output_iter = output_sframe_ptr->get_output_iterator(idx);
 
+    // Read batches of columns, a single row buffer is reused for writing
+    column_batch items;
+    std::vector<flexible_type> row;
     while(true) {
-      // Read a batch of values
+      vector_iterator->get_next_batch(idx, graphlab::sframe_config::SFRAME_READ_BATCH_SIZE, items);
+      if (items.num_rows() == 0) break;
 
-      std::vector<std::vector<flexible_type>> items
-          = vector_iterator->get_next(idx, graphlab::sframe_config::SFRAME_READ_BATCH_SIZE);
-      if (items.size() == 0) break;
-
-      std::move(items.begin(), items.end(), output_iter);
+      for (size_t i = 0; i < items.num_rows(); ++i) {
+        items.get_row(i, row);
+        *output_iter = row;
+        ++output_iter;
+      }
     }
    });
 
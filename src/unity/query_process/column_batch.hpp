@@ -0,0 +1,314 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef GRAPHLAB_UNITY_COLUMN_BATCH_HPP
+#define GRAPHLAB_UNITY_COLUMN_BATCH_HPP
+
+#include <vector>
+#include <algorithm>
+#include <logger/assertions.hpp>
+#include <flexible_type/flexible_type.hpp>
+#include <sframe/sframe_rows.hpp>
+
+namespace graphlab {
+
+/**
+ * A batch of rows exchanged between lazy evaluation operators on the batch
+ * execution path (see lazy_eval_op_imp_base::get_next_batch()).
+ *
+ * The rows are stored column-wise in an \ref sframe_rows made only of
+ * decoded columns, so that operators over wide SFrames do not allocate a
+ * vector per row. A selection vector lists, in increasing order, which of
+ * the stored ("physical") rows are actually part of the batch. Filters
+ * narrow the selection instead of copying the surviving rows. Without a
+ * selection vector all the physical rows are selected.
+ *
+ * All row indices taken by the accessors below are indices among the
+ * selected rows, unless stated otherwise.
+ */
+class column_batch {
+ public:
+  typedef sframe_rows::decoded_column_type column_type;
+
+  column_batch() { }
+
+  column_batch(const column_batch& other) = default;
+  column_batch& operator=(const column_batch& other) = default;
+
+  column_batch(column_batch&& other) {
+    (*this) = std::move(other);
+  }
+
+  column_batch& operator=(column_batch&& other) {
+    // sframe_rows is not movable, so swap its contents instead
+    m_rows.get_columns().swap(other.m_rows.get_columns());
+    m_num_physical_rows = other.m_num_physical_rows;
+    m_has_selection = other.m_has_selection;
+    m_selection.swap(other.m_selection);
+    other.clear();
+    return *this;
+  }
+
+  /// Removes all columns and rows
+  inline void clear() {
+    m_rows.reset();
+    m_num_physical_rows = 0;
+    m_has_selection = false;
+    m_selection.clear();
+  }
+
+  /// Returns the number of columns
+  inline size_t num_columns() const {
+    return m_rows.get_columns().size();
+  }
+
+  /// Returns the number of selected rows
+  inline size_t num_rows() const {
+    return m_has_selection ? m_selection.size() : m_num_physical_rows;
+  }
+
+  /// Returns the number of stored rows, whether selected or not
+  inline size_t num_physical_rows() const {
+    return m_num_physical_rows;
+  }
+
+  /// Returns true if only some of the stored rows are selected
+  inline bool has_selection() const {
+    return m_has_selection;
+  }
+
+  /// Returns the physical row index of the i-th selected row
+  inline size_t physical_row(size_t i) const {
+    return m_has_selection ? m_selection[i] : i;
+  }
+
+  /// Returns the value of the i-th selected row in a column
+  inline const flexible_type& value(size_t column, size_t i) const {
+    return get_column(column)[physical_row(i)];
+  }
+
+  /**
+   * Returns a column, including the rows which are not selected.
+   * Index with \ref physical_row().
+   */
+  inline const column_type& get_column(size_t column) const {
+    DASSERT_LT(column, num_columns());
+    return m_rows.get_columns()[column].m_decoded_column;
+  }
+
+  /// Modifiable version of get_column
+  inline column_type& get_column(size_t column) {
+    DASSERT_LT(column, num_columns());
+    return m_rows.get_columns()[column].m_decoded_column;
+  }
+
+  /**
+   * Adds a column to the right of the batch. The column must be as long as
+   * the existing columns, and is subject to the current selection.
+   */
+  inline void add_column(column_type column) {
+    if (num_columns() == 0) {
+      m_num_physical_rows = column.size();
+    } else {
+      ASSERT_EQ(column.size(), m_num_physical_rows);
+    }
+    push_column(std::move(column));
+  }
+
+  /**
+   * Moves all the columns of another batch with the same number of selected
+   * rows to the right of this batch. Selections are kept when both batches
+   * select the same physical rows, and applied otherwise. other is cleared.
+   */
+  void add_columns(column_batch& other) {
+    if (num_columns() == 0) {
+      (*this) = std::move(other);
+      return;
+    }
+    ASSERT_EQ(other.num_rows(), num_rows());
+    if (m_has_selection != other.m_has_selection ||
+        m_num_physical_rows != other.m_num_physical_rows ||
+        m_selection != other.m_selection) {
+      compact();
+      other.compact();
+    }
+    for (auto& col: other.m_rows.get_columns()) {
+      push_column(std::move(col.m_decoded_column));
+    }
+    other.clear();
+  }
+
+  /**
+   * Narrows the selection to a subset of the selected rows.
+   * rows lists, in increasing order, the indices of the selected rows to keep.
+   */
+  void select(const std::vector<size_t>& rows) {
+    DASSERT_TRUE(rows.empty() || rows.back() < num_rows());
+    if (m_has_selection) {
+      for (size_t i = 0;i < rows.size(); ++i) {
+        m_selection[i] = m_selection[rows[i]];
+      }
+      m_selection.resize(rows.size());
+    } else {
+      m_selection = rows;
+      m_has_selection = true;
+    }
+  }
+
+  /// Drops the first num_to_drop selected rows.
+  void drop_front(size_t num_to_drop) {
+    num_to_drop = std::min(num_to_drop, num_rows());
+    if (num_to_drop == 0) return;
+    if (!m_has_selection) {
+      m_selection.resize(m_num_physical_rows - num_to_drop);
+      for (size_t i = 0;i < m_selection.size(); ++i) {
+        m_selection[i] = num_to_drop + i;
+      }
+      m_has_selection = true;
+    } else {
+      m_selection.erase(m_selection.begin(), m_selection.begin() + num_to_drop);
+    }
+  }
+
+  /**
+   * Removes the rows which are not selected from the columns, so that the
+   * batch no longer has a selection.
+   */
+  void compact() {
+    if (!m_has_selection) return;
+    for (auto& col: m_rows.get_columns()) {
+      column_type& values = col.m_decoded_column;
+      for (size_t i = 0;i < m_selection.size(); ++i) {
+        if (m_selection[i] != i) values[i] = std::move(values[m_selection[i]]);
+      }
+      values.resize(m_selection.size());
+    }
+    m_num_physical_rows = m_selection.size();
+    m_has_selection = false;
+    m_selection.clear();
+  }
+
+  /**
+   * Moves the first (up to) max_rows selected rows of another batch to the
+   * end of this batch. The rows are removed from other. Both batches must
+   * have the same number of columns unless this batch is empty.
+   */
+  void append(column_batch& other, size_t max_rows) {
+    size_t num_to_move = std::min(max_rows, other.num_rows());
+    if (num_to_move == 0) return;
+    if (num_columns() == 0 && m_num_physical_rows == 0 &&
+        num_to_move == other.num_rows()) {
+      (*this) = std::move(other);
+      return;
+    }
+    if (num_columns() == 0) {
+      for (size_t c = 0;c < other.num_columns(); ++c) add_column(column_type());
+    }
+    ASSERT_EQ(num_columns(), other.num_columns());
+    for (size_t c = 0;c < num_columns(); ++c) {
+      column_type& target = get_column(c);
+      column_type& source = other.get_column(c);
+      target.reserve(target.size() + num_to_move);
+      for (size_t i = 0;i < num_to_move; ++i) {
+        target.push_back(std::move(source[other.physical_row(i)]));
+      }
+    }
+    if (m_has_selection) {
+      for (size_t i = 0;i < num_to_move; ++i) {
+        m_selection.push_back(m_num_physical_rows + i);
+      }
+    }
+    m_num_physical_rows += num_to_move;
+    other.drop_front(num_to_move);
+  }
+
+  /// Reads the i-th selected row of a single column batch
+  inline void get_row(size_t i, flexible_type& ret) const {
+    DASSERT_EQ(num_columns(), 1);
+    ret = value(0, i);
+  }
+
+  /// Reads the i-th selected row into a vector with one value per column
+  inline void get_row(size_t i, std::vector<flexible_type>& ret) const {
+    size_t ncols = num_columns();
+    ret.resize(ncols);
+    size_t row = physical_row(i);
+    for (size_t c = 0;c < ncols; ++c) ret[c] = get_column(c)[row];
+  }
+
+  /// Replaces the contents with a single column of values
+  void assign(std::vector<flexible_type>&& values) {
+    clear();
+    add_column(std::move(values));
+  }
+
+  /// Replaces the contents with rows of values
+  void assign(std::vector<std::vector<flexible_type>>&& rows) {
+    clear();
+    if (rows.empty()) return;
+    size_t ncols = rows[0].size();
+    std::vector<column_type> columns(ncols, column_type(rows.size()));
+    for (size_t i = 0;i < rows.size(); ++i) {
+      DASSERT_EQ(rows[i].size(), ncols);
+      for (size_t c = 0;c < ncols; ++c) columns[c][i] = std::move(rows[i][c]);
+    }
+    for (auto& col: columns) add_column(std::move(col));
+    m_num_physical_rows = rows.size();
+  }
+
+  /// Moves the selected rows of a single column batch out into ret.
+  void move_to(std::vector<flexible_type>& ret) {
+    ret.clear();
+    if (num_rows() > 0) {
+      compact();
+      ret = std::move(get_column(0));
+    }
+    clear();
+  }
+
+  /// Moves the selected rows out into ret, one vector per row.
+  void move_to(std::vector<std::vector<flexible_type>>& ret) {
+    size_t nrows = num_rows();
+    size_t ncols = num_columns();
+    ret.resize(nrows);
+    for (size_t i = 0;i < nrows; ++i) {
+      size_t row = physical_row(i);
+      ret[i].resize(ncols);
+      for (size_t c = 0;c < ncols; ++c) {
+        ret[i][c] = std::move(get_column(c)[row]);
+      }
+    }
+    clear();
+  }
+
+ private:
+  /**
+   * Adds a column group without going through sframe_rows::add_decoded_column()
+   * whose row count bookkeeping does not see the columns being resized.
+   */
+  inline void push_column(column_type&& column) {
+    m_rows.get_columns().push_back(sframe_rows::column_group_type());
+    m_rows.get_columns().back() = std::move(column);
+  }
+
+  sframe_rows m_rows;
+  size_t m_num_physical_rows = 0;
+  bool m_has_selection = false;
+  std::vector<size_t> m_selection;
+};
+
+} // namespace graphlab
+#endif
@@ -20,6 +20,7 @@
 #include <tuple>
 #include <logger/logger.hpp>
 #include <flexible_type/flexible_type.hpp>
+#include <unity/query_process/column_batch.hpp>
 
 namespace graphlab {
 
@@ -59,6 +60,16 @@ public:
   **/
   std::vector<T> get_next(size_t segment_index, size_t num_items);
 
+  /**
+  *  Get next set of values from given segment as a column batch.
+  * \param segment_index the index to which the next set of items need to be retrieved
+  * \param num_items Number of items to retrieve.
+  * \param ret The batch to store the items in. Its previous contents are discarded.
+  *
+  * The batch selects exactly num_items rows, unless it is the last batch.
+  **/
+  void get_next_batch(size_t segment_index, size_t num_items, column_batch& ret);
+
   /**
   *  Skip next set of values from given sement
   * \param segment_index the index to which the next set of items need to be skipped
@@ -169,6 +180,10 @@ class lazy_eval_op_imp_base : public lazy_eval_op_base {
     size_t m_start_item_index = 0;
     size_t m_item_count = 0;
     std::vector<T> m_items;
+    // set when the items were read through get_next_batch(). They are then
+    // held in m_batch instead of m_items
+    bool m_is_batch = false;
+    column_batch m_batch;
   };
 
 public:
@@ -219,6 +234,20 @@ protected:
   **/
   virtual size_t skip_rows(size_t segment_index, size_t num_items) = 0;
 
+  /**
+   * Batch version of \ref get_next(). Stores the next batch of values from the
+   * segment in "ret" as a column batch, discarding its previous contents.
+   * Exactly num_items rows are selected, unless it is the last batch in the
+   * chunk.
+   *
+   * Operators which can work on columns directly override this to avoid
+   * materializing every row, and filters only narrow the selection of the
+   * batches they read. The default implementation wraps get_next().
+  **/
+  virtual void get_next_batch(size_t segment_index, size_t num_items, column_batch& ret) {
+    ret.assign(this->get_next(segment_index, num_items));
+  }
+
   // move first "num_to_move" items from source to beginning of target, resize source, target has enough
   // space to hold the items
   void move_items(std::vector<T>& source, std::vector<T>& target, size_t num_to_move) {
@@ -338,8 +367,9 @@ private:
 
     if (cached_items.m_initialized) {
       if (cached_items.m_start_item_index == start_item) {
-        DASSERT_TRUE(num_items == cached_items.m_item_count);
-        return num_items;
+        // fewer items than requested are skipped at the end of the segment
+        DASSERT_TRUE(num_items >= cached_items.m_item_count);
+        return cached_items.m_item_count;
       } else {
         // Caller should consume the rows in order
         DASSERT_LT(cached_items.m_start_item_index, start_item);
@@ -354,6 +384,7 @@ private:
     m_cached_items[segment_index].m_fullfilled = false;
     m_cached_items[segment_index].m_item_count = num_skipped;
     m_cached_items[segment_index].m_items.clear();
+    m_cached_items[segment_index].m_batch.clear();
 
     return num_skipped;
   }
@@ -373,6 +404,12 @@ private:
         // There should never have cases where the items are skipped but is needed later
         DASSERT_TRUE(cached_items.m_fullfilled);
         DASSERT_TRUE(num_items >= cached_items.m_item_count);
+        if (cached_items.m_is_batch) {
+          DASSERT_EQ(cached_items.m_batch.num_rows(), cached_items.m_item_count);
+          std::vector<T> items;
+          column_batch(cached_items.m_batch).move_to(items);
+          return items;
+        }
         return cached_items.m_items;
       } else {
         // the read should be in order
@@ -387,10 +424,56 @@ private:
     m_cached_items[segment_index].m_item_count = items.size();
     m_cached_items[segment_index].m_initialized = true;
     m_cached_items[segment_index].m_fullfilled = true;
+    m_cached_items[segment_index].m_is_batch = false;
+    m_cached_items[segment_index].m_batch.clear();
 
     return items;
   }
 
+  /**
+   * Batch version of get_items(). The batch is only kept in the cache when
+   * more than one iterator consumes this operator: a single consumer reads
+   * in order and never asks for the same items twice.
+   **/
+  void get_batch_items(size_t segment_index, size_t start_item, size_t num_items, column_batch& ret) {
+    DASSERT_TRUE(segment_index < m_dop);
+    m_started = true;
+
+    auto& cached_items = m_cached_items[segment_index];
+    DASSERT_TRUE(start_item == 0 || cached_items.m_initialized);
+
+    if (cached_items.m_initialized) {
+      if (cached_items.m_start_item_index == start_item) {
+        DASSERT_TRUE(cached_items.m_fullfilled);
+        DASSERT_TRUE(num_items >= cached_items.m_item_count);
+        if (cached_items.m_is_batch) {
+          DASSERT_EQ(cached_items.m_batch.num_rows(), cached_items.m_item_count);
+          ret = cached_items.m_batch;
+        } else {
+          ret.assign(std::vector<T>(cached_items.m_items));
+        }
+        return;
+      } else {
+        // the read should be in order
+        DASSERT_LT(cached_items.m_start_item_index, start_item);
+      }
+    }
+
+    // fulfill next chunk
+    this->get_next_batch(segment_index, num_items, ret);
+    cached_items.m_start_item_index = start_item;
+    cached_items.m_item_count = ret.num_rows();
+    cached_items.m_items.clear();
+    cached_items.m_initialized = true;
+    cached_items.m_fullfilled = true;
+    cached_items.m_is_batch = true;
+    if (m_active_iterators.size() > 1) {
+      cached_items.m_batch = ret;
+    } else {
+      cached_items.m_batch.clear();
+    }
+  }
+
   std::map<uintptr_t, uintptr_t> m_active_iterators;
   std::vector<parallel_iterator_cached_item> m_cached_items;
   bool m_started;
@@ -434,6 +517,12 @@ std::vector<T> parallel_iterator<T>::get_next(size_t segment_index, size_t num_i
   return return_val;
 }
 
+template<typename T>
+void parallel_iterator<T>::get_next_batch(size_t segment_index, size_t num_items, column_batch& ret) {
+  m_owner->get_batch_items(segment_index, m_next_item_index[segment_index], num_items, ret);
+  m_next_item_index[segment_index] += ret.num_rows();
+}
+
 template<typename T>
 size_t parallel_iterator<T>::skip_rows(size_t segment_index, size_t num_items) {
   size_t num_skipped = m_owner->skip_items(segment_index, m_next_item_index[segment_index], num_items);
@@ -18,6 +18,7 @@
 #define GRAPHLAB_UNITY_LE_IMP
 
 #include <limits>
+#include <cmath>
 #include <logger/logger.hpp>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/sarray.hpp>
@@ -358,6 +359,17 @@ protected:
     return rows;
   }
 
+  virtual void get_next_batch(size_t segment_index, size_t num_items, column_batch& ret) {
+    // the columns are stitched together without building the rows
+    ret.clear();
+    column_batch one_column;
+    for (size_t i = 0; i < m_iterators.size(); ++i) {
+      m_iterators[i]->get_next_batch(segment_index, num_items, one_column);
+      ASSERT_EQ(one_column.num_rows(), i == 0 ? one_column.num_rows() : ret.num_rows());
+      ret.add_columns(one_column);
+    }
+  }
+
   virtual std::shared_ptr<lazy_eval_op_base> clone() {
     return std::make_shared<le_sframe>(m_sources);
   };
@@ -476,6 +488,254 @@ private:
   std::shared_ptr<sarray<T>> m_source;
 };
 
+/**
+ * Compares every value of an SArray against a constant with one of the
+ * comparison operators ("<", ">", "<=", ">=", "==", "!="), emitting the 
+ * result of the comparison (or UNDEFINED for UNDEFINED values).
+ *
+ * The operator reads from the SArray directly, and for each on disk block
+ * consults the block statistics (min / max / undefined count). If the 
+ * comparison has the same result for every row in the block, the constant
+ * result is emitted without reading or decoding the block. Combined with
+ * \ref le_logical_filter, which skips reading the filtered column where
+ * the index is all zero, a selective range filter only reads the blocks
+ * which may contain matches.
+ **/
+class le_sarray_compare : public lazy_eval_op_imp_base<flexible_type> {
+ public:
+  typedef std::function<flexible_type(const flexible_type&, const flexible_type&)> CompareFn;
+
+  /**
+   * Constructs a new comparison operator.
+   * \param sarray_ptr The source sarray
+   * \param other The constant to compare against. Must not be UNDEFINED.
+   * \param op The comparison operator.
+   * \param right_operator If true, computes "other op value", otherwise
+   *                       computes "value op other".
+   * \param compare_fn The comparison function as returned by 
+   *                   unity_sarray_binary_operations::get_binary_operator
+   **/
+  le_sarray_compare(std::shared_ptr<sarray<flexible_type>> sarray_ptr,
+                    flexible_type other,
+                    std::string op,
+                    bool right_operator,
+                    CompareFn compare_fn):
+      lazy_eval_op_imp_base<flexible_type>(std::string("sarray_compare"), false) {
+    DASSERT_MSG(sarray_ptr, "source cannot be NULL");
+    DASSERT_TRUE(other.get_type() != flex_type_enum::UNDEFINED);
+    m_source = sarray_ptr;
+    m_reader = sarray_ptr->get_reader();
+    m_other = other;
+    m_op = op;
+    m_right_operator = right_operator;
+    m_compare_fn = compare_fn;
+  }
+
+  ~le_sarray_compare() {
+    m_reader.reset();
+    m_source.reset();
+  }
+
+  /**
+   * Returns true if op is a comparison operator this operator can evaluate.
+   */
+  static bool is_supported_operator(const std::string& op) {
+    return op == "<" || op == ">" || op == "<=" || op == ">=" || 
+        op == "==" || op == "!=";
+  }
+
+  virtual flex_type_enum get_type() const {
+    return flex_type_enum::INTEGER;
+  }
+
+  virtual bool has_size() const {
+    return true;
+  }
+
+  virtual size_t size() const {
+    return m_source->size();
+  }
+
+  std::vector<std::shared_ptr<lazy_eval_op_base>> get_children() const {
+    std::vector<std::shared_ptr<lazy_eval_op_base>> empty_vector;
+    return empty_vector;
+  }
+
+  void set_children(std::vector<std::shared_ptr<lazy_eval_op_base>>& children) {
+    log_and_throw("this should never be called!");
+  }
+
+ protected:
+
+  virtual void start(size_t dop, const std::vector<size_t>& segment_sizes) {
+    if (segment_sizes.empty()) {
+      this->compute_chunk_sizes(dop, size(), m_iterator_begins, m_iterator_ends);
+    } else {
+      DASSERT_EQ(segment_sizes.size(), dop);
+      this->compute_iterator_locations(segment_sizes, m_iterator_begins, m_iterator_ends);
+      DASSERT_EQ(m_iterator_ends.back(), size());
+    }
+  }
+
+  virtual void stop() {
+    m_iterator_begins.clear();
+    m_iterator_ends.clear();
+  }
+
+  virtual size_t skip_rows(size_t segment_index, size_t num_items) {
+    auto iterator_begin = m_iterator_begins[segment_index];
+    auto iterator_end = m_iterator_ends[segment_index];
+    size_t items_to_skip = std::min(num_items, iterator_end - iterator_begin);
+    m_iterator_begins[segment_index] = iterator_begin + items_to_skip;
+    return items_to_skip;
+  }
+
+  virtual std::vector<flexible_type> get_next(size_t segment_index, size_t num_items) {
+    auto return_value = std::vector<flexible_type>();
+    auto iterator_begin = m_iterator_begins[segment_index];
+    auto iterator_end = m_iterator_ends[segment_index];
+
+    // nothing to read, reach end of chunk
+    if (iterator_end == iterator_begin) {
+      return return_value;
+    }
+
+    size_t items_to_read = std::min(num_items, iterator_end - iterator_begin);
+    size_t row_end = iterator_begin + items_to_read;
+    return_value.resize(items_to_read);
+
+    // Walk the range block by block. Rows in blocks whose result is 
+    // determined by the block statistics are filled in directly. 
+    // Consecutive rows which do need to be read are read together.
+    std::vector<flexible_type> buffer;
+    size_t row = iterator_begin;
+    size_t pending_read_start = row;
+    while (row < row_end) {
+      size_t block_row_start = 0, block_row_end = 0;
+      flexible_type constant_result;
+      auto stats = m_reader->get_block_statistics(row, block_row_start, block_row_end);
+      bool pruned = stats != NULL && block_row_end > row &&
+          evaluate_on_statistics(*stats, constant_result);
+      size_t next_row = (block_row_end > row) ? std::min(block_row_end, row_end) : row_end;
+      if (pruned) {
+        read_and_compare(pending_read_start, row, iterator_begin, buffer, return_value);
+        for (size_t i = row; i < next_row; ++i) {
+          return_value[i - iterator_begin] = constant_result;
+        }
+        pending_read_start = next_row;
+      }
+      row = next_row;
+    }
+    read_and_compare(pending_read_start, row_end, iterator_begin, buffer, return_value);
+
+    // adjust the begin iterator so that next time we read from the correct place
+    m_iterator_begins[segment_index] = row_end;
+
+    return return_value;
+  }
+
+  virtual std::shared_ptr<lazy_eval_op_base> clone() {
+    return std::make_shared<le_sarray_compare>(m_source, m_other, m_op, 
+                                               m_right_operator, m_compare_fn);
+  };
+
+ private:
+  std::unique_ptr<sarray_reader<flexible_type>> m_reader;
+  std::vector<size_t> m_iterator_begins;
+  std::vector<size_t> m_iterator_ends;
+  std::shared_ptr<sarray<flexible_type>> m_source;
+  flexible_type m_other;
+  std::string m_op;
+  bool m_right_operator;
+  CompareFn m_compare_fn;
+
+  /**
+   * Reads rows [row_start, row_end) and compares them, storing the result
+   * in output[row_start - output_offset ...]
+   */
+  void read_and_compare(size_t row_start, size_t row_end, size_t output_offset,
+                        std::vector<flexible_type>& buffer, 
+                        std::vector<flexible_type>& output) {
+    if (row_start >= row_end) return;
+    m_reader->read_rows(row_start, row_end, buffer);
+    DASSERT_EQ(buffer.size(), row_end - row_start);
+    for (size_t i = 0; i < buffer.size(); ++i) {
+      const flexible_type& f = buffer[i];
+      auto& out = output[row_start - output_offset + i];
+      if (f.get_type() == flex_type_enum::UNDEFINED) {
+        out = f;
+      } else {
+        out = m_right_operator ? m_compare_fn(m_other, f) : m_compare_fn(f, m_other);
+      }
+    }
+  }
+
+  /**
+   * Tries to evaluate the comparison for an entire block from its 
+   * statistics. Returns true and stores the result in ret if every row
+   * in the block has the same result.
+   */
+  bool evaluate_on_statistics(const v2_block_impl::block_statistics& stats,
+                              flexible_type& ret) const {
+    if (stats.num_elem > 0 && stats.num_undefined == stats.num_elem) {
+      // all undefined. undefined values are passed through as is
+      ret = FLEX_UNDEFINED;
+      return true;
+    }
+    if (!stats.has_bounds || stats.num_undefined > 0) return false;
+    // we can only reason about the bounds if they are ordered against
+    // the constant in the same way as the values are.
+    flex_type_enum bounds_type = stats.min_value.get_type();
+    flex_type_enum other_type = m_other.get_type();
+    bool bounds_numeric = bounds_type == flex_type_enum::INTEGER || 
+                          bounds_type == flex_type_enum::FLOAT;
+    bool other_numeric = other_type == flex_type_enum::INTEGER || 
+                         other_type == flex_type_enum::FLOAT;
+    if (bounds_type != other_type && !(bounds_numeric && other_numeric)) return false;
+    if (other_type == flex_type_enum::FLOAT && 
+        std::isnan(m_other.get<flex_float>())) return false;
+
+    // normalize to "value op other"
+    std::string op = m_op;
+    if (m_right_operator) {
+      if (op == "<") op = ">";
+      else if (op == ">") op = "<";
+      else if (op == "<=") op = ">=";
+      else if (op == ">=") op = "<=";
+    }
+    const flexible_type& lo = stats.min_value;
+    const flexible_type& hi = stats.max_value;
+    const flexible_type& other = m_other;
+    bool all_true = false, all_false = false;
+    if (op == "<") {
+      all_true = hi < other; 
+      all_false = lo >= other;
+    } else if (op == "<=") {
+      all_true = hi <= other; 
+      all_false = lo > other;
+    } else if (op == ">") {
+      all_true = lo > other; 
+      all_false = hi <= other;
+    } else if (op == ">=") {
+      all_true = lo >= other; 
+      all_false = hi < other;
+    } else if (op == "==" || op == "!=") {
+      bool none_equal = other < lo || other > hi;
+      bool all_equal = lo == hi && lo == other;
+      all_true = (op == "==") ? all_equal : none_equal;
+      all_false = (op == "==") ? none_equal : all_equal;
+    }
+    if (all_true) {
+      ret = 1;
+      return true;
+    } else if (all_false) {
+      ret = 0;
+      return true;
+    }
+    return false;
+  }
+};
+
 
 /**
  * Provide parallel block reader interface on a vector of other lazy_eval_op_impl
@@ -861,6 +1121,21 @@ private:
     m_lambda_hash = (size_t)(-1);
   }
 
+  /**
+   * Sets a function transforming a whole batch of values at a time, used
+   * instead of calling the transform function on every value. The batch
+   * function must compute the same results as the transform function, and
+   * convert them to the output type. Only applies to native transform
+   * functions.
+   */
+  void set_batch_transform_fn(BatchTransformFn batch_transform_fn) {
+    DASSERT_TRUE(m_lambda.empty());
+    m_custom_batch_transform_fn = batch_transform_fn;
+    if (m_custom_batch_transform_fn) {
+      m_batch_transform_fn = m_custom_batch_transform_fn;
+    }
+  }
+
   ~le_transform() {
     // unregister the lambda
     if (m_lambda_hash != (size_t)(-1)) {
@@ -940,9 +1215,33 @@ protected:
     return output;
   }
 
+  virtual void get_next_batch(size_t segment_index, size_t num_items, column_batch& ret) {
+    column_batch input;
+    m_source_iterator->get_next_batch(segment_index, num_items, input);
+
+    // only the selected rows are transformed. The output has no selection
+    std::vector<flexible_type> output(input.num_rows());
+    if (m_transform_fn && !m_custom_batch_transform_fn) {
+      S row;
+      for (size_t i = 0; i < output.size(); ++i) {
+        input.get_row(i, row);
+        output[i] = convert_value_to_output_type(m_transform_fn(row), m_type);
+      }
+    } else if (!output.empty()) {
+      // lambdas and batch transforms are evaluated in bulk over the
+      // selected rows
+      std::vector<S> items;
+      input.move_to(items);
+      m_batch_transform_fn(items, output);
+    }
+    ret.assign(std::move(output));
+  }
+
   virtual std::shared_ptr<lazy_eval_op_base> clone() {
     if (m_transform_fn) {
-      return std::make_shared<le_transform<S, TransformFn>>(m_source, m_transform_fn, m_skip_undefined, m_seed, m_type, m_column_names);
+      auto ret = std::make_shared<le_transform<S, TransformFn>>(m_source, m_transform_fn, m_skip_undefined, m_seed, m_type, m_column_names);
+      ret->set_batch_transform_fn(m_custom_batch_transform_fn);
+      return ret;
     } else {
       return std::make_shared<le_transform<S, TransformFn>>(m_source, m_lambda, m_skip_undefined, m_seed, m_type, m_column_names);
     }
@@ -1008,6 +1307,7 @@ private:
   std::shared_ptr<parallel_iterator<S>> m_source_iterator;
   TransformFn m_transform_fn;
   BatchTransformFn m_batch_transform_fn;
+  BatchTransformFn m_custom_batch_transform_fn;
   std::string m_lambda;
   bool m_skip_undefined = false;
   int m_seed;
@@ -1025,6 +1325,7 @@ private:
  public:
   typedef std::function<flexible_type(const flexible_type &, const flexible_type &)> VectorOpFn;
   typedef std::vector<flexible_type> VectorType;
+  typedef std::function<void(const VectorType&, const VectorType&, VectorType&)> BatchVectorOpFn;
 
   /**
    * Constructs a new parallel vector operator
@@ -1049,6 +1350,16 @@ private:
     m_type = type;
   }
 
+  /**
+   * Sets a function computing the vector operation over a whole batch of
+   * values at a time, used instead of calling the vector function on every
+   * pair of values. The batch function must compute the same results as the
+   * vector function.
+   */
+  void set_batch_vector_op_fn(BatchVectorOpFn batch_vector_op_fn) {
+    m_batch_vector_op_fn = batch_vector_op_fn;
+  }
+
   virtual flex_type_enum get_type() const {
     return m_type;
   }
@@ -1079,7 +1390,9 @@ private:
 
 protected:
   virtual std::shared_ptr<lazy_eval_op_base> clone() {
-    return std::make_shared<le_vector>(m_left, m_right, m_vector_op_fn, m_type);
+    auto ret = std::make_shared<le_vector>(m_left, m_right, m_vector_op_fn, m_type);
+    ret->set_batch_vector_op_fn(m_batch_vector_op_fn);
+    return ret;
   }
 
   virtual void start(size_t dop, const std::vector<size_t>& segment_sizes) {
@@ -1110,13 +1423,39 @@ protected:
     }
 
     logstream(LOG_DEBUG) << "thread: " << segment_index << ", vector operation getting from left " << left_items.size() << " items " << std::endl;
-    std::vector<flexible_type> output_items;
+    if (m_batch_vector_op_fn) {
+      std::vector<flexible_type> output_items(left_items.size());
+      m_batch_vector_op_fn(left_items, right_items, output_items);
+      return output_items;
+    }
     transform(left_items, right_items);
     logstream(LOG_DEBUG) << "thread: " << segment_index << ", done vector processing. " << std::endl;
 
     return left_items;
   }
 
+  virtual void get_next_batch(size_t segment_index, size_t num_items, column_batch& ret) {
+    column_batch left, right;
+    m_left_iterator->get_next_batch(segment_index, num_items, left);
+    m_right_iterator->get_next_batch(segment_index, num_items, right);
+
+    DASSERT_MSG(right.num_rows() == left.num_rows(), "There should be the same amount of items read from left and right for vector operation");
+
+    std::vector<flexible_type> output(left.num_rows());
+    if (m_batch_vector_op_fn) {
+      left.compact();
+      right.compact();
+      if (output.size() > 0) {
+        m_batch_vector_op_fn(left.get_column(0), right.get_column(0), output);
+      }
+    } else {
+      for (size_t i = 0; i < output.size(); ++i) {
+        output[i] = m_vector_op_fn(left.value(0, i), right.value(0, i));
+      }
+    }
+    ret.assign(std::move(output));
+  }
+
 private:
   // transform and do an inplace replace of left value
   void transform(VectorType& left, VectorType& right) {
@@ -1131,6 +1470,7 @@ private:
   std::unique_ptr<parallel_iterator<flexible_type>> m_left_iterator;
   std::unique_ptr<parallel_iterator<flexible_type>> m_right_iterator;
   VectorOpFn m_vector_op_fn;
+  BatchVectorOpFn m_batch_vector_op_fn;
 };
 
 /** This class implements a "filter" operator that would lazily evaluate
@@ -1202,7 +1542,7 @@ protected:
    virtual void start(size_t dop, const std::vector<size_t>& segment_sizes) {
     m_left_iterator = parallel_iterator<T>::create(m_left, dop, segment_sizes);
     m_right_iterator = parallel_iterator<flexible_type>::create(m_right, dop, segment_sizes);
-    m_left_over_items = std::vector<std::vector<T>>(dop);
+    m_left_over_items = std::vector<column_batch>(dop);
   }
 
   virtual void stop() {
@@ -1212,91 +1552,88 @@ protected:
   }
 
   virtual size_t skip_rows(size_t segment_index, size_t num_items) {
-    size_t items_skipped = 0;
-
-    size_t left_over_item_count = m_left_over_items[segment_index].size();
-    if (left_over_item_count > 0) {
-      size_t items_to_skip = std::min(num_items, left_over_item_count);
-
-      m_left_over_items.erase(m_left_over_items.begin(), std::next(m_left_over_items.begin(), items_to_skip));
-      DASSERT_TRUE(m_left_over_items.size() == left_over_item_count - items_to_skip);
-
-      items_skipped = items_to_skip;
-    }
+    column_batch& left_over = m_left_over_items[segment_index];
+    size_t items_skipped = std::min(num_items, left_over.num_rows());
+    left_over.drop_front(items_skipped);
 
+    column_batch left_items;
+    column_batch right_items;
+    std::vector<size_t> selected;
     while (items_skipped < num_items) {
-      std::vector<flexible_type> right_items = m_right_iterator->get_next(segment_index, num_items);
-      if (right_items.size() == 0) break;
+      m_right_iterator->get_next_batch(segment_index, num_items, right_items);
+      if (right_items.num_rows() == 0) break;
 
-      // delay reading of left items untill we see any non-zero value
-      std::vector<T> left_items;
-      for(size_t i = 0; i < right_items.size(); i++) {
-        if (!right_items[i].is_zero()) {
-          if (items_skipped == num_items) {
-            if (left_items.size() == 0) { // fulfill delay read left side rows
-              left_items = m_left_iterator->get_next(segment_index, right_items.size());
-              DASSERT_TRUE(left_items.size() == right_items.size());
-            }
-            m_left_over_items[segment_index].push_back(left_items[i]);
-          } else {
-            items_skipped++;
-          }
-        }
+      selected.clear();
+      for(size_t i = 0; i < right_items.num_rows(); i++) {
+        if (!right_items.value(0, i).is_zero()) selected.push_back(i);
       }
 
-      // skip left side rows if all rows are skipped
-      if (left_items.size() == 0) {
-        m_left_iterator->skip_rows(segment_index, right_items.size());
+      size_t items_needed = num_items - items_skipped;
+      if (selected.size() <= items_needed) {
+        // every selected row is skipped: do not read the left side
+        size_t num_skipped = m_left_iterator->skip_rows(segment_index, right_items.num_rows());
+        DASSERT_EQ(num_skipped, right_items.num_rows());
+        items_skipped += selected.size();
+        continue;
       }
-    }
 
+      // Only read the left side for the batch holding the left over rows.
+      // It is read whole: operators with several consumers must be read
+      // in the same steps by all of them.
+      m_left_iterator->get_next_batch(segment_index, right_items.num_rows(), left_items);
+      DASSERT_EQ(left_items.num_rows(), right_items.num_rows());
+      left_items.select(std::vector<size_t>(selected.begin() + items_needed,
+                                            selected.end()));
+      DASSERT_EQ(left_over.num_rows(), 0);
+      left_over = std::move(left_items);
+      items_skipped = num_items;
+    }
     return items_skipped;
   }
 
   virtual std::vector<T> get_next(size_t segment_index, size_t num_items) {
-    std::vector<T> output_items(num_items);
-    size_t items_got = 0;
+    column_batch batch;
+    get_next_batch(segment_index, num_items, batch);
+    std::vector<T> output_items;
+    batch.move_to(output_items);
+    return output_items;
+  }
 
+  virtual void get_next_batch(size_t segment_index, size_t num_items, column_batch& ret) {
     // Move existing items to output if any
-    size_t left_over_item_count = m_left_over_items[segment_index].size();
-    if (left_over_item_count > 0) {
-      size_t items_to_move = std::min(num_items, left_over_item_count);
-      this->move_items(m_left_over_items[segment_index], output_items, items_to_move);
-      DASSERT_TRUE(m_left_over_items[segment_index].size() == left_over_item_count - items_to_move);
-      items_got = items_to_move;
-    }
-
-    while(items_got < num_items) {
-      std::vector<flexible_type> right_items = m_right_iterator->get_next(segment_index, num_items);
-      if (right_items.size() == 0) break;
-
-      std::vector<T> left_items;
-      for(size_t i = 0; i < right_items.size(); i++) {
-        if (!right_items[i].is_zero()) {
-          // delay reading let side
-          if (left_items.size() == 0) {
-            left_items = m_left_iterator->get_next(segment_index, right_items.size());
-            DASSERT_EQ(left_items.size(), right_items.size());
-          }
-
-          if (items_got == num_items) {
-            m_left_over_items[segment_index].push_back(left_items[i]);
-          } else {
-            output_items[items_got] = left_items[i];
-            items_got++;
-          }
-        }
+    ret.clear();
+    ret.append(m_left_over_items[segment_index], num_items);
+
+    column_batch left_items;
+    column_batch right_items;
+    std::vector<size_t> selected;
+    while(ret.num_rows() < num_items) {
+      m_right_iterator->get_next_batch(segment_index, num_items, right_items);
+      if (right_items.num_rows() == 0) break;
+
+      selected.clear();
+      for(size_t i = 0; i < right_items.num_rows(); i++) {
+        if (!right_items.value(0, i).is_zero()) selected.push_back(i);
       }
 
-      if (left_items.size() == 0) {
-        size_t num_skipped = m_left_iterator->skip_rows(segment_index, right_items.size());
-        DASSERT_EQ(num_skipped, right_items.size());
+      // do not read the left side if nothing is selected
+      if (selected.empty()) {
+        size_t num_skipped = m_left_iterator->skip_rows(segment_index, right_items.num_rows());
+        DASSERT_EQ(num_skipped, right_items.num_rows());
+        continue;
       }
-    }
 
-    output_items.resize(items_got);
+      // narrow the selection of the left side instead of copying the rows
+      m_left_iterator->get_next_batch(segment_index, right_items.num_rows(), left_items);
+      DASSERT_EQ(left_items.num_rows(), right_items.num_rows());
+      left_items.select(selected);
 
-    return output_items;
+      ret.append(left_items, num_items - ret.num_rows());
+      if (left_items.num_rows() > 0) {
+        DASSERT_EQ(m_left_over_items[segment_index].num_rows(), 0);
+        m_left_over_items[segment_index] = std::move(left_items);
+      }
+    }
   }
 
 private:
@@ -1305,7 +1642,7 @@ private:
   std::shared_ptr<lazy_eval_op_imp_base<flexible_type>> m_right;
   std::unique_ptr<parallel_iterator<T>> m_left_iterator;
   std::unique_ptr<parallel_iterator<flexible_type>> m_right_iterator;
-  std::vector<std::vector<T>> m_left_over_items; // left over items from previous chunk read, one list for each chunk
+  std::vector<column_batch> m_left_over_items; // left over items from previous chunk read, one batch for each chunk
 };
 
 /**
@@ -183,6 +183,9 @@ sframe lazy_groupby_aggregate(const lazy_sframe& source,
 
     container.define_group(column_numbers, group.second);
   }
+  if (container.use_typed_aggregation(num_keys, frame_with_relevant_cols->column_types())) {
+    logstream(LOG_INFO) << "Using typed group aggregation" << std::endl;
+  }
   // done. now we can begin parallel processing
 
   // shuffle the rows based on the value of the key column.
@@ -191,14 +194,17 @@ sframe lazy_groupby_aggregate(const lazy_sframe& source,
   logstream(LOG_INFO) << "Filling group container: " << std::endl;
   parallel_for (0, thread::cpu_count(),
                 [&](size_t i) {
+                  groupby_aggregate_impl::group_aggregate_container::local_buffer
+                      buffer(container, num_keys);
                   std::vector<std::vector<flexible_type> > rows;
                   while(1) {
                     rows = input_reader->get_next(i, graphlab::sframe_config::SFRAME_READ_BATCH_SIZE);
                     if (rows.size() == 0) break;
                     for (auto& row: rows) {
-                      container.add(row, num_keys);
+                      buffer.add(row);
                     }
                   }
+                  buffer.flush();
                 });
 
   logstream(LOG_INFO) << "Group container filled in " << ti.current_time() << std::endl;
@@ -319,7 +319,12 @@ private:
   }
 
   void sort_one_chunk(std::vector<std::vector<flexible_type>>& rows) {
-    std::sort(rows.begin(), rows.end(), sframe_sort_impl::less_than_partial_function(m_sort_column_indexes, m_sort_orders));
+    std::vector<flex_type_enum> sort_column_types;
+    for (size_t column_idx: m_sort_column_indexes) {
+      sort_column_types.push_back(m_column_types[column_idx]);
+    }
+    sframe_sort_impl::sort_rows(rows,
+        sframe_sort_impl::sort_key_encoder(m_sort_column_indexes, m_sort_orders, sort_column_types));
   }
 
   std::vector<std::string> m_column_names;
@@ -66,10 +66,10 @@ namespace graphlab {
     }
 
     // This is a collection of partition keys sorted in the required order.
-    // Each key is a flex_list value that contains the spliting value for
-    // each sort column. Together they defines the "cut line" for all rows in
-    // the SFrame.
-    std::vector<flexible_type> partition_keys;
+    // Each key is the encoded spliting value of the sort columns (see
+    // sframe_sort_impl::sort_key_encoder). Together they defines the
+    // "cut line" for all rows in the SFrame.
+    std::vector<std::string> partition_keys;
 
 
     // Do a quantile sketch on the sort columns to figure out the "splitting" points
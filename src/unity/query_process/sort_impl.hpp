@@ -18,6 +18,9 @@
 #ifndef GRAPHLAB_UNITY_SFRAME_SORT_IMPL
 #define GRAPHLAB_UNITY_SFRAME_SORT_IMPL
 
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <functional>
 #include <algorithm>
 #include <parallel/thread_pool.hpp>
@@ -32,67 +35,10 @@ namespace graphlab {
 
 namespace sframe_sort_impl {
 
-/**
-* Comparator that compares two flex_list value with given ascending/descending
-* order. Order value "true" means ascending, "false" means descending
-* it compares all values in the two flex_list types
-**/
-struct less_than_full_function
-{
-  less_than_full_function() {};
-  less_than_full_function(const std::vector<bool>& sort_orders):
-    m_sort_orders(sort_orders)
-  {}
-
-  inline bool operator() (const flexible_type& v1, const flexible_type& v2) const
-  {
-    DASSERT_TRUE(v1.get_type() == flex_type_enum::LIST);
-    DASSERT_TRUE(v2.get_type() == flex_type_enum::LIST);
-
-    const flex_list& v1_v = v1.get<flex_list>();
-    const flex_list& v2_v = v2.get<flex_list>();
-    return compare(v1_v, v2_v);
-  }
-
-
-  inline bool operator() (const std::vector<flexible_type>& v1, const std::vector<flexible_type>& v2) const {
-    return compare(v1, v2);
-  }
-
-  inline bool compare(const std::vector<flexible_type>& v1, const std::vector<flexible_type>& v2) const {
-    DASSERT_TRUE(v1.size() == v2.size());
-    DASSERT_TRUE(v1.size() == m_sort_orders.size());
-
-    for(size_t i = 0; i < m_sort_orders.size(); i++) {
-      bool ascending = m_sort_orders[i];
-
-      if (v1[i] == FLEX_UNDEFINED) {
-        if (v2[i] == FLEX_UNDEFINED) {
-          continue;  // equal
-        } else {
-          return ascending;
-        }
-      }
-
-      if (v2[i] == FLEX_UNDEFINED) {
-        return !ascending;
-      }
-
-      if (v1[i] < v2[i]) return ascending;
-      if (v1[i] > v2[i]) return !ascending;
-    }
-
-    return false;
-  }
-
-  std::vector<bool> m_sort_orders;
-};
-
 /**
 * Comparator that compares two flex_list value with given ascending/descending
 * order and given sort columns.
-* This is different from above in that it is only comparing part of the columns
-* in the value, not all the values
+* It is only comparing part of the columns in the value, not all the values
 * Order value "true" means ascending, "false" means descending
 **/
 struct less_than_partial_function
@@ -132,18 +78,213 @@ struct less_than_partial_function
   std::vector<bool> m_sort_orders;
 };
 
+/**
+ * Encodes the sort columns of a row into a single byte string such that
+ * comparing the strings of two rows byte by byte (memcmp, or std::string
+ * comparison) orders the rows exactly like \ref less_than_partial_function.
+ * Sorting on the encoded keys avoids re-dispatching on the value types and
+ * sort orders in every comparison.
+ *
+ * Each column is encoded as a tag byte (undefined values sort before all
+ * others) followed by:
+ *  - INTEGER and DATETIME: the 64 bit value with the sign bit flipped,
+ *    big endian. DATETIME compares on the posix timestamp only.
+ *  - FLOAT: the IEEE bits with the sign bit flipped for positive numbers and
+ *    all bits flipped for negative numbers, big endian. -0.0 is encoded as
+ *    0.0 and all NaNs as one NaN (which sorts after +inf).
+ *  - STRING: the bytes, with 0x00 escaped as 0x00 0xFF, terminated by
+ *    0x00 0x00 so that a string sorts before the strings it prefixes.
+ * All the bytes of a descending column, including its tag, are inverted.
+ *
+ * The encoding depends on the column type: integers in a FLOAT column are
+ * encoded as floats. Any other value whose type differs from its column
+ * type is an error.
+ */
+class sort_key_encoder {
+ public:
+  /**
+   * \param sort_columns The indexes of the sort columns in the rows
+   * \param sort_orders The order of each sort column, true means ascending
+   * \param column_types The type of each sort column
+   */
+  sort_key_encoder(const std::vector<size_t>& sort_columns,
+                   const std::vector<bool>& sort_orders,
+                   const std::vector<flex_type_enum>& column_types)
+    : m_sort_columns(sort_columns), m_sort_orders(sort_orders),
+      m_column_types(column_types) {
+    ASSERT_EQ(sort_orders.size(), sort_columns.size());
+    ASSERT_EQ(column_types.size(), sort_columns.size());
+  }
+
+  /// Appends the encoded key of a row to out
+  void encode(const std::vector<flexible_type>& row, std::string& out) const {
+    for (size_t i = 0; i < m_sort_columns.size(); ++i) {
+      DASSERT_LT(m_sort_columns[i], row.size());
+      size_t begin = out.size();
+      encode_value(row[m_sort_columns[i]], m_column_types[i], out);
+      if (!m_sort_orders[i]) {
+        for (size_t j = begin; j < out.size(); ++j) out[j] = ~out[j];
+      }
+    }
+  }
+
+  /// Returns the encoded key of a row
+  std::string encode(const std::vector<flexible_type>& row) const {
+    std::string ret;
+    encode(row, ret);
+    return ret;
+  }
+
+ private:
+  static inline void append_uint64(uint64_t value, std::string& out) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      out.push_back(char((value >> shift) & 0xFF));
+    }
+  }
+
+  static inline void append_int64(int64_t value, std::string& out) {
+    append_uint64(uint64_t(value) ^ (uint64_t(1) << 63), out);
+  }
+
+  static inline void append_double(double value, std::string& out) {
+    if (value == 0) value = 0;  // -0.0 compares equal to 0.0
+    if (std::isnan(value)) value = std::numeric_limits<double>::quiet_NaN();
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (bits & (uint64_t(1) << 63)) bits = ~bits;
+    else bits ^= (uint64_t(1) << 63);
+    append_uint64(bits, out);
+  }
+
+  static inline void append_string(const flex_string& value, std::string& out) {
+    for (char c: value) {
+      out.push_back(c);
+      if (c == 0) out.push_back(char(0xFF));
+    }
+    out.push_back(0);
+    out.push_back(0);
+  }
+
+  static void encode_value(const flexible_type& value,
+                           flex_type_enum column_type,
+                           std::string& out) {
+    if (value.get_type() == flex_type_enum::UNDEFINED) {
+      out.push_back(0);
+      return;
+    }
+    out.push_back(1);
+    switch(value.get_type()) {
+     case flex_type_enum::INTEGER:
+       if (column_type == flex_type_enum::FLOAT) {
+         append_double(value.get<flex_int>(), out);
+         return;
+       } else if (column_type == flex_type_enum::INTEGER) {
+         append_int64(value.get<flex_int>(), out);
+         return;
+       }
+       break;
+     case flex_type_enum::FLOAT:
+       if (column_type == flex_type_enum::FLOAT) {
+         append_double(value.get<flex_float>(), out);
+         return;
+       }
+       break;
+     case flex_type_enum::DATETIME:
+       if (column_type == flex_type_enum::DATETIME) {
+         append_int64(value.get<flex_date_time>().posix_timestamp(), out);
+         return;
+       }
+       break;
+     case flex_type_enum::STRING:
+       if (column_type == flex_type_enum::STRING) {
+         append_string(value.get<flex_string>(), out);
+         return;
+       }
+       break;
+     default:
+       break;
+    }
+    log_and_throw(std::string("Cannot sort value of type ") +
+                  flex_type_enum_to_name(value.get_type()) +
+                  " in a column of type " +
+                  flex_type_enum_to_name(column_type));
+  }
+
+  std::vector<size_t> m_sort_columns;
+  std::vector<bool> m_sort_orders;
+  std::vector<flex_type_enum> m_column_types;
+};
+
+/**
+ * Sorts rows on the keys produced by a \ref sort_key_encoder.
+ *
+ * The keys of all the rows are encoded once into a single buffer. The sort
+ * then moves around (prefix, row) pairs, where the prefix holds the first 8
+ * bytes of the key, and only compares the rest of the keys with memcmp when
+ * the prefixes are equal.
+ */
+inline void sort_rows(std::vector<std::vector<flexible_type>>& rows,
+                      const sort_key_encoder& encoder) {
+  size_t num_rows = rows.size();
+  std::string keys;
+  std::vector<size_t> key_offsets(num_rows + 1);
+  for (size_t i = 0; i < num_rows; ++i) {
+    key_offsets[i] = keys.size();
+    encoder.encode(rows[i], keys);
+  }
+  key_offsets[num_rows] = keys.size();
+
+  struct entry {
+    uint64_t prefix;
+    size_t row;
+  };
+  std::vector<entry> entries(num_rows);
+  for (size_t i = 0; i < num_rows; ++i) {
+    uint64_t prefix = 0;
+    size_t len = std::min<size_t>(8, key_offsets[i + 1] - key_offsets[i]);
+    for (size_t j = 0; j < 8; ++j) {
+      unsigned char c = j < len ? (unsigned char)keys[key_offsets[i] + j] : 0;
+      prefix = (prefix << 8) | c;
+    }
+    entries[i] = entry{prefix, i};
+  }
+
+  const char* key_data = keys.data();
+  std::sort(entries.begin(), entries.end(),
+            [&](const entry& a, const entry& b) {
+              if (a.prefix != b.prefix) return a.prefix < b.prefix;
+              size_t a_len = key_offsets[a.row + 1] - key_offsets[a.row];
+              size_t b_len = key_offsets[b.row + 1] - key_offsets[b.row];
+              if (a_len <= 8 || b_len <= 8) return a_len < b_len;
+              int c = memcmp(key_data + key_offsets[a.row] + 8,
+                             key_data + key_offsets[b.row] + 8,
+                             std::min(a_len, b_len) - 8);
+              if (c != 0) return c < 0;
+              return a_len < b_len;
+            });
+
+  std::vector<std::vector<flexible_type>> sorted(num_rows);
+  for (size_t i = 0; i < num_rows; ++i) {
+    sorted[i] = std::move(rows[entries[i].row]);
+  }
+  rows.swap(sorted);
+}
+
 /**
 ** Create a quantile sketch for the key columns so that we can decide how to partition
-   the sframe
+   the sframe. The sketch is over the keys encoded by \ref sort_key_encoder.
 **/
-std::shared_ptr<sketches::streaming_quantile_sketch<flexible_type, less_than_full_function>>
+std::shared_ptr<sketches::streaming_quantile_sketch<std::string, std::less<std::string>>>
 create_quantile_sketch(
   std::shared_ptr<lazy_sframe>&   sframe_ptr,
   const std::vector<bool>&        sort_orders ) {
 
+  typedef sketches::streaming_quantile_sketch<std::string, std::less<std::string>> sketch_type;
+  auto global_quantiles = std::make_shared<sketch_type>(0.005);
 
-  auto comparator =  less_than_full_function(sort_orders);
-  auto global_quantiles = std::make_shared<sketches::streaming_quantile_sketch<flexible_type, less_than_full_function>>(0.005, comparator);
+  std::vector<size_t> key_columns(sort_orders.size());
+  for (size_t i = 0; i < key_columns.size(); ++i) key_columns[i] = i;
+  sort_key_encoder encoder(key_columns, sort_orders, sframe_ptr->column_types());
 
   graphlab::mutex lock;
   size_t dop = thread::cpu_count();
@@ -173,8 +314,8 @@ create_quantile_sketch(
   parallel_for(0, dop,
      [&](size_t idx) {
         size_t elements_sampled = 0;
-        std::shared_ptr<sketches::streaming_quantile_sketch<flexible_type, less_than_full_function>> quantiles;
-        quantiles.reset(new sketches::streaming_quantile_sketch<flexible_type, less_than_full_function>(0.005, comparator));
+        std::shared_ptr<sketch_type> quantiles;
+        quantiles.reset(new sketch_type(0.005));
 
         while(true) {
           std::vector<std::vector<flexible_type> > items
@@ -184,7 +325,7 @@ create_quantile_sketch(
 
           elements_sampled += items.size();
           for(auto& val: items) {
-            quantiles->add(std::move(val));
+            quantiles->add(encoder.encode(val));
           }
         }
 
@@ -205,30 +346,28 @@ create_quantile_sketch(
 * The way to do this is to do a sketch summary over the sorted columns, find the
 * quantile keys for each incremental quantile and use that key as "spliting point".
 
-* \param sframe_ptr The lazy sframe that needs to be sorted
+* \param sframe_ptr The lazy sframe that needs to be sorted, made of the sort
+*   columns only
 * \param sort_orders The sort order for the each sorted columns, true means ascending
 * \param num_partitions The number of partitions to partition the result to
-* \param[out] partition_keys The "pivot point". There will be num_partitions-1 of these.
-* \param[out] partition_sorted Indicates whether or not a given partition contains
-*   all the same key hence no need to sort later
+* \param[out] partition_keys The "pivot point", encoded by \ref sort_key_encoder.
+*   There will be num_partitions-1 of these.
 * \return true if all key values are the same(hence no need to sort), false otherwise
 **/
 bool get_partition_keys(
   std::shared_ptr<lazy_sframe>    sframe_ptr,
   const std::vector<bool>&        sort_orders,
   size_t                          num_partitions,
-  std::vector<flexible_type>&     partition_keys) {
+  std::vector<std::string>&       partition_keys) {
 
   auto quantiles = create_quantile_sketch(sframe_ptr, sort_orders);
 
   // figure out all the cutting place we need for the each partion by calculating
   // quantiles
   double quantile_unit = 1.0 / num_partitions;
-  flexible_type quantile_val;
 
   for (size_t i = 0;i < num_partitions - 1; ++i) {
-    quantile_val = quantiles->query_quantile((i + 1) * quantile_unit);
-    partition_keys.push_back(quantile_val);
+    partition_keys.push_back(quantiles->query_quantile((i + 1) * quantile_unit));
   }
   return false;
 }
@@ -245,7 +384,8 @@ bool get_partition_keys(
  * \param sframe_ptr The lazy sframe to be scatter partitioned
  * \param sort_columns The column indexes for all sorted columns
  * \param sort_orders The ascending/descending order for each sorting column
- * \param partition_keys The "spliting" point to partition the sframe
+ * \param partition_keys The "spliting" point to partition the sframe, encoded
+*   by \ref sort_key_encoder and in increasing order
 
  * \return a pointer to a persisted sarray object, the sarray stores serialized
  *   values of partitioned sframe, with values between segments relatively ordered
@@ -254,7 +394,7 @@ std::shared_ptr<sarray<std::string>> scatter_partition(
   const std::shared_ptr<lazy_sframe> sframe_ptr,
   const std::vector<size_t>& sort_columns,
   const std::vector<bool>& sort_orders,
-  const std::vector<flexible_type>& partition_keys,
+  const std::vector<std::string>& partition_keys,
   std::vector<size_t>& partition_sizes,
   std::vector<bool>& partition_sorted) {
 
@@ -276,47 +416,45 @@ std::shared_ptr<sarray<std::string>> scatter_partition(
   // Create a mutex for each partition
   std::vector<mutex> outiter_mutexes(num_partitions_keys);
   std::vector<mutex> sorted_mutexes(num_partitions_keys);
-  std::vector<flex_list> first_sort_key(num_partitions_keys);
+  std::vector<std::string> first_sort_key(num_partitions_keys);
   std::vector<size_t> partition_size_in_bytes(num_partitions_keys, 0);
   std::vector<size_t> partition_size_in_rows(num_partitions_keys, 0);
 
   // Iterate over each row of the given SFrame, compare against the partition key,
   // and write that row to the appropriate segment of the partitioned sframe_ptr
-  size_t num_keys = sort_orders.size();
   size_t dop = thread::cpu_count();
-  less_than_full_function less_than(sort_orders);
+  std::vector<flex_type_enum> sort_column_types;
+  for (size_t column_idx: sort_columns) {
+    sort_column_types.push_back(sframe_ptr->column_type(column_idx));
+  }
+  sort_key_encoder encoder(sort_columns, sort_orders, sort_column_types);
   auto parallel_iterator = sframe_ptr->get_iterator(dop);
 
   parallel_for(0, dop, [&](size_t segment_id) {
     oarchive oarc;
-    std::vector<flexible_type> sort_keys(sort_columns.size());
+    std::string sort_key;
     while(true) {
       auto items = parallel_iterator->get_next(segment_id, graphlab::DEFAULT_SARRAY_READER_BUFFER_SIZE);
       if (items.size() == 0) break;
 
       for(auto& item: items) {
         // extract sort key
-        for(size_t i = 0; i < num_keys; i++) {
-          sort_keys[i] = item[sort_columns[i]];
-        }
-
-        // find which partition the value belongs to
-        size_t partition_id = num_partitions_keys - 1;
-        for(size_t i = 0; i < partition_keys.size() ; i++) {
-          const flex_list& partition_key = partition_keys[i].get<flex_list>();
-          if((sort_keys == partition_key) || less_than(sort_keys, partition_key)) {
-            partition_id = i;
-            break;
-          }
-        }
+        sort_key.clear();
+        encoder.encode(item, sort_key);
+
+        // find which partition the value belongs to: the first one whose
+        // partition key is not less than the sort key
+        size_t partition_id =
+            std::lower_bound(partition_keys.begin(), partition_keys.end(), sort_key)
+            - partition_keys.begin();
         DASSERT_TRUE(partition_id < num_partitions_keys);
 
         sorted_mutexes[partition_id].lock();
         if(partition_sorted[partition_id]) {
           if(first_sort_key[partition_id].size() == 0) {
-            first_sort_key[partition_id] = sort_keys;
+            first_sort_key[partition_id] = sort_key;
           } else {
-            if(first_sort_key[partition_id] != sort_keys) {
+            if(first_sort_key[partition_id] != sort_key) {
               partition_sorted[partition_id] = false;
             }
           }
@@ -399,7 +537,11 @@ std::shared_ptr<sframe> sort_sframe_in_memory(
   auto rows = iter->get_next(0, num_rows);
   DASSERT_TRUE(rows.size() == num_rows);
 
-  std::sort(rows.begin(), rows.end(), less_than_partial_function(sort_columns, sort_orders));
+  std::vector<flex_type_enum> sort_column_types;
+  for (size_t column_idx: sort_columns) {
+    sort_column_types.push_back(sframe_ptr->column_type(column_idx));
+  }
+  sort_rows(rows, sort_key_encoder(sort_columns, sort_orders, sort_column_types));
 
   // persist to disk
   // Note: we could potentially keep this in meory but it may take too much
@@ -17,6 +17,7 @@
 #ifndef GRAPHLAB_UNITY_CONNECTED_COMPONENT
 #define GRAPHLAB_UNITY_CONNECTED_COMPONENT
 #include <unity/lib/toolkit_function_specification.hpp>
+#include <sgraph/sgraph.hpp>
 
 namespace graphlab {
 namespace connected_component {
@@ -42,6 +43,27 @@ namespace connected_component {
  */
 std::vector<toolkit_function_specification> get_toolkit_function_registration() ;
 
+/**
+ * Computes the connected components of the graph, and adds their ids to
+ * the vertices as the "component_id" column. The id of a component is the
+ * smallest internal vertex id of the component.
+ *
+ * Uses a union find when it fits in SGRAPH_UNION_FIND_CAPACITY,
+ * and label propagation otherwise. Both give the same ids.
+ *
+ * Returns an sframe with the id and the number of vertices of each
+ * component.
+ */
+sframe compute_connected_component(sgraph& g);
+
+/**
+ * Computes the "component_id" column of the vertices by label
+ * propagation. The number of passes over the edges grows with the
+ * diameter of the graph. Used by \ref compute_connected_component when
+ * the union find does not fit in memory.
+ */
+void compute_component_id_label_propagation(sgraph& g);
+
 } // namespace connected_component
 } // namespace graphlab
 #endif
@@ -21,28 +21,39 @@
 #include <unity/lib/unity_sframe.hpp>
 #include <metric/simple_metrics_service.hpp>
 #include <sgraph/sgraph_compute.hpp>
+#include <sgraph/sgraph_constants.hpp>
+#include <graphlab/util/union_find.hpp>
 #include <sframe/algorithm.hpp>
 #include <sframe/groupby_aggregate.hpp>
 #include <sframe/groupby_aggregate_operators.hpp>
 #include <table_printer/table_printer.hpp>
 #include <atomic>
+#include <limits>
 
 namespace graphlab {
 namespace connected_component {
 
 const std::string COMPONENT_ID_COLUMN = "component_id";
 
+/**
+ * Returns the global ids of the first vertex of each vertex partition,
+ * followed by the number of vertices. The vertex at row i of partition p
+ * has global id ret[p] + i.
+ */
+std::vector<size_t> vertex_partition_begin_ids(const sgraph& g) {
+  std::vector<size_t> beginids{0};
+  for (auto& sf: g.vertex_group()) {
+    beginids.push_back(beginids.back() + sf.size());
+  }
+  return beginids;
+}
+
 /**
  * Initialize a unique component id from 0 to N-1
  */
 void init_component_id(sgraph& g) {
   auto& vgroup = g.vertex_group();
-  std::vector<size_t> beginids{0};
-  size_t acc = 0;
-  for (auto& sf: vgroup) {
-    acc += sf.size();
-    beginids.push_back(acc);
-  }
+  std::vector<size_t> beginids = vertex_partition_begin_ids(g);
   parallel_for (0, vgroup.size(), [&](size_t partitionid) {
     size_t begin = beginids[partitionid];
     size_t end = beginids[partitionid+1];
@@ -62,8 +73,92 @@ void init_component_id(sgraph& g) {
 }
 
 /**
- * Compute connected component on the graph, add a new column to the vertex
- * with name "component_id".
+ * Returns true if the union find structures for the graph fit in
+ * SGRAPH_UNION_FIND_CAPACITY. They are allocated on their own, apart from
+ * the vertex blocks of triple_apply.
+ */
+bool can_use_union_find(const sgraph& g) {
+  size_t num_vertices = g.num_vertices();
+  // the union find parent array, plus the smallest vertex id per root
+  size_t bytes_per_vertex = sizeof(uint64_t) + sizeof(uint32_t);
+  return num_vertices < std::numeric_limits<uint32_t>::max() &&
+      num_vertices * bytes_per_vertex <= SGRAPH_UNION_FIND_CAPACITY;
+}
+
+/**
+ * Computes the component ids with a concurrent union find over the global
+ * vertex ids, and adds them as a new column to the vertices.
+ *
+ * One streaming pass over the source and target id columns of the edge
+ * partitions merges the endpoints of every edge, and one pass over the
+ * vertices writes out the component ids, whatever the diameter of the
+ * graph. As with label propagation, the component id is the smallest
+ * global vertex id of the component.
+ */
+void compute_component_id_union_find(sgraph& g) {
+  const size_t READ_BATCH_SIZE = 64 * 1024;
+  std::vector<size_t> beginids = vertex_partition_begin_ids(g);
+  size_t num_vertices = beginids.back();
+  size_t num_partitions = g.get_num_partitions();
+
+  concurrent_union_find uf;
+  uf.init(num_vertices);
+
+  // edge pass
+  parallel_for(0, num_partitions * num_partitions, [&](size_t edgepart) {
+    size_t src_partition = edgepart / num_partitions;
+    size_t dst_partition = edgepart % num_partitions;
+    const sframe& edges = g.edge_partition(src_partition, dst_partition);
+    auto src_reader = edges.select_column(sgraph::SRC_COLUMN_NAME)->get_reader();
+    auto dst_reader = edges.select_column(sgraph::DST_COLUMN_NAME)->get_reader();
+    std::vector<flexible_type> src_ids, dst_ids;
+    for (size_t row = 0; row < edges.size(); row += READ_BATCH_SIZE) {
+      size_t row_end = std::min(row + READ_BATCH_SIZE, edges.size());
+      src_reader->read_rows(row, row_end, src_ids);
+      dst_reader->read_rows(row, row_end, dst_ids);
+      for (size_t i = 0; i < src_ids.size(); ++i) {
+        uf.merge(beginids[src_partition] + src_ids[i].get<flex_int>(),
+                 beginids[dst_partition] + dst_ids[i].get<flex_int>());
+      }
+    }
+  });
+
+  if(cppipc::must_cancel()) {
+    log_and_throw(std::string("Toolkit cancelled by user."));
+  }
+
+  // the smallest vertex id of each component, stored at its root
+  std::vector<uint32_t> min_ids(num_vertices, std::numeric_limits<uint32_t>::max());
+  parallel_for(0, num_vertices, [&](size_t vid) {
+    uint32_t& min_id = min_ids[uf.find(vid)];
+    uint32_t cur = min_id;
+    while (vid < cur && !atomic_compare_and_swap(min_id, cur, (uint32_t)vid)) {
+      cur = min_id;
+    }
+  });
+
+  // vertex pass
+  auto& vgroup = g.vertex_group();
+  parallel_for (0, vgroup.size(), [&](size_t partitionid) {
+    std::shared_ptr<sarray<flexible_type>> id_column =
+        std::make_shared<sarray<flexible_type>>();
+    id_column->open_for_write(1);
+    id_column->set_type(flex_type_enum::INTEGER);
+    auto out = id_column->get_output_iterator(0);
+    for (size_t vid = beginids[partitionid]; vid < beginids[partitionid + 1]; ++vid) {
+      *out = (flex_int)min_ids[uf.find(vid)];
+      ++out;
+    }
+    id_column->close();
+    vgroup[partitionid] = vgroup[partitionid].add_column(id_column, COMPONENT_ID_COLUMN);
+  });
+  logprogress_stream << "Found connected components with union find in one edge pass"
+                     << std::endl;
+}
+
+/**
+ * Computes the component ids by label propagation, and adds them as a new
+ * column to the vertices.
  *
  * Algorithm is simple:
  * Init every vertex with the component_id = vertexid
@@ -71,15 +166,12 @@ void init_component_id(sgraph& g) {
  *  Each vertex repeatedly gather neighbors id and choose the min id.
  * }
  *
- * Returns an sframe with component id and component size information.
+ * The number of passes over the edges grows with the diameter of the
+ * graph, so this is only used when the union find does not fit in memory.
  */
-sframe compute_connected_component(sgraph& g) {
-  typedef sgraph_compute::sgraph_engine<flexible_type>::graph_data_type graph_data_type;
-  typedef sgraph::edge_direction edge_direction;
-
+void compute_component_id_label_propagation(sgraph& g) {
   init_component_id(g);
   std::atomic<long> num_changed;
-  sgraph_compute::sgraph_engine<flexible_type> ga;
 
   const size_t cid_idx = g.get_vertex_field_id(COMPONENT_ID_COLUMN);
 
@@ -111,6 +203,24 @@ sframe compute_connected_component(sgraph& g) {
   }
 
   table.print_footer();
+}
+
+/**
+ * Compute connected component on the graph, add a new column to the vertex
+ * with name "component_id".
+ *
+ * Uses a union find when it fits in memory, and label propagation
+ * otherwise.
+ *
+ * Returns an sframe with component id and component size information.
+ */
+sframe compute_connected_component(sgraph& g) {
+  if (can_use_union_find(g)) {
+    compute_component_id_union_find(g);
+  } else {
+    compute_component_id_label_propagation(g);
+  }
+
   sframe component_info;
   if (g.get_vertices().size() > 0) {
    component_info = groupby_aggregate(std::move(g.get_vertices()),
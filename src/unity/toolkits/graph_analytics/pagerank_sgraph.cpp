@@ -53,47 +53,37 @@ namespace graphlab {
   }
 
 void triple_apply_pagerank(sgraph& g, size_t& num_iter, double& total_pagerank, double& total_delta) {
-  typedef sgraph_compute::sgraph_engine<flexible_type>::graph_data_type graph_data_type;
-  typedef sgraph::edge_direction edge_direction;
-
   // initialize every vertex with core id kmin
   g.init_vertex_field(PAGERANK_COLUMN, reset_probability);
   g.init_vertex_field(PREV_PAGERANK_COLUMN, 1.0);
   g.init_vertex_field(DELTA_COLUMN, 0.0);
 
   // Initialize degree count
-  sgraph_compute::sgraph_engine<flexible_type> ga;
-  auto degrees = ga.gather(
-          g,
-          [=](const graph_data_type& center,
-              const graph_data_type& edge,
-              const graph_data_type& other,
-              edge_direction edgedir,
-              flexible_type& combiner) {
-              combiner += 1;
-          },
-          flexible_type(0),
-          edge_direction::OUT_EDGE);
-  g.add_vertex_field(degrees, OUT_DEGREE_COLUMN);
+  g.init_vertex_field(OUT_DEGREE_COLUMN, flex_int(0));
+  sgraph_compute::typed_triple_apply(
+      g,
+      [](sgraph_compute::typed_edge_scope& scope) {
+        scope.add_to_source(0, 1);
+      },
+      {OUT_DEGREE_COLUMN}, {OUT_DEGREE_COLUMN});
 
   num_iter = 0;
   total_delta = 0.0;
   total_pagerank = 0.0;
   timer mytimer;
 
-  // Triple apply
+  // Triple apply over the typed pagerank, prev_pagerank and out_degree
+  // fields, summing into pagerank with atomic adds.
   double w = (1 - reset_probability);
-  const size_t degree_idx = g.get_vertex_field_id(OUT_DEGREE_COLUMN);
+  const std::vector<std::string> typed_fields{PAGERANK_COLUMN, PREV_PAGERANK_COLUMN,
+                                              OUT_DEGREE_COLUMN};
   const size_t pr_idx = g.get_vertex_field_id(PAGERANK_COLUMN);
   const size_t old_pr_idx = g.get_vertex_field_id(PREV_PAGERANK_COLUMN);
 
-  sgraph_compute::triple_apply_fn_type apply_fn =
-    [&](sgraph_compute::edge_scope& scope) {
-      auto& source = scope.source();
-      auto& target = scope.target();
-      scope.lock_vertices();
-      target[pr_idx] += w * source[old_pr_idx] / source[degree_idx];
-      scope.unlock_vertices();
+  sgraph_compute::typed_triple_apply_fn_type apply_fn =
+    [&](sgraph_compute::typed_edge_scope& scope) {
+      // fields 0, 1, 2 are pagerank, prev_pagerank and out_degree
+      scope.add_to_target(0, w * scope.source_float(1) / scope.source_float(2));
     };
 
   table_printer table({{"Iteration", 0}, 
@@ -110,7 +100,7 @@ void triple_apply_pagerank(sgraph& g, size_t& num_iter, double& total_pagerank,
 
     g.init_vertex_field(PAGERANK_COLUMN, reset_probability);
 
-    sgraph_compute::triple_apply(g, apply_fn, {PAGERANK_COLUMN});
+    sgraph_compute::typed_triple_apply(g, apply_fn, typed_fields, {PAGERANK_COLUMN});
 
     // compute the change in pagerank
     auto delta = sgraph_compute::vertex_apply(
@@ -114,6 +114,10 @@ void check_and_init_graph(sgraph& g) {
 /**
  *  Computes the shortest path distance from all vertices to the source vertex using triple_apply model
  *  Add a new column named DISTANCE_COLUMN to the vertex data.
+ *
+ *  Only the out edges of the vertices whose distance changed in the
+ *  previous iteration are relaxed, so the late iterations only visit the
+ *  few edges around the vertices still changing.
  */
 
 void triple_apply_sssp(sgraph& g) {
@@ -133,10 +137,16 @@ void triple_apply_sssp(sgraph& g) {
 
       if(src_cid + weight < dst_cid)  {
         scope.target()[dist_idx] = src_cid + weight;
+        scope.activate_target();
         ++num_changed;
       }
    };
 
+  // vertices whose distance changed in the last iteration.
+  // Initially, all the vertices.
+  sgraph_compute::vertex_frontier frontier(g), next_frontier(g);
+  frontier.activate_all();
+
   table_printer table({{"Number of vertices updated", 0}});
   table.print_header();
   while(true){
@@ -144,7 +154,11 @@ void triple_apply_sssp(sgraph& g) {
       log_and_throw(std::string("Toolkit cancelled by user."));
     }
     num_changed = 0;
-    sgraph_compute::triple_apply(g, relax_edge_fn, {DISTANCE_COLUMN});
+    next_frontier.clear();
+    sgraph_compute::triple_apply(g, relax_edge_fn, {DISTANCE_COLUMN}, {},
+                                 frontier, edge_direction::OUT_EDGE,
+                                 &next_frontier);
+    frontier.swap(next_frontier);
 
     table.print_row(num_changed.load());
     if (num_changed == 0) {
@@ -0,0 +1,111 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <sframe/integer_pack.hpp>
+#include <serialization/serialization_includes.hpp>
+#include <timer/timer.hpp>
+using namespace graphlab;
+using namespace integer_pack;
+
+/*
+ * Reports the decode throughput of the integer_pack kernels for every
+ * bit width, at every kernel level supported by this CPU.
+ * Throughput is measured in GB/s of decoded 64-bit output.
+ */
+
+static const size_t NUM_VALUES = 128;
+
+static double bench_unpack(size_t nbits, size_t iterations) {
+  std::vector<uint8_t> pack(NUM_VALUES * 8);
+  for (size_t i = 0;i < pack.size(); ++i) pack[i] = (i * 97) % 256;
+  uint64_t out[NUM_VALUES];
+  uint64_t checksum = 0;
+  timer ti;
+  ti.start();
+  for (size_t i = 0;i < iterations; ++i) {
+    switch(nbits) {
+     case 1: unpack_1(pack.data(), NUM_VALUES, out); break;
+     case 2: unpack_2(pack.data(), NUM_VALUES, out); break;
+     case 4: unpack_4(pack.data(), NUM_VALUES, out); break;
+     case 8: unpack_8(pack.data(), NUM_VALUES, out); break;
+     case 16: unpack_16((uint16_t*)pack.data(), NUM_VALUES, out); break;
+     case 32: unpack_32((uint32_t*)pack.data(), NUM_VALUES, out); break;
+    }
+    checksum += out[i % NUM_VALUES];
+  }
+  double t = ti.current_time();
+  if (checksum == 1) std::cout << "";
+  return (double)(iterations * NUM_VALUES * sizeof(uint64_t)) / t / 1e9;
+}
+
+static double bench_frame_of_reference(size_t nbits,
+                                       bool delta,
+                                       size_t iterations) {
+  // generate a sequence which codes at the requested bit width
+  uint64_t in[NUM_VALUES];
+  uint64_t mask = nbits == 64 ? (uint64_t)(-1) : (((uint64_t)1 << nbits) - 1);
+  uint64_t v = 0;
+  for (size_t i = 0;i < NUM_VALUES; ++i) {
+    uint64_t r = (i * 2654435761ULL) & mask;
+    if (delta) v += r;
+    else v = r;
+    in[i] = v;
+  }
+  oarchive oarc;
+  frame_of_reference_encode_128(in, NUM_VALUES, oarc);
+  uint64_t out[NUM_VALUES];
+  uint64_t checksum = 0;
+  timer ti;
+  ti.start();
+  for (size_t i = 0;i < iterations; ++i) {
+    iarchive iarc(oarc.buf, oarc.off);
+    frame_of_reference_decode_128(iarc, NUM_VALUES, out);
+    checksum += out[i % NUM_VALUES];
+  }
+  double t = ti.current_time();
+  free(oarc.buf);
+  if (checksum == 1) std::cout << "";
+  return (double)(iterations * NUM_VALUES * sizeof(uint64_t)) / t / 1e9;
+}
+
+int main(int argc, char** argv) {
+  size_t iterations = 1000000;
+  if (argc > 1) iterations = atol(argv[1]);
+  std::cout << "Usage: " << argv[0] << " [iterations per measurement]\n";
+  std::cout << "Best supported level: "
+            << simd_level_name(get_max_simd_level()) << "\n\n";
+
+  for (int level = (int)simd_level::SCALAR;
+       level <= (int)get_max_simd_level(); ++level) {
+    set_simd_level((simd_level)level);
+    std::cout << "Kernel level: " << simd_level_name(get_simd_level()) << "\n";
+    for (size_t nbits = 1; nbits <= 32; nbits *= 2) {
+      std::cout << "  unpack_" << nbits << ": "
+                << bench_unpack(nbits, iterations) << " GB/s\n";
+    }
+    for (size_t nbits = 1; nbits <= 64; nbits *= 2) {
+      std::cout << "  frame_of_reference_decode_128 " << nbits << " bits: "
+                << bench_frame_of_reference(nbits, false, iterations)
+                << " GB/s, delta: "
+                << bench_frame_of_reference(nbits, true, iterations)
+                << " GB/s\n";
+    }
+    std::cout << "\n";
+  }
+}
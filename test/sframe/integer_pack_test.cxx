@@ -163,4 +163,44 @@ class integer_pack_test: public CxxTest::TestSuite {
       TS_ASSERT_EQUALS(i, i2);
     }
   }
+  void test_simd_kernels() {
+    // every kernel level must decode identically to the scalar kernels
+    simd_level old_level = get_simd_level();
+    uint8_t pack[128*8];
+    uint64_t expected[129], out[129];
+    for (int level = (int)simd_level::SCALAR; 
+         level <= (int)get_max_simd_level(); ++level) {
+      // the scalar unpackers require at least one value
+      for (size_t len = 1; len <= 128; ++len) {
+        for (size_t i = 0;i < sizeof(pack); ++i) pack[i] = (i * 97 + len) % 256;
+        for (size_t nbits = 1; nbits <= 32; nbits *= 2) {
+          for (int pass = 0; pass < 2; ++pass) {
+            set_simd_level(pass == 0 ? simd_level::SCALAR : (simd_level)level);
+            uint64_t* target = pass == 0 ? expected : out;
+            switch(nbits) {
+             case 1: unpack_1(pack, len, target); break;
+             case 2: unpack_2(pack, len, target); break;
+             case 4: unpack_4(pack, len, target); break;
+             case 8: unpack_8(pack, len, target); break;
+             case 16: unpack_16((uint16_t*)pack, len, target); break;
+             case 32: unpack_32((uint32_t*)pack, len, target); break;
+            }
+          }
+          for (size_t i = 0;i < len; ++i) TS_ASSERT_EQUALS(expected[i], out[i]);
+        }
+        for (int negative = 0; negative < 2; ++negative) {
+          for (int pass = 0; pass < 2; ++pass) {
+            set_simd_level(pass == 0 ? simd_level::SCALAR : (simd_level)level);
+            uint64_t* target = pass == 0 ? expected : out;
+            target[0] = 12345;
+            for (size_t i = 1;i <= len; ++i) target[i] = (i * 2654435761ULL) % 1000;
+            if (negative) delta_negative_decode(target + 1, len);
+            else delta_decode(target + 1, len);
+          }
+          for (size_t i = 0;i <= len; ++i) TS_ASSERT_EQUALS(expected[i], out[i]);
+        }
+      }
+    }
+    set_simd_level(old_level);
+  }
 };
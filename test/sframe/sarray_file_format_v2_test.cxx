@@ -19,6 +19,11 @@
 #include <sframe/sarray_v2_block_manager.hpp>
 #include <sframe/sarray_file_format_v2.hpp>
 #include <sframe/sarray_index_file.hpp>
+#include <sframe/sframe_constants.hpp>
+#include <sframe/sframe_config.hpp>
+#include <sframe/sarray_v2_block_cache.hpp>
+#include <globals/globals.hpp>
+#include <sframe/sarray_v2_type_encoding.hpp>
 #include <timer/timer.hpp>
 #include <random/random.hpp>
 
@@ -434,4 +439,354 @@ class sarray_file_format_v2_test: public CxxTest::TestSuite {
     }
   }
 
+  void test_block_statistics(void) {
+    // write a column of sorted integers with some undefined blocks, 
+    // and check that the statistics bound each block
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 4, 1);
+    size_t v = 0;
+    for (size_t i = 0;i < 4; ++i) {
+      for (size_t j = 0;j < 100000; ++j) {
+        if (i == 3) group_writer.write_segment(0, i, FLEX_UNDEFINED);
+        else group_writer.write_segment(0, i, v);
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    sarray_format_reader_v2<flexible_type> reader;
+    reader.open(test_file_name + ":0");
+    size_t row = 0;
+    size_t num_blocks = 0;
+    while (row < 400000) {
+      size_t block_start = 0, block_end = 0;
+      auto stats = reader.get_block_statistics(row, block_start, block_end);
+      TS_ASSERT(stats != NULL);
+      TS_ASSERT_EQUALS(block_start, row);
+      TS_ASSERT_LESS_THAN(block_start, block_end);
+      TS_ASSERT_EQUALS(stats->num_elem, block_end - block_start);
+      if (row >= 300000) {
+        TS_ASSERT_EQUALS(stats->num_undefined, stats->num_elem);
+        TS_ASSERT(!stats->has_bounds);
+      } else {
+        TS_ASSERT_EQUALS(stats->num_undefined, 0);
+        TS_ASSERT(stats->has_bounds);
+        TS_ASSERT_EQUALS((size_t)stats->min_value, block_start);
+        TS_ASSERT_EQUALS((size_t)stats->max_value, block_end - 1);
+      }
+      row = block_end;
+      ++num_blocks;
+    }
+    TS_ASSERT_EQUALS(row, 400000);
+    TS_ASSERT_LESS_THAN(4, num_blocks);
+  }
+
+  void test_mmap_read(void) {
+    // the mmap and stream read paths must return the same values
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 4, 1);
+    size_t v = 0;
+    for (size_t i = 0;i < 4; ++i) {
+      for (size_t j = 0;j < 100000; ++j) {
+        if (i % 2) group_writer.write_segment(0, i, std::to_string(v % 7));
+        else group_writer.write_segment(0, i, v * v);
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    size_t old_mmap_read = SFRAME_MMAP_READ;
+    for (size_t mmap_read = 0; mmap_read < 2; ++mmap_read) {
+      SFRAME_MMAP_READ = mmap_read;
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      // the segment is already open in the reader, so this shares its mapping
+      auto& manager = v2_block_impl::block_manager::get_instance();
+      auto column = manager.open_column(reader.get_index_info().segment_files[0]);
+      TS_ASSERT_EQUALS(manager.is_column_mapped(column), mmap_read == 1);
+      manager.close_column(column);
+      std::vector<flexible_type> vals;
+      TS_ASSERT_EQUALS(reader.read_rows(0, 400000, vals), 400000);
+      for (size_t i = 0;i < vals.size(); ++i) {
+        if ((i / 100000) % 2) {
+          TS_ASSERT_EQUALS(vals[i], flexible_type(std::to_string(i % 7)));
+        } else {
+          TS_ASSERT_EQUALS((size_t)vals[i], i * i);
+        }
+      }
+    }
+    SFRAME_MMAP_READ = old_mmap_read;
+  }
+
+  void test_block_cache(void) {
+    // repeated, compressible strings so the blocks are lz4 compressed and
+    // go through the cache even when the file is memory mapped
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 2, 1);
+    for (size_t i = 0;i < 2; ++i) {
+      for (size_t j = 0;j < 100000; ++j) {
+        group_writer.write_segment(0, i, std::string(50, 'a' + (j / 1000) % 26));
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    auto& cache = v2_block_impl::block_cache::get_instance();
+    size_t old_cache_size = sframe_config::SFRAME_BLOCK_CACHE_SIZE;
+    sframe_config::SFRAME_BLOCK_CACHE_SIZE = 64 * 1024 * 1024;
+    cache.clear();
+    auto read_all = [&]() {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      std::vector<flexible_type> vals;
+      TS_ASSERT_EQUALS(reader.read_rows(0, 200000, vals), 200000);
+      for (size_t i = 0;i < vals.size(); ++i) {
+        TS_ASSERT_EQUALS(vals[i].get<flex_string>(),
+                         std::string(50, 'a' + ((i % 100000) / 1000) % 26));
+      }
+    };
+    // first scan misses and fills the cache. The second scan, after the 
+    // segments were closed and reopened, hits
+    auto before = cache.get_statistics();
+    read_all();
+    auto after_first = cache.get_statistics();
+    TS_ASSERT_LESS_THAN(before.misses, after_first.misses);
+    TS_ASSERT_LESS_THAN(0, after_first.num_entries);
+    read_all();
+    auto after_second = cache.get_statistics();
+    TS_ASSERT_EQUALS(after_second.misses, after_first.misses);
+    TS_ASSERT_EQUALS(after_second.hits - after_first.hits, 
+                     after_first.misses - before.misses);
+
+    // a budget of half the column evicts as the scan proceeds
+    sframe_config::SFRAME_BLOCK_CACHE_SIZE = after_first.memory_usage / 2;
+    cache.clear();
+    read_all();
+    auto after_small = cache.get_statistics();
+    TS_ASSERT_LESS_THAN(after_second.evictions, after_small.evictions);
+    TS_ASSERT_LESS_THAN_EQUALS(after_small.memory_usage, 
+                               sframe_config::SFRAME_BLOCK_CACHE_SIZE);
+
+    // changing the global at runtime evicts right away, and 0 empties the
+    // cache
+    size_t small_budget = after_small.memory_usage / 2;
+    TS_ASSERT(globals::set_global("SFRAME_BLOCK_CACHE_SIZE", (flex_int)small_budget) ==
+              globals::set_global_error_codes::SUCCESS);
+    TS_ASSERT_EQUALS(sframe_config::SFRAME_BLOCK_CACHE_SIZE, small_budget);
+    TS_ASSERT_LESS_THAN_EQUALS(cache.get_statistics().memory_usage, small_budget);
+    TS_ASSERT(globals::set_global("SFRAME_BLOCK_CACHE_SIZE", 0) ==
+              globals::set_global_error_codes::SUCCESS);
+    TS_ASSERT_EQUALS(cache.get_statistics().num_entries, 0);
+    TS_ASSERT_EQUALS(cache.get_statistics().memory_usage, 0);
+    read_all();
+    TS_ASSERT_EQUALS(cache.get_statistics().num_entries, 0);
+
+    cache.clear();
+    sframe_config::SFRAME_BLOCK_CACHE_SIZE = old_cache_size;
+  }
+
+  void test_readahead(void) {
+    sarray_group_format_writer_v2<flexible_type> group_writer;
+    std::string test_file_name = get_temp_name() + ".sidx";
+    group_writer.open(test_file_name, 4, 1);
+    size_t v = 0;
+    for (size_t i = 0;i < 4; ++i) {
+      for (size_t j = 0;j < 200000; ++j) {
+        group_writer.write_segment(0, i, v);
+        ++v;
+      }
+    }
+    group_writer.close();
+    group_writer.write_index_file();
+
+    for (size_t depth: {0, 1, 4}) {
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      reader.set_readahead(depth);
+      // sequential scan in small pieces, with the odd random read mixed in
+      std::vector<flexible_type> vals;
+      for (size_t start = 0; start < 800000; start += 1000) {
+        TS_ASSERT_EQUALS(reader.read_rows(start, start + 1000, vals), 1000);
+        for (size_t k = 0; k < vals.size(); ++k) {
+          TS_ASSERT_EQUALS((size_t)vals[k], start + k);
+        }
+        if (start % 100000 == 0) {
+          size_t r = start / 2;
+          TS_ASSERT_EQUALS(reader.read_rows(r, r + 10, vals), 10);
+          TS_ASSERT_EQUALS((size_t)vals[9], r + 9);
+        }
+      }
+      // closing with reads in flight must be safe
+      reader.read_rows(0, 10, vals);
+    }
+
+    // readahead stops at the end of the range being read
+    sarray_format_reader_v2<flexible_type> reader;
+    reader.open(test_file_name + ":0");
+    TS_ASSERT_EQUALS(reader.readahead_range_end(0), 800000);
+    TS_ASSERT_EQUALS(reader.readahead_range_end(799999), 800000);
+    reader.set_readahead_range_ends({150000, 500000, 800000});
+    TS_ASSERT_EQUALS(reader.readahead_range_end(0), 150000);
+    TS_ASSERT_EQUALS(reader.readahead_range_end(149999), 150000);
+    TS_ASSERT_EQUALS(reader.readahead_range_end(150000), 500000);
+    TS_ASSERT_EQUALS(reader.readahead_range_end(799999), 800000);
+    reader.set_readahead(4);
+    // scan the ranges out of order
+    std::vector<flexible_type> vals;
+    for (auto range: std::vector<std::pair<size_t, size_t>>{{150000, 500000},
+                                                            {0, 150000},
+                                                            {500000, 800000}}) {
+      for (size_t start = range.first; start < range.second; start += 1000) {
+        size_t end = std::min(start + 1000, range.second);
+        TS_ASSERT_EQUALS(reader.read_rows(start, end, vals), end - start);
+        TS_ASSERT_EQUALS((size_t)vals[0], start);
+        TS_ASSERT_EQUALS((size_t)vals.back(), end - 1);
+      }
+    }
+  }
+
+  void test_compression_type(void) {
+    using v2_block_impl::block_compression_type;
+    // compressible, but not trivially so
+    std::vector<std::string> words{"alpha", "beta", "gamma", "delta", 
+                                   "epsilon", "zeta", "eta", "theta"};
+    std::vector<size_t> file_sizes;
+    for (auto type: {block_compression_type::NONE, 
+                     block_compression_type::LZ4,
+                     block_compression_type::LZ4HC}) {
+      sarray_group_format_writer_v2<flexible_type> group_writer;
+      std::string test_file_name = get_temp_name() + ".sidx";
+      group_writer.open(test_file_name, 1, 1);
+      group_writer.set_compression(type, 9);
+      for (size_t i = 0;i < 100000; ++i) {
+        group_writer.write_segment(0, 0, 
+                                   flex_list{words[(i * i) % 8], 
+                                             words[(i / 3) % 8], 
+                                             flex_int(i % 100)});
+      }
+      group_writer.close();
+      group_writer.write_index_file();
+      std::string segment_file = group_writer.get_index_info().segment_files[0];
+      general_ifstream fin(segment_file);
+      file_sizes.push_back(fin.file_size());
+
+      sarray_format_reader_v2<flexible_type> reader;
+      reader.open(test_file_name + ":0");
+      std::vector<flexible_type> vals;
+      TS_ASSERT_EQUALS(reader.read_rows(0, 100000, vals), 100000);
+      for (size_t i = 0;i < vals.size(); i += 7) {
+        const flex_list& row = vals[i].get<flex_list>();
+        TS_ASSERT_EQUALS(row[0], flexible_type(words[(i * i) % 8]));
+        TS_ASSERT_EQUALS(row[2], flexible_type(i % 100));
+      }
+    }
+    TS_ASSERT_LESS_THAN(file_sizes[1], file_sizes[0]);
+    TS_ASSERT_LESS_THAN_EQUALS(file_sizes[2], file_sizes[1]);
+  }
+
+  /**
+   * Encodes and decodes a block, both with typed_decode and the streaming
+   * decoder, and returns the block flags.
+   */
+  size_t check_typed_encode_roundtrip(const std::vector<flexible_type>& data,
+                                      size_t& ret_size) {
+    v2_block_impl::block_info info;
+    oarchive oarc;
+    v2_block_impl::typed_encode(data, info, oarc);
+    ret_size = oarc.off;
+    std::vector<flexible_type> decoded;
+    TS_ASSERT(v2_block_impl::typed_decode(info, oarc.buf, oarc.off, decoded));
+    std::vector<flexible_type> streamed;
+    TS_ASSERT(v2_block_impl::typed_decode_stream_callback(
+        info, oarc.buf, oarc.off, 
+        [&](const flexible_type& f) { streamed.push_back(f); }));
+    TS_ASSERT_EQUALS(decoded.size(), data.size());
+    TS_ASSERT_EQUALS(streamed.size(), data.size());
+    for (size_t i = 0;i < data.size(); ++i) {
+      TS_ASSERT_EQUALS(decoded[i].get_type(), data[i].get_type());
+      TS_ASSERT_EQUALS(streamed[i].get_type(), data[i].get_type());
+      if (data[i].get_type() == flex_type_enum::DATETIME) {
+        auto dt = data[i].get<flex_date_time>();
+        for (auto& other: {decoded[i], streamed[i]}) {
+          TS_ASSERT_EQUALS(other.get<flex_date_time>().posix_timestamp(), 
+                           dt.posix_timestamp());
+          TS_ASSERT_EQUALS(other.get<flex_date_time>().time_zone_offset(), 
+                           dt.time_zone_offset());
+        }
+      } else if (data[i].get_type() != flex_type_enum::UNDEFINED) {
+        // compare bit patterns so that -0.0 and NaN are checked too
+        TS_ASSERT_EQUALS(decoded[i].get<flex_int>(), data[i].get<flex_int>());
+        TS_ASSERT_EQUALS(streamed[i].get<flex_int>(), data[i].get<flex_int>());
+      }
+    }
+    free(oarc.buf);
+    return info.flags;
+  }
+
+  void test_extended_encodings(void) {
+    using namespace v2_block_impl;
+    size_t size = 0, plain_size = 0;
+    // long runs of integers (i.e. a sorted key column)
+    std::vector<flexible_type> runs;
+    for (size_t i = 0;i < 4096; ++i) runs.push_back(flex_int(1000000 + i / 512));
+    runs[100] = FLEX_UNDEFINED;
+    TS_ASSERT_EQUALS(check_typed_encode_roundtrip(runs, size), RLE_ENCODING);
+
+    // slowly varying doubles (a sensor reading)
+    std::vector<flexible_type> sensor;
+    for (size_t i = 0;i < 4096; ++i) {
+      sensor.push_back(20.0 + 0.25 * (i / 3 % 16));
+    }
+    sensor[7] = -0.0;
+    sensor[8] = std::numeric_limits<double>::quiet_NaN();
+    sensor[9] = FLEX_UNDEFINED;
+    size_t flags = check_typed_encode_roundtrip(sensor, size);
+    TS_ASSERT(flags & EXTENDED_ENCODING_FLAGS);
+    TS_ASSERT((flags & IS_FLEXIBLE_TYPE) == 0);
+
+    // random doubles. Any encoding may win, but the result must decode
+    random::seed(1001);
+    std::vector<flexible_type> noise;
+    for (size_t i = 0;i < 1000; ++i) {
+      noise.push_back(random::fast_uniform<double>(-1e6, 1e6));
+    }
+    check_typed_encode_roundtrip(noise, size);
+
+    // regularly spaced timestamps, with a few gaps and time zone changes
+    std::vector<flexible_type> times;
+    for (size_t i = 0;i < 4096; ++i) {
+      int64_t ts = 1420070400 + 60 * i + (i > 2000 ? 3600 : 0);
+      times.push_back(flex_date_time(ts, i < 3000 ? -16 : 2));
+    }
+    times[0] = FLEX_UNDEFINED;
+    times[500] = FLEX_UNDEFINED;
+    times[501] = flex_date_time(-5, 0);
+    TS_ASSERT_EQUALS(check_typed_encode_roundtrip(times, size), 
+                     DELTA_OF_DELTA_ENCODING);
+
+    // random integers keep the original encoding
+    std::vector<flexible_type> ints;
+    for (size_t i = 0;i < 1000; ++i) {
+      ints.push_back(random::fast_uniform<flex_int>(0, 1000000));
+    }
+    TS_ASSERT_EQUALS(check_typed_encode_roundtrip(ints, size), 
+                     IS_FLEXIBLE_TYPE);
+
+    // the extended encodings are smaller, and can be turned off
+    std::vector<std::vector<flexible_type>*> columns{&runs, &sensor, &times};
+    for (auto column: columns) {
+      check_typed_encode_roundtrip(*column, size);
+      SFRAME_WRITE_EXTENDED_ENCODINGS = false;
+      TS_ASSERT_EQUALS(check_typed_encode_roundtrip(*column, plain_size),
+                       IS_FLEXIBLE_TYPE);
+      SFRAME_WRITE_EXTENDED_ENCODINGS = true;
+      TS_ASSERT_LESS_THAN(size, plain_size);
+    }
+  }
+
 };
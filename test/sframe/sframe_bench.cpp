@@ -15,11 +15,73 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <iostream>
+#include <set>
 #include <sframe/sframe.hpp>
+#include <sframe/sframe_config.hpp>
 #include <sframe/parallel_csv_parser.hpp>
 #include <fileio/temp_files.hpp>
+#include <fileio/general_fstream.hpp>
 #include <timer/timer.hpp>
 using namespace graphlab;
+using v2_block_impl::block_compression_type;
+
+/**
+ * Returns the number of bytes on disk used by the segment files of a frame.
+ */
+static size_t frame_size_on_disk(const sframe& frame) {
+  // v2 segment files are named [file]:[column]. Columns share files.
+  std::set<std::string> files;
+  for (size_t i = 0; i < frame.num_columns(); ++i) {
+    for (auto& segfile: frame.select_column(i)->get_index_info().segment_files) {
+      files.insert(segfile.substr(0, segfile.find_last_of(':')));
+    }
+  }
+  size_t ret = 0;
+  for (auto& file: files) ret += general_ifstream(file).file_size();
+  return ret;
+}
+
+/**
+ * Copies the frame with the given compression, and reports the size of the
+ * copy, and the time it takes to write and to read back.
+ */
+static void bench_compression(const sframe& frame,
+                              block_compression_type type, 
+                              int level,
+                              const std::string& name) {
+  const size_t ROWS_PER_READ = 4096;
+  std::vector<std::vector<flexible_type> > rows;
+  sframe out;
+  out.open_for_write(frame.column_names(), frame.column_types(), "", 1);
+  out.set_compression(type, level);
+  auto source = frame.get_reader();
+  timer ti;
+  auto iter = out.get_output_iterator(0);
+  for (size_t i = 0; i < frame.num_rows(); i += ROWS_PER_READ) {
+    source->read_rows(i, i + ROWS_PER_READ, rows);
+    for (auto& row: rows) {
+      *iter = row;
+      ++iter;
+    }
+  }
+  out.close();
+  double write_time = ti.current_time();
+
+  ti.start();
+  auto reader = out.get_reader();
+  size_t num_read = 0;
+  for (size_t i = 0; i < out.num_rows(); i += ROWS_PER_READ) {
+    num_read += reader->read_rows(i, i + ROWS_PER_READ, rows);
+  }
+  double read_time = ti.current_time();
+  ASSERT_EQ(num_read, frame.num_rows());
+
+  double mb = frame_size_on_disk(out) / 1024.0 / 1024.0;
+  double mrows = frame.num_rows() / 1e6;
+  std::cout << name << ": " << mb << " MB, written in " << write_time 
+            << "s (" << mrows / write_time << " M rows/s), read in " 
+            << read_time << "s (" << mrows / read_time << " M rows/s)\n";
+}
 
 int main(int argc, char** argv) {
   if (argc != 2) {
@@ -46,4 +108,15 @@ int main(int argc, char** argv) {
     std::cout << frame.column_name(i) << "\n";
   }
   std::cout << frame.num_rows() << " rows\n";
+
+  // compare the compression modes. The block cache is disabled so every
+  // read decompresses.
+  std::cout << "\nCompression:\n";
+  sframe_config::SFRAME_BLOCK_CACHE_SIZE = 0;
+  bench_compression(frame, block_compression_type::NONE, 0, "none");
+  bench_compression(frame, block_compression_type::LZ4, 0, "lz4");
+  for (int level: {4, 9, 16}) {
+    bench_compression(frame, block_compression_type::LZ4HC, level, 
+                      "lz4hc level " + std::to_string(level));
+  }
 }
@@ -17,13 +17,17 @@
 #include <iostream>
 #include <typeinfo>
 #include <boost/filesystem.hpp>
+#include <boost/algorithm/string.hpp>
+#include <fileio/general_fstream.hpp>
 #include <sframe/sframe.hpp>
 #include <sframe/algorithm.hpp>
 #include <sframe/sframe_from_flex_type_record_inserter.hpp>
 #include <flexible_type/flexible_type.hpp>
 #include <sframe/parallel_csv_parser.hpp>
 #include <sframe/csv_line_tokenizer.hpp>
+#include <sframe/csv_structural_scan.hpp>
 #include <flexible_type/string_escape.hpp>
+#include <parallel/pthread_tools.hpp>
 #include <random/random.hpp>
 #include <cxxtest/TestSuite.h>
 
@@ -387,4 +391,172 @@ class sframe_test : public CxxTest::TestSuite {
      evaluate(escape_parsing());
      evaluate(escape_parsing_string_hint());
    }
+
+   void test_structural_scan() {
+     using namespace csv_scan;
+     scan_level old_level = get_scan_level();
+     // random text over a small alphabet, searched from every offset
+     std::string alphabet = "ab,\"\\#\n ";
+     std::string text;
+     for (size_t i = 0;i < 300; ++i) {
+       text.push_back(alphabet[random::fast_uniform<size_t>(0, alphabet.size() - 1)]);
+     }
+     std::vector<std::string> sets{",", ",\"", ",#\\", "\n\r\"\\"};
+     for (size_t level = 0; level <= (size_t)get_max_scan_level(); ++level) {
+       set_scan_level((scan_level)level);
+       for (auto& set_chars: sets) {
+         char_set set(set_chars);
+         for (size_t begin = 0; begin < text.size(); ++begin) {
+           const char* expected = std::find_first_of(text.data() + begin,
+                                                     text.data() + text.size(),
+                                                     set_chars.begin(),
+                                                     set_chars.end());
+           TS_ASSERT_EQUALS(find_first_of(text.data() + begin,
+                                          text.data() + text.size(), set),
+                            expected);
+         }
+       }
+     }
+
+     // the tokenizer gives the same tokens with every kernel
+     std::vector<std::string> lines{
+       "a,b,c",
+       "\"a long quoted field, with a delimiter\",\"esc\\\"aped\" , x",
+       "0123456789012345678901234567890123456789,abcdefghijklmnopqrstuvwxyz0123456789#comment",
+       "[1,2,3],{\"a\":1},  leading spaces and trailing  ,",
+       "a\\,b,\"\"\"double\"\"\",end"};
+     for (std::string delimiter: {",", "::"}) {
+       for (bool double_quote: {false, true}) {
+         csv_line_tokenizer tokenizer;
+         tokenizer.delimiter = delimiter;
+         tokenizer.double_quote = double_quote;
+         tokenizer.init();
+         std::vector<std::vector<std::string> > expected;
+         set_scan_level(scan_level::SCALAR);
+         for (auto line: lines) {
+           boost::algorithm::replace_all(line, ",", delimiter);
+           std::vector<std::string> tokens;
+           tokenizer.tokenize_line(line.c_str(), line.length(), tokens);
+           expected.push_back(tokens);
+         }
+         for (size_t level = 1; level <= (size_t)get_max_scan_level(); ++level) {
+           set_scan_level((scan_level)level);
+           for (size_t i = 0;i < lines.size(); ++i) {
+             std::string line = lines[i];
+             boost::algorithm::replace_all(line, ",", delimiter);
+             std::vector<std::string> tokens;
+             tokenizer.tokenize_line(line.c_str(), line.length(), tokens);
+             TS_ASSERT_EQUALS(tokens, expected[i]);
+           }
+         }
+       }
+     }
+     set_scan_level(old_level);
+   }
+
+   /**
+    * Writes num_files CSV files to a new directory, some with lines which
+    * fail to parse, and checks that reading them with and without the file
+    * parallel mode gives the same rows and errors.
+    */
+   void check_csv_directory_parse_files_in_parallel(size_t num_files,
+                                                    size_t rows_per_file,
+                                                    bool compressed) {
+     std::string dirname = get_temp_name();
+     boost::filesystem::create_directory(dirname);
+     size_t expected_rows = 0;
+     for (size_t f = 0;f < num_files; ++f) {
+       std::string filename = dirname + "/part-" + std::to_string(f) + ".csv";
+       if (compressed) filename += ".gz";
+       general_ofstream fout(filename);
+       fout << "a,b\n";
+       for (size_t i = 0;i < rows_per_file * (f + 1); ++i) {
+         fout << f << "," << i << "\n";
+         if (f % 3 == 0 && i % 37 == 0) fout << "bad line " << f << "\n";
+       }
+       expected_rows += rows_per_file * (f + 1);
+     }
+     auto parse = [&](bool parallel,
+                      std::vector<std::vector<flexible_type> >& rows,
+                      std::map<std::string, std::vector<flexible_type> >& errors) {
+       size_t old_value = SFRAME_CSV_PARSE_FILES_IN_PARALLEL;
+       SFRAME_CSV_PARSE_FILES_IN_PARALLEL = parallel;
+       csv_line_tokenizer tokenizer;
+       tokenizer.init();
+       sframe frame;
+       auto ret = frame.init_from_csvs(dirname, tokenizer, true,
+                                       true, // continue on failure
+                                       true, // store errors
+                                       {{"a", flex_type_enum::INTEGER},
+                                        {"b", flex_type_enum::INTEGER}});
+       SFRAME_CSV_PARSE_FILES_IN_PARALLEL = old_value;
+       rows.clear();
+       frame.get_reader()->read_rows(0, frame.num_rows(), rows);
+       errors.clear();
+       for (auto& file_errors: ret) {
+         auto& v = errors[file_errors.first];
+         file_errors.second->get_reader()->read_rows(0, file_errors.second->size(), v);
+       }
+     };
+     std::vector<std::vector<flexible_type> > serial_rows, parallel_rows;
+     std::map<std::string, std::vector<flexible_type> > serial_errors, parallel_errors;
+     parse(false, serial_rows, serial_errors);
+     parse(true, parallel_rows, parallel_errors);
+     TS_ASSERT_EQUALS(serial_rows.size(), expected_rows);
+     TS_ASSERT(parallel_rows == serial_rows);
+     TS_ASSERT_EQUALS(serial_errors.size(), (num_files + 2) / 3);
+     TS_ASSERT(parallel_errors == serial_errors);
+     boost::filesystem::remove_all(dirname);
+   }
+
+   void test_csv_directory_parse_files_in_parallel() {
+     // at least as many files as cores
+     check_csv_directory_parse_files_in_parallel(
+         std::max<size_t>(thread::cpu_count(), 7), 100, false);
+     // compressed files are always parsed in parallel
+     check_csv_directory_parse_files_in_parallel(7, 100, true);
+   }
+
+   void test_csv_directory_few_large_files() {
+     // fewer uncompressed files than cores are parsed one after the other,
+     // each with all the parse threads
+     check_csv_directory_parse_files_in_parallel(2, 20000, false);
+   }
+
+   void test_csv_type_inference() {
+     std::string filename = get_temp_name() + ".csv";
+     {
+       std::ofstream fout(filename);
+       fout << "int,float,mixed,vec,list,dict,str,empty\n";
+       for (size_t i = 0;i < 50; ++i) {
+         fout << i << "," << i << ".5,"
+              << (i % 2 ? std::to_string(i) : std::to_string(i) + ".25") << ","
+              << "[1 2 " << i << "],"
+              << (i == 7 ? "[a,b]" : "[1,2]") << ","
+              << "{'a':" << i << "},"
+              << (i == 3 ? "hello" : std::to_string(i)) << ",\n";
+       }
+     }
+     csv_line_tokenizer tokenizer;
+     tokenizer.init();
+     sframe frame;
+     frame.init_from_csvs(filename, tokenizer, true, false, false,
+                          {{"str", flex_type_enum::STRING}}, 0,
+                          20); // type inference rows
+     TS_ASSERT_EQUALS(frame.num_rows(), 50);
+     TS_ASSERT_EQUALS(frame.column_type(0), flex_type_enum::INTEGER);
+     TS_ASSERT_EQUALS(frame.column_type(1), flex_type_enum::FLOAT);
+     TS_ASSERT_EQUALS(frame.column_type(2), flex_type_enum::FLOAT);
+     TS_ASSERT_EQUALS(frame.column_type(3), flex_type_enum::VECTOR);
+     TS_ASSERT_EQUALS(frame.column_type(4), flex_type_enum::LIST);
+     TS_ASSERT_EQUALS(frame.column_type(5), flex_type_enum::DICT);
+     TS_ASSERT_EQUALS(frame.column_type(6), flex_type_enum::STRING);
+     TS_ASSERT_EQUALS(frame.column_type(7), flex_type_enum::STRING);
+     std::vector<std::vector<flexible_type> > rows;
+     frame.get_reader()->read_rows(0, frame.num_rows(), rows);
+     TS_ASSERT_EQUALS(rows[40][0], 40);
+     TS_ASSERT_EQUALS(rows[40][2], 40.25);
+     TS_ASSERT_EQUALS(rows[41][6], "41");
+     boost::filesystem::remove(filename);
+   }
 };
@@ -15,6 +15,7 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <iostream>
+#include <set>
 #include <typeinfo>
 #include <boost/filesystem.hpp>
 #include <sframe/sframe.hpp>
@@ -26,6 +27,7 @@
 #include <random/random.hpp>
 #include <sframe/groupby_aggregate.hpp>
 #include <sframe/groupby_aggregate_operators.hpp>
+#include <sframe/join.hpp>
 #include <cxxtest/TestSuite.h>
 
 using namespace graphlab;
@@ -1612,6 +1614,217 @@ class sframe_test : public CxxTest::TestSuite {
   
    }
 
+   void run_typed_groupby_aggregate_test(size_t NUM_GROUPS,
+                                         size_t NUM_ROWS,
+                                         size_t BUFFER_SIZE) {
+     // the numeric aggregators go through the typed aggregation path unless
+     // another aggregator is present. Compare the two paths.
+     sframe input;
+     input.open_for_write({"key","int","float"},
+                          {flex_type_enum::INTEGER, flex_type_enum::INTEGER,
+                          flex_type_enum::FLOAT},
+                          "", 4 /* 4 segments*/);
+     for (size_t i = 0;i < NUM_ROWS; ++i) {
+       auto iter = input.get_output_iterator(i % 4);
+       std::vector<flexible_type> flex(3);
+       flex[0] = (i * 7) % NUM_GROUPS;
+       flex[1] = int(i % 13) - 6;
+       flex[2] = (double)(i % 17) / 4.0 - 2.0;
+       // inject missing values
+       if (i % 5 == 0) flex[1] = FLEX_UNDEFINED;
+       if (i % 7 == 0) flex[2] = FLEX_UNDEFINED;
+       if (i % 101 == 0) flex[0] = FLEX_UNDEFINED;
+       (*iter) = flex;
+       ++iter;
+     }
+     input.close();
+
+     std::vector<std::pair<std::vector<std::string>,
+                           std::shared_ptr<group_aggregate_value>>> groups =
+         {{{}, std::make_shared<groupby_operators::count>()},
+          {{"int"}, std::make_shared<groupby_operators::sum>()},
+          {{"float"}, std::make_shared<groupby_operators::sum>()},
+          {{"int"}, std::make_shared<groupby_operators::min>()},
+          {{"float"}, std::make_shared<groupby_operators::min>()},
+          {{"int"}, std::make_shared<groupby_operators::max>()},
+          {{"float"}, std::make_shared<groupby_operators::max>()},
+          {{"int"}, std::make_shared<groupby_operators::average>()},
+          {{"float"}, std::make_shared<groupby_operators::variance>()},
+          {{"int"}, std::make_shared<groupby_operators::stdv>()}};
+     std::vector<std::string> names(groups.size(), "");
+     sframe typed_output = graphlab::groupby_aggregate(input, {"key"}, names,
+                                                       groups, BUFFER_SIZE);
+     groups.push_back({{"int"}, std::make_shared<groupby_operators::select_one>()});
+     names.push_back("");
+     sframe generic_output = graphlab::groupby_aggregate(input, {"key"}, names,
+                                                         groups, BUFFER_SIZE);
+
+     TS_ASSERT_EQUALS(typed_output.num_columns() + 1, generic_output.num_columns());
+     TS_ASSERT_EQUALS(typed_output.num_rows(), generic_output.num_rows());
+     for (size_t i = 0;i < typed_output.num_columns(); ++i) {
+       TS_ASSERT_EQUALS(typed_output.column_name(i), generic_output.column_name(i));
+       TS_ASSERT_EQUALS(typed_output.column_type(i), generic_output.column_type(i));
+     }
+
+     std::vector<std::vector<flexible_type> > typed_rows, generic_rows;
+     typed_output.get_reader()->read_rows(0, typed_output.num_rows(), typed_rows);
+     generic_output.get_reader()->read_rows(0, generic_output.num_rows(), generic_rows);
+     std::map<flexible_type, std::vector<flexible_type> > generic_by_key;
+     for (auto& row: generic_rows) {
+       // undefined keys sort before everything else
+       flexible_type key = row[0] == FLEX_UNDEFINED ? flexible_type(-1) : row[0];
+       generic_by_key[key] = row;
+     }
+     TS_ASSERT_EQUALS(generic_by_key.size(), NUM_GROUPS + 1);
+     for (auto& row: typed_rows) {
+       flexible_type key = row[0] == FLEX_UNDEFINED ? flexible_type(-1) : row[0];
+       TS_ASSERT(generic_by_key.count(key));
+       auto& expected = generic_by_key[key];
+       for (size_t i = 1;i < row.size(); ++i) {
+         TS_ASSERT_EQUALS(row[i].get_type(), expected[i].get_type());
+         if (row[i].get_type() == flex_type_enum::FLOAT) {
+           TS_ASSERT_DELTA(row[i].get<flex_float>(), expected[i].get<flex_float>(), 1e-6);
+         } else {
+           TS_ASSERT_EQUALS(row[i], expected[i]);
+         }
+       }
+     }
+   }
+
+   void test_sframe_typed_groupby_aggregate() {
+     run_typed_groupby_aggregate_test(100, 100000, 1000);
+     run_typed_groupby_aggregate_test(10, 100, 1000);
+     // small buffer: the typed tables are spilled and merged
+     run_typed_groupby_aggregate_test(1000, 100000, 10);
+     run_typed_groupby_aggregate_test(10000, 20000, 2);
+   }
+
+   void test_sframe_skewed_groupby_aggregate() {
+     // most rows go to one key. Exercise the thread local pre-aggregation
+     // with a local buffer small enough to be flushed often, and with the
+     // keys which only appear once making it fall back to direct insertion.
+     size_t local_buffer_size = SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS;
+     for (size_t buffer_size: {size_t(0), size_t(4), size_t(1024)}) {
+       SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS = buffer_size;
+       sframe input;
+       input.open_for_write({"key","int"},
+                            {flex_type_enum::INTEGER, flex_type_enum::INTEGER},
+                            "", 4 /* 4 segments*/);
+       const size_t NUM_ROWS = 100000;
+       std::map<flex_int, size_t> counts;
+       for (size_t i = 0;i < NUM_ROWS; ++i) {
+         auto iter = input.get_output_iterator(i % 4);
+         flex_int key = (i % 10 == 0) ? flex_int(i) : 0;
+         (*iter) = std::vector<flexible_type>{key, flex_int(i % 1000)};
+         ++iter;
+         ++counts[key];
+       }
+       input.close();
+
+       auto quantile = std::make_shared<groupby_operators::quantile>();
+       quantile->init({0.5});
+       sframe output = graphlab::groupby_aggregate(input,
+                                         {"key"},
+                                         {"count", "median"},
+                                         {{{}, std::make_shared<groupby_operators::count>()},
+                                         {{"int"}, quantile}},
+                                         100);
+       TS_ASSERT_EQUALS(output.num_rows(), counts.size());
+       std::vector<std::vector<flexible_type> > ret;
+       output.get_reader()->read_rows(0, output.num_rows(), ret);
+       for (auto& row: ret) {
+         flex_int key = row[0];
+         TS_ASSERT_EQUALS(size_t(row[1]), counts[key]);
+         double median = row[2].get<flex_vec>()[0];
+         if (key == 0) {
+           TS_ASSERT_DELTA(median, 500, 20);
+         } else {
+           TS_ASSERT_EQUALS(median, double(key % 1000));
+         }
+       }
+     }
+     SFRAME_GROUPBY_LOCAL_BUFFER_NUM_GROUPS = local_buffer_size;
+   }
+
+   void test_sframe_count_distinct_groupby_aggregate() {
+     // key k has up to (k+1)*1000 distinct values, some missing.
+     // A small buffer forces the groups to be spilled and merged.
+     sframe input;
+     input.open_for_write({"key","val"},
+                          {flex_type_enum::INTEGER, flex_type_enum::STRING},
+                          "", 4 /* 4 segments*/);
+     const size_t NUM_ROWS = 200000;
+     std::map<flex_int, std::set<flex_string> > distinct;
+     for (size_t i = 0;i < NUM_ROWS; ++i) {
+       auto iter = input.get_output_iterator(i % 4);
+       flex_int key = i % 10;
+       flexible_type val;
+       if (i % 7 != 0) {
+         val = std::to_string((i / 10) % ((key + 1) * 1000));
+         distinct[key].insert(val.get<flex_string>());
+       }
+       (*iter) = std::vector<flexible_type>{key, val};
+       ++iter;
+     }
+     // a group with only a few distinct values is counted exactly
+     auto iter = input.get_output_iterator(0);
+     for (size_t i = 0;i < 10; ++i) {
+       (*iter) = std::vector<flexible_type>{10, std::to_string(i % 3)};
+       ++iter;
+       distinct[10].insert(std::to_string(i % 3));
+     }
+     input.close();
+
+     sframe output = graphlab::groupby_aggregate(input,
+                                       {"key"},
+                                       {"exact", "approx"},
+                                       {{{"val"}, get_builtin_group_aggregator("__builtin__count__distinct__")},
+                                       {{"val"}, get_builtin_group_aggregator("__builtin__approx__count__distinct__")}},
+                                       3);
+     TS_ASSERT_EQUALS(output.num_rows(), distinct.size());
+     TS_ASSERT_EQUALS(output.column_type(1), flex_type_enum::INTEGER);
+     TS_ASSERT_EQUALS(output.column_type(2), flex_type_enum::INTEGER);
+     std::vector<std::vector<flexible_type> > ret;
+     output.get_reader()->read_rows(0, output.num_rows(), ret);
+     for (auto& row: ret) {
+       size_t expected = distinct[row[0].get<flex_int>()].size();
+       TS_ASSERT_EQUALS(size_t(row[1]), expected);
+       if (row[0] == 10) {
+         TS_ASSERT_EQUALS(size_t(row[2]), expected);
+       } else {
+         TS_ASSERT_DELTA(double(row[2]), double(expected), 0.05 * expected);
+       }
+     }
+   }
+
+   void test_sframe_count_distinct_nan() {
+     // NaNs with different payloads are one value, and so are 0.0 and -0.0
+     std::vector<flex_float> values{std::nan("1"), std::nan("2"),
+                                    -std::numeric_limits<flex_float>::quiet_NaN(),
+                                    0.0, -0.0, 1.0, 1.0};
+     sframe input;
+     input.open_for_write({"key","val"},
+                          {flex_type_enum::INTEGER, flex_type_enum::FLOAT},
+                          "", 2 /* 2 segments*/);
+     for (size_t i = 0;i < values.size(); ++i) {
+       auto iter = input.get_output_iterator(i % 2);
+       (*iter) = std::vector<flexible_type>{0, values[i]};
+       ++iter;
+     }
+     input.close();
+
+     sframe output = graphlab::groupby_aggregate(input,
+                                       {"key"},
+                                       {"exact", "approx"},
+                                       {{{"val"}, get_builtin_group_aggregator("__builtin__count__distinct__")},
+                                       {{"val"}, get_builtin_group_aggregator("__builtin__approx__count__distinct__")}});
+     std::vector<std::vector<flexible_type> > ret;
+     output.get_reader()->read_rows(0, output.num_rows(), ret);
+     TS_ASSERT_EQUALS(ret.size(), 1);
+     TS_ASSERT_EQUALS(size_t(ret[0][1]), 3);
+     TS_ASSERT_EQUALS(size_t(ret[0][2]), 3);
+   }
+
    void test_sframe_groupby_aggregate_negative_tests() {
      sframe input;
      input.open_for_write({"str","int","float"},
@@ -1663,6 +1876,220 @@ class sframe_test : public CxxTest::TestSuite {
    }
 
 
+   static std::vector<std::string> join_test_row_key(
+       const std::vector<flexible_type>& row) {
+     std::vector<std::string> ret;
+     for (auto& v: row) {
+       ret.push_back(v.get_type() == flex_type_enum::UNDEFINED ?
+                     "NULL" : std::string(v));
+     }
+     return ret;
+   }
+
+   void test_sframe_join() {
+     // left keys 100..109 and right keys 50..69 have no match.
+     // Duplicate keys on both sides produce cross products.
+     std::vector<std::vector<flexible_type> > left_rows, right_rows;
+     for (size_t i = 0;i < 310; ++i) {
+       flex_int key = i < 300 ? flex_int(i % 50) : flex_int(100 + i - 300);
+       left_rows.push_back({key, flex_int(i)});
+     }
+     for (size_t i = 0;i < 200; ++i) {
+       right_rows.push_back({flex_int(i % 70), std::to_string(i)});
+     }
+     auto make_frame = [](std::vector<std::vector<flexible_type> > rows,
+                          const std::vector<std::string>& names,
+                          const std::vector<flex_type_enum>& types) {
+       sframe sf;
+       sf.open_for_write(names, types, "", 3);
+       std::copy(rows.begin(), rows.end(), sf.get_output_iterator(1));
+       sf.close();
+       return sf;
+     };
+     auto sort_rows = [](std::vector<std::vector<flexible_type> > rows) {
+       std::stable_sort(rows.begin(), rows.end(),
+                        [](const std::vector<flexible_type>& a,
+                           const std::vector<flexible_type>& b) {
+                          return a[0] < b[0];
+                        });
+       return rows;
+     };
+     std::vector<std::string> left_names{"k","a"}, right_names{"k","b"};
+     std::vector<flex_type_enum> left_types{flex_type_enum::INTEGER, flex_type_enum::INTEGER};
+     std::vector<flex_type_enum> right_types{flex_type_enum::INTEGER, flex_type_enum::STRING};
+     sframe left = make_frame(left_rows, left_names, left_types);
+     sframe right = make_frame(right_rows, right_names, right_types);
+     sframe sorted_left = make_frame(sort_rows(left_rows), left_names, left_types);
+     sframe sorted_right = make_frame(sort_rows(right_rows), right_names, right_types);
+     TS_ASSERT(!join_impl::is_sorted_on(left, {0}));
+     TS_ASSERT(join_impl::is_sorted_on(sorted_left, {0}));
+     TS_ASSERT(join_impl::is_sorted_on(sorted_right, {0}));
+
+     size_t num_sorts = 0;
+     join_sort_function sorter = [&](const sframe& sf,
+                                     const std::vector<std::string>& keys) {
+       TS_ASSERT_EQUALS(keys, std::vector<std::string>{"k"});
+       ++num_sorts;
+       std::vector<std::vector<flexible_type> > rows;
+       sf.get_reader()->read_rows(0, sf.num_rows(), rows);
+       return make_frame(sort_rows(rows), sf.column_names(), sf.column_types());
+     };
+
+     for (std::string join_type: {"inner", "left", "right", "outer"}) {
+       bool keep_left = (join_type == "left" || join_type == "outer");
+       bool keep_right = (join_type == "right" || join_type == "outer");
+       std::vector<std::vector<flexible_type> > expected;
+       std::set<size_t> matched_right;
+       for (auto& l: left_rows) {
+         bool matched = false;
+         for (size_t j = 0;j < right_rows.size(); ++j) {
+           if (l[0] == right_rows[j][0]) {
+             expected.push_back({l[0], l[1], right_rows[j][1]});
+             matched_right.insert(j);
+             matched = true;
+           }
+         }
+         if (!matched && keep_left) {
+           expected.push_back({l[0], l[1], FLEX_UNDEFINED});
+         }
+       }
+       for (size_t j = 0;j < right_rows.size(); ++j) {
+         if (!matched_right.count(j) && keep_right) {
+           expected.push_back({right_rows[j][0], FLEX_UNDEFINED, right_rows[j][1]});
+         }
+       }
+       std::vector<std::vector<std::string> > expected_keys;
+       for (auto& row: expected) expected_keys.push_back(join_test_row_key(row));
+       std::sort(expected_keys.begin(), expected_keys.end());
+
+       // hash join in memory and partitioned over several GRACE partitions,
+       // merge join of sorted frames, and merge join after sorting the
+       // right frame as GRACE partitioning would cost more.
+       struct join_case {
+         sframe* left;
+         sframe* right;
+         size_t max_buffer_size;
+         bool use_sorter;
+         size_t expected_sorts;
+       };
+       std::vector<join_case> cases{{&left, &right, 1000000, false, 0},
+                                    {&left, &right, 100, false, 0},
+                                    {&left, &right, 100, true, 0},
+                                    {&sorted_left, &sorted_right, 1000000, false, 0},
+                                    {&sorted_left, &right, 100, true, 1}};
+       for (auto& c: cases) {
+         num_sorts = 0;
+         sframe result = graphlab::join(*c.left, *c.right, join_type,
+                                        {{"k", "k"}}, c.max_buffer_size,
+                                        c.use_sorter ? sorter : join_sort_function());
+         TS_ASSERT_EQUALS(num_sorts, c.expected_sorts);
+         TS_ASSERT_EQUALS(result.column_names(),
+                          std::vector<std::string>({"k", "a", "b"}));
+         std::vector<std::vector<flexible_type> > ret;
+         result.get_reader()->read_rows(0, result.num_rows(), ret);
+         std::vector<std::vector<std::string> > ret_keys;
+         for (auto& row: ret) ret_keys.push_back(join_test_row_key(row));
+         std::sort(ret_keys.begin(), ret_keys.end());
+         TS_ASSERT_EQUALS(ret_keys.size(), expected_keys.size());
+         TS_ASSERT(ret_keys == expected_keys);
+       }
+     }
+
+     // semi and anti joins keep the left rows unchanged, each at most once,
+     // including against an empty key set
+     sframe empty_right = make_frame({}, right_names, right_types);
+     for (std::string join_type: {"semi", "anti"}) {
+       for (sframe* r: {&right, &sorted_right, &empty_right}) {
+         std::set<flexible_type> right_keys;
+         std::vector<std::vector<flexible_type> > rows;
+         r->get_reader()->read_rows(0, r->num_rows(), rows);
+         for (auto& row: rows) right_keys.insert(row[0]);
+         std::vector<std::vector<std::string> > expected_keys;
+         for (auto& l: left_rows) {
+           if ((right_keys.count(l[0]) > 0) == (join_type == "semi")) {
+             expected_keys.push_back(join_test_row_key(l));
+           }
+         }
+         std::sort(expected_keys.begin(), expected_keys.end());
+         for (sframe* l: {&left, &sorted_left}) {
+           for (size_t max_buffer_size: {size_t(1000000), size_t(10)}) {
+             sframe result = graphlab::join(*l, *r, join_type, {{"k", "k"}},
+                                            max_buffer_size);
+             TS_ASSERT_EQUALS(result.column_names(), left_names);
+             std::vector<std::vector<flexible_type> > ret;
+             result.get_reader()->read_rows(0, result.num_rows(), ret);
+             std::vector<std::vector<std::string> > ret_keys;
+             for (auto& row: ret) ret_keys.push_back(join_test_row_key(row));
+             std::sort(ret_keys.begin(), ret_keys.end());
+             TS_ASSERT(ret_keys == expected_keys);
+           }
+         }
+       }
+     }
+   }
+
+   void test_sframe_grace_join_filter() {
+     // 200 build rows (keys 0..199) and 2000 probe rows (keys 0..1999), of
+     // which 1800 have no match
+     auto make_frame = [](size_t num_rows) {
+       sframe sf;
+       sf.open_for_write({"k", "v"}, {flex_type_enum::INTEGER, flex_type_enum::STRING}, "", 2);
+       auto out = sf.get_output_iterator(0);
+       for (size_t i = 0;i < num_rows; ++i) {
+         *out = std::vector<flexible_type>{flex_int(i), std::to_string(i)};
+         ++out;
+       }
+       sf.close();
+       return sf;
+     };
+     sframe build = make_frame(200);
+     sframe probe = make_frame(2000);
+     auto sorted_result = [](sframe result) {
+       std::vector<std::vector<flexible_type> > rows;
+       result.get_reader()->read_rows(0, result.num_rows(), rows);
+       std::vector<std::vector<std::string> > ret;
+       for (auto& row: rows) ret.push_back(join_test_row_key(row));
+       std::sort(ret.begin(), ret.end());
+       return ret;
+     };
+
+     // (join type, left frame, right frame), with the probe frame as the
+     // executor's right frame. Anti joins emit the unmatched probe rows and
+     // do not use the filter.
+     struct join_case {
+       join_type_t join_type;
+       std::string name;
+       sframe* left;
+       sframe* right;
+     };
+     std::vector<join_case> cases{{INNER_JOIN, "inner", &probe, &build},
+                                  {LEFT_JOIN, "left", &build, &probe},
+                                  {SEMI_JOIN, "semi", &probe, &build},
+                                  {ANTI_JOIN, "anti", &probe, &build}};
+     for (auto& c: cases) {
+       // with 100 cells of memory, the build side is GRACE partitioned and
+       // the filter gets 8 bits per key
+       join_impl::hash_join_executor executor(*c.left, *c.right, {0}, {0},
+                                              c.join_type, 100);
+       auto ret = sorted_result(executor.grace_hash_join());
+       auto expected = sorted_result(graphlab::join(*c.left, *c.right, c.name,
+                                                    {{"k", "k"}}, 1000000));
+       TS_ASSERT_EQUALS(ret.size(), c.join_type == ANTI_JOIN ? 1800 : 200);
+       TS_ASSERT(ret == expected);
+       if (c.join_type == ANTI_JOIN) {
+         TS_ASSERT_EQUALS(executor.num_filtered_rows(), 0);
+       } else {
+         TS_ASSERT_LESS_THAN_EQUALS(executor.num_filtered_rows(), 1800);
+         TS_ASSERT_LESS_THAN(1700, executor.num_filtered_rows());
+       }
+     }
+
+     // no filter when there are too few bits per key
+     join_impl::hash_join_executor executor(probe, build, {0}, {0}, INNER_JOIN, 20);
+     TS_ASSERT_EQUALS(executor.grace_hash_join().num_rows(), 200);
+     TS_ASSERT_EQUALS(executor.num_filtered_rows(), 0);
+   }
+
    void run_sframe_aggregate_operators_test(std::shared_ptr<group_aggregate_value> val,
                                             const std::vector<size_t>& vals,
                                             const std::vector<flex_type_enum>& input_types,
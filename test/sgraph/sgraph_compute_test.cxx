@@ -14,8 +14,11 @@
 * You should have received a copy of the GNU Affero General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <atomic>
 #include <sgraph/sgraph.hpp>
 #include <sgraph/sgraph_compute.hpp>
+#include <sgraph/sgraph_constants.hpp>
+#include <sgraph/sgraph_vertex_block_cache.hpp>
 #include <sframe/algorithm.hpp>
 #include <boost/bind.hpp>
 #include <cxxtest/TestSuite.h>
@@ -263,6 +266,44 @@ class sgraph_compute_test : public CxxTest::TestSuite {
     return ret;
   }
 
+  std::vector<std::pair<flexible_type, flexible_type>> typed_triple_apply_degree_count(
+    sgraph& g,
+    sgraph::edge_direction dir) {
+
+    sgraph_compute::typed_triple_apply_fn_type fn;
+    g.init_vertex_field("__degree__", flex_int(0));
+    if (dir == sgraph::edge_direction::IN_EDGE) {
+      fn = [](sgraph_compute::typed_edge_scope& scope) {
+        scope.add_to_target(0, 1);
+      };
+    } else if (dir == sgraph::edge_direction::OUT_EDGE) {
+      fn = [](sgraph_compute::typed_edge_scope& scope) {
+        scope.add_to_source(0, 1);
+      };
+    } else {
+      fn = [](sgraph_compute::typed_edge_scope& scope) {
+        scope.add_to_source(0, 1);
+        scope.add_to_target(0, 1);
+      };
+    }
+    sgraph_compute::typed_triple_apply(g, fn, {"__degree__"}, {"__degree__"});
+
+    auto result = g.fetch_vertex_data_field("__degree__");
+    auto vertex_ids = g.fetch_vertex_data_field(sgraph::VID_COLUMN_NAME);
+    std::vector<std::pair<flexible_type, flexible_type>> ret;
+    for (size_t i = 0; i < result.size(); ++i) {
+      std::vector<flexible_type> degree_vec;
+      std::vector<flexible_type> id_vec;
+      result[i]->get_reader()->read_rows(0, g.num_vertices(), degree_vec);
+      vertex_ids[i]->get_reader()->read_rows(0, g.num_vertices(), id_vec);
+      for (size_t j = 0; j < degree_vec.size(); ++j) {
+        ret.push_back({id_vec[j], degree_vec[j]});
+      }
+    }
+    g.remove_vertex_field("__degree__");
+    return ret;
+  }
+
   void test_basic_edge_count() {
     size_t n_vertex = 1000;
     size_t n_partition = 4;
@@ -275,7 +316,8 @@ class sgraph_compute_test : public CxxTest::TestSuite {
       degree_count_functions{
         boost::bind(&sgraph_compute_test::mr_degree_count, this, _1, _2),
         boost::bind(&sgraph_compute_test::triple_apply_degree_count, this, _1, _2, false), // triple_apply_simple
-        boost::bind(&sgraph_compute_test::triple_apply_degree_count, this, _1, _2, true) // triple_apply_batch
+        boost::bind(&sgraph_compute_test::triple_apply_degree_count, this, _1, _2, true), // triple_apply_batch
+        boost::bind(&sgraph_compute_test::typed_triple_apply_degree_count, this, _1, _2)
       };
 
     for (auto degree_count_fn: degree_count_functions) {
@@ -513,4 +555,127 @@ class sgraph_compute_test : public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(vsum2, n_vertex);
 
   }
+  void test_triple_apply_frontier() {
+    // hop distance from vertex 0 in a one direction ring, only relaxing
+    // the out edges of the vertices which changed.
+    size_t n_vertex = 1000;
+    size_t n_partition = 4;
+    sgraph g = create_ring_graph(n_vertex, n_partition, false);
+    auto dist = sgraph_compute::vertex_apply(g, sgraph::VID_COLUMN_NAME,
+                                             flex_type_enum::INTEGER,
+                                             [=](const flexible_type& id) {
+                                               return flexible_type(id == 0 ? 0 : n_vertex);
+                                             });
+    g.add_vertex_field(dist, "dist");
+    g.init_edge_field("hits", flex_int(0));
+    size_t dist_idx = g.get_vertex_field_id("dist");
+    size_t hits_idx = g.get_edge_field_id("hits");
+
+    std::atomic<size_t> num_visited(0);
+    sgraph_compute::triple_apply_fn_type fn =
+        [&](sgraph_compute::edge_scope& scope) {
+          ++num_visited;
+          scope.edge()[hits_idx] += 1;
+          if (scope.source()[dist_idx] + 1 < scope.target()[dist_idx]) {
+            scope.target()[dist_idx] = scope.source()[dist_idx] + 1;
+            scope.activate_target();
+          }
+        };
+
+    sgraph_compute::vertex_frontier frontier(g), next_frontier(g);
+    frontier.activate_all();
+    TS_ASSERT_EQUALS(frontier.num_active(), n_vertex);
+    size_t num_iterations = 0;
+    while (!frontier.empty()) {
+      next_frontier.clear();
+      sgraph_compute::triple_apply(g, fn, {"dist"}, {"hits"}, frontier,
+                                   sgraph::edge_direction::OUT_EDGE,
+                                   &next_frontier);
+      frontier.swap(next_frontier);
+      ++num_iterations;
+    }
+    // every vertex changes once, and only its out edge is visited again.
+    TS_ASSERT_LESS_THAN_EQUALS(num_visited.load(), 2 * n_vertex);
+    TS_ASSERT_LESS_THAN(1, num_iterations);
+
+    sframe vertices = g.get_vertices();
+    std::vector<std::vector<flexible_type>> rows;
+    vertices.get_reader()->read_rows(0, vertices.size(), rows);
+    size_t id_column = vertices.column_index(sgraph::VID_COLUMN_NAME);
+    size_t dist_column = vertices.column_index("dist");
+    for (auto& row: rows) {
+      TS_ASSERT_EQUALS(row[dist_column], row[id_column]);
+    }
+
+    // the edges which were not visited keep their data
+    sframe edges = g.get_edges();
+    TS_ASSERT_EQUALS(edges.size(), n_vertex);
+    edges.get_reader()->read_rows(0, edges.size(), rows);
+    size_t total_hits = 0;
+    for (auto& row: rows) total_hits += (flex_int)row[edges.column_index("hits")];
+    TS_ASSERT_EQUALS(total_hits, num_visited.load());
+  }
+
+  void test_vertex_block_cache() {
+    // 8 partitions, each coordinate (i, j) needs blocks i and j
+    size_t n_partition = 8;
+    std::vector<size_t> block_bytes(n_partition, 100);
+    auto blocks_of = [](std::pair<size_t, size_t> c) {
+      return std::vector<size_t>{c.first, c.second};
+    };
+    auto coordinates = sgraph_compute::hilbert_ordered_coordinates(n_partition);
+    TS_ASSERT_EQUALS(coordinates.size(), n_partition * n_partition);
+    for (size_t capacity: {size_t(1), size_t(200), size_t(400), size_t(1000)}) {
+      sgraph_compute::vertex_block_cache cache(n_partition, blocks_of,
+                                               block_bytes, capacity);
+      std::vector<bool> loaded(n_partition, false);
+      std::atomic<size_t> num_visited(0);
+      cache.run(coordinates,
+                [&](const std::vector<size_t>& blocks) {
+                  for (size_t b: blocks) {
+                    TS_ASSERT(loaded[b]);
+                    loaded[b] = false;
+                  }
+                },
+                [&](const std::vector<size_t>& blocks) {
+                  for (size_t b: blocks) {
+                    TS_ASSERT(!loaded[b]);
+                    loaded[b] = true;
+                  }
+                  size_t num_loaded = std::count(loaded.begin(), loaded.end(), true);
+                  // a single coordinate may exceed a tiny capacity
+                  TS_ASSERT_LESS_THAN_EQUALS(num_loaded * 100, std::max<size_t>(capacity, 200));
+                },
+                [&](std::pair<size_t, size_t> c) {
+                  TS_ASSERT(loaded[c.first] && loaded[c.second]);
+                  ++num_visited;
+                },
+                4);
+      TS_ASSERT_EQUALS(num_visited.load(), coordinates.size());
+      TS_ASSERT_EQUALS(std::count(loaded.begin(), loaded.end(), true), 0);
+      if (capacity >= n_partition * 100) {
+        // everything fits: every block is loaded once
+        TS_ASSERT_EQUALS(cache.num_loads(), n_partition);
+        TS_ASSERT_EQUALS(cache.num_passes(), coordinates.size() / 4);
+      }
+    }
+
+    // the graph computations give the same results with a tiny budget
+    size_t old_capacity = SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY;
+    SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY = 1;
+    sgraph g = create_ring_graph(1000, 4, false);
+    for (auto dir: {sgraph::edge_direction::IN_EDGE, sgraph::edge_direction::ANY_EDGE}) {
+      size_t expected = dir == sgraph::edge_direction::ANY_EDGE ? 2 : 1;
+      for (auto& degree: mr_degree_count(g, dir)) {
+        TS_ASSERT_EQUALS((int)degree.second, expected);
+      }
+      for (auto& degree: triple_apply_degree_count(g, dir)) {
+        TS_ASSERT_EQUALS((int)degree.second, expected);
+      }
+      for (auto& degree: typed_triple_apply_degree_count(g, dir)) {
+        TS_ASSERT_EQUALS((int)degree.second, expected);
+      }
+    }
+    SGRAPH_VERTEX_BLOCK_CACHE_CAPACITY = old_capacity;
+  }
 };
@@ -15,7 +15,11 @@
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <sgraph/sgraph.hpp>
+#include <sgraph/sgraph_constants.hpp>
 #include <sframe/algorithm.hpp>
+#include <serialization/dir_archive.hpp>
+#include <fileio/temp_files.hpp>
+#include <boost/filesystem.hpp>
 #include "sgraph_test_util.hpp"
 #include <cxxtest/TestSuite.h>
 
@@ -273,6 +277,134 @@ class sgraph_test : public CxxTest::TestSuite {
     }
   }
 
+  void test_get_edges_with_index() {
+    sgraph g = create_and_check_ring_graph(1000, 4, true);
+    std::vector<std::pair<std::vector<flexible_type>, std::vector<flexible_type>>> queries{
+      {{5}, {FLEX_UNDEFINED}},
+      {{FLEX_UNDEFINED}, {7}},
+      {{3, 10}, {4, 12}},
+      {{20, FLEX_UNDEFINED, 999, 2000}, {FLEX_UNDEFINED, 20, 0, FLEX_UNDEFINED}},
+      {{FLEX_UNDEFINED}, {FLEX_UNDEFINED}},
+    };
+    auto check_queries = [&](const sgraph& graph) {
+      for (auto& query : queries) {
+        sframe indexed = graph.get_edges(query.first, query.second);
+        size_t old_value = SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES;
+        SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES = 0;
+        sframe scanned = graph.get_edges(query.first, query.second);
+        SGRAPH_EDGE_INDEX_MAX_QUERY_VERTICES = old_value;
+        TS_ASSERT(test_frame_equal(indexed, scanned, {0, 1}));
+      }
+    };
+    // queries do not build the index
+    check_queries(g);
+    TS_ASSERT(!g.find_edge_index(0, 0));
+
+    g.build_edge_index();
+    auto index = g.find_edge_index(0, 0);
+    TS_ASSERT(index);
+    check_queries(g);
+    TS_ASSERT_EQUALS(g.get_edges({5}, {FLEX_UNDEFINED}).num_rows(), 2);
+    TS_ASSERT_EQUALS(g.get_edges({3, 10}, {4, 12}).num_rows(), 1);
+    TS_ASSERT_EQUALS(g.find_edge_index(0, 0), index);
+
+    // the index of a modified partition is rebuilt
+    sframe more_edges = create_sframe(
+        {{"source", flex_type_enum::INTEGER, {5, 5}},
+         {"target", flex_type_enum::INTEGER, {500, 501}}});
+    g.add_edges(more_edges, "source", "target");
+    TS_ASSERT_EQUALS(g.get_edges({5}, {FLEX_UNDEFINED}).num_rows(), 4);
+    check_queries(g);
+
+    // the index is saved with the graph, and the loaded graph uses it
+    // without rebuilding it
+    g.build_edge_index();
+    std::string dirname = get_temp_name();
+    {
+      graphlab::dir_archive dir;
+      dir.open_directory_for_write(dirname);
+      graphlab::oarchive oarc(dir);
+      oarc << g;
+    }
+    {
+      graphlab::dir_archive dir;
+      dir.open_directory_for_read(dirname);
+      graphlab::iarchive iarc(dir);
+      sgraph loaded;
+      iarc >> loaded;
+      TS_ASSERT_EQUALS(loaded.num_edges(), g.num_edges());
+      std::vector<std::shared_ptr<const sgraph_edge_index>> loaded_indices;
+      for (size_t i = 0; i < loaded.get_num_partitions(); ++i) {
+        for (size_t j = 0; j < loaded.get_num_partitions(); ++j) {
+          loaded_indices.push_back(loaded.find_edge_index(i, j));
+          TS_ASSERT(loaded_indices.back());
+        }
+      }
+      check_queries(loaded);
+      for (size_t i = 0; i < loaded.get_num_partitions(); ++i) {
+        for (size_t j = 0; j < loaded.get_num_partitions(); ++j) {
+          TS_ASSERT_EQUALS(loaded.find_edge_index(i, j),
+                           loaded_indices[i * loaded.get_num_partitions() + j]);
+        }
+      }
+    }
+    boost::filesystem::remove_all(dirname);
+
+    // a dropped index is not used, and not saved
+    g.drop_edge_index();
+    TS_ASSERT(!g.find_edge_index(0, 0));
+    check_queries(g);
+    TS_ASSERT(!g.find_edge_index(0, 0));
+    {
+      graphlab::dir_archive dir;
+      dir.open_directory_for_write(dirname);
+      graphlab::oarchive oarc(dir);
+      oarc << g;
+    }
+    {
+      graphlab::dir_archive dir;
+      dir.open_directory_for_read(dirname);
+      graphlab::iarchive iarc(dir);
+      sgraph loaded;
+      iarc >> loaded;
+      TS_ASSERT(!loaded.find_edge_index(0, 0));
+      check_queries(loaded);
+      TS_ASSERT(!loaded.find_edge_index(0, 0));
+    }
+    boost::filesystem::remove_all(dirname);
+  }
+
+  void test_save_indexed_and_unindexed_graphs() {
+    // several graphs in one archive, as in a model, only some of which
+    // are indexed
+    sgraph indexed = create_and_check_ring_graph(100, 4, true);
+    sgraph unindexed = create_and_check_ring_graph(200, 4, false);
+    indexed.build_edge_index();
+    std::string dirname = get_temp_name();
+    {
+      graphlab::dir_archive dir;
+      dir.open_directory_for_write(dirname);
+      graphlab::oarchive oarc(dir);
+      oarc << unindexed << indexed << unindexed;
+    }
+    {
+      graphlab::dir_archive dir;
+      dir.open_directory_for_read(dirname);
+      graphlab::iarchive iarc(dir);
+      sgraph loaded_unindexed, loaded_indexed, loaded_unindexed2;
+      iarc >> loaded_unindexed >> loaded_indexed >> loaded_unindexed2;
+      TS_ASSERT_EQUALS(loaded_unindexed.num_edges(), 200);
+      TS_ASSERT_EQUALS(loaded_indexed.num_edges(), 200);
+      TS_ASSERT_EQUALS(loaded_unindexed2.num_edges(), 200);
+      TS_ASSERT(!loaded_unindexed.find_edge_index(0, 0));
+      TS_ASSERT(loaded_indexed.find_edge_index(0, 0));
+      TS_ASSERT(!loaded_unindexed2.find_edge_index(0, 0));
+      TS_ASSERT_EQUALS(loaded_indexed.get_edges({5}, {FLEX_UNDEFINED}).num_rows(), 2);
+      TS_ASSERT_EQUALS(loaded_unindexed2.get_edges({5}, {FLEX_UNDEFINED}).num_rows(), 1);
+    }
+    boost::filesystem::remove_all(dirname);
+  }
+
   template<typename T>
   void assert_vector_equals(
       const std::vector<T>& a,
@@ -0,0 +1,159 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <map>
+#include <set>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include <sgraph/sgraph.hpp>
+#include <sgraph/sgraph_constants.hpp>
+#include <random/random.hpp>
+#include <unity/toolkits/graph_analytics/connected_component.hpp>
+
+using namespace graphlab;
+
+class connected_component_test : public CxxTest::TestSuite {
+  const size_t NUM_RANDOM_VERTICES = 2000;
+  const size_t CHAIN_LENGTH = 500;
+  const size_t NUM_ISOLATED_VERTICES = 100;
+
+ public:
+  connected_component_test() {
+    global_logger().set_log_level(LOG_FATAL);
+  }
+
+  /**
+   * A graph with sparse random edges between vertices 0 to
+   * NUM_RANDOM_VERTICES - 1 (many small components and a large one),
+   * a chain of CHAIN_LENGTH vertices and isolated vertices. Returns the
+   * edges in edge_list.
+   */
+  sgraph make_graph(size_t num_random_edges,
+                    std::vector<std::pair<flex_int, flex_int>>& edge_list) {
+    edge_list.clear();
+    for (size_t i = 0;i < num_random_edges; ++i) {
+      edge_list.push_back({random::fast_uniform<flex_int>(0, NUM_RANDOM_VERTICES - 1),
+                           random::fast_uniform<flex_int>(0, NUM_RANDOM_VERTICES - 1)});
+    }
+    // the chain, with its edges in random directions and order
+    std::vector<std::pair<flex_int, flex_int>> chain;
+    for (size_t i = 0;i + 1 < CHAIN_LENGTH; ++i) {
+      flex_int a = NUM_RANDOM_VERTICES + i;
+      chain.push_back(random::fast_uniform<int>(0, 1) ? std::make_pair(a, a + 1)
+                                                      : std::make_pair(a + 1, a));
+    }
+    random::shuffle(chain);
+    edge_list.insert(edge_list.end(), chain.begin(), chain.end());
+
+    sframe edges;
+    edges.open_for_write({"src", "dst"}, {flex_type_enum::INTEGER, flex_type_enum::INTEGER}, "", 1);
+    auto out = edges.get_output_iterator(0);
+    for (auto& e: edge_list) {
+      *out = std::vector<flexible_type>{e.first, e.second};
+      ++out;
+    }
+    edges.close();
+
+    sframe vertices;
+    vertices.open_for_write({"id"}, {flex_type_enum::INTEGER}, "", 1);
+    auto vout = vertices.get_output_iterator(0);
+    for (size_t i = 0;i < NUM_ISOLATED_VERTICES; ++i) {
+      *vout = std::vector<flexible_type>{flex_int(NUM_RANDOM_VERTICES + CHAIN_LENGTH + i)};
+      ++vout;
+    }
+    vertices.close();
+
+    sgraph g(4);
+    g.add_vertices(vertices, "id");
+    g.add_edges(edges, "src", "dst");
+    return g;
+  }
+
+  /// Returns the component id of each vertex id, and the number of components
+  std::map<flexible_type, flexible_type> run(sgraph g, size_t& num_components) {
+    sframe components = connected_component::compute_connected_component(g);
+    num_components = components.size();
+    sframe vertices = g.get_vertices();
+    std::vector<std::vector<flexible_type>> rows;
+    vertices.get_reader()->read_rows(0, vertices.size(), rows);
+    size_t vid_idx = vertices.column_index(sgraph::VID_COLUMN_NAME);
+    size_t cid_idx = vertices.column_index("component_id");
+    std::map<flexible_type, flexible_type> ret;
+    for (auto& row: rows) ret[row[vid_idx]] = row[cid_idx];
+    return ret;
+  }
+
+  void test_union_find_and_label_propagation() {
+    random::seed(1);
+    for (size_t num_random_edges: {500, 1000, 3000}) {
+      std::vector<std::pair<flex_int, flex_int>> edge_list;
+      sgraph g = make_graph(num_random_edges, edge_list);
+      size_t num_vertices = NUM_RANDOM_VERTICES + CHAIN_LENGTH + NUM_ISOLATED_VERTICES;
+
+      size_t num_components = 0;
+      auto union_find_ids = run(g, num_components);
+
+      // the union find does not fit, so label propagation is used
+      size_t old_capacity = SGRAPH_UNION_FIND_CAPACITY;
+      SGRAPH_UNION_FIND_CAPACITY = 0;
+      size_t num_propagated_components = 0;
+      auto propagated_ids = run(g, num_propagated_components);
+      SGRAPH_UNION_FIND_CAPACITY = old_capacity;
+
+      TS_ASSERT(union_find_ids == propagated_ids);
+      TS_ASSERT_EQUALS(num_components, num_propagated_components);
+
+      // the components match a union find over the edge list
+      std::vector<size_t> parent(num_vertices);
+      for (size_t i = 0;i < num_vertices; ++i) parent[i] = i;
+      std::function<size_t(size_t)> find = [&](size_t i) {
+        return parent[i] == i ? i : (parent[i] = find(parent[i]));
+      };
+      for (auto& e: edge_list) parent[find(e.first)] = find(e.second);
+      // the random vertices without edges are not in the graph
+      std::set<flex_int> graph_vertices;
+      for (auto& e: edge_list) {
+        graph_vertices.insert(e.first);
+        graph_vertices.insert(e.second);
+      }
+      for (size_t i = 0;i < NUM_ISOLATED_VERTICES; ++i) {
+        graph_vertices.insert(NUM_RANDOM_VERTICES + CHAIN_LENGTH + i);
+      }
+      TS_ASSERT_EQUALS(union_find_ids.size(), graph_vertices.size());
+      std::map<size_t, flexible_type> root_to_cid;
+      std::set<flexible_type> cids;
+      for (flex_int vid: graph_vertices) {
+        flexible_type cid = union_find_ids[vid];
+        auto iter = root_to_cid.insert({find(vid), cid}).first;
+        TS_ASSERT_EQUALS(iter->second, cid);
+        cids.insert(cid);
+      }
+      TS_ASSERT_EQUALS(cids.size(), root_to_cid.size());
+      TS_ASSERT_EQUALS(num_components, cids.size());
+
+      // the whole chain is one component, and each isolated vertex is its own
+      for (size_t i = 1;i < CHAIN_LENGTH; ++i) {
+        TS_ASSERT_EQUALS(union_find_ids[flex_int(NUM_RANDOM_VERTICES + i)],
+                         union_find_ids[flex_int(NUM_RANDOM_VERTICES)]);
+      }
+      std::set<flexible_type> isolated_cids;
+      for (size_t i = 0;i < NUM_ISOLATED_VERTICES; ++i) {
+        isolated_cids.insert(union_find_ids[flex_int(NUM_RANDOM_VERTICES + CHAIN_LENGTH + i)]);
+      }
+      TS_ASSERT_EQUALS(isolated_cids.size(), NUM_ISOLATED_VERTICES);
+    }
+  }
+};
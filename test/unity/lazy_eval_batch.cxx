@@ -0,0 +1,384 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <string>
+#include <vector>
+#include <cxxtest/TestSuite.h>
+#include <sframe/sarray.hpp>
+#include <sframe/sframe_config.hpp>
+#include <sframe/sarray_v2_block_cache.hpp>
+#include <sframe/sarray_v2_block_types.hpp>
+#include <unity/query_process/column_batch.hpp>
+#include <unity/query_process/lazy_eval_op_imp.hpp>
+
+using namespace graphlab;
+
+typedef std::shared_ptr<lazy_eval_op_imp_base<flexible_type>> value_op_type;
+
+class lazy_eval_batch_test: public CxxTest::TestSuite {
+  const size_t ARRAY_SIZE = 20000;
+
+  /// (read or skip, number of rows) steps, cycled through until the end
+  const std::vector<std::pair<bool, size_t>> READ_PATTERN{
+    {true, 7}, {false, 3}, {true, 1}, {false, 50}, {true, 100},
+    {false, 1000}, {true, 13}, {false, 1}, {true, 4096}, {false, 9}};
+
+ public:
+  lazy_eval_batch_test() {
+    global_logger().set_log_level(LOG_FATAL);
+  }
+
+  /**
+   * An sarray of 4 segments where row i is (i * 7919) % mod, or the
+   * string of i if mod is 0.
+   */
+  value_op_type make_source(int mod) {
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write(4);
+    sa->set_type(mod == 0 ? flex_type_enum::STRING : flex_type_enum::INTEGER);
+    for (size_t s = 0; s < 4; ++s) {
+      auto out = sa->get_output_iterator(s);
+      for (size_t i = s * ARRAY_SIZE / 4; i < (s + 1) * ARRAY_SIZE / 4; ++i) {
+        if (mod == 0) *out = std::to_string(i);
+        else *out = (flex_int)((i * 7919) % mod);
+        ++out;
+      }
+    }
+    sa->close();
+    return std::make_shared<le_sarray<flexible_type>>(sa);
+  }
+
+  /**
+   * Reads all the segments of an operator, with get_next() or
+   * get_next_batch(), batch_size rows at a time. Returns the rows of each
+   * segment.
+   */
+  template <typename T>
+  std::vector<std::vector<T>> read_all(std::shared_ptr<lazy_eval_op_imp_base<T>> op,
+                                       bool use_batch, size_t dop, size_t batch_size) {
+    auto iter = parallel_iterator<T>::create(op, dop);
+    std::vector<std::vector<T>> ret(dop);
+    for (size_t segment = 0; segment < dop; ++segment) {
+      while(true) {
+        std::vector<T> items;
+        if (use_batch) {
+          column_batch batch;
+          iter->get_next_batch(segment, batch_size, batch);
+          batch.move_to(items);
+        } else {
+          items = iter->get_next(segment, batch_size);
+        }
+        if (items.empty()) break;
+        TS_ASSERT_LESS_THAN_EQUALS(items.size(), batch_size);
+        ret[segment].insert(ret[segment].end(), items.begin(), items.end());
+      }
+    }
+    return ret;
+  }
+
+  /**
+   * Reads all the segments of an operator following READ_PATTERN, reading
+   * with get_next() or get_next_batch(). Returns the rows read.
+   */
+  template <typename T>
+  std::vector<T> read_with_skips(std::shared_ptr<lazy_eval_op_imp_base<T>> op,
+                                 bool use_batch, size_t dop) {
+    auto iter = parallel_iterator<T>::create(op, dop);
+    std::vector<T> ret;
+    for (size_t segment = 0; segment < dop; ++segment) {
+      for (size_t step = 0; ; ++step) {
+        auto action = READ_PATTERN[step % READ_PATTERN.size()];
+        if (action.first) {
+          std::vector<T> items;
+          if (use_batch) {
+            column_batch batch;
+            iter->get_next_batch(segment, action.second, batch);
+            batch.move_to(items);
+          } else {
+            items = iter->get_next(segment, action.second);
+          }
+          ret.insert(ret.end(), items.begin(), items.end());
+          if (items.size() < action.second) break;
+        } else {
+          if (iter->skip_rows(segment, action.second) < action.second) break;
+        }
+      }
+    }
+    return ret;
+  }
+
+  /// Applies READ_PATTERN to the rows of each segment
+  template <typename T>
+  std::vector<T> expected_with_skips(const std::vector<std::vector<T>>& segments) {
+    std::vector<T> ret;
+    for (auto& rows: segments) {
+      size_t pos = 0;
+      for (size_t step = 0; pos < rows.size(); ++step) {
+        auto action = READ_PATTERN[step % READ_PATTERN.size()];
+        size_t end = std::min(pos + action.second, rows.size());
+        if (action.first) ret.insert(ret.end(), rows.begin() + pos, rows.begin() + end);
+        pos = end;
+      }
+    }
+    return ret;
+  }
+
+  template <typename T>
+  std::vector<T> concat(const std::vector<std::vector<T>>& segments) {
+    std::vector<T> ret;
+    for (auto& rows: segments) ret.insert(ret.end(), rows.begin(), rows.end());
+    return ret;
+  }
+
+  /**
+   * Checks that batch and row at a time reads of the operator give the
+   * same rows, including when reads are interleaved with skips. Returns
+   * the rows.
+   */
+  template <typename T>
+  std::vector<T> check_operator(std::shared_ptr<lazy_eval_op_imp_base<T>> op) {
+    std::vector<T> all_rows;
+    for (size_t dop: {1, 3}) {
+      auto rows = read_all<T>(op, false, dop, 1000);
+      if (dop == 1) all_rows = concat(rows);
+      TS_ASSERT(concat(rows) == all_rows);
+      for (size_t batch_size: {1, 7, 1000, 4096}) {
+        TS_ASSERT(read_all<T>(op, true, dop, batch_size) == rows);
+        TS_ASSERT(read_all<T>(op, false, dop, batch_size) == rows);
+      }
+      auto expected = expected_with_skips(rows);
+      TS_ASSERT(read_with_skips<T>(op, false, dop) == expected);
+      TS_ASSERT(read_with_skips<T>(op, true, dop) == expected);
+    }
+    return all_rows;
+  }
+
+  void test_column_batch() {
+    column_batch batch;
+    batch.add_column({0, 1, 2, 3, 4, 5});
+    batch.add_column({"a", "b", "c", "d", "e", "f"});
+    TS_ASSERT_EQUALS(batch.num_rows(), 6);
+    TS_ASSERT(!batch.has_selection());
+
+    batch.select({1, 2, 4, 5});
+    batch.select({0, 2, 3});  // rows 1, 4 and 5
+    TS_ASSERT(batch.has_selection());
+    TS_ASSERT_EQUALS(batch.num_rows(), 3);
+    TS_ASSERT_EQUALS(batch.num_physical_rows(), 6);
+    TS_ASSERT_EQUALS(batch.value(0, 1), 4);
+    TS_ASSERT_EQUALS(batch.value(1, 2), "f");
+
+    batch.drop_front(1);
+    std::vector<flexible_type> row;
+    batch.get_row(0, row);
+    TS_ASSERT(row == std::vector<flexible_type>({4, "e"}));
+
+    // appending the selected rows of another batch
+    column_batch other;
+    other.add_column({10, 11, 12});
+    other.add_column({"x", "y", "z"});
+    other.select({0, 2});
+    batch.append(other, 1);
+    TS_ASSERT_EQUALS(batch.num_rows(), 3);
+    TS_ASSERT_EQUALS(other.num_rows(), 1);
+    TS_ASSERT_EQUALS(other.value(0, 0), 12);
+
+    // adding the columns of a batch with a different selection
+    column_batch flags;
+    flags.add_column({1, 0, 1, 0});
+    flags.select({0, 1, 2});
+    batch.add_columns(flags);
+    TS_ASSERT_EQUALS(batch.num_columns(), 3);
+    TS_ASSERT_EQUALS(flags.num_columns(), 0);
+
+    std::vector<std::vector<flexible_type>> rows;
+    batch.compact();
+    TS_ASSERT(!batch.has_selection());
+    batch.move_to(rows);
+    TS_ASSERT(rows == std::vector<std::vector<flexible_type>>(
+        {{4, "e", 1}, {5, "f", 0}, {10, "x", 1}}));
+    TS_ASSERT_EQUALS(batch.num_rows(), 0);
+
+    // single column batches
+    column_batch values;
+    values.assign(std::vector<flexible_type>{1, 2, 3});
+    values.select({0, 2});
+    std::vector<flexible_type> out;
+    values.move_to(out);
+    TS_ASSERT(out == std::vector<flexible_type>({1, 3}));
+  }
+
+  void test_transform_and_vector() {
+    auto a = make_source(10);
+    auto b = make_source(1000);
+    auto doubled = std::make_shared<le_transform<flexible_type>>(
+        a, [](const flexible_type& x) { return x * 2; }, flex_type_enum::INTEGER);
+    auto sum = std::make_shared<le_vector>(
+        doubled, b,
+        [](const flexible_type& x, const flexible_type& y) { return x + y; },
+        flex_type_enum::INTEGER);
+    auto rows = check_operator<flexible_type>(sum);
+    TS_ASSERT_EQUALS(rows.size(), ARRAY_SIZE);
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT_EQUALS(rows[i], (flex_int)(2 * ((i * 7919) % 10) + (i * 7919) % 1000));
+    }
+  }
+
+  void test_sarray_compare_pruning() {
+    // sorted strings longer than the block statistics keep, so every block
+    // bound is cut down to a prefix
+    const size_t num_rows = 100000;
+    auto make_value = [](size_t i) {
+      std::string number = std::to_string(i);
+      return std::string(6 - number.length(), '0') + number + std::string(200, 'x');
+    };
+    auto sa = std::make_shared<sarray<flexible_type>>();
+    sa->open_for_write(1);
+    sa->set_type(flex_type_enum::STRING);
+    auto out = sa->get_output_iterator(0);
+    for (size_t i = 0; i < num_rows; ++i) {
+      *out = make_value(i);
+      ++out;
+    }
+    sa->close();
+
+    size_t block_start = 0, block_end = 0;
+    auto stats = sa->get_reader()->get_block_statistics(0, block_start, block_end);
+    TS_ASSERT(stats != NULL);
+    TS_ASSERT(stats->has_bounds);
+    TS_ASSERT_EQUALS(stats->min_value.get<flex_string>().length(),
+                     v2_block_impl::MAX_BLOCK_STATISTICS_STRING_LENGTH);
+    TS_ASSERT_EQUALS(stats->max_value.get<flex_string>().length(),
+                     v2_block_impl::MAX_BLOCK_STATISTICS_STRING_LENGTH);
+    TS_ASSERT_LESS_THAN(block_end, num_rows);
+
+    // count the blocks decoded through the block cache, without readahead
+    auto& cache = v2_block_impl::block_cache::get_instance();
+    size_t old_cache_size = sframe_config::SFRAME_BLOCK_CACHE_SIZE;
+    size_t old_readahead = sframe_config::SFRAME_READAHEAD_BLOCKS;
+    sframe_config::SFRAME_BLOCK_CACHE_SIZE = 64 * 1024 * 1024;
+    sframe_config::SFRAME_READAHEAD_BLOCKS = 0;
+    auto blocks_read = [&](value_op_type op) {
+      cache.clear();
+      size_t misses = cache.get_statistics().misses;
+      read_all<flexible_type>(op, false, 1, num_rows);
+      return cache.get_statistics().misses - misses;
+    };
+    flexible_type other = make_value(1000);
+    auto compare = std::make_shared<le_sarray_compare>(
+        sa, other, "<", false,
+        [](const flexible_type& a, const flexible_type& b)->flexible_type {
+          return (flex_int)(a < b);
+        });
+    size_t pruned_blocks_read = blocks_read(compare);
+    size_t all_blocks_read = blocks_read(std::make_shared<le_sarray<flexible_type>>(sa));
+    TS_ASSERT_LESS_THAN(0, pruned_blocks_read);
+    TS_ASSERT_LESS_THAN(pruned_blocks_read, all_blocks_read);
+
+    // and the skipped blocks give the same rows
+    auto rows = check_operator<flexible_type>(compare);
+    TS_ASSERT_EQUALS(rows.size(), num_rows);
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT_EQUALS(rows[i], (flex_int)(i < 1000));
+    }
+    cache.clear();
+    sframe_config::SFRAME_BLOCK_CACHE_SIZE = old_cache_size;
+    sframe_config::SFRAME_READAHEAD_BLOCKS = old_readahead;
+  }
+
+  void test_logical_filter() {
+    auto a = make_source(10);
+    auto names = make_source(0);
+    auto mask = std::make_shared<le_transform<flexible_type>>(
+        a, [](const flexible_type& x) { return flexible_type(x < 3); },
+        flex_type_enum::INTEGER);
+    auto filtered = std::make_shared<le_logical_filter<flexible_type>>(
+        names, mask, flex_type_enum::STRING);
+    auto rows = check_operator<flexible_type>(filtered);
+
+    std::vector<flexible_type> expected;
+    for (size_t i = 0; i < ARRAY_SIZE; ++i) {
+      if ((i * 7919) % 10 < 3) expected.push_back(std::to_string(i));
+    }
+    TS_ASSERT(rows == expected);
+
+    // a transform and a binary operator over the filter. The binary
+    // operator reads the filter through two iterators.
+    auto suffixed = std::make_shared<le_transform<flexible_type>>(
+        filtered, [](const flexible_type& x) { return x + "!"; },
+        flex_type_enum::STRING);
+    auto twice = std::make_shared<le_vector>(
+        suffixed, filtered,
+        [](const flexible_type& x, const flexible_type& y) { return x + y; },
+        flex_type_enum::STRING);
+    rows = check_operator<flexible_type>(twice);
+    TS_ASSERT_EQUALS(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT_EQUALS(rows[i], expected[i] + "!" + expected[i]);
+    }
+
+    // a batch transform over the filter only sees the selected rows
+    size_t num_transformed = 0;
+    auto batch_suffixed = std::make_shared<le_transform<flexible_type>>(
+        filtered, [](const flexible_type& x) { return x + "!"; },
+        flex_type_enum::STRING);
+    batch_suffixed->set_batch_transform_fn(
+        [&](std::vector<flexible_type>& input, std::vector<flexible_type>& output) {
+          num_transformed += input.size();
+          for (size_t i = 0; i < input.size(); ++i) output[i] = input[i] + "!";
+        });
+    auto batch_rows = read_all<flexible_type>(batch_suffixed, true, 1, 1000);
+    TS_ASSERT_EQUALS(num_transformed, expected.size());
+    rows = check_operator<flexible_type>(batch_suffixed);
+    TS_ASSERT(concat(batch_rows) == rows);
+    TS_ASSERT_EQUALS(rows.size(), expected.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      TS_ASSERT_EQUALS(rows[i], expected[i] + "!");
+    }
+  }
+
+  void test_sframe_filter() {
+    auto a = make_source(10);
+    auto b = make_source(1000);
+    auto names = make_source(0);
+    auto sf = std::make_shared<le_sframe>(std::vector<value_op_type>{a, b, names});
+    auto mask = std::make_shared<le_transform<flexible_type>>(
+        b, [](const flexible_type& x) { return flexible_type(x < 100); },
+        flex_type_enum::INTEGER);
+    auto filtered = std::make_shared<le_logical_filter<std::vector<flexible_type>>>(
+        sf, mask, flex_type_enum::LIST);
+    auto rows = check_operator<std::vector<flexible_type>>(filtered);
+    for (auto& row: rows) {
+      size_t i = std::stoul(row[2].get<flex_string>());
+      TS_ASSERT_EQUALS(row[0], (flex_int)((i * 7919) % 10));
+      TS_ASSERT_EQUALS(row[1], (flex_int)((i * 7919) % 1000));
+      TS_ASSERT_LESS_THAN(row[1], 100);
+    }
+
+    // a filter of the filter, which skips rows of the inner filter
+    auto mask2 = std::make_shared<le_transform<std::vector<flexible_type>>>(
+        filtered,
+        [](const std::vector<flexible_type>& row) { return flexible_type(row[0] == 1); },
+        flex_type_enum::INTEGER);
+    auto filtered2 = std::make_shared<le_logical_filter<std::vector<flexible_type>>>(
+        filtered, mask2, flex_type_enum::LIST);
+    auto rows2 = check_operator<std::vector<flexible_type>>(filtered2);
+    std::vector<std::vector<flexible_type>> expected;
+    for (auto& row: rows) if (row[0] == 1) expected.push_back(row);
+    TS_ASSERT(rows2 == expected);
+    TS_ASSERT_LESS_THAN(0, rows2.size());
+  }
+};
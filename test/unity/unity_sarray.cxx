@@ -22,6 +22,7 @@
 
 #include <fileio/temp_files.hpp>
 #include <unity/lib/unity_sarray.hpp>
+#include <unity/lib/unity_sarray_binary_operations.hpp>
 #include <unity/query_process/algorithm_parallel_iter.hpp>
 using namespace graphlab;
 
@@ -999,6 +1000,57 @@ class unity_sarray_test: public CxxTest::TestSuite {
     }
   }
 
+  void test_binary_kernels() {
+    // the typed kernels must agree with the per element operators,
+    // including on undefined values and scalars on either side
+    std::vector<flexible_type> ints{3, -2, 0, 7, FLEX_UNDEFINED, 5, 0, 1};
+    std::vector<flexible_type> floats{1.5, -2.0, 0.0, FLEX_UNDEFINED, 3.0, 5.0, 0.5, -0.25};
+    std::vector<std::string> ops{"+", "-", "*", "/", "<", ">", "<=", ">=",
+                                 "==", "!=", "&", "|"};
+    std::vector<std::pair<flex_type_enum, const std::vector<flexible_type>*>> sides{
+      {flex_type_enum::INTEGER, &ints}, {flex_type_enum::FLOAT, &floats}};
+    for (auto& op: ops) {
+      for (auto& l: sides) {
+        for (auto& r: sides) {
+          auto kernel = unity_sarray_binary_operations::get_binary_kernel(l.first, r.first, op);
+          auto fn = unity_sarray_binary_operations::get_binary_operator(l.first, r.first, op);
+          TS_ASSERT(bool(kernel));
+          const std::vector<flexible_type>& left = *(l.second);
+          const std::vector<flexible_type>& right = *(r.second);
+          size_t n = left.size();
+          // (left step, right step): column/column, column/scalar, scalar/column
+          std::vector<std::pair<size_t, size_t>> steps{{1, 1}, {1, 0}, {0, 1}};
+          for (auto& step: steps) {
+            std::vector<flexible_type> out(n);
+            TS_ASSERT(kernel(left.data(), step.first, right.data(), step.second, n, out.data()));
+            for (size_t i = 0;i < n; ++i) {
+              const flexible_type& a = left[i * step.first];
+              const flexible_type& b = right[i * step.second];
+              if (a.get_type() == flex_type_enum::UNDEFINED ||
+                  b.get_type() == flex_type_enum::UNDEFINED) {
+                TS_ASSERT_EQUALS(out[i].get_type(), flex_type_enum::UNDEFINED);
+              } else {
+                flexible_type expected = fn(a, b);
+                TS_ASSERT_EQUALS(out[i].get_type(), expected.get_type());
+                // 0 / 0 is nan on both sides
+                TS_ASSERT(out[i] == expected || (op == "/" && b.is_zero()));
+              }
+            }
+          }
+        }
+      }
+    }
+    // a value not of the declared type makes the kernel fall back
+    auto kernel = unity_sarray_binary_operations::get_binary_kernel(
+        flex_type_enum::INTEGER, flex_type_enum::INTEGER, "+");
+    std::vector<flexible_type> mixed{1, 2.5};
+    std::vector<flexible_type> out(2);
+    TS_ASSERT(!kernel(mixed.data(), 1, ints.data(), 1, 2, out.data()));
+    // there are no kernels for other types
+    TS_ASSERT(!unity_sarray_binary_operations::get_binary_kernel(
+        flex_type_enum::STRING, flex_type_enum::STRING, "+"));
+  }
+
   void test_string_scalar_ops() {
     // make a vector with an UNDEFINED first value
     std::vector<flexible_type> vec{"a","a","a","a","a","a","a","a","a","a"};
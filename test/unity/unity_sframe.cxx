@@ -25,6 +25,7 @@
 #include <sframe/sarray.hpp>
 #include <cxxtest/TestSuite.h>
 #include <sframe/sframe_config.hpp>
+#include <unity/query_process/sort_impl.hpp>
 using namespace graphlab;
 
 class unity_sframe_test: public CxxTest::TestSuite {
@@ -747,6 +748,54 @@ class unity_sframe_test: public CxxTest::TestSuite {
 
   }
 
+  void test_sort_key_encoder() {
+    // encoded keys must order rows like less_than_partial_function
+    std::vector<flexible_type> ints = {FLEX_UNDEFINED, std::numeric_limits<flex_int>::min(),
+                                       -5, -1, 0, 1, 255, 256,
+                                       std::numeric_limits<flex_int>::max()};
+    std::vector<flexible_type> floats = {FLEX_UNDEFINED, -INFINITY, -1e10, -1.5, -0.0,
+                                         0.0, 1e-300, 2, 2.5, INFINITY};
+    std::vector<flexible_type> strings = {FLEX_UNDEFINED, "", std::string("\0", 1),
+                                          std::string("a\0", 2), "a", "ab",
+                                          "b", std::string("\xff")};
+    std::vector<std::vector<flexible_type>> rows;
+    for (size_t i = 0; i < 2000; ++i) {
+      rows.push_back({ints[rand() % ints.size()],
+                      floats[rand() % floats.size()],
+                      strings[rand() % strings.size()],
+                      flex_date_time(rand() % 5 - 2, rand() % 3)});
+    }
+    std::vector<flex_type_enum> types = {flex_type_enum::INTEGER, flex_type_enum::FLOAT,
+                                         flex_type_enum::STRING, flex_type_enum::DATETIME};
+    std::vector<std::vector<size_t>> column_orders = {{0, 1, 2, 3}, {2, 0}, {1, 3, 2}};
+    for (auto& columns: column_orders) {
+      for (size_t trial = 0; trial < 4; ++trial) {
+        std::vector<bool> orders;
+        std::vector<flex_type_enum> column_types;
+        for (size_t c: columns) {
+          orders.push_back(rand() % 2);
+          column_types.push_back(types[c]);
+        }
+        sframe_sort_impl::less_than_partial_function less_than(columns, orders);
+        sframe_sort_impl::sort_key_encoder encoder(columns, orders, column_types);
+        for (size_t i = 0; i < 500; ++i) {
+          auto& a = rows[rand() % rows.size()];
+          auto& b = rows[rand() % rows.size()];
+          TS_ASSERT_EQUALS(less_than(a, b), encoder.encode(a) < encoder.encode(b));
+        }
+        auto sorted = rows;
+        sframe_sort_impl::sort_rows(sorted, encoder);
+        for (size_t i = 1; i < sorted.size(); ++i) {
+          TS_ASSERT(!less_than(sorted[i], sorted[i - 1]));
+        }
+      }
+    }
+    // integers in a float column compare as floats
+    sframe_sort_impl::sort_key_encoder encoder({0}, {true}, {flex_type_enum::FLOAT});
+    TS_ASSERT(encoder.encode({flexible_type(1)}) < encoder.encode({flexible_type(1.5)}));
+    TS_ASSERT(encoder.encode({flexible_type(2)}) == encoder.encode({flexible_type(2.0)}));
+  }
+
   void test_sort_exception() {
     auto sa = std::make_shared<unity_sarray>();
     auto sf = std::make_shared<unity_sframe>();
@@ -332,6 +332,49 @@ class unity_graph_test: public CxxTest::TestSuite {
     TS_ASSERT_EQUALS(vt.nrows(), 2);
   }
 
+  void test_get_edges_with_index() {
+    dataframe_t df;
+    create_test_dataframe_c(df);  // edges a --> b
+    std::shared_ptr<unity_sframe_base> sf(new unity_sframe);
+    sf->construct_from_dataframe(df);
+    options_map_t empty_constraint;
+
+    std::shared_ptr<unity_sgraph_base> graph1(new unity_sgraph);
+    std::shared_ptr<unity_sgraph_base> graph2(graph1->add_edges(sf, "a", "b", 0, 0));
+    graph2->build_edge_index(0, 0);
+    const sgraph& g2 = std::dynamic_pointer_cast<unity_sgraph>(graph2)->get_graph();
+    size_t nparts = g2.get_num_partitions();
+    for (size_t i = 0; i < nparts; ++i) {
+      for (size_t j = 0; j < nparts; ++j) {
+        TS_ASSERT(g2.find_edge_index(i, j));
+      }
+    }
+
+    // the graphs derived from an indexed graph are indexed. Their changed
+    // partitions are only reindexed by the indexed get_edges(); a scan
+    // would leave them out of date.
+    dataframe_t more;
+    more.set_column("a", {5, 5}, flex_type_enum::INTEGER);
+    more.set_column("b", {100, 101}, flex_type_enum::INTEGER);
+    std::shared_ptr<unity_sframe_base> more_sf(new unity_sframe);
+    more_sf->construct_from_dataframe(more);
+    std::shared_ptr<unity_sgraph_base> graph3(graph2->add_edges(more_sf, "a", "b", 0, 0));
+    const sgraph& g3 = std::dynamic_pointer_cast<unity_sgraph>(graph3)->get_graph();
+    size_t src_pid = flexible_type(5).hash() % nparts;
+    size_t dst_pid = flexible_type(100).hash() % nparts;
+    TS_ASSERT(!g3.find_edge_index(src_pid, dst_pid));
+    dataframe_t vt = graph3->get_edges({5}, {flex_undefined()}, empty_constraint, 0, 0)
+                         ->_head(size_t(-1));
+    TS_ASSERT_EQUALS(vt.nrows(), 3);
+    TS_ASSERT(g3.find_edge_index(src_pid, dst_pid));
+
+    graph3->drop_edge_index(0, 0);
+    TS_ASSERT(!g3.find_edge_index(src_pid, dst_pid));
+    vt = graph3->get_edges({5}, {flex_undefined()}, empty_constraint, 0, 0)->_head(size_t(-1));
+    TS_ASSERT_EQUALS(vt.nrows(), 3);
+    TS_ASSERT(!g3.find_edge_index(src_pid, dst_pid));
+  }
+
   void test_errors() {
     size_t group, groupa, groupb;
     group = groupa = groupb = 0;
@@ -0,0 +1,85 @@
+/*
+* Copyright (C) 2015 Dato, Inc.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU Affero General Public License as
+* published by the Free Software Foundation, either version 3 of the
+* License, or (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Affero General Public License for more details.
+*
+* You should have received a copy of the GNU Affero General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <cmath>
+#include <cxxtest/TestSuite.h>
+#include <graphlab/util/bloom_filter.hpp>
+#include <parallel/lambda_omp.hpp>
+
+using namespace graphlab;
+
+class bloom_filter_test : public CxxTest::TestSuite {
+ public:
+  /// The expected false positive rate of k probes with m bits per key
+  static double expected_false_positive_rate(double m, double k) {
+    return std::pow(1 - std::exp(-k / m), k);
+  }
+
+  /**
+   * Inserts the keys 0, 2, 4, ... (num_keys of them) into the filter, then
+   * checks that they are all found, and that the odd keys are found at
+   * about the expected rate.
+   */
+  template <typename Filter>
+  void check_filter(Filter& filter, size_t num_keys, double bits_per_key, size_t probes) {
+    for (size_t i = 0;i < num_keys; ++i) filter.insert(2 * i);
+    for (size_t i = 0;i < num_keys; ++i) TS_ASSERT(filter.may_contain(2 * i));
+
+    size_t num_false_positives = 0;
+    size_t num_queries = 10 * num_keys;
+    for (size_t i = 0;i < num_queries; ++i) {
+      num_false_positives += filter.may_contain(2 * i + 1);
+    }
+    double rate = double(num_false_positives) / num_queries;
+    double expected = expected_false_positive_rate(bits_per_key, probes);
+    TS_ASSERT_LESS_THAN(rate, 1.5 * expected);
+    TS_ASSERT_LESS_THAN(0.5 * expected, rate);
+  }
+
+  void test_size() {
+    bloom_filter filter(1, 5);
+    TS_ASSERT_EQUALS(filter.size(), 64);
+    filter.init(65, 5);
+    TS_ASSERT_EQUALS(filter.size(), 128);
+    // not rounded up to a power of 2
+    filter.init(640, 5);
+    TS_ASSERT_EQUALS(filter.size(), 640);
+  }
+
+  void test_false_positive_rate() {
+    // a size which is not a power of 2
+    bloom_filter filter(10 * 30000, 5);
+    check_filter(filter, 30000, 10, 5);
+    filter.init(4 * 30000, 3);
+    check_filter(filter, 30000, 4, 3);
+    filter.init(2 * 30000, 1);
+    check_filter(filter, 30000, 2, 1);
+  }
+
+  void test_concurrent_insert() {
+    bloom_filter filter(10 * 100000, 5);
+    parallel_for(size_t(0), size_t(100000), [&](size_t i) { filter.insert(i * 7919); });
+    for (size_t i = 0;i < 100000; ++i) TS_ASSERT(filter.may_contain(i * 7919));
+  }
+
+  void test_fixed_bloom_filter() {
+    fixed_bloom_filter<8192, 5> filter;
+    check_filter(filter, 800, 8192.0 / 800, 5);
+    filter.clear();
+    TS_ASSERT(!filter.may_contain(0));
+    TS_ASSERT(!filter.may_contain(2));
+  }
+};